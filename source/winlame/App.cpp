@@ -29,6 +29,10 @@
 #include "preset/PresetManagerImpl.hpp"
 #include "encoder/ModuleManagerImpl.hpp"
 #include "encoder/LameNogapInstanceManager.hpp"
+#include "encoder/TranscodeCache.hpp"
+#include "encoder/EncodingCostModel.hpp"
+#include "encoder/BatchJournal.hpp"
+#include "encoder/WorkerProcessPool.hpp"
 #include "TaskManager.hpp"
 #include <ulib/CrashReporter.hpp>
 #include "CrashSaveResultsDlg.hpp"
@@ -106,6 +110,29 @@ m_startInputCD(false)
    m_spModuleManager.reset(new Encoder::ModuleManagerImpl);
    ioc.Register<Encoder::ModuleManager>(std::ref(*m_spModuleManager.get()));
 
+   m_spTranscodeCache.reset(new Encoder::TranscodeCache(
+      m_settings.transcode_cache_folder,
+      ULONGLONG(m_settings.transcode_cache_max_size_mb) * 1024 * 1024));
+   ioc.Register<Encoder::TranscodeCache>(std::ref(*m_spTranscodeCache.get()));
+
+   m_spEncodingCostModel.reset(new Encoder::EncodingCostModel(m_settings.encoding_cost_factors));
+   ioc.Register<Encoder::EncodingCostModel>(std::ref(*m_spEncodingCostModel.get()));
+
+   // local app-data, non-roaming; jobs of an interrupted batch are recovered
+   // before new jobs are recorded
+   CString journalFolder = Path::Combine(Path::SpecialFolder(CSIDL_LOCAL_APPDATA), _T("winLAME\\journal"));
+   m_interruptedJobFilenames = Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder);
+
+   m_spBatchJournal.reset(new Encoder::BatchJournal(journalFolder));
+   ioc.Register<Encoder::BatchJournal>(std::ref(*m_spBatchJournal.get()));
+
+   // worker processes are only started when encoding in worker processes
+   TCHAR executableFilename[MAX_PATH] = {};
+   GetModuleFileName(nullptr, executableFilename, MAX_PATH);
+
+   m_spWorkerProcessPool.reset(new Encoder::WorkerProcessPool(executableFilename));
+   ioc.Register<Encoder::WorkerProcessPool>(std::ref(*m_spWorkerProcessPool.get()));
+
    LoadPresetFile();
 
    // set language to use
@@ -123,6 +150,9 @@ App::~App()
    // store settings in the registry
    try
    {
+      if (m_spEncodingCostModel != nullptr)
+         m_settings.encoding_cost_factors = m_spEncodingCostModel->GetCostFactorsText();
+
       m_settings.StoreSettings();
    }
    catch (...) // NOSONAR
@@ -242,12 +272,39 @@ std::shared_ptr<UI::WizardPage> App::GetClassicModeStartWizardPage(UI::WizardPag
       }
    }
 
+   // offer to encode the remaining files of an interrupted batch
+   std::vector<CString> resumeFilenames;
+   if (wizardPage == nullptr &&
+      AskResumeInterruptedJobs(nullptr, resumeFilenames))
+   {
+      wizardPage = std::make_shared<UI::InputFilesPage>(host, resumeFilenames);
+   }
+
    if (wizardPage == nullptr)
       wizardPage = std::make_shared<UI::ClassicModeStartPage>(host);
 
    return wizardPage;
 }
 
+bool App::AskResumeInterruptedJobs(HWND hwndParent, std::vector<CString>& filenames)
+{
+   if (m_interruptedJobFilenames.empty())
+      return false;
+
+   std::vector<CString> interruptedJobFilenames;
+   interruptedJobFilenames.swap(m_interruptedJobFilenames);
+
+   CString text;
+   text.Format(IDS_BATCH_JOURNAL_RESUME_U, static_cast<unsigned int>(interruptedJobFilenames.size()));
+
+   int ret = AtlMessageBox(hwndParent, text.GetString(), IDS_APP_CAPTION, MB_YESNO | MB_ICONQUESTION);
+   if (ret != IDYES)
+      return false;
+
+   filenames = interruptedJobFilenames;
+   return true;
+}
+
 int App::RunMainFrame(int nCmdShow)
 {
    CMessageLoop theLoop;
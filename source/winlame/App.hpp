@@ -31,6 +31,10 @@ namespace Encoder
 {
    class ModuleManager;
    class LameNogapInstanceManager;
+   class TranscodeCache;
+   class EncodingCostModel;
+   class BatchJournal;
+   class WorkerProcessPool;
 }
 namespace UI
 {
@@ -74,6 +78,11 @@ public:
    /// resets flag to start Input CD dialog
    void ResetStartInputCD() { m_startInputCD = false; }
 
+   /// \brief asks the user if the jobs of an interrupted encoding batch should be resumed
+   /// \details the user is only asked once; returns true and the input
+   /// filenames of the jobs when they should be encoded again
+   bool AskResumeInterruptedJobs(HWND hwndParent, std::vector<CString>& filenames);
+
    /// runs application
    int Run(LPTSTR /*lpstrCmdLine*/ = NULL, int nCmdShow = SW_SHOWDEFAULT);
 
@@ -136,6 +145,21 @@ private:
    /// module manager
    std::shared_ptr<Encoder::ModuleManager> m_spModuleManager;
 
+   /// transcode cache
+   std::shared_ptr<Encoder::TranscodeCache> m_spTranscodeCache;
+
+   /// encoding cost model
+   std::shared_ptr<Encoder::EncodingCostModel> m_spEncodingCostModel;
+
+   /// batch journal
+   std::shared_ptr<Encoder::BatchJournal> m_spBatchJournal;
+
+   /// worker process pool
+   std::shared_ptr<Encoder::WorkerProcessPool> m_spWorkerProcessPool;
+
+   /// input filenames of jobs of an interrupted encoding batch
+   std::vector<CString> m_interruptedJobFilenames;
+
    /// indicates if help file is available
    bool m_helpAvailable;
 
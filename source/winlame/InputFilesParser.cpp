@@ -21,6 +21,7 @@
 
 #include "stdafx.h"
 #include "InputFilesParser.hpp"
+#include "CueSheet.hpp"
 #include <fstream>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -230,59 +231,36 @@ void InputFilesParser::ImportPlsPlaylist(LPCTSTR filename)
 
 void InputFilesParser::ImportCueSheet(LPCTSTR filename)
 {
-   // open cue sheet
-   std::ifstream sheet(CStringA(filename), std::ios::in);
-   if (!sheet.is_open()) return;
-
-   // find out pathname (for relative file refs)
-   std::tstring path(filename);
-   std::tstring::size_type pos = path.find_last_of('\\');
-   if (pos != std::tstring::npos)
-      path.erase(pos);
+   Encoder::CueSheet cueSheet;
+   if (!cueSheet.Load(filename))
+      return;
 
-   // read in all lines
-   std::tstring line;
+   for (const CString& imageFilename : cueSheet.GetFilenames())
+      InsertFilename(imageFilename);
 
-   while (!sheet.eof())
+   // create one job per track; the filename is generated from the title
+   for (size_t trackIndex = 0, maxIndex = cueSheet.Tracks().size(); trackIndex < maxIndex; trackIndex++)
    {
-#ifdef UNICODE
-      std::string line2;
-      std::getline(sheet, line2);
-      line = CString(line2.c_str());
-#else
-      std::getline(sheet, line);
-#endif
-      if (line.empty()) continue;
+      const Encoder::CueSheetTrack& track = cueSheet.Tracks()[trackIndex];
 
-      // trim
-      while (line.size() != 0 && line.at(0) == ' ') line.erase(0, 1);
-      if (line.empty()) continue;
+      Encoder::EncoderJob job(track.m_filename);
 
-      // file entry?
-      if (line.compare(0, 4, _T("FILE")) == 0)
-      {
-         // trim
-         line.erase(0, 5);
-         while (line.size() != 0 && line.at(0) == ' ') line.erase(0, 1);
-         if (line.empty()) continue;
-
-         // determine endchar
-         char endchar = ' ';
-         if (line.at(0) == '\"') endchar = '\"';
-
-         // search endchar
-         std::tstring::size_type pos2 = line.find_first_of(endchar, 1);
-         if (pos2 == std::tstring::npos) continue;
-
-         // cut out filename
-         std::tstring fname;
-         fname.assign(line.c_str() + (endchar == ' ' ? 0 : 1),
-            pos2 - (endchar == ' ' ? 0 : 1));
-
-         // insert filename
-         InsertFilename(fname.c_str());
-      }
-   }
+      unsigned int startFrame = 0, endFrame = 0;
+      cueSheet.GetTrackFrameRange(trackIndex, startFrame, endFrame);
+      job.Range(startFrame, endFrame);
+
+      cueSheet.SetTrackInfo(trackIndex, job.GetTrackInfo());
+      job.UseTrackInfo(true);
+      job.CueSheetFilename(filename);
+
+      CString title;
+      title.Format(_T("%02u - %s"), track.m_trackNumber,
+         track.m_title.IsEmpty() ? Path::FilenameOnly(track.m_filename).GetString() : track.m_title.GetString());
+      job.Title(title);
 
-   sheet.close();
+      CString key = track.m_filename;
+      key.MakeLower();
+
+      m_mapCueSheetTrackJobs[key].push_back(job);
+   }
 }
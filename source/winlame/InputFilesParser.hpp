@@ -22,11 +22,15 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include "EncoderInterface.hpp"
 
 /// \brief parses input files
 /// \details When input is folder name, the parser adds all files recursively.
 /// When input is playlists (.m3u, .pls) or cue sheets (.cue), it adds the the referenced files.
 /// When input is a normal existing file, it adds it to the file list.
+/// For cue sheets, one encoder job per track is created additionally, with
+/// the track's range in the referenced file and the track infos.
 class InputFilesParser
 {
 public:
@@ -44,6 +48,10 @@ public:
    /// returns playlist name; when a playlist was added, this is the same name (else it is empty)
    CString PlaylistName() { return m_cszPlaylistName; }
 
+   /// returns encoder jobs for the tracks of files referenced by cue sheets,
+   /// by lowercase filename
+   const std::map<CString, std::vector<Encoder::EncoderJob>>& CueSheetTrackJobs() const { return m_mapCueSheetTrackJobs; }
+
    /// parses list of filenames
    void Parse(const std::vector<CString>& vecFilenames);
 
@@ -72,4 +80,7 @@ private:
 
    /// possible playlist name
    CString m_cszPlaylistName;
+
+   /// encoder jobs for cue sheet tracks, by lowercase filename
+   std::map<CString, std::vector<Encoder::EncoderJob>> m_mapCueSheetTrackJobs;
 };
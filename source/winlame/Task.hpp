@@ -23,6 +23,7 @@
 
 #include "TaskInfo.hpp"
 #include <atomic>
+#include <vector>
 
 /// task interface
 class Task
@@ -50,9 +51,21 @@ public:
    /// task should be aborted, e.g. when program is closed
    virtual void Stop() = 0;
 
+   /// returns estimated run time of the task, in seconds, or 0 when unknown;
+   /// used to start the longest tasks first
+   virtual double EstimatedCost() const { return 0.0; }
+
    /// returns if task was already started
    bool IsStarted() const { return m_isStarted; }
 
+   /// adds another task id this task depends on; the task only runs when
+   /// all tasks it depends on are finished; must be called before the task
+   /// is added to the task manager
+   void AddDependentTaskId(unsigned int dependentTaskId)
+   {
+      m_additionalDependentTaskIds.push_back(dependentTaskId);
+   }
+
 protected:
    friend class TaskManager;
 
@@ -83,6 +96,9 @@ protected:
    /// returns dependent task id
    unsigned int DependentTaskId() const { return m_dependentTaskId; }
 
+   /// returns additional dependent task ids
+   const std::vector<unsigned int>& AdditionalDependentTaskIds() const { return m_additionalDependentTaskIds; }
+
    /// returns error text, if any
    const CString& ErrorText() const { return m_errorText; }
 
@@ -93,6 +109,9 @@ private:
    /// task id this task depends on; may be 0 for no task
    unsigned int m_dependentTaskId;
 
+   /// additional task ids this task depends on
+   std::vector<unsigned int> m_additionalDependentTaskIds;
+
    /// flag that indicates if the task already has been started
    std::atomic<bool> m_isStarted;
 
@@ -21,6 +21,7 @@
 //
 #include "stdafx.h"
 #include "TaskCreationHelper.hpp"
+#include "UISettings.hpp"
 #include "TaskManager.hpp"
 #include "EncoderTask.hpp"
 #include "CreatePlaylistTask.hpp"
@@ -28,7 +29,14 @@
 #include "EjectCDTask.hpp"
 #include "CDRipTitleFormatManager.hpp"
 #include "LameNogapInstanceManager.hpp"
+#include "TranscodeCache.hpp"
+#include "BatchJournal.hpp"
+#include "FileSystemCache.hpp"
+#include "Playlist.hpp"
+#include "WorkerProcessPool.hpp"
+#include "EncodingCostModel.hpp"
 #include <sndfile.h>
+#include <algorithm>
 
 TaskCreationHelper::TaskCreationHelper()
    :m_uiSettings(IoCContainer::Current().Resolve<UISettings>()),
@@ -42,6 +50,8 @@ bool TaskCreationHelper::IsLossyTranscoding() const
 
    bool in_lossy = false;
 
+   int out_id = moduleManager.GetOutputModuleID(m_uiSettings.output_module);
+
    // only have to check when from input page; CD reading is always lossless
    if (m_uiSettings.m_bFromInputFilesPage)
    {
@@ -57,14 +67,13 @@ bool TaskCreationHelper::IsLossyTranscoding() const
          if (inmod == nullptr)
             continue;
 
-         int in_id = inmod->GetModuleID();
-
-         in_lossy |= Encoder::EncoderImpl::IsLossyInputModule(in_id);
+         // files of the same codec are still warned about; whether they are
+         // copied without re-encoding depends on the input file's bitrate,
+         // channels and sample rate, which are only known when encoding
+         in_lossy |= Encoder::EncoderImpl::IsLossyInputModule(inmod->GetModuleID());
       }
    }
 
-   int out_id = moduleManager.GetOutputModuleID(m_uiSettings.output_module);
-
    bool out_lossy = Encoder::EncoderImpl::IsLossyOutputModule(out_id);
 
    return in_lossy && out_lossy;
@@ -110,6 +119,15 @@ bool TaskCreationHelper::IsOverwritingOriginalFiles() const
 
 void TaskCreationHelper::AddTasks()
 {
+   // each batch of tasks gets a new cache, so that changes by other
+   // processes between batches are seen
+   m_fileSystemCache = std::make_shared<Encoder::FileSystemCache>();
+
+   // the playlist entries are collected while encoding, and the playlist
+   // is written once, in the order of the jobs
+   m_playlist = m_uiSettings.create_playlist ? std::make_shared<Encoder::Playlist>() : nullptr;
+   m_outputTaskIds.clear();
+
    if (m_uiSettings.m_bFromInputFilesPage)
       AddInputFilesTasks();
    else
@@ -120,6 +138,7 @@ void TaskCreationHelper::AddTasks()
 
    m_uiSettings.encoderjoblist.clear();
    m_uiSettings.cdreadjoblist.clear();
+   m_uiSettings.cuesheet_track_jobs.clear();
 }
 
 void TaskCreationHelper::AddInputFilesTasks()
@@ -134,14 +153,11 @@ void TaskCreationHelper::AddInputFilesTasks()
       moduleManager.GetOutputModuleID(m_uiSettings.output_module) == ID_OM_LAME &&
       m_uiSettings.settings_manager.QueryValueInt(LameOptNoGap) == 1;
 
-   int nogapInstanceId = -1; // valid values start at 0
+   // each album is encoded as a separate nogap chain; the chains can be
+   // encoded at the same time
+   std::map<CString, NogapChain> nogapChains;
    if (lameNogapEncoding)
-   {
-      Encoder::LameNogapInstanceManager& nogapInstanceManager =
-         IoCContainer::Current().Resolve<Encoder::LameNogapInstanceManager>();
-
-      nogapInstanceId = nogapInstanceManager.NextNogapInstanceId();
-   }
+      nogapChains = GetNogapChains();
 
    for (int i = 0, iMax = m_uiSettings.encoderjoblist.size(); i < iMax; i++)
    {
@@ -158,7 +174,11 @@ void TaskCreationHelper::AddInputFilesTasks()
       else
          taskSettings.m_outputFolder = m_uiSettings.m_defaultSettings.outputdir;
 
-      taskSettings.m_title = Path::FilenameAndExt(job.InputFilename());
+      taskSettings.m_title = job.Title().IsEmpty() ? Path::FilenameAndExt(job.InputFilename()) : job.Title();
+
+      // the length is used to start the longest tasks first
+      taskSettings.m_inputLengthInSeconds = GetEncoderJobLengthInSeconds(job);
+      taskSettings.m_costModel = &IoCContainer::Current().Resolve<Encoder::EncodingCostModel>();
 
       taskSettings.m_outputModuleID = moduleManager.GetOutputModuleID(m_uiSettings.output_module);
 
@@ -166,16 +186,58 @@ void TaskCreationHelper::AddInputFilesTasks()
       taskSettings.m_trackInfo = job.GetTrackInfo();
       taskSettings.m_overwriteExisting = m_uiSettings.m_defaultSettings.overwrite_existing;
       taskSettings.m_deleteInputAfterEncode = m_uiSettings.m_defaultSettings.delete_after_encode;
+      taskSettings.m_verifyOutput = m_uiSettings.verify_output;
+      taskSettings.m_allowPassThrough = m_uiSettings.allow_pass_through;
+
+      // cue sheet tracks are ranges of a disc image, with track info from
+      // the cue sheet
+      taskSettings.m_useTrackInfo = job.UseTrackInfo();
+      taskSettings.m_rangeStartFrame = job.RangeStartFrame();
+      taskSettings.m_rangeEndFrame = job.RangeEndFrame();
+
+      if (job.HasRange())
+         taskSettings.m_deleteInputAfterEncode = false;
+
+      Encoder::TranscodeCache& transcodeCache = IoCContainer::Current().Resolve<Encoder::TranscodeCache>();
+      if (transcodeCache.IsEnabled())
+         taskSettings.m_transcodeCache = &transcodeCache;
+
+      taskSettings.m_additionalOutputs = GetAdditionalOutputs();
+      taskSettings.m_fileSystemCache = m_fileSystemCache;
 
-      // set previous task id when encoding with LAME and using nogap encoding
+      if (m_playlist != nullptr)
+      {
+         taskSettings.m_playlist = m_playlist;
+         taskSettings.m_playlistEntryIndex = m_playlist->GetNumEntries();
+      }
+
+      // record the job, so that it can be resumed when winLAME is closed
+      // or crashes while encoding
+      Encoder::BatchJournal& batchJournal = IoCContainer::Current().Resolve<Encoder::BatchJournal>();
+      if (batchJournal.IsEnabled())
+      {
+         taskSettings.m_batchJournal = &batchJournal;
+         taskSettings.m_batchJournalJobId = batchJournal.AddJob(job.InputFilename(), job.HasRange());
+      }
+
+      // LAME nogap encoding needs all files of a chain to be encoded in
+      // the same process
+      if (m_uiSettings.use_worker_processes && !lameNogapEncoding)
+         taskSettings.m_workerProcessPool = &IoCContainer::Current().Resolve<Encoder::WorkerProcessPool>();
+
+      // set previous task id of the album when encoding with LAME and using
+      // nogap encoding
       unsigned int dependentTaskId = 0;
+      NogapChain* nogapChain = nullptr;
       if (lameNogapEncoding)
       {
-         dependentTaskId = m_lastTaskId;
+         nogapChain = &nogapChains[Encoder::LameNogapInstanceManager::GetChainKey(job)];
+
+         dependentTaskId = nogapChain->m_lastTaskId;
 
-         taskSettings.m_settingsManager.setValue(LameNoGapInstanceId, nogapInstanceId);
+         taskSettings.m_settingsManager.setValue(LameNoGapInstanceId, nogapChain->m_nogapInstanceId);
 
-         if (i == iMax - 1)
+         if (i == nogapChain->m_lastJobIndex)
             taskSettings.m_settingsManager.setValue(GeneralIsLastFile, 1);
       }
 
@@ -183,9 +245,20 @@ void TaskCreationHelper::AddInputFilesTasks()
 
       taskMgr.AddTask(spTask);
 
-      CString inputTitle = Path::FilenameOnly(job.InputFilename());
+      if (nogapChain != nullptr)
+         nogapChain->m_lastTaskId = spTask->Id();
+
+      CString inputTitle = job.Title().IsEmpty()
+         ? Path::FilenameOnly(job.InputFilename())
+         : CDRipTitleFormatManager::GetFilenameByTitle(job.Title());
+
       job.OutputFilename(spTask->GenerateOutputFilename(inputTitle));
 
+      if (m_playlist != nullptr)
+         m_playlist->AddEntry(job.OutputFilename(), taskSettings.m_title, taskSettings.m_inputLengthInSeconds);
+
+      m_outputTaskIds.push_back(spTask->Id());
+
       m_lastTaskId = spTask->Id();
    }
 }
@@ -215,6 +288,7 @@ void TaskCreationHelper::AddCDExtractTasks()
    TaskManager& taskMgr = IoCContainer::Current().Resolve<TaskManager>();
 
    unsigned int lastCDReadTaskId = 0;
+   unsigned int lastNogapEncoderTaskId = 0;
 
    unsigned int maxJobIndex = m_uiSettings.cdreadjoblist.size();
    for (unsigned int jobIndex = 0; jobIndex < maxJobIndex; jobIndex++)
@@ -241,9 +315,14 @@ void TaskCreationHelper::AddCDExtractTasks()
       }
 
       std::shared_ptr<Encoder::CDExtractTask> spCDExtractTask(new Encoder::CDExtractTask(lastCDReadTaskId, discInfo, trackInfo));
+
+      if (lastCDReadTaskId == 0)
+         spCDExtractTask->SetFirstTrackOfRip();
+
       taskMgr.AddTask(spCDExtractTask);
 
       m_lastTaskId = spCDExtractTask->Id();
+      m_outputTaskIds.push_back(spCDExtractTask->Id());
 
       cdReadJob.OutputFilename(spCDExtractTask->OutputFilename());
       cdReadJob.Title(spCDExtractTask->Title());
@@ -267,10 +346,22 @@ void TaskCreationHelper::AddCDExtractTasks()
 
          cdReadJob.OutputFilename(spEncoderTask->GenerateOutputFilename(titleFilename));
 
+         // the tracks of a nogap chain must be encoded one after another;
+         // extracting the tracks doesn't wait for encoding, though
+         if (lameNogapEncoding && lastNogapEncoderTaskId != 0)
+            spEncoderTask->AddDependentTaskId(lastNogapEncoderTaskId);
+
          taskMgr.AddTask(spEncoderTask);
 
          m_lastTaskId = spEncoderTask->Id();
+         m_outputTaskIds.push_back(spEncoderTask->Id());
+
+         if (lameNogapEncoding)
+            lastNogapEncoderTaskId = spEncoderTask->Id();
       }
+
+      if (m_playlist != nullptr)
+         m_playlist->AddEntry(cdReadJob.OutputFilename(), cdReadJob.Title(), trackInfo.m_trackLengthInSeconds);
    }
 }
 
@@ -285,6 +376,9 @@ std::shared_ptr<Encoder::EncoderTask> TaskCreationHelper::CreateEncoderTaskForCD
 
    taskSettings.m_title = cdReadJob.Title();
 
+   taskSettings.m_inputLengthInSeconds = cdReadJob.TrackInfo().m_trackLengthInSeconds;
+   taskSettings.m_costModel = &IoCContainer::Current().Resolve<Encoder::EncodingCostModel>();
+
    Encoder::ModuleManager& moduleManager = IoCContainer::Current().Resolve<Encoder::ModuleManager>();
    taskSettings.m_outputModuleID = moduleManager.GetOutputModuleID(m_uiSettings.output_module);
 
@@ -300,6 +394,16 @@ std::shared_ptr<Encoder::EncoderTask> TaskCreationHelper::CreateEncoderTaskForCD
    taskSettings.m_useTrackInfo = true;
    taskSettings.m_overwriteExisting = m_uiSettings.m_defaultSettings.overwrite_existing;
    taskSettings.m_deleteInputAfterEncode = true; // temporary file created by CDExtractTask
+   taskSettings.m_allowPassThrough = false; // temporary FLAC file uses the fastest compression
+   taskSettings.m_verifyOutput = m_uiSettings.verify_output;
+   taskSettings.m_additionalOutputs = GetAdditionalOutputs();
+   taskSettings.m_fileSystemCache = m_fileSystemCache;
+
+   if (m_playlist != nullptr)
+   {
+      taskSettings.m_playlist = m_playlist;
+      taskSettings.m_playlistEntryIndex = m_playlist->GetNumEntries();
+   }
 
    if (isLastTrack)
       taskSettings.m_settingsManager.setValue(GeneralIsLastFile, 1);
@@ -307,6 +411,81 @@ std::shared_ptr<Encoder::EncoderTask> TaskCreationHelper::CreateEncoderTaskForCD
    return std::make_shared<Encoder::EncoderTask>(cdReadTaskId, taskSettings);
 }
 
+std::map<CString, TaskCreationHelper::NogapChain> TaskCreationHelper::GetNogapChains() const
+{
+   Encoder::LameNogapInstanceManager& nogapInstanceManager =
+      IoCContainer::Current().Resolve<Encoder::LameNogapInstanceManager>();
+
+   std::map<CString, NogapChain> nogapChains;
+
+   for (int i = 0, iMax = m_uiSettings.encoderjoblist.size(); i < iMax; i++)
+   {
+      CString key = Encoder::LameNogapInstanceManager::GetChainKey(m_uiSettings.encoderjoblist[i]);
+
+      auto iter = nogapChains.find(key);
+      if (iter == nogapChains.end())
+      {
+         NogapChain& nogapChain = nogapChains[key];
+         nogapChain.m_nogapInstanceId = nogapInstanceManager.NextNogapInstanceId();
+         nogapChain.m_lastJobIndex = i;
+      }
+      else
+         iter->second.m_lastJobIndex = i;
+   }
+
+   return nogapChains;
+}
+
+double TaskCreationHelper::GetEncoderJobLengthInSeconds(const Encoder::EncoderJob& job)
+{
+   // cue sheet tracks with an end know their length already
+   if (job.RangeEndFrame() > job.RangeStartFrame())
+      return (job.RangeEndFrame() - job.RangeStartFrame()) / 75.0;
+
+   // the input file length was already determined when the file was added
+   // to the input list; the file isn't read again here, since the tasks are
+   // created on the UI thread
+   if (job.InputLengthInSeconds() == 0)
+      return 0.0;
+
+   double rangeStartInSeconds = job.RangeStartFrame() / 75.0;
+   return std::max(0.0, job.InputLengthInSeconds() - rangeStartInSeconds);
+}
+
+std::vector<Encoder::EncoderOutputSettings> TaskCreationHelper::GetAdditionalOutputs() const
+{
+   std::vector<Encoder::EncoderOutputSettings> additionalOutputs;
+
+   Encoder::ModuleManager& moduleManager = IoCContainer::Current().Resolve<Encoder::ModuleManager>();
+   int mainOutputModuleID = moduleManager.GetOutputModuleID(m_uiSettings.output_module);
+
+   int pos = 0;
+   CString token = m_uiSettings.additional_output_modules.Tokenize(_T(", "), pos);
+   while (!token.IsEmpty())
+   {
+      int outputModuleID = _ttoi(token);
+
+      // only use known output modules, and each one only once
+      bool isKnownModule = false;
+      for (size_t index = 0, maxIndex = moduleManager.GetOutputModuleCount(); index < maxIndex; index++)
+      {
+         if (moduleManager.GetOutputModuleID(index) == outputModuleID)
+            isKnownModule = true;
+      }
+
+      bool isUsedModule = outputModuleID == mainOutputModuleID ||
+         std::any_of(additionalOutputs.begin(), additionalOutputs.end(),
+            [outputModuleID](const Encoder::EncoderOutputSettings& output) { return output.m_outputModuleID == outputModuleID; });
+
+      if (isKnownModule && !isUsedModule)
+         additionalOutputs.push_back(Encoder::EncoderOutputSettings(outputModuleID));
+
+      token = m_uiSettings.additional_output_modules.Tokenize(_T(", "), pos);
+   }
+
+   return additionalOutputs;
+}
+
 CString TaskCreationHelper::FindCommonPlaylistOutputFolder() const
 {
    CString playlistOutputFolder = m_uiSettings.m_defaultSettings.outputdir;
@@ -358,11 +537,13 @@ void TaskCreationHelper::AddPlaylistTask()
    CString playlistFilename =
       Path::Combine(playlistOutputFolder, m_uiSettings.playlist_filename);
 
-   std::shared_ptr<Task> spTask;
-   if (m_uiSettings.m_bFromInputFilesPage)
-      spTask.reset(new Encoder::CreatePlaylistTask(m_lastTaskId, playlistFilename, m_uiSettings.encoderjoblist));
-   else
-      spTask.reset(new Encoder::CreatePlaylistTask(m_lastTaskId, playlistFilename, m_uiSettings.cdreadjoblist));
+   std::shared_ptr<Task> spTask =
+      std::make_shared<Encoder::CreatePlaylistTask>(m_lastTaskId, playlistFilename, m_playlist);
+
+   // tasks may finish in any order; the playlist is written when all tasks
+   // that write output files are finished
+   for (unsigned int taskId : m_outputTaskIds)
+      spTask->AddDependentTaskId(taskId);
 
    taskMgr.AddTask(spTask);
 }
@@ -21,6 +21,9 @@
 //
 #pragma once
 
+#include <map>
+#include <vector>
+
 struct UISettings;
 struct CDRipDiscInfo;
 
@@ -28,6 +31,10 @@ namespace Encoder
 {
    class EncoderTask;
    class CDReadJob;
+   class EncoderJob;
+   class FileSystemCache;
+   class Playlist;
+   struct EncoderOutputSettings;
 }
 
 /// helper class to help with creating tasks for encoding, CD readout and playlist writing
@@ -47,9 +54,25 @@ public:
    void AddTasks();
 
 private:
+   /// nogap chain of input files, e.g. the tracks of an album
+   struct NogapChain
+   {
+      /// nogap instance ID used by all tasks of the chain
+      int m_nogapInstanceId = -1;
+
+      /// index of the last encoder job of the chain
+      int m_lastJobIndex = -1;
+
+      /// id of the last task added to the chain; 0 when no task was added yet
+      unsigned int m_lastTaskId = 0;
+   };
+
    /// adds tasks for input files to task manager
    void AddInputFilesTasks();
 
+   /// returns all nogap chains of the encoder jobs, by chain key
+   std::map<CString, NogapChain> GetNogapChains() const;
+
    /// adds tasks for CD extraction to task manager
    void AddCDExtractTasks();
 
@@ -58,6 +81,13 @@ private:
       unsigned int cdReadTaskId, const Encoder::CDReadJob& cdReadJob,
       int nogapInstanceId, bool isLastTrack);
 
+   /// returns length of the audio to encode for an encoder job, in seconds;
+   /// returns 0 when the length of the input file isn't known
+   static double GetEncoderJobLengthInSeconds(const Encoder::EncoderJob& job);
+
+   /// returns additional outputs that are encoded from the same input file
+   std::vector<Encoder::EncoderOutputSettings> GetAdditionalOutputs() const;
+
    /// finds playlist output folder that is common to all files on the playlist
    CString FindCommonPlaylistOutputFolder() const;
 
@@ -73,4 +103,14 @@ private:
 
    /// last task id used for an encoding task or a CD extract task
    unsigned int m_lastTaskId;
+
+   /// file system cache shared by all encoder tasks of the batch
+   std::shared_ptr<Encoder::FileSystemCache> m_fileSystemCache;
+
+   /// playlist that the tasks of the batch report their outputs to, or
+   /// nullptr when no playlist is created
+   std::shared_ptr<Encoder::Playlist> m_playlist;
+
+   /// IDs of all tasks of the batch that write output files
+   std::vector<unsigned int> m_outputTaskIds;
 };
@@ -23,37 +23,37 @@
 #include "TaskManager.hpp"
 #include "CDExtractTask.hpp"
 #include "Task.hpp"
+#include "TaskScheduleOrder.hpp"
 #include <ulib/thread/Thread.hpp>
 #include <algorithm>
+#include <chrono>
 #include <set>
 
+/// interval in which the controller thread samples the worker threads
+const std::chrono::seconds c_controllerSampleInterval(2);
+
+/// maximum number of worker threads
+const unsigned int c_maxWorkerThreads = 64;
+
 TaskManager::TaskManager(const TaskManagerConfig& config)
    :m_nextTaskId(1),
    m_config(config),
-   m_defaultWork(asio::make_work_guard(m_ioContext))
+   m_activeWorkerCount(0),
+   m_numRunningTasks(0),
+   m_numCompletedTasks(0),
+   m_scheduleChanged(false),
+   m_defaultWork(asio::make_work_guard(m_ioContext)),
+   m_stopController(false)
 {
-   // find out number of threads to start
-   unsigned int uiNumThreads = m_config.m_uiUseNumTasks;
-   if (m_config.m_bAutoTasksPerCpu)
+   unsigned int numWorkers = 0;
    {
-      uiNumThreads = std::thread::hardware_concurrency();
-      if (uiNumThreads == 0)
-         uiNumThreads = m_config.m_uiUseNumTasks;
+      std::unique_lock<std::mutex> lock(m_mutexController);
+      numWorkers = SetupController(m_config);
    }
 
-   if (uiNumThreads == 0)
-      uiNumThreads = 2; // set to a sane value
-
-   // start up threads
-   for (unsigned int i = 0; i < uiNumThreads; i++)
-   {
-      std::shared_ptr<std::thread> spThread = std::make_shared<std::thread>(
-         std::bind(&TaskManager::RunThread, std::ref(m_ioContext), i));
+   SetActiveWorkerCount(numWorkers);
 
-      SetBusyFlag(GetThreadId(spThread->native_handle()), false);
-
-      m_vecThreadPool.push_back(spThread);
-   }
+   m_controllerThread = std::thread(std::bind(&TaskManager::RunControllerThread, this));
 }
 
 TaskManager::~TaskManager()
@@ -61,11 +61,23 @@ TaskManager::~TaskManager()
    // stop all tasks
    try
    {
+      {
+         std::unique_lock<std::mutex> lock(m_mutexController);
+         m_stopController = true;
+      }
+
+      m_conditionStopController.notify_one();
+
+      if (m_controllerThread.joinable())
+         m_controllerThread.join();
+
       StopAll();
 
       // stop threads
       m_defaultWork.reset();
 
+      std::unique_lock<std::mutex> lock(m_mutexThreadPool);
+
       for (unsigned int i = 0, iMax = m_vecThreadPool.size(); i < iMax; i++)
          m_vecThreadPool[i]->join();
 
@@ -79,6 +91,44 @@ TaskManager::~TaskManager()
    }
 }
 
+void TaskManager::UpdateConfig(const TaskManagerConfig& config)
+{
+   unsigned int numWorkers = 0;
+   {
+      std::unique_lock<std::mutex> lock(m_mutexController);
+
+      m_config = config;
+      numWorkers = SetupController(m_config);
+   }
+
+   SetActiveWorkerCount(numWorkers);
+}
+
+unsigned int TaskManager::ActiveWorkerCount() const
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   return m_activeWorkerCount;
+}
+
+void TaskManager::SetActiveWorkerCount(unsigned int numWorkers)
+{
+   numWorkers = std::min(std::max(numWorkers, 1U), c_maxWorkerThreads);
+
+   StartWorkerThreads(numWorkers);
+
+   {
+      std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+      if (m_activeWorkerCount != numWorkers)
+         ATLTRACE(_T("TaskManager: changing active worker count from %u to %u\n"), m_activeWorkerCount, numWorkers);
+
+      m_activeWorkerCount = numWorkers;
+   }
+
+   StartRunnableTasks();
+}
+
 std::vector<TaskInfo> TaskManager::CurrentTasks()
 {
    std::vector<TaskInfo> vecTaskInfos;
@@ -112,42 +162,17 @@ void TaskManager::AddTask(std::shared_ptr<Task> spTask)
    {
       std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
       m_deqTaskQueue.push_back(spTask);
+      m_scheduleChanged = true;
    }
 
    ATLASSERT(spTask->IsStarted() == false); // must not be already started
 
-   if (IsTaskRunnable(spTask))
-   {
-      spTask->IsStarted(true);
-
-      asio::post(
-         m_ioContext.get_executor(),
-         std::bind(&TaskManager::RunTask, this, spTask));
-   }
+   StartRunnableTasks();
 }
 
 void TaskManager::CheckRunnableTasks()
 {
-   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
-
-   std::for_each(m_deqTaskQueue.begin(), m_deqTaskQueue.end(),
-      [&](std::shared_ptr<Task>& spTask)
-   {
-      auto iter = m_mapCompletedTaskInfos.find(spTask->Id());
-      if (iter != m_mapCompletedTaskInfos.end())
-         return; // already completed
-
-      if (m_mapCompletedTaskInfos.find(spTask->Id()) == m_mapCompletedTaskInfos.end() &&
-         !spTask->IsStarted() &&
-         IsTaskRunnable(spTask))
-      {
-         spTask->IsStarted(true);
-
-         asio::post(
-            m_ioContext.get_executor(),
-            std::bind(&TaskManager::RunTask, this, spTask));
-      }
-   });
+   StartRunnableTasks();
 }
 
 bool TaskManager::IsQueueEmpty() const
@@ -272,6 +297,7 @@ void TaskManager::StopAll()
       StoreCompletedTaskInfo(spTask, errorText);
    }
 
+   m_scheduledTasks.clear();
    m_setFinishedTaskIds.clear();
 }
 
@@ -312,6 +338,146 @@ void TaskManager::RunThread(asio::io_context& ioContext, unsigned int threadNumb
    }
 }
 
+void TaskManager::StartWorkerThreads(unsigned int numThreads)
+{
+   std::unique_lock<std::mutex> lock(m_mutexThreadPool);
+
+   // threads are never stopped; idle threads just wait in the io context
+   for (unsigned int i = m_vecThreadPool.size(); i < numThreads; i++)
+   {
+      std::shared_ptr<std::thread> spThread = std::make_shared<std::thread>(
+         std::bind(&TaskManager::RunThread, std::ref(m_ioContext), i));
+
+      SetBusyFlag(GetThreadId(spThread->native_handle()), false);
+
+      m_vecThreadPool.push_back(spThread);
+   }
+}
+
+unsigned int TaskManager::SetupController(const TaskManagerConfig& config)
+{
+   m_controller.reset();
+
+   unsigned int numCpus = std::thread::hardware_concurrency();
+
+   if (!config.m_bAutoTasksPerCpu || numCpus == 0)
+   {
+      unsigned int numWorkers = config.m_uiUseNumTasks;
+      if (numWorkers == 0)
+         numWorkers = 2; // set to a sane value
+
+      return numWorkers;
+   }
+
+   // start with one task per CPU; SMT machines may profit from less tasks,
+   // and I/O bound tasks from more tasks
+   unsigned int maxWorkers = std::min(2 * numCpus, c_maxWorkerThreads);
+
+   m_controller.reset(new WorkerCountController(1, maxWorkers, numCpus, numCpus));
+
+   return m_controller->NumWorkers();
+}
+
+void TaskManager::RunControllerThread()
+{
+   Thread::SetName(_T("task manager controller thread"));
+
+   auto lastSampleTime = std::chrono::steady_clock::now();
+   ULONGLONG lastCpuTime = WorkerCpuTime();
+   double lastCompletedWork = CompletedWork();
+   unsigned int lastNumRunningTasks = 0;
+
+   std::unique_lock<std::mutex> lock(m_mutexController);
+
+   while (!m_conditionStopController.wait_for(lock, c_controllerSampleInterval,
+      [&]() { return m_stopController; }))
+   {
+      auto now = std::chrono::steady_clock::now();
+      ULONGLONG cpuTime = WorkerCpuTime();
+      double completedWork = CompletedWork();
+
+      unsigned int numRunningTasks = 0;
+      {
+         std::unique_lock<std::recursive_mutex> queueLock(m_mutexQueue);
+         numRunningTasks = m_numRunningTasks;
+      }
+
+      WorkerPoolSample sample;
+      sample.m_intervalInSeconds = std::chrono::duration<double>(now - lastSampleTime).count();
+      sample.m_numWaitingTasks = NumWaitingTasks();
+      sample.m_cpuSeconds = (cpuTime - lastCpuTime) / 1e7;
+      sample.m_completedWork = std::max(0.0, completedWork - lastCompletedWork);
+
+      // approximates the busy time by the number of running tasks at the
+      // start and the end of the interval; tasks usually run much longer
+      // than the sample interval
+      sample.m_busyWorkerSeconds = sample.m_intervalInSeconds * (lastNumRunningTasks + numRunningTasks) / 2.0;
+
+      lastSampleTime = now;
+      lastCpuTime = cpuTime;
+      lastCompletedWork = completedWork;
+      lastNumRunningTasks = numRunningTasks;
+
+      if (m_controller == nullptr)
+         continue;
+
+      unsigned int numWorkers = m_controller->Update(sample);
+
+      if (numWorkers != ActiveWorkerCount())
+         SetActiveWorkerCount(numWorkers);
+   }
+}
+
+ULONGLONG TaskManager::WorkerCpuTime() const
+{
+   std::unique_lock<std::mutex> lock(m_mutexThreadPool);
+
+   ULONGLONG cpuTime = 0;
+   for (const std::shared_ptr<std::thread>& spThread : m_vecThreadPool)
+   {
+      FILETIME creationTime = {}, exitTime = {}, kernelTime = {}, userTime = {};
+      if (!::GetThreadTimes(spThread->native_handle(), &creationTime, &exitTime, &kernelTime, &userTime))
+         continue;
+
+      cpuTime += (ULONGLONG(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+      cpuTime += (ULONGLONG(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+   }
+
+   return cpuTime;
+}
+
+double TaskManager::CompletedWork() const
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   double completedWork = m_numCompletedTasks;
+
+   for (const std::shared_ptr<Task>& spTask : m_deqTaskQueue)
+   {
+      if (spTask->IsStarted() && !IsTaskCompleted(spTask))
+         completedWork += std::min(spTask->GetTaskInfo().Progress(), 100U) / 100.0;
+   }
+
+   return completedWork;
+}
+
+unsigned int TaskManager::NumWaitingTasks() const
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   unsigned int numWaitingTasks = 0;
+
+   for (const std::shared_ptr<Task>& spTask : m_deqTaskQueue)
+   {
+      if (!spTask->IsStarted() &&
+         !IsTaskCompleted(spTask) &&
+         IsTaskRunnable(spTask))
+         numWaitingTasks++;
+   }
+
+   return numWaitingTasks;
+}
+
 bool TaskManager::IsTaskRunnable(std::shared_ptr<Task> spTask) const
 {
    std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
@@ -319,18 +485,107 @@ bool TaskManager::IsTaskRunnable(std::shared_ptr<Task> spTask) const
    // check dependent task ID
    unsigned int dependentTaskId = spTask->DependentTaskId();
 
-   if (dependentTaskId == 0)
-      return true;
-
-   if (m_setFinishedTaskIds.find(dependentTaskId) == m_setFinishedTaskIds.end())
+   if (dependentTaskId != 0 &&
+      m_setFinishedTaskIds.find(dependentTaskId) == m_setFinishedTaskIds.end())
    {
       // task id wasn't reported as finished yet
       return false;
    }
 
+   for (unsigned int additionalDependentTaskId : spTask->AdditionalDependentTaskIds())
+   {
+      if (m_setFinishedTaskIds.find(additionalDependentTaskId) == m_setFinishedTaskIds.end())
+         return false;
+   }
+
    return true;
 }
 
+bool TaskManager::IsTaskCompleted(std::shared_ptr<Task> spTask) const
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   return m_mapCompletedTaskInfos.find(spTask->Id()) != m_mapCompletedTaskInfos.end();
+}
+
+void TaskManager::StartRunnableTasks()
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   if (m_numRunningTasks >= m_activeWorkerCount)
+      return;
+
+   if (m_scheduleChanged)
+      CalculateScheduleOrder();
+
+   for (auto iter = m_scheduledTasks.begin(); iter != m_scheduledTasks.end() &&
+      m_numRunningTasks < m_activeWorkerCount;)
+   {
+      std::shared_ptr<Task> spTask = *iter;
+
+      if (spTask->IsStarted() ||
+         IsTaskCompleted(spTask))
+      {
+         iter = m_scheduledTasks.erase(iter);
+         continue;
+      }
+
+      if (!IsTaskRunnable(spTask))
+      {
+         ++iter;
+         continue;
+      }
+
+      iter = m_scheduledTasks.erase(iter);
+
+      spTask->IsStarted(true);
+      m_numRunningTasks++;
+
+      asio::post(
+         m_ioContext.get_executor(),
+         std::bind(&TaskManager::RunTask, this, spTask));
+   }
+}
+
+void TaskManager::CalculateScheduleOrder()
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+   // start longest tasks first, in order to minimize the time the whole
+   // queue takes; only tasks that weren't started yet are considered, and
+   // the order only changes when new tasks are added
+   std::vector<std::shared_ptr<Task>> pendingTasks;
+   std::vector<TaskScheduleEntry> entries;
+
+   for (std::shared_ptr<Task> spTask : m_deqTaskQueue)
+   {
+      if (spTask->IsStarted() ||
+         IsTaskCompleted(spTask))
+         continue;
+
+      TaskScheduleEntry entry;
+      entry.m_id = spTask->Id();
+      // same dependencies as checked by IsTaskRunnable()
+      if (spTask->DependentTaskId() != 0)
+         entry.m_dependentTaskIds.push_back(spTask->DependentTaskId());
+
+      const std::vector<unsigned int>& additionalDependentTaskIds = spTask->AdditionalDependentTaskIds();
+      entry.m_dependentTaskIds.insert(entry.m_dependentTaskIds.end(),
+         additionalDependentTaskIds.begin(), additionalDependentTaskIds.end());
+      entry.m_estimatedCost = spTask->EstimatedCost();
+
+      pendingTasks.push_back(spTask);
+      entries.push_back(entry);
+   }
+
+   m_scheduledTasks.clear();
+
+   for (size_t index : TaskScheduleOrder::Calculate(entries))
+      m_scheduledTasks.push_back(pendingTasks[index]);
+
+   m_scheduleChanged = false;
+}
+
 void TaskManager::RunTask(std::shared_ptr<Task> spTask)
 {
    SetBusyFlag(GetCurrentThreadId(), true);
@@ -353,6 +608,16 @@ void TaskManager::RunTask(std::shared_ptr<Task> spTask)
    SetBusyFlag(GetCurrentThreadId(), false);
 
    StoreCompletedTaskInfo(spTask, errorText);
+
+   {
+      std::unique_lock<std::recursive_mutex> lock(m_mutexQueue);
+
+      m_numRunningTasks--;
+      m_numCompletedTasks++;
+   }
+
+   // the finished task may free a worker, or make dependent tasks runnable
+   StartRunnableTasks();
 }
 
 void TaskManager::StoreCompletedTaskInfo(std::shared_ptr<Task> spTask, CString& errorText)
@@ -401,6 +666,7 @@ void TaskManager::RemoveTask(std::shared_ptr<Task> spTask)
          spTask->Stop();
 
          m_deqTaskQueue.erase(iterTaskQueue);
+         m_scheduledTasks.remove(spTask);
 
          auto iterTaskInfos = m_mapCompletedTaskInfos.find(spTask->Id());
          if (iterTaskInfos != m_mapCompletedTaskInfos.end())
@@ -23,18 +23,26 @@
 
 #include <vector>
 #include <deque>
+#include <list>
 #include <set>
 #include <memory>
 #include <atomic>
 #include <mutex>
 #include <thread>
+#include <condition_variable>
 #include <asio.hpp>
 #include "TaskInfo.hpp"
 #include "TaskManagerConfig.hpp"
+#include "WorkerCountController.hpp"
 
 class Task;
 
-/// manages all background tasks
+/// \brief manages all background tasks
+/// \details tasks are run on a pool of worker threads; the number of tasks
+/// running at the same time is limited by the active worker count. When the
+/// number of tasks is chosen automatically, a controller thread samples CPU
+/// time, I/O wait and task throughput of the workers, and adapts the active
+/// worker count using a WorkerCountController.
 class TaskManager
 {
 public:
@@ -43,6 +51,17 @@ public:
    /// dtor
    ~TaskManager();
 
+   /// applies a changed configuration, without restarting running tasks
+   void UpdateConfig(const TaskManagerConfig& config);
+
+   /// returns the number of tasks that may run at the same time
+   unsigned int ActiveWorkerCount() const;
+
+   /// sets the number of tasks that may run at the same time; when reducing
+   /// the number, running tasks are finished first. When the number of tasks
+   /// is chosen automatically, the controller may change it again.
+   void SetActiveWorkerCount(unsigned int numWorkers);
+
    /// returns a snapshot of current tasks
    std::vector<TaskInfo> CurrentTasks();
 
@@ -77,9 +96,38 @@ private:
    /// thread function
    static void RunThread(asio::io_context& ioContext, unsigned int threadNumber);
 
+   /// starts worker threads until the thread pool has the given size
+   void StartWorkerThreads(unsigned int numThreads);
+
+   /// creates worker count controller for given config, or none when the
+   /// number of tasks is fixed; returns initial active worker count
+   unsigned int SetupController(const TaskManagerConfig& config);
+
+   /// controller thread function
+   void RunControllerThread();
+
+   /// returns CPU time used by all worker threads, in 100ns units
+   ULONGLONG WorkerCpuTime() const;
+
+   /// returns number of completed tasks, including progress of running tasks
+   double CompletedWork() const;
+
+   /// returns number of runnable tasks that wait for a free worker
+   unsigned int NumWaitingTasks() const;
+
    /// returns if a task is runnable
    bool IsTaskRunnable(std::shared_ptr<Task> spTask) const;
 
+   /// returns if a task is completed
+   bool IsTaskCompleted(std::shared_ptr<Task> spTask) const;
+
+   /// starts runnable tasks, as long as the active worker count permits;
+   /// tasks with the longest estimated run time are started first
+   void StartRunnableTasks();
+
+   /// calculates the order in which the tasks not started yet are started
+   void CalculateScheduleOrder();
+
    /// runs single task
    void RunTask(std::shared_ptr<Task> spTask);
 
@@ -111,6 +159,13 @@ private:
    /// task queue, protected by queue mutex
    T_deqTaskQueue m_deqTaskQueue;
 
+   /// tasks not started yet, in the order they are started; protected by
+   /// queue mutex
+   std::list<std::shared_ptr<Task>> m_scheduledTasks;
+
+   /// indicates if tasks were added since the schedule order was calculated
+   bool m_scheduleChanged;
+
 
    // task bookkeeping
 
@@ -120,6 +175,15 @@ private:
    /// set with all finished task ids
    std::set<unsigned int> m_setFinishedTaskIds;
 
+   /// number of tasks that may run at the same time, protected by queue mutex
+   unsigned int m_activeWorkerCount;
+
+   /// number of currently running tasks, protected by queue mutex
+   unsigned int m_numRunningTasks;
+
+   /// number of tasks completed since start, protected by queue mutex
+   unsigned int m_numCompletedTasks;
+
 
    // thread pool
 
@@ -129,10 +193,31 @@ private:
    /// default work for io context
    asio::executor_work_guard<asio::io_context::executor_type> m_defaultWork;
 
+   /// mutex protecting thread pool
+   mutable std::mutex m_mutexThreadPool;
+
    /// thread pool
    std::vector<std::shared_ptr<std::thread>> m_vecThreadPool;
 
 
+   // worker count controller
+
+   /// mutex protecting controller and stop flag
+   std::mutex m_mutexController;
+
+   /// condition that is signaled when the controller thread should stop
+   std::condition_variable m_conditionStopController;
+
+   /// indicates if the controller thread should stop
+   bool m_stopController;
+
+   /// worker count controller; null when the number of tasks is fixed
+   std::unique_ptr<WorkerCountController> m_controller;
+
+   /// controller thread
+   std::thread m_controllerThread;
+
+
    // busy flags
 
    /// mutex protecting busy flag map
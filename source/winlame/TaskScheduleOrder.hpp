@@ -0,0 +1,104 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TaskScheduleOrder.hpp
+/// \brief calculates the order in which queued tasks are started
+//
+#pragma once
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+/// queued task, as seen by the scheduler
+struct TaskScheduleEntry
+{
+   /// task id
+   unsigned int m_id = 0;
+
+   /// ids of all tasks this task depends on; empty for no task
+   std::vector<unsigned int> m_dependentTaskIds;
+
+   /// estimated run time of the task, in seconds; 0 when unknown
+   double m_estimatedCost = 0.0;
+};
+
+/// \brief calculates the order in which queued tasks are started
+/// \details tasks are started longest job first, which keeps the workers
+/// busy until the end of a batch, instead of leaving a single long task
+/// running alone at the end. A task that other tasks depend on, e.g. a CD
+/// extract task or a task of a nogap chain, is rated by the cost of the
+/// longest chain that follows it, since its dependent tasks can't start
+/// before it's finished. Tasks with equal cost keep their queue order, so
+/// that a batch without estimated costs is still run in insertion order.
+class TaskScheduleOrder
+{
+public:
+   /// returns the indices of all given entries, in the order in which the
+   /// tasks should be started
+   static std::vector<size_t> Calculate(const std::vector<TaskScheduleEntry>& entries)
+   {
+      std::vector<double> chainCosts = CalculateChainCosts(entries);
+
+      std::vector<size_t> order(entries.size());
+      for (size_t index = 0; index < order.size(); index++)
+         order[index] = index;
+
+      std::stable_sort(order.begin(), order.end(),
+         [&chainCosts](size_t lhs, size_t rhs)
+      {
+         return chainCosts[lhs] > chainCosts[rhs];
+      });
+
+      return order;
+   }
+
+   /// \brief returns the cost of each entry, plus the cost of the longest
+   /// chain of entries that depend on it
+   /// \details dependent tasks are always added to the queue after the task
+   /// they depend on, so a single pass from the back of the queue is
+   /// sufficient
+   static std::vector<double> CalculateChainCosts(const std::vector<TaskScheduleEntry>& entries)
+   {
+      std::map<unsigned int, size_t> indexById;
+      for (size_t index = 0; index < entries.size(); index++)
+         indexById[entries[index].m_id] = index;
+
+      std::vector<double> chainCosts(entries.size(), 0.0);
+      std::vector<double> maxDependentChainCosts(entries.size(), 0.0);
+
+      for (size_t index = entries.size(); index-- > 0;)
+      {
+         const TaskScheduleEntry& entry = entries[index];
+
+         chainCosts[index] = entry.m_estimatedCost + maxDependentChainCosts[index];
+
+         for (unsigned int dependentTaskId : entry.m_dependentTaskIds)
+         {
+            auto iter = indexById.find(dependentTaskId);
+            if (iter == indexById.end())
+               continue; // already started or finished
+
+            double& maxCost = maxDependentChainCosts[iter->second];
+            maxCost = std::max(maxCost, chainCosts[index]);
+         }
+      }
+
+      return chainCosts;
+   }
+};
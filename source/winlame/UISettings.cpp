@@ -40,6 +40,16 @@ LPCTSTR g_pszActionAfterEncoding = _T("ActionAfterEncoding");
 LPCTSTR g_pszEjectDiscAfterReading = _T("EjectDiscAfterReading");
 LPCTSTR g_pszLastSelectedPresetIndex = _T("LastSelectedPresetIndex");
 LPCTSTR g_pszCdripTempFolder = _T("CDExtractTempFolder");
+LPCTSTR g_pszCdripTempFlac = _T("CDExtractTempFlac");
+LPCTSTR g_pszCdripReadOffset = _T("CDExtractReadOffset");
+LPCTSTR g_pszCdripWriteLog = _T("CDExtractWriteLog");
+LPCTSTR g_pszTranscodeCacheFolder = _T("TranscodeCacheFolder");
+LPCTSTR g_pszTranscodeCacheMaxSize = _T("TranscodeCacheMaxSizeMB");
+LPCTSTR g_pszVerifyOutput = _T("VerifyOutput");
+LPCTSTR g_pszAllowPassThrough = _T("AllowPassThrough");
+LPCTSTR g_pszAdditionalOutputModules = _T("AdditionalOutputModules");
+LPCTSTR g_pszEncodingCostFactors = _T("EncodingCostFactors");
+LPCTSTR g_pszUseWorkerProcesses = _T("UseWorkerProcesses");
 LPCTSTR g_pszOutputPathHistory = _T("OutputPathHistory%02zu");
 LPCTSTR g_pszFreedbServer = _T("FreedbServer");
 LPCTSTR g_pszDiscInfosCdplayerIni = _T("StoreDiscInfosInCdplayerIni");
@@ -73,6 +83,13 @@ UISettings::UISettings()
    m_iLastSelectedPresetIndex(1), // first preset is the "best practice" preset
    last_page_was_cdrip_page(false),
    cdrip_temp_folder(Path::TempFolder()),
+   cdrip_temp_flac(false),
+   cdrip_read_offset(0),
+   cdrip_write_log(true),
+   transcode_cache_max_size_mb(1024),
+   verify_output(false),
+   allow_pass_through(true),
+   use_worker_processes(false),
    freedb_server(_T("gnudb.gnudb.org")),
    store_disc_infos_cdplayer_ini(true),
    cdrip_format_various_track(_T("%track% - %album% - %artist% - %title%")),
@@ -158,6 +175,32 @@ void UISettings::ReadSettings()
    // read "cd extraction temp folder"
    ReadStringValue(regRoot, g_pszCdripTempFolder, MAX_PATH, cdrip_temp_folder);
 
+   // read "cd extraction temp FLAC files" value
+   ReadBooleanValue(regRoot, g_pszCdripTempFlac, cdrip_temp_flac);
+
+   // read "cd extraction read offset" and "write rip log" values
+   ReadIntValue(regRoot, g_pszCdripReadOffset, cdrip_read_offset);
+   ReadBooleanValue(regRoot, g_pszCdripWriteLog, cdrip_write_log);
+
+   // read "transcode cache" values
+   ReadStringValue(regRoot, g_pszTranscodeCacheFolder, MAX_PATH, transcode_cache_folder);
+   ReadUIntValue(regRoot, g_pszTranscodeCacheMaxSize, transcode_cache_max_size_mb);
+
+   // read "verify output" value
+   ReadBooleanValue(regRoot, g_pszVerifyOutput, verify_output);
+
+   // read "allow pass through" value
+   ReadBooleanValue(regRoot, g_pszAllowPassThrough, allow_pass_through);
+
+   // read "additional output modules"
+   ReadStringValue(regRoot, g_pszAdditionalOutputModules, MAX_PATH, additional_output_modules);
+
+   // read "encoding cost factors"
+   ReadStringValue(regRoot, g_pszEncodingCostFactors, MAX_PATH, encoding_cost_factors);
+
+   // read "use worker processes" value
+   ReadBooleanValue(regRoot, g_pszUseWorkerProcesses, use_worker_processes);
+
    // read "freedb server"
    ReadStringValue(regRoot, g_pszFreedbServer, MAX_PATH, freedb_server);
 
@@ -267,6 +310,41 @@ void UISettings::StoreSettings()
    // write cd extraction temp folder
    regRoot.SetValue(cdrip_temp_folder, g_pszCdripTempFolder);
 
+   // write "cd extraction temp FLAC files" value
+   value = cdrip_temp_flac ? 1 : 0;
+   regRoot.SetValue(value, g_pszCdripTempFlac);
+
+   // write cd extraction read offset and "write rip log" value
+   value = cdrip_read_offset;
+   regRoot.SetValue(value, g_pszCdripReadOffset);
+
+   value = cdrip_write_log ? 1 : 0;
+   regRoot.SetValue(value, g_pszCdripWriteLog);
+
+   // write transcode cache values
+   regRoot.SetValue(transcode_cache_folder, g_pszTranscodeCacheFolder);
+
+   value = transcode_cache_max_size_mb;
+   regRoot.SetValue(value, g_pszTranscodeCacheMaxSize);
+
+   // write "verify output" value
+   value = verify_output ? 1 : 0;
+   regRoot.SetValue(value, g_pszVerifyOutput);
+
+   // write "allow pass through" value
+   value = allow_pass_through ? 1 : 0;
+   regRoot.SetValue(value, g_pszAllowPassThrough);
+
+   // write additional output modules
+   regRoot.SetValue(additional_output_modules, g_pszAdditionalOutputModules);
+
+   // write encoding cost factors
+   regRoot.SetValue(encoding_cost_factors, g_pszEncodingCostFactors);
+
+   // write "use worker processes" value
+   value = use_worker_processes ? 1 : 0;
+   regRoot.SetValue(value, g_pszUseWorkerProcesses);
+
    // write freedb server
    regRoot.SetValue(freedb_server, g_pszFreedbServer);
 
@@ -26,6 +26,7 @@
 #include "EncoderInterface.hpp"
 #include "CDReadJob.hpp"
 #include "TaskManagerConfig.hpp"
+#include <map>
 
 namespace Encoder
 {
@@ -71,6 +72,11 @@ struct UISettings
    /// list of CD read jobs
    std::vector<Encoder::CDReadJob> cdreadjoblist;
 
+   /// encoder jobs for the tracks of disc images referenced by cue sheets,
+   /// by lowercase disc image filename; the disc image is encoded as these
+   /// jobs instead of one job for the whole file
+   std::map<CString, EncoderJobList> cuesheet_track_jobs;
+
    /// default encoding settings
    EncodingSettings m_defaultSettings;
 
@@ -114,6 +120,43 @@ struct UISettings
    /// temporary folder for cd ripping
    CString cdrip_temp_folder;
 
+   /// indicates if extracted tracks are stored as FLAC files in the
+   /// temporary folder, instead of wave files
+   bool cdrip_temp_flac;
+
+   /// read offset of the CD drive, in samples; compensated when extracting
+   int cdrip_read_offset;
+
+   /// indicates if a rip log with the checksums of all extracted tracks is
+   /// written to the output folder
+   bool cdrip_write_log;
+
+   /// folder for the transcode cache; empty when the cache is disabled
+   CString transcode_cache_folder;
+
+   /// maximum size of the transcode cache, in MB
+   UINT transcode_cache_max_size_mb;
+
+   /// indicates if encoded output files are decoded again and checked before
+   /// they replace existing files
+   bool verify_output;
+
+   /// indicates if input files may be copied to the output without
+   /// re-encoding, when the output has the same codec and settings
+   bool allow_pass_through;
+
+   /// comma separated list of output module IDs that are encoded in addition
+   /// to the selected output module, from the same decoded input
+   CString additional_output_modules;
+
+   /// cost factors of the output modules, learned from previous encoder
+   /// runs; see EncodingCostModel
+   CString encoding_cost_factors;
+
+   /// indicates if input files are encoded in separate worker processes, so
+   /// that a crashing module doesn't end winLAME
+   bool use_worker_processes;
+
    /// freedb servername
    CString freedb_server;
 
@@ -0,0 +1,289 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerCountController.hpp
+/// \brief controller for the number of active task manager workers
+//
+#pragma once
+
+#include <map>
+#include <algorithm>
+
+/// measurements of the worker pool, taken over one sample interval
+struct WorkerPoolSample
+{
+   /// length of the sample interval, in seconds
+   double m_intervalInSeconds = 0.0;
+
+   /// number of tasks that were waiting for a free worker at the end of the interval
+   unsigned int m_numWaitingTasks = 0;
+
+   /// wall clock time that workers spent running tasks, in seconds
+   double m_busyWorkerSeconds = 0.0;
+
+   /// CPU time used by the workers, in seconds
+   double m_cpuSeconds = 0.0;
+
+   /// work completed in the interval, in number of tasks; includes the
+   /// progress of tasks that are still running
+   double m_completedWork = 0.0;
+};
+
+/// \brief controls the number of active workers, based on measured throughput
+/// \details the controller compares the task throughput measured with
+/// different numbers of workers, and moves to a neighbouring worker count
+/// when that one performed better, or when it wasn't measured yet and the
+/// measured CPU load and I/O wait suggest it could. An additional worker must
+/// add at least a fraction of the average throughput of a worker; this stops
+/// growing when the CPU cores, the disk or the network are saturated. When a
+/// worker was removed since it didn't pay off, the controller continues to
+/// descend until removing a worker costs throughput, e.g. down to the number of
+/// physical cores on SMT machines. Samples where not all workers are busy
+/// aren't used. A change only happens
+/// after several samples in a row agree, and the first sample after a change
+/// is ignored, since it contains the transition. Throughput measurements
+/// expire after a while, so that a changed workload is probed again.
+class WorkerCountController
+{
+public:
+   /// number of samples in a row that must propose the same change
+   static const unsigned int c_numStableSamples = 3;
+
+   /// number of samples after which a throughput measurement expires
+   static const unsigned int c_maxMeasurementAge = 60;
+
+   /// CPU saturation below which more workers are tried
+   static constexpr double c_lowCpuSaturation = 0.85;
+
+   /// CPU saturation above which fewer workers are tried
+   static constexpr double c_highCpuSaturation = 0.95;
+
+   /// fraction of busy time spent waiting for I/O, above which more workers are tried
+   static constexpr double c_highIoWaitRatio = 0.3;
+
+   /// minimum fraction of the average per-worker throughput that an
+   /// additional worker must add
+   static constexpr double c_minWorkerGain = 0.5;
+
+   /// fraction of the sample interval that all workers must be busy, for the
+   /// sample to be used
+   static constexpr double c_minBusyRatio = 0.9;
+
+   /// ctor
+   WorkerCountController(unsigned int minWorkers, unsigned int maxWorkers,
+      unsigned int initialWorkers, unsigned int numCpus)
+      :m_minWorkers(std::max(1U, minWorkers)),
+      m_maxWorkers(std::max(m_minWorkers, maxWorkers)),
+      m_numWorkers(std::min(std::max(initialWorkers, m_minWorkers), m_maxWorkers)),
+      m_numCpus(std::max(1U, numCpus)),
+      m_sampleIndex(0),
+      m_numSettleSamples(1),
+      m_isDescending(false),
+      m_proposedChange(0),
+      m_numProposedSamples(0)
+   {
+   }
+
+   /// returns current number of workers
+   unsigned int NumWorkers() const { return m_numWorkers; }
+
+   /// returns lower bound of number of workers
+   unsigned int MinWorkers() const { return m_minWorkers; }
+
+   /// returns upper bound of number of workers
+   unsigned int MaxWorkers() const { return m_maxWorkers; }
+
+   /// processes a new sample and returns the new number of workers
+   unsigned int Update(const WorkerPoolSample& sample)
+   {
+      m_sampleIndex++;
+
+      if (m_numSettleSamples > 0)
+      {
+         m_numSettleSamples--;
+         return m_numWorkers;
+      }
+
+      if (sample.m_intervalInSeconds <= 0.0)
+         return m_numWorkers;
+
+      // a pool that isn't fully used says nothing about the best worker count
+      if (sample.m_numWaitingTasks == 0 &&
+         sample.m_busyWorkerSeconds < c_minBusyRatio * sample.m_intervalInSeconds * m_numWorkers)
+      {
+         ResetProposal();
+         return m_numWorkers;
+      }
+
+      StoreThroughput(sample.m_completedWork / sample.m_intervalInSeconds);
+
+      bool isDescent = false;
+      int change = ProposeChange(sample, isDescent);
+
+      if (change == 0 || change != m_proposedChange)
+      {
+         m_proposedChange = change;
+         m_numProposedSamples = change == 0 ? 0 : 1;
+      }
+      else
+         m_numProposedSamples++;
+
+      if (m_proposedChange != 0 &&
+         m_numProposedSamples >= c_numStableSamples)
+      {
+         m_numWorkers = static_cast<unsigned int>(static_cast<int>(m_numWorkers) + m_proposedChange);
+         m_isDescending = isDescent;
+
+         ResetProposal();
+         m_numSettleSamples = 1;
+      }
+
+      return m_numWorkers;
+   }
+
+private:
+   /// throughput measured with a specific number of workers
+   struct Measurement
+   {
+      double m_throughput = 0.0;       ///< average throughput, in tasks per second
+      unsigned int m_numSamples = 0;   ///< number of samples averaged
+      unsigned int m_lastSample = 0;   ///< index of last sample
+   };
+
+   /// stores throughput for the current number of workers
+   void StoreThroughput(double throughput)
+   {
+      Measurement& measurement = m_measurements[m_numWorkers];
+
+      if (IsExpired(measurement))
+         measurement = Measurement();
+
+      // running average over the samples taken at this worker count
+      measurement.m_numSamples++;
+      measurement.m_throughput += (throughput - measurement.m_throughput) / measurement.m_numSamples;
+      measurement.m_lastSample = m_sampleIndex;
+   }
+
+   /// returns if a measurement is too old to be used
+   bool IsExpired(const Measurement& measurement) const
+   {
+      return measurement.m_numSamples == 0 ||
+         m_sampleIndex - measurement.m_lastSample > c_maxMeasurementAge;
+   }
+
+   /// returns measured throughput for given number of workers, or a negative
+   /// value when not measured
+   double Throughput(unsigned int numWorkers) const
+   {
+      auto iter = m_measurements.find(numWorkers);
+      if (iter == m_measurements.end() || IsExpired(iter->second))
+         return -1.0;
+
+      return iter->second.m_throughput;
+   }
+
+   /// proposes a change of the number of workers: -1, 0 or +1; isDescent is
+   /// set when fewer workers are proposed, since the last worker didn't pay off
+   int ProposeChange(const WorkerPoolSample& sample, bool& isDescent) const
+   {
+      double cpuSaturation = sample.m_cpuSeconds / (sample.m_intervalInSeconds * m_numCpus);
+
+      double ioWaitRatio = sample.m_busyWorkerSeconds > 0.0
+         ? 1.0 - sample.m_cpuSeconds / sample.m_busyWorkerSeconds
+         : 0.0;
+
+      double current = Throughput(m_numWorkers);
+      double fewer = m_numWorkers > m_minWorkers ? Throughput(m_numWorkers - 1) : -1.0;
+      double more = m_numWorkers < m_maxWorkers ? Throughput(m_numWorkers + 1) : -1.0;
+
+      // the last worker added didn't pay off
+      if (fewer >= 0.0 && current < fewer * (1.0 + c_minWorkerGain / (m_numWorkers - 1)))
+      {
+         isDescent = true;
+         return -1;
+      }
+
+      // no more workers are needed when no task is waiting
+      bool canGrow = m_numWorkers < m_maxWorkers && sample.m_numWaitingTasks > 0;
+
+      if (canGrow && more >= 0.0 && more >= current * (1.0 + c_minWorkerGain / m_numWorkers))
+         return +1;
+
+      // continue descending, since the next worker may not pay off either;
+      // when it did, the rule above moves back up again
+      if (m_isDescending && m_numWorkers > m_minWorkers && fewer < 0.0)
+      {
+         isDescent = true;
+         return -1;
+      }
+
+      // probe unknown worker counts, based on CPU load and I/O wait
+      if (canGrow && more < 0.0 &&
+         (cpuSaturation < c_lowCpuSaturation || ioWaitRatio > c_highIoWaitRatio))
+         return +1;
+
+      // probe fewer workers when the CPUs are saturated; when the probe shows
+      // that the removed worker didn't pay off, the descent continues
+      if (m_numWorkers > m_minWorkers && fewer < 0.0 &&
+         cpuSaturation > c_highCpuSaturation && ioWaitRatio <= c_highIoWaitRatio)
+      {
+         isDescent = true;
+         return -1;
+      }
+
+      return 0;
+   }
+
+   /// resets proposed change
+   void ResetProposal()
+   {
+      m_proposedChange = 0;
+      m_numProposedSamples = 0;
+   }
+
+private:
+   /// minimum number of workers
+   unsigned int m_minWorkers;
+
+   /// maximum number of workers
+   unsigned int m_maxWorkers;
+
+   /// current number of workers
+   unsigned int m_numWorkers;
+
+   /// number of logical CPUs
+   unsigned int m_numCpus;
+
+   /// index of current sample
+   unsigned int m_sampleIndex;
+
+   /// number of samples to ignore before measuring again
+   unsigned int m_numSettleSamples;
+
+   /// indicates if the last change removed a worker, and further workers may be removed
+   bool m_isDescending;
+
+   /// currently proposed change
+   int m_proposedChange;
+
+   /// number of samples in a row that proposed the change
+   unsigned int m_numProposedSamples;
+
+   /// throughput measurements, by number of workers
+   std::map<unsigned int, Measurement> m_measurements;
+};
@@ -25,6 +25,7 @@
 #include "ClassicModeStartPage.hpp"
 #include <ulib/IoCContainer.hpp>
 #include "TaskManager.hpp"
+#include "BatchJournal.hpp"
 
 using namespace UI;
 
@@ -113,6 +114,9 @@ LRESULT ClassicModeEncoderPage::OnButtonBack(WORD /*wNotifyCode*/, WORD /*wID*/,
    m_taskManager.StopAll();
    m_taskManager.RemoveCompletedTasks();
 
+   // the stopped jobs aren't resumed on the next start
+   IoCContainer::Current().Resolve<Encoder::BatchJournal>().FinishBatch();
+
    // since all files are finished, go back to start page
    m_pageHost.SetWizardPage(std::make_shared<ClassicModeStartPage>(m_pageHost));
 
@@ -123,6 +127,9 @@ LRESULT ClassicModeEncoderPage::OnTasksStopAll(WORD /*wNotifyCode*/, WORD /*wID*
 {
    m_taskManager.StopAll();
 
+   // the stopped jobs aren't resumed on the next start
+   IoCContainer::Current().Resolve<Encoder::BatchJournal>().FinishBatch();
+
    return 0;
 }
 
@@ -22,10 +22,7 @@
 //
 #include "stdafx.h"
 #include "resource.h"
-#include <fstream>
 #include "AacInputModule.hpp"
-#include <sys/types.h>
-#include <sys/stat.h>
 #include <ulib/DynamicLibrary.hpp>
 #include "AudioFileTag.hpp"
 #include "ChannelRemapper.hpp"
@@ -149,10 +146,10 @@ int AacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    TrackInfo& trackInfo, SampleContainer& samples)
 {
    // open infile
-   m_inputFile.open(infilename, std::ios::in | std::ios::binary);
-   if (!m_inputFile.is_open())
+   if (!m_inputFile.Open(infilename))
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
       return -1;
    }
 
@@ -167,9 +164,7 @@ int AacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    }
 
    // find out length of aac file
-   struct _stat64 statbuf = {};
-   ::_tstat64(infilename, &statbuf);
-   m_inputFileLength = statbuf.st_size;
+   m_inputFileLength = m_inputFile.Length();
    m_currentFilePos = 0;
 
    // search for begin of aac stream, skipping id3v2 tags; modifies m_currentFilePos
@@ -180,7 +175,7 @@ int AacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    tag.ReadFromFile(infilename);
 
    // seek to begin
-   m_inputFile.seekg(m_currentFilePos, std::ios::beg);
+   m_inputFile.Seek(static_cast<LONGLONG>(m_currentFilePos), SEEK_SET);
 
    // grab decoder instance
    m_decoder = NeAACDecOpen();
@@ -194,7 +189,7 @@ int AacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    }
 
    // read first frame(s) and get infos about the aac file
-   m_inputFile.read(reinterpret_cast<char*>(m_inputBuffer), c_aacInputBufferSize);
+   m_inputFile.Read(m_inputBuffer, c_aacInputBufferSize);
 
    unsigned long samplerate = 0;
    unsigned char channels = 0;
@@ -210,7 +205,7 @@ int AacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
 
    // seek to the next start
    m_currentFilePos += result;
-   m_inputFile.seekg(m_currentFilePos, std::ios::beg);
+   m_inputFile.Seek(static_cast<LONGLONG>(m_currentFilePos), SEEK_SET);
 
    // get right file info (for HE AAC files)
    NeAACDecFrameInfo frameInfo{};
@@ -257,11 +252,9 @@ int AacInputModule::DecodeSamples(SampleContainer& samples)
    // fill input buffer
    if (m_inputBufferHigh < c_aacInputBufferSize)
    {
-      m_inputFile.read(
-         reinterpret_cast<char*>(m_inputBuffer + m_inputBufferHigh),
-         std::streamsize(c_aacInputBufferSize) - m_inputBufferHigh);
-
-      int read = static_cast<int>(m_inputFile.gcount());
+      int read = static_cast<int>(m_inputFile.Read(
+         m_inputBuffer + m_inputBufferHigh,
+         size_t(c_aacInputBufferSize) - m_inputBufferHigh));
 
       if (read == 0 && m_inputBufferHigh == 0)
          return 0;
@@ -310,5 +303,5 @@ int AacInputModule::DecodeSamples(SampleContainer& samples)
 void AacInputModule::DoneInput()
 {
    NeAACDecClose(m_decoder);
-   m_inputFile.close();
+   m_inputFile.Close();
 }
@@ -23,7 +23,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
-#include <iosfwd>
+#include "BufferedInputFile.hpp"
 #include "neaacdec.h"
 
 extern "C"
@@ -110,8 +110,8 @@ namespace Encoder
       /// aac file info
       faadAACInfo m_info;
 
-      /// input file stream
-      std::ifstream m_inputFile;
+      /// input file
+      BufferedInputFile m_inputFile;
 
       /// last error occured
       CString m_lastError;
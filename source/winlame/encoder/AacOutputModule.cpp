@@ -21,7 +21,6 @@
 /// \brief contains the implementation of the AAC output module
 //
 #include "stdafx.h"
-#include <fstream>
 #include "resource.h"
 #include "AacOutputModule.hpp"
 #include "neaacdec.h"
@@ -83,8 +82,12 @@ int AacOutputModule::InitOutput(LPCTSTR outfilename,
    SettingsManager& mgr, const TrackInfo& trackInfo,
    SampleContainer& samples)
 {
-   m_outputFile.open(outfilename, std::ios::out | std::ios::binary);
-   if (!m_outputFile.is_open())
+   // estimate output size when encoding with a bitrate
+   unsigned int bytesPerSecond = 0;
+   if (mgr.QueryValueInt(AacBRCMethod) != 0)
+      bytesPerSecond = static_cast<unsigned int>(mgr.QueryValueInt(AacBitrate)) * 1000 / 8;
+
+   if (!m_outputFile.Open(outfilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
    {
       m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
       return -1;
@@ -141,14 +144,12 @@ int AacOutputModule::InitOutput(LPCTSTR outfilename,
       m_params.bit_rate = mgr.QueryValueInt(AacBitrate) * 1000 / m_params.num_channels;
    }
 
-   // channel remap
-   size_t maxChannelIndex = std::min<size_t>(
-      m_params.num_channels,
-      ChannelRemapper::GetMaxMappedChannel());
+   // channel remap; channels that can't be mapped are passed through
+   size_t numChannels = m_params.num_channels;
 
-   std::vector< int32_t> channelMap(maxChannelIndex);
+   std::vector< int32_t> channelMap(numChannels);
 
-   for (size_t channelIndex = 0; channelIndex < maxChannelIndex; channelIndex++)
+   for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
    {
       channelMap[channelIndex] = (int32_t)ChannelRemapper::GetMappedChannel(
          T_enChannelMapType::aacOutputChannelMap,
@@ -266,9 +267,7 @@ int AacOutputModule::EncodeAndWrite(unsigned long inputBufferSize)
    // write the output buffer
    if (bytesWritten > 0)
    {
-      m_outputFile.write(
-         reinterpret_cast<char*>(m_outputBuffer.data()),
-         bytesWritten);
+      m_outputFile.Write(m_outputBuffer.data(), bytesWritten);
    }
 
    m_sampleBufferHigh = 0;
@@ -297,12 +296,10 @@ void AacOutputModule::DoneOutput()
       &bytesWritten) >= FAAC_OK &&
       bytesWritten > 0)
    {
-      m_outputFile.write(
-         reinterpret_cast<char*>(m_outputBuffer.data()),
-         bytesWritten);
+      m_outputFile.Write(m_outputBuffer.data(), bytesWritten);
    }
 
-   m_outputFile.close();
+   m_outputFile.Close();
 
    m_handle.reset();
 }
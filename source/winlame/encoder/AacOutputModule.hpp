@@ -23,7 +23,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
-#include <iosfwd>
+#include "BufferedOutputFile.hpp"
 #include "faac.h"
 
 namespace Encoder
@@ -92,8 +92,8 @@ namespace Encoder
       /// bitrate control method
       int m_bitrateControlMethod = 0;
 
-      /// output file stream
-      std::ofstream m_outputFile;
+      /// output file
+      BufferedOutputFile m_outputFile;
 
       /// last error occured
       CString m_lastError;
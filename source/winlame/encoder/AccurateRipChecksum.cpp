@@ -0,0 +1,159 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file AccurateRipChecksum.cpp
+/// \brief AccurateRip and CRC32 checksums of CD audio tracks
+//
+#include "stdafx.h"
+#include "AccurateRipChecksum.hpp"
+#include <algorithm>
+#include <array>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ACCURATERIP_USE_SSE2
+#endif
+
+using Encoder::AccurateRipChecksum;
+
+/// number of samples left out at the start of the first track and at the
+/// end of the last track
+static const uint32_t c_numSkippedSamples = 5 * AccurateRipChecksum::c_samplesPerFrame;
+
+/// returns CRC32 lookup table, for the reversed polynomial 0xEDB88320
+static const std::array<uint32_t, 256>& GetCrc32Table()
+{
+   static const std::array<uint32_t, 256> s_table = []()
+   {
+      std::array<uint32_t, 256> table = {};
+      for (uint32_t index = 0; index < 256; index++)
+      {
+         uint32_t value = index;
+         for (int bit = 0; bit < 8; bit++)
+            value = (value & 1) != 0 ? (value >> 1) ^ 0xEDB88320U : value >> 1;
+
+         table[index] = value;
+      }
+
+      return table;
+   }();
+
+   return s_table;
+}
+
+AccurateRipChecksum::AccurateRipChecksum(bool isFirstTrack, bool isLastTrack, uint32_t numTrackSamples)
+   :m_checkStart(isFirstTrack ? c_numSkippedSamples : 1),
+   m_checkEnd(numTrackSamples),
+   m_numSamples(0),
+   m_sumLow(0),
+   m_sumHigh(0),
+   m_crc32(0xFFFFFFFFU)
+{
+   if (isLastTrack)
+      m_checkEnd = numTrackSamples > c_numSkippedSamples ? numTrackSamples - c_numSkippedSamples : 0;
+}
+
+void AccurateRipChecksum::Add(const int16_t* samples, size_t numSamples)
+{
+   AddCrc32(reinterpret_cast<const uint8_t*>(samples), numSamples * 4);
+
+   // each stereo sample is used as 32 bit value, left channel in the low word;
+   // the multiplier is the 1-based position of the sample in the track
+   uint32_t firstMultiplier = m_numSamples + 1;
+   uint32_t lastMultiplier = m_numSamples + static_cast<uint32_t>(numSamples);
+
+   uint32_t start = std::max(firstMultiplier, m_checkStart);
+   uint32_t end = std::min(lastMultiplier, m_checkEnd);
+
+   if (numSamples > 0 && start <= end)
+   {
+      const uint32_t* stereoSamples = reinterpret_cast<const uint32_t*>(samples);
+      AddAccurateRip(stereoSamples + (start - firstMultiplier), end - start + 1, start);
+   }
+
+   m_numSamples += static_cast<uint32_t>(numSamples);
+}
+
+uint32_t AccurateRipChecksum::GetChecksumV1() const
+{
+   return m_sumLow;
+}
+
+uint32_t AccurateRipChecksum::GetChecksumV2() const
+{
+   return m_sumLow + m_sumHigh;
+}
+
+void AccurateRipChecksum::AddAccurateRip(const uint32_t* samples, size_t numSamples, uint32_t multiplier)
+{
+   uint32_t sumLow = m_sumLow;
+   uint32_t sumHigh = m_sumHigh;
+
+   size_t index = 0;
+
+#ifdef ACCURATERIP_USE_SSE2
+   // calculates the 64 bit products of four samples at a time; the even
+   // lanes of the sums collect the low, the odd lanes the high 32 bits
+   __m128i sums = _mm_setzero_si128();
+   __m128i multipliers = _mm_set_epi32(
+      static_cast<int>(multiplier + 3), static_cast<int>(multiplier + 2),
+      static_cast<int>(multiplier + 1), static_cast<int>(multiplier));
+   const __m128i increment = _mm_set1_epi32(4);
+
+   for (; index + 4 <= numSamples; index += 4)
+   {
+      __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+
+      __m128i productsEven = _mm_mul_epu32(values, multipliers);
+      __m128i productsOdd = _mm_mul_epu32(_mm_srli_epi64(values, 32), _mm_srli_epi64(multipliers, 32));
+
+      sums = _mm_add_epi32(sums, _mm_add_epi32(productsEven, productsOdd));
+      multipliers = _mm_add_epi32(multipliers, increment);
+   }
+
+   uint32_t lanes[4];
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+
+   sumLow += lanes[0] + lanes[2];
+   sumHigh += lanes[1] + lanes[3];
+
+   multiplier += static_cast<uint32_t>(index);
+#endif
+
+   for (; index < numSamples; index++, multiplier++)
+   {
+      uint64_t product = uint64_t(samples[index]) * multiplier;
+
+      sumLow += static_cast<uint32_t>(product);
+      sumHigh += static_cast<uint32_t>(product >> 32);
+   }
+
+   m_sumLow = sumLow;
+   m_sumHigh = sumHigh;
+}
+
+void AccurateRipChecksum::AddCrc32(const uint8_t* data, size_t length)
+{
+   const std::array<uint32_t, 256>& table = GetCrc32Table();
+
+   uint32_t crc = m_crc32;
+   for (size_t index = 0; index < length; index++)
+      crc = table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+
+   m_crc32 = crc;
+}
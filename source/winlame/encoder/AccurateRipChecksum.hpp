@@ -0,0 +1,89 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file AccurateRipChecksum.hpp
+/// \brief AccurateRip and CRC32 checksums of CD audio tracks
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Encoder
+{
+   /// \brief calculates AccurateRip v1, v2 and CRC32 checksums of a CD audio track
+   /// \details the checksums are calculated while the track is extracted,
+   /// block by block, from 16 bit stereo samples, as read from the CD. The
+   /// AccurateRip checksums leave out the first 5 frames of the first track
+   /// and the last 5 frames of the last track, since the read offset of
+   /// most drives doesn't allow reading them. The class only uses standard
+   /// C++, so that it can be tested on other platforms, too.
+   class AccurateRipChecksum
+   {
+   public:
+      /// number of stereo samples per CD frame
+      static const unsigned int c_samplesPerFrame = 588;
+
+      /// ctor; takes the track's position on the disc and its length in
+      /// stereo samples, which determine the samples that are left out
+      AccurateRipChecksum(bool isFirstTrack, bool isLastTrack, uint32_t numTrackSamples);
+
+      /// adds interleaved 16 bit stereo samples; numSamples is the number of
+      /// stereo samples
+      void Add(const int16_t* samples, size_t numSamples);
+
+      /// returns number of stereo samples added so far
+      uint32_t GetNumSamples() const { return m_numSamples; }
+
+      /// returns AccurateRip v1 checksum
+      uint32_t GetChecksumV1() const;
+
+      /// returns AccurateRip v2 checksum
+      uint32_t GetChecksumV2() const;
+
+      /// returns CRC32 over all samples, as used by EAC's "copy CRC"
+      uint32_t GetCrc32() const { return ~m_crc32; }
+
+   private:
+      /// adds samples to the AccurateRip checksums, starting with given multiplier
+      void AddAccurateRip(const uint32_t* samples, size_t numSamples, uint32_t multiplier);
+
+      /// adds bytes to the CRC32
+      void AddCrc32(const uint8_t* data, size_t length);
+
+   private:
+      /// first sample multiplier that is part of the AccurateRip checksums
+      uint32_t m_checkStart;
+
+      /// last sample multiplier that is part of the AccurateRip checksums
+      uint32_t m_checkEnd;
+
+      /// number of stereo samples added so far
+      uint32_t m_numSamples;
+
+      /// sum of the low 32 bits of all products of sample and multiplier
+      uint32_t m_sumLow;
+
+      /// sum of the high 32 bits of all products of sample and multiplier
+      uint32_t m_sumHigh;
+
+      /// CRC32 value, not yet inverted
+      uint32_t m_crc32;
+   };
+
+} // namespace Encoder
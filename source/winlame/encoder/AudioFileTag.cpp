@@ -344,6 +344,41 @@ bool AudioFileTag::WriteToFile(const CString& filename, AudioFileType audioFileT
    if (spFileRef == nullptr || spFileRef->isNull())
       return false;
 
+   return StoreTrackInfoInFile(spFileRef);
+}
+
+bool AudioFileTag::ReplaceInFile(const CString& filename, AudioFileType audioFileType) const
+{
+   std::shared_ptr<TagLib::FileRef> spFileRef = OpenFile(filename, audioFileType);
+
+   if (spFileRef == nullptr || spFileRef->isNull())
+      return false;
+
+   RemoveAllTagInfos(spFileRef);
+
+   return StoreTrackInfoInFile(spFileRef);
+}
+
+void AudioFileTag::RemoveAllTagInfos(std::shared_ptr<TagLib::FileRef> spFileRef)
+{
+   // removes all text infos of all tag types the file contains
+   spFileRef->file()->setProperties(TagLib::PropertyMap());
+
+   TagLib::ID3v2::Tag* id3v2tag = FindId3v2Tag(spFileRef);
+   if (id3v2tag != nullptr)
+      id3v2tag->removeFrames(TagLib::ByteVector::fromCString("APIC"));
+
+   TagLib::Ogg::XiphComment* oggXiphComment = FindOggXiphCommentTag(spFileRef);
+   if (oggXiphComment != nullptr)
+      oggXiphComment->removeAllPictures();
+
+   TagLib::FLAC::File* flacFile = dynamic_cast<TagLib::FLAC::File*>(spFileRef->file());
+   if (flacFile != nullptr)
+      flacFile->removePictures();
+}
+
+bool AudioFileTag::StoreTrackInfoInFile(std::shared_ptr<TagLib::FileRef> spFileRef) const
+{
    TagLib::Tag* tag = spFileRef->file()->tag();
    if (tag == nullptr)
       return false;
@@ -76,6 +76,10 @@ namespace Encoder
       /// stores TrackInfo data to tag infos in audio file
       bool WriteToFile(const CString& filename, AudioFileType audioFileType = AudioFileType::FromExtension) const;
 
+      /// replaces all tag infos in audio file with TrackInfo data; tag infos
+      /// that are not in the TrackInfo are removed, e.g. when re-tagging a copy
+      bool ReplaceInFile(const CString& filename, AudioFileType audioFileType = AudioFileType::FromExtension) const;
+
       /// returns TagLib version number
       static CString GetTagLibVersion();
 
@@ -89,6 +93,12 @@ namespace Encoder
       /// finds Ogg comment tag in given file, if available
       static TagLib::Ogg::XiphComment* FindOggXiphCommentTag(std::shared_ptr<TagLib::FileRef> spFile);
 
+      /// removes all tag infos, including pictures, from given file
+      static void RemoveAllTagInfos(std::shared_ptr<TagLib::FileRef> spFile);
+
+      /// stores all track infos in the tags of given file and saves the file
+      bool StoreTrackInfoInFile(std::shared_ptr<TagLib::FileRef> spFile) const;
+
       /// reads all track infos from tag
       void ReadTrackInfoFromTag(TagLib::Tag* tag);
 
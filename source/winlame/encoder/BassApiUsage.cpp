@@ -0,0 +1,65 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BassApiUsage.cpp
+/// \brief reference counted initialization of the BASS API
+//
+#include "stdafx.h"
+#include "BassApiUsage.hpp"
+#include "bass.h"
+#include <mutex>
+
+using Encoder::BassApiUsage;
+
+/// mutex protecting the BASS API usage count
+static std::mutex s_mutexBassApiUsage;
+
+/// number of users of the BASS API
+static unsigned int s_bassApiUsageCount = 0;
+
+bool BassApiUsage::Init(DWORD samplerateInHz)
+{
+   if (m_initialized)
+      return true;
+
+   std::unique_lock<std::mutex> lock(s_mutexBassApiUsage);
+
+   // setup output - "no sound" device, stereo, 16 bits
+   if (s_bassApiUsageCount == 0 &&
+      !BASS_Init(0, samplerateInHz, 0, nullptr, nullptr))
+      return false;
+
+   s_bassApiUsageCount++;
+   m_initialized = true;
+
+   return true;
+}
+
+void BassApiUsage::Free()
+{
+   if (!m_initialized)
+      return;
+
+   std::unique_lock<std::mutex> lock(s_mutexBassApiUsage);
+
+   ATLASSERT(s_bassApiUsageCount > 0);
+   if (--s_bassApiUsageCount == 0)
+      BASS_Free();
+
+   m_initialized = false;
+}
@@ -0,0 +1,64 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BassApiUsage.hpp
+/// \brief reference counted initialization of the BASS API
+//
+#pragma once
+
+namespace Encoder
+{
+   /// \brief usage of the BASS API
+   /// \details BASS_Init() and BASS_Free() initialize and free the "no sound"
+   /// device for the whole process. Every user of the BASS API holds a
+   /// BassApiUsage object; the first user calls BASS_Init(), and the last
+   /// user calls BASS_Free(). Both calls are serialized, so that no thread
+   /// can free the device while another thread initializes or uses it.
+   class BassApiUsage
+   {
+   public:
+      /// ctor
+      BassApiUsage()
+         :m_initialized(false)
+      {
+      }
+
+      /// dtor; frees BASS API usage when still initialized
+      ~BassApiUsage()
+      {
+         Free();
+      }
+
+      /// deleted copy ctor
+      BassApiUsage(const BassApiUsage&) = delete;
+      /// deleted copy assignment operator
+      BassApiUsage& operator=(const BassApiUsage&) = delete;
+
+      /// initializes BASS API, when no other user did so already; returns
+      /// false when BASS couldn't be initialized
+      bool Init(DWORD samplerateInHz = 44100);
+
+      /// frees BASS API usage; BASS is freed when this was the last user
+      void Free();
+
+   private:
+      /// indicates if this object initialized the BASS API
+      bool m_initialized;
+   };
+
+} // namespace Encoder
@@ -34,9 +34,6 @@ using Encoder::BassInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
 
-/// BASS API usage count
-std::atomic<unsigned int> s_bassApiusageCount = { 0 };
-
 // constants
 
 /// name of WMA picture tag
@@ -151,14 +148,10 @@ int BassInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    // not playing anything, so don't need an update thread
    BASS_SetConfig(BASS_CONFIG_UPDATEPERIOD, 0);
 
-   // setup output - "no sound" device, 44100hz, stereo, 16 bits
-   if (s_bassApiusageCount++ == 0)
+   if (!m_bassApiUsage.Init())
    {
-      if (!BASS_Init(0, 44100, 0, 0, nullptr))
-      {
-         m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_DECODER);
-         return -1;
-      }
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_DECODER);
+      return -1;
    }
 
    // try streaming the file/url
@@ -357,10 +350,7 @@ float BassInputModule::PercentDone() const
 
 void BassInputModule::DoneInput()
 {
-   if (--s_bassApiusageCount == 0)
-   {
-      BASS_Free();
-   }
+   m_bassApiUsage.Free();
 
    delete[] m_buffer;
 }
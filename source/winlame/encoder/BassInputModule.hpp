@@ -25,6 +25,7 @@
 #include "ModuleInterface.hpp"
 #include "bass.h"
 #include "basswma.h"
+#include "BassApiUsage.hpp"
 
 namespace Encoder
 {
@@ -106,6 +107,9 @@ namespace Encoder
 
       /// channel handle
       DWORD m_channel;
+
+      /// BASS API usage
+      BassApiUsage m_bassApiUsage;
    };
 
 } // namespace Encoder
@@ -32,8 +32,6 @@ using Encoder::BassWmaOutputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
 
-extern std::atomic<unsigned int> s_bassApiusageCount;
-
 BassWmaOutputModule::BassWmaOutputModule()
    :m_handle(0),
    m_samplerateInHz(0),
@@ -117,14 +115,10 @@ int BassWmaOutputModule::InitOutput(LPCTSTR outfilename,
    // not playing anything, so don't need an update thread
    BASS_SetConfig(BASS_CONFIG_UPDATEPERIOD, 0);
 
-   // setup output - "no sound" device, 44100hz, stereo, 16 bits
-   if (s_bassApiusageCount++ == 0)
+   if (!m_bassApiUsage.Init(m_samplerateInHz))
    {
-      if (!BASS_Init(0, m_samplerateInHz, 0, 0, NULL))
-      {
-         m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
-         return -1;
-      }
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      return -1;
    }
 
    // find nearest valid bitrate
@@ -216,10 +210,7 @@ void BassWmaOutputModule::DoneOutput()
 {
    BASS_WMA_EncodeClose(m_handle);
 
-   if (--s_bassApiusageCount == 0)
-   {
-      BASS_Free();
-   }
+   m_bassApiUsage.Free();
 }
 
 void BassWmaOutputModule::AddTrackInfo(const TrackInfo& trackInfo)
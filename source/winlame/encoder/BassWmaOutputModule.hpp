@@ -25,6 +25,7 @@
 #include "ModuleInterface.hpp"
 #include "bass.h"
 #include "basswma.h"
+#include "BassApiUsage.hpp"
 
 namespace Encoder
 {
@@ -89,6 +90,9 @@ namespace Encoder
 
       /// bitrate mode
       WmaBitrateMode m_bitrateMode = WmaBitrateMode::CBR;
+
+      /// BASS API usage
+      BassApiUsage m_bassApiUsage;
    };
 
 } // namespace Encoder
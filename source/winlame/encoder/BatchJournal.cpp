@@ -0,0 +1,407 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BatchJournal.cpp
+/// \brief journal of encoding jobs, used to resume an interrupted batch
+//
+#include "stdafx.h"
+#include "BatchJournal.hpp"
+#include <ulib/Path.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
+
+using Encoder::BatchJournal;
+
+/// file extension of journal files
+static LPCTSTR c_journalFileExtension = _T(".journal");
+
+/// interval in which the journal file is flushed to disk; the records are
+/// written to the file immediately, so that they survive a crash of winLAME,
+/// but writing them through to the disk is only necessary to survive a
+/// system crash, and is done less often
+static const ULONGLONG c_flushIntervalInMilliseconds = 1000;
+
+/// a job, as read from a journal file
+struct JournalJob
+{
+   CString m_inputFilename;               ///< input filename
+   bool m_hasRange = false;               ///< indicates if a range of the input file is encoded
+   bool m_finished = false;               ///< indicates if the job was finished
+   std::vector<CString> m_tempFilenames;  ///< temporary files of the job
+   std::vector<CString> m_outputFilenames;///< output files written by the job
+   std::vector<ULONGLONG> m_outputFileSizes;///< sizes of the output files, when they were written
+};
+
+/// reads size of a file; returns false when the file doesn't exist
+static bool ReadFileSize(const CString& filename, ULONGLONG& fileSize)
+{
+   WIN32_FILE_ATTRIBUTE_DATA data = {};
+   if (!GetFileAttributesEx(filename, GetFileExInfoStandard, &data))
+      return false;
+
+   fileSize = (static_cast<ULONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+   return true;
+}
+
+/// converts string to UTF-8, for writing a record
+static CStringA ToRecordText(const CString& text)
+{
+   return CStringA(CT2A(text, CP_UTF8));
+}
+
+/// converts UTF-8 text of a record to string
+static CString FromRecordText(const CStringA& text)
+{
+   return CString(CA2T(text, CP_UTF8));
+}
+
+/// splits journal record into tab separated fields
+static std::vector<CStringA> SplitRecord(const CStringA& record)
+{
+   std::vector<CStringA> fields;
+
+   int start = 0;
+   for (;;)
+   {
+      int pos = record.Find('\t', start);
+      if (pos == -1)
+      {
+         fields.push_back(record.Mid(start));
+         break;
+      }
+
+      fields.push_back(record.Mid(start, pos - start));
+      start = pos + 1;
+   }
+
+   return fields;
+}
+
+BatchJournal::BatchJournal(const CString& journalFolder)
+   :m_journalFolder(journalFolder),
+   m_journalFile(INVALID_HANDLE_VALUE),
+   m_journalFileCounter(0),
+   m_lastJobId(0),
+   m_lastFlushTickCount(0)
+{
+}
+
+BatchJournal::~BatchJournal()
+{
+   // the journal file is kept, so that the unfinished jobs can be resumed
+   if (m_journalFile != INVALID_HANDLE_VALUE)
+   {
+      FlushFileBuffers(m_journalFile);
+      CloseHandle(m_journalFile);
+   }
+}
+
+unsigned int BatchJournal::AddJob(const CString& inputFilename, bool hasRange)
+{
+   if (!IsEnabled())
+      return 0;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (m_journalFile == INVALID_HANDLE_VALUE)
+   {
+      if (!Path::FolderExists(m_journalFolder))
+         Path::CreateDirectoryRecursive(m_journalFolder);
+
+      // the file is only shared for reading, so that other winLAME
+      // instances don't recover jobs of a batch that is still running
+      m_journalFilename.Format(_T("batch-%u-%u%s"),
+         GetCurrentProcessId(), ++m_journalFileCounter, c_journalFileExtension);
+      m_journalFilename = Path::Combine(m_journalFolder, m_journalFilename);
+
+      m_journalFile = CreateFile(m_journalFilename, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+         CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+      if (m_journalFile == INVALID_HANDLE_VALUE)
+      {
+         ATLTRACE(_T("BatchJournal: couldn't create journal file %s, error %u\n"),
+            m_journalFilename.GetString(), GetLastError());
+         return 0;
+      }
+
+      m_lastFlushTickCount = GetTickCount64();
+   }
+
+   unsigned int jobId = ++m_lastJobId;
+   m_unfinishedJobIds.insert(jobId);
+
+   CStringA record;
+   record.Format("J\t%u\t%d\t", jobId, hasRange ? 1 : 0);
+   record += ToRecordText(inputFilename);
+
+   WriteRecord(record);
+
+   return jobId;
+}
+
+void BatchJournal::StartJob(unsigned int jobId)
+{
+   if (jobId == 0)
+      return;
+
+   CStringA record;
+   record.Format("S\t%u", jobId);
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   WriteRecord(record);
+}
+
+void BatchJournal::AddTempFile(unsigned int jobId, const CString& tempFilename)
+{
+   if (jobId == 0)
+      return;
+
+   CStringA record;
+   record.Format("T\t%u\t", jobId);
+   record += ToRecordText(tempFilename);
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   WriteRecord(record);
+}
+
+void BatchJournal::AddOutputFile(unsigned int jobId, const CString& outputFilename)
+{
+   if (jobId == 0)
+      return;
+
+   // the size is checked when recovering, to detect output files that were
+   // truncated or replaced since
+   ULONGLONG fileSize = 0;
+   ReadFileSize(outputFilename, fileSize);
+
+   CStringA record;
+   record.Format("O\t%u\t%I64u\t", jobId, fileSize);
+   record += ToRecordText(outputFilename);
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   WriteRecord(record);
+}
+
+void BatchJournal::FinishJob(unsigned int jobId)
+{
+   if (jobId == 0)
+      return;
+
+   CStringA record;
+   record.Format("D\t%u", jobId);
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   // jobs of a batch that was already finished aren't recorded anymore
+   if (m_unfinishedJobIds.erase(jobId) == 0)
+      return;
+
+   WriteRecord(record);
+
+   if (m_unfinishedJobIds.empty())
+      DeleteJournalFile();
+}
+
+void BatchJournal::FinishBatch()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   m_unfinishedJobIds.clear();
+   DeleteJournalFile();
+}
+
+void BatchJournal::WriteRecord(const CStringA& record)
+{
+   if (m_journalFile == INVALID_HANDLE_VALUE)
+      return;
+
+   // a record is always written with a single call, so that a crash can
+   // only truncate the last record
+   CStringA line = record + "\r\n";
+
+   DWORD numWritten = 0;
+   if (!WriteFile(m_journalFile, line.GetString(), static_cast<DWORD>(line.GetLength()), &numWritten, nullptr))
+   {
+      ATLTRACE(_T("BatchJournal: couldn't write journal record, error %u\n"), GetLastError());
+      return;
+   }
+
+   ULONGLONG now = GetTickCount64();
+   if (now - m_lastFlushTickCount >= c_flushIntervalInMilliseconds)
+   {
+      FlushFileBuffers(m_journalFile);
+      m_lastFlushTickCount = now;
+   }
+}
+
+void BatchJournal::DeleteJournalFile()
+{
+   if (m_journalFile == INVALID_HANDLE_VALUE)
+      return;
+
+   CloseHandle(m_journalFile);
+   m_journalFile = INVALID_HANDLE_VALUE;
+
+   DeleteFile(m_journalFilename);
+   m_journalFilename.Empty();
+}
+
+std::vector<CString> BatchJournal::RecoverInterruptedJobs(const CString& journalFolder)
+{
+   std::vector<CString> inputFilenames;
+
+   if (journalFolder.IsEmpty())
+      return inputFilenames;
+
+   std::vector<CString> journalFilenames;
+
+   WIN32_FIND_DATA findData = {};
+   HANDLE find = FindFirstFile(Path::Combine(journalFolder, CString(_T("*")) + c_journalFileExtension), &findData);
+   if (find == INVALID_HANDLE_VALUE)
+      return inputFilenames;
+
+   do
+   {
+      if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+         journalFilenames.push_back(Path::Combine(journalFolder, findData.cFileName));
+
+   } while (FindNextFile(find, &findData));
+
+   FindClose(find);
+
+   // journal filenames contain the process ID, so sort them to get a
+   // stable order of the resumed input files
+   std::sort(journalFilenames.begin(), journalFilenames.end());
+
+   for (const CString& journalFilename : journalFilenames)
+      RecoverJournalFile(journalFilename, inputFilenames);
+
+   return inputFilenames;
+}
+
+void BatchJournal::RecoverJournalFile(const CString& journalFilename,
+   std::vector<CString>& inputFilenames)
+{
+   // opening the file exclusively fails when another winLAME instance still
+   // writes to it; the file is deleted after reading it
+   HANDLE file = CreateFile(journalFilename, GENERIC_READ | DELETE, 0, nullptr,
+      OPEN_EXISTING, FILE_FLAG_DELETE_ON_CLOSE | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+   if (file == INVALID_HANDLE_VALUE)
+      return;
+
+   LARGE_INTEGER fileSize = {};
+   CStringA content;
+
+   if (GetFileSizeEx(file, &fileSize) &&
+      fileSize.QuadPart > 0 &&
+      fileSize.QuadPart < MAXLONG)
+   {
+      DWORD numRead = 0;
+      LPSTR buffer = content.GetBuffer(static_cast<int>(fileSize.QuadPart));
+
+      if (!ReadFile(file, buffer, static_cast<DWORD>(fileSize.QuadPart), &numRead, nullptr))
+         numRead = 0;
+
+      content.ReleaseBuffer(static_cast<int>(numRead));
+   }
+
+   CloseHandle(file);
+
+   // replay all records; the last record may be truncated and is then ignored
+   std::map<unsigned int, JournalJob> jobs;
+
+   int start = 0;
+   while (start < content.GetLength())
+   {
+      int pos = content.Find('\n', start);
+      if (pos == -1)
+         break;
+
+      CStringA record = content.Mid(start, pos - start);
+      record.TrimRight('\r');
+      start = pos + 1;
+
+      std::vector<CStringA> fields = SplitRecord(record);
+      if (fields.size() < 2)
+         continue;
+
+      unsigned int jobId = strtoul(fields[1], nullptr, 10);
+
+      if (fields[0] == "J" && fields.size() == 4)
+      {
+         JournalJob& job = jobs[jobId];
+         job.m_hasRange = fields[2] == "1";
+         job.m_inputFilename = FromRecordText(fields[3]);
+         continue;
+      }
+
+      auto iter = jobs.find(jobId);
+      if (iter == jobs.end())
+         continue;
+
+      JournalJob& job = iter->second;
+
+      if (fields[0] == "T" && fields.size() == 3)
+         job.m_tempFilenames.push_back(FromRecordText(fields[2]));
+      else if (fields[0] == "O" && fields.size() == 4)
+      {
+         job.m_outputFileSizes.push_back(_strtoui64(fields[2], nullptr, 10));
+         job.m_outputFilenames.push_back(FromRecordText(fields[3]));
+      }
+      else if (fields[0] == "D")
+         job.m_finished = true;
+   }
+
+   std::set<CString> knownInputFilenames(inputFilenames.begin(), inputFilenames.end());
+
+   for (const auto& iter : jobs)
+   {
+      const JournalJob& job = iter.second;
+
+      // temp files that still exist were never renamed to output files
+      for (const CString& tempFilename : job.m_tempFilenames)
+      {
+         if (std::find(job.m_outputFilenames.begin(), job.m_outputFilenames.end(), tempFilename) == job.m_outputFilenames.end() &&
+            Path::FileExists(tempFilename))
+         {
+            DeleteFile(tempFilename);
+         }
+      }
+
+      // finished jobs are skipped, as long as their output files still
+      // exist with the size they were written with
+      bool resumeJob = !job.m_finished;
+      for (size_t index = 0; index < job.m_outputFilenames.size(); index++)
+      {
+         ULONGLONG fileSize = 0;
+         if (!ReadFileSize(job.m_outputFilenames[index], fileSize) ||
+            fileSize != job.m_outputFileSizes[index])
+            resumeJob = true;
+      }
+
+      if (resumeJob &&
+         !job.m_hasRange &&
+         Path::FileExists(job.m_inputFilename) &&
+         knownInputFilenames.insert(job.m_inputFilename).second)
+      {
+         inputFilenames.push_back(job.m_inputFilename);
+      }
+   }
+}
@@ -0,0 +1,125 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BatchJournal.hpp
+/// \brief journal of encoding jobs, used to resume an interrupted batch
+//
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace Encoder
+{
+   /// \brief journal of encoding jobs
+   /// \details Records the jobs of an encoding batch in an append-only
+   /// journal file: job creation, start, temporary and output files and job
+   /// completion. When winLAME crashes or is closed while encoding, the
+   /// journal file stays in the journal folder, and the next winLAME start
+   /// can resume the jobs that weren't finished. The journal file is deleted
+   /// when all jobs are finished, or when the batch is ended by the user.
+   /// All methods may be called by multiple encoder threads at the same time.
+   class BatchJournal
+   {
+   public:
+      /// ctor; uses given journal folder; an empty folder name disables
+      /// the journal
+      explicit BatchJournal(const CString& journalFolder);
+      /// dtor; closes the journal file, keeping it when jobs weren't finished
+      ~BatchJournal();
+
+      /// deleted copy ctor
+      BatchJournal(const BatchJournal&) = delete;
+      /// deleted copy assignment operator
+      BatchJournal& operator=(const BatchJournal&) = delete;
+
+      /// returns if the journal is enabled
+      bool IsEnabled() const { return !m_journalFolder.IsEmpty(); }
+
+      /// adds a new job for given input file and returns the job ID; returns
+      /// 0 when the job couldn't be recorded
+      unsigned int AddJob(const CString& inputFilename, bool hasRange);
+
+      /// records that the job was started
+      void StartJob(unsigned int jobId);
+
+      /// records a temporary file of the job, deleted when the job is resumed
+      void AddTempFile(unsigned int jobId, const CString& tempFilename);
+
+      /// records an output file that the job completely wrote, together
+      /// with its size
+      void AddOutputFile(unsigned int jobId, const CString& outputFilename);
+
+      /// records that the job finished, successfully or with errors; the
+      /// journal file is deleted when no job is left
+      void FinishJob(unsigned int jobId);
+
+      /// \brief ends the current batch, e.g. when the user stopped all tasks
+      /// \details jobs that were stopped or never started are closed out and
+      /// aren't resumed on the next start; the journal file is deleted
+      void FinishBatch();
+
+      /// \brief recovers jobs of interrupted batches
+      /// \details Reads all journal files in the journal folder that aren't
+      /// in use by another winLAME instance. Temporary files of unfinished
+      /// jobs are deleted, and the journal files are removed. Returns the
+      /// input filenames of all jobs that weren't finished, or whose output
+      /// files were deleted or changed in size since. Jobs encoding a range
+      /// of an input file aren't returned, since the range can't be restored
+      /// from the input file alone.
+      static std::vector<CString> RecoverInterruptedJobs(const CString& journalFolder);
+
+   private:
+      /// appends a record to the journal file; the mutex must be locked
+      void WriteRecord(const CStringA& record);
+
+      /// closes and deletes the journal file; the mutex must be locked
+      void DeleteJournalFile();
+
+      /// reads a single journal file and adds the jobs to resume
+      static void RecoverJournalFile(const CString& journalFilename,
+         std::vector<CString>& inputFilenames);
+
+   private:
+      /// journal folder
+      CString m_journalFolder;
+
+      /// mutex protecting the journal file and the counters
+      std::mutex m_mutex;
+
+      /// journal file; INVALID_HANDLE_VALUE when no batch is running
+      HANDLE m_journalFile;
+
+      /// journal filename of the current batch
+      CString m_journalFilename;
+
+      /// number of journal files written by this process
+      unsigned int m_journalFileCounter;
+
+      /// last job ID that was assigned
+      unsigned int m_lastJobId;
+
+      /// IDs of the jobs of the current batch that weren't finished yet
+      std::set<unsigned int> m_unfinishedJobIds;
+
+      /// tick count of the last time the journal file was flushed to disk
+      ULONGLONG m_lastFlushTickCount;
+   };
+
+} // namespace Encoder
@@ -0,0 +1,497 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BufferedInputFile.cpp
+/// \brief buffered input file with memory mapping or read-ahead I/O thread
+//
+#include "stdafx.h"
+#include "BufferedInputFile.hpp"
+#include <ulib/win32/ErrorMessage.hpp>
+#include <ulib/thread/Thread.hpp>
+
+using Encoder::BufferedInputFile;
+
+/// memory range entry for PrefetchVirtualMemory(); same layout as
+/// WIN32_MEMORY_RANGE_ENTRY, which is only declared for Windows 8 and later
+struct MemoryRangeEntry
+{
+   PVOID VirtualAddress;   ///< start address
+   SIZE_T NumberOfBytes;   ///< number of bytes
+};
+
+/// function type of PrefetchVirtualMemory()
+typedef BOOL(WINAPI* T_fnPrefetchVirtualMemory)(HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG);
+
+/// prefetches the given memory range into the working set; the function is
+/// only available on Windows 8 and later, so it's loaded dynamically, and
+/// nothing is done on older systems
+static void PrefetchMemory(const void* address, size_t length)
+{
+   static T_fnPrefetchVirtualMemory fnPrefetchVirtualMemory =
+      reinterpret_cast<T_fnPrefetchVirtualMemory>(
+         ::GetProcAddress(::GetModuleHandle(_T("kernel32.dll")), "PrefetchVirtualMemory"));
+
+   if (fnPrefetchVirtualMemory == nullptr)
+      return;
+
+   MemoryRangeEntry entry = { const_cast<void*>(address), length };
+   fnPrefetchVirtualMemory(::GetCurrentProcess(), 1, &entry, 0);
+}
+
+/// copies data from a mapped view; reading from the view raises an exception
+/// when the underlying file can't be read anymore, e.g. when a removable drive
+/// was removed; returns false in this case
+static bool CopyFromMappedView(void* dest, const BYTE* source, size_t length)
+{
+   __try
+   {
+      memcpy(dest, source, length);
+   }
+   __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+      EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+   {
+      return false;
+   }
+
+   return true;
+}
+
+BufferedInputFile::BufferedInputFile()
+   :m_file(INVALID_HANDLE_VALUE),
+   m_fileMapping(nullptr),
+   m_mappedView(nullptr),
+   m_position(0),
+   m_length(0),
+   m_readAheadPosition(0),
+   m_readAheadGeneration(0),
+   m_stopIoThread(false),
+   m_lastError(0),
+   m_numReadCalls(0)
+{
+}
+
+BufferedInputFile::~BufferedInputFile()
+{
+   try
+   {
+      if (IsOpen())
+         Close();
+   }
+   catch (...)
+   {
+      ATLTRACE(_T("Exception while closing buffered input file\n"));
+   }
+}
+
+bool BufferedInputFile::Open(LPCTSTR filename, const InputFileOptions& options)
+{
+   ATLASSERT(!IsOpen()); // must not be open already
+
+   m_options = options;
+   if (m_options.m_blockSize < 4096)
+      m_options.m_blockSize = 4096;
+
+   if (m_options.m_numReadAheadBlocks < 2)
+      m_options.m_numReadAheadBlocks = 2;
+
+   m_position = 0;
+   m_length = 0;
+   m_lastError = 0;
+   m_numReadCalls = 0;
+
+   m_file = ::CreateFile(filename,
+      GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+
+   if (m_file == INVALID_HANDLE_VALUE)
+   {
+      m_lastError = ::GetLastError();
+      return false;
+   }
+
+   LARGE_INTEGER fileSize = {};
+   if (!::GetFileSizeEx(m_file, &fileSize))
+   {
+      m_lastError = ::GetLastError();
+
+      ::CloseHandle(m_file);
+      m_file = INVALID_HANDLE_VALUE;
+      return false;
+   }
+
+   m_length = static_cast<ULONGLONG>(fileSize.QuadPart);
+
+   // empty files can't be mapped; they are read using the read-ahead thread,
+   // which immediately reports the end of file
+   if (m_options.m_allowMemoryMapping &&
+      m_length > 0 &&
+      m_length <= m_options.m_maxMappedSize &&
+      IsMappableFile(filename) &&
+      MapFile())
+   {
+      return true;
+   }
+
+   StartReadAhead();
+
+   return true;
+}
+
+size_t BufferedInputFile::Read(void* data, size_t length)
+{
+   ATLASSERT(IsOpen());
+
+   if (m_position >= m_length)
+      return 0;
+
+   if (IsMemoryMapped())
+   {
+      size_t sizeToCopy = static_cast<size_t>(std::min<ULONGLONG>(length, m_length - m_position));
+
+      if (!CopyFromMappedView(data, m_mappedView + m_position, sizeToCopy))
+      {
+         SetError(ERROR_READ_FAULT);
+         return 0;
+      }
+
+      m_position += sizeToCopy;
+
+      return sizeToCopy;
+   }
+
+   BYTE* dest = static_cast<BYTE*>(data);
+   size_t totalRead = 0;
+
+   while (length > 0 && m_position < m_length)
+   {
+      ULONGLONG blockStart = m_currentBlock.m_fileOffset;
+      ULONGLONG blockEnd = blockStart + m_currentBlock.m_data.size();
+
+      if (m_position < blockStart || m_position >= blockEnd)
+      {
+         if (!FetchBlock())
+            break;
+
+         continue;
+      }
+
+      size_t sizeToCopy = static_cast<size_t>(std::min<ULONGLONG>(length, blockEnd - m_position));
+
+      memcpy(dest, m_currentBlock.m_data.data() + (m_position - blockStart), sizeToCopy);
+
+      dest += sizeToCopy;
+      length -= sizeToCopy;
+      totalRead += sizeToCopy;
+
+      m_position += sizeToCopy;
+   }
+
+   return totalRead;
+}
+
+bool BufferedInputFile::Seek(LONGLONG offset, int origin)
+{
+   ATLASSERT(IsOpen());
+
+   LONGLONG newPosition = offset;
+   switch (origin)
+   {
+   case SEEK_SET:
+      break;
+   case SEEK_CUR:
+      newPosition += static_cast<LONGLONG>(m_position);
+      break;
+   case SEEK_END:
+      newPosition += static_cast<LONGLONG>(m_length);
+      break;
+   default:
+      ATLASSERT(false);
+      return false;
+   }
+
+   if (newPosition < 0)
+      return false;
+
+   if (static_cast<ULONGLONG>(newPosition) == m_position)
+      return true;
+
+   m_position = static_cast<ULONGLONG>(newPosition);
+
+   if (IsMemoryMapped())
+      return true;
+
+   // seeking inside the current block keeps the blocks read ahead, since
+   // decoders often seek back a few bytes while parsing headers
+   ULONGLONG blockStart = m_currentBlock.m_fileOffset;
+   ULONGLONG blockEnd = blockStart + m_currentBlock.m_data.size();
+
+   if (m_position < blockStart || m_position >= blockEnd)
+      RestartReadAhead();
+
+   return true;
+}
+
+void BufferedInputFile::Close()
+{
+   if (!IsOpen())
+      return;
+
+   if (m_ioThread.joinable())
+   {
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_stopIoThread = true;
+      }
+
+      m_conditionFree.notify_one();
+
+      m_ioThread.join();
+   }
+
+   if (m_mappedView != nullptr)
+   {
+      ::UnmapViewOfFile(m_mappedView);
+      m_mappedView = nullptr;
+   }
+
+   if (m_fileMapping != nullptr)
+   {
+      ::CloseHandle(m_fileMapping);
+      m_fileMapping = nullptr;
+   }
+
+   ::CloseHandle(m_file);
+   m_file = INVALID_HANDLE_VALUE;
+
+   m_currentBlock = ReadBlock();
+   m_freeBlocks.clear();
+   m_readBlocks.clear();
+}
+
+DWORD BufferedInputFile::GetLastError() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   return m_lastError;
+}
+
+CString BufferedInputFile::GetLastErrorText() const
+{
+   DWORD lastError = GetLastError();
+   if (lastError == 0)
+      return CString();
+
+   return Win32::ErrorMessage(lastError).ToString();
+}
+
+bool BufferedInputFile::IsMappableFile(LPCTSTR filename)
+{
+   CString path = filename;
+
+   // long path prefix, e.g. \\?\C:\Music\file.mp3
+   if (path.Left(4) == _T("\\\\?\\"))
+      path = path.Mid(4);
+
+   // UNC paths are on network shares
+   if (path.Left(2) == _T("\\\\"))
+      return false;
+
+   // page faults on mapped files on network drives would block the decoder
+   // on each page; they are better read in large blocks
+   CString root;
+   if (path.GetLength() >= 2 && path[1] == _T(':'))
+      root = path.Left(2) + _T("\\");
+
+   return ::GetDriveType(root.IsEmpty() ? nullptr : root.GetString()) != DRIVE_REMOTE;
+}
+
+bool BufferedInputFile::MapFile()
+{
+   m_fileMapping = ::CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (m_fileMapping == nullptr)
+      return false;
+
+   m_mappedView = static_cast<const BYTE*>(::MapViewOfFile(m_fileMapping, FILE_MAP_READ, 0, 0, 0));
+   if (m_mappedView == nullptr)
+   {
+      ::CloseHandle(m_fileMapping);
+      m_fileMapping = nullptr;
+      return false;
+   }
+
+   // lets the memory manager read in the file using large I/O requests,
+   // instead of single page faults while decoding
+   PrefetchMemory(m_mappedView, static_cast<size_t>(m_length));
+
+   return true;
+}
+
+void BufferedInputFile::StartReadAhead()
+{
+   m_currentBlock = ReadBlock();
+   m_readBlocks.clear();
+
+   m_freeBlocks.clear();
+   m_freeBlocks.resize(m_options.m_numReadAheadBlocks);
+
+   m_readAheadPosition = 0;
+   m_readAheadGeneration = 0;
+   m_stopIoThread = false;
+
+   m_ioThread = std::thread(std::bind(&BufferedInputFile::RunIoThread, this));
+}
+
+bool BufferedInputFile::FetchBlock()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (!m_currentBlock.m_data.empty())
+   {
+      m_freeBlocks.push_back(std::move(m_currentBlock));
+      m_currentBlock = ReadBlock();
+
+      m_conditionFree.notify_one();
+   }
+
+   m_conditionRead.wait(lock, [&]() { return !m_readBlocks.empty() || m_lastError != 0; });
+
+   if (m_readBlocks.empty())
+      return false; // read error
+
+   ReadBlock block = std::move(m_readBlocks.front());
+   m_readBlocks.pop_front();
+
+   ULONGLONG blockEnd = block.m_fileOffset + block.m_data.size();
+
+   if (m_position >= block.m_fileOffset && m_position < blockEnd)
+   {
+      m_currentBlock = std::move(block);
+      return true;
+   }
+
+   // the read-ahead always restarts at the current position, so a block
+   // that doesn't contain it was cut short, since the file was truncated
+   m_freeBlocks.push_back(std::move(block));
+   m_conditionFree.notify_one();
+
+   return false;
+}
+
+void BufferedInputFile::RestartReadAhead()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      if (!m_currentBlock.m_data.empty())
+      {
+         m_freeBlocks.push_back(std::move(m_currentBlock));
+         m_currentBlock = ReadBlock();
+      }
+
+      while (!m_readBlocks.empty())
+      {
+         m_freeBlocks.push_back(std::move(m_readBlocks.front()));
+         m_readBlocks.pop_front();
+      }
+
+      // blocks that are currently being read are discarded by the I/O thread
+      m_readAheadGeneration++;
+      m_readAheadPosition = m_position;
+   }
+
+   m_conditionFree.notify_one();
+}
+
+void BufferedInputFile::SetError(DWORD errorCode)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (m_lastError == 0)
+      m_lastError = errorCode;
+
+   m_conditionRead.notify_all();
+}
+
+void BufferedInputFile::RunIoThread()
+{
+   Thread::SetName(_T("input file I/O thread"));
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   for (;;)
+   {
+      m_conditionFree.wait(lock, [&]()
+      {
+         return m_stopIoThread ||
+            (!m_freeBlocks.empty() && m_readAheadPosition < m_length && m_lastError == 0);
+      });
+
+      if (m_stopIoThread)
+         break;
+
+      ReadBlock block = std::move(m_freeBlocks.back());
+      m_freeBlocks.pop_back();
+
+      block.m_fileOffset = m_readAheadPosition;
+      m_readAheadPosition += m_options.m_blockSize;
+
+      unsigned int generation = m_readAheadGeneration;
+
+      lock.unlock();
+
+      block.m_data.resize(m_options.m_blockSize);
+
+      // the offset in the OVERLAPPED struct also works for synchronous
+      // file handles, and doesn't need a separate seek call
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>(block.m_fileOffset & 0xFFFFFFFF);
+      overlapped.OffsetHigh = static_cast<DWORD>(block.m_fileOffset >> 32);
+
+      DWORD bytesRead = 0;
+      BOOL ret = ::ReadFile(m_file,
+         block.m_data.data(),
+         static_cast<DWORD>(block.m_data.size()),
+         &bytesRead,
+         &overlapped);
+
+      m_numReadCalls++;
+
+      DWORD errorCode = ret ? 0 : ::GetLastError();
+
+      block.m_data.resize(bytesRead);
+
+      lock.lock();
+
+      if (errorCode != 0 && errorCode != ERROR_HANDLE_EOF &&
+         generation == m_readAheadGeneration)
+      {
+         if (m_lastError == 0)
+            m_lastError = errorCode;
+      }
+
+      if (generation != m_readAheadGeneration)
+         m_freeBlocks.push_back(std::move(block));
+      else
+         m_readBlocks.push_back(std::move(block));
+
+      m_conditionRead.notify_all();
+   }
+}
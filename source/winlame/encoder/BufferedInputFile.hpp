@@ -0,0 +1,203 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BufferedInputFile.hpp
+/// \brief buffered input file with memory mapping or read-ahead I/O thread
+//
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Encoder
+{
+   /// options for opening a buffered input file
+   struct InputFileOptions
+   {
+      /// ctor; sets default values
+      InputFileOptions()
+         :m_blockSize(1024 * 1024),
+         m_numReadAheadBlocks(4),
+         m_maxMappedSize(256 * 1024 * 1024),
+         m_allowMemoryMapping(true)
+      {
+      }
+
+      /// size of a single read-ahead block, in bytes
+      size_t m_blockSize;
+
+      /// number of blocks that the I/O thread reads ahead of the decoder
+      unsigned int m_numReadAheadBlocks;
+
+      /// maximum file size that is memory mapped; larger files use read-ahead,
+      /// in order to not exhaust the address space of the process
+      ULONGLONG m_maxMappedSize;
+
+      /// indicates if local files may be memory mapped
+      bool m_allowMemoryMapping;
+   };
+
+   /// \brief input file that is read by decoders
+   /// \details local files are memory mapped, and the whole mapping is
+   /// prefetched into memory when opening; files on network drives or files
+   /// that are too large to map are read in large blocks by a background I/O
+   /// thread, ahead of the decoder. The Read(), Seek() and Tell() functions
+   /// behave like fread(), fseek() and ftell(), so that the class can be
+   /// plugged into the I/O callbacks of the decoder libraries.
+   class BufferedInputFile
+   {
+   public:
+      /// ctor
+      BufferedInputFile();
+      /// dtor; closes file when still open
+      ~BufferedInputFile();
+
+      /// deleted copy ctor
+      BufferedInputFile(const BufferedInputFile&) = delete;
+      /// deleted copy assignment operator
+      BufferedInputFile& operator=(const BufferedInputFile&) = delete;
+
+      /// opens input file; returns false on errors
+      bool Open(LPCTSTR filename, const InputFileOptions& options = InputFileOptions());
+
+      /// returns if file is open
+      bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+
+      /// returns if the file is memory mapped
+      bool IsMemoryMapped() const { return m_mappedView != nullptr; }
+
+      /// reads data at the current position; returns number of bytes read,
+      /// which is less than the requested length at the end of the file or
+      /// on errors
+      size_t Read(void* data, size_t length);
+
+      /// sets new file position; origin is SEEK_SET, SEEK_CUR or SEEK_END;
+      /// returns false when the new position would be before the start of
+      /// the file
+      bool Seek(LONGLONG offset, int origin);
+
+      /// returns current file position
+      ULONGLONG Tell() const { return m_position; }
+
+      /// returns file length
+      ULONGLONG Length() const { return m_length; }
+
+      /// returns if the current position is at or beyond the end of the file
+      bool IsEndOfFile() const { return m_position >= m_length; }
+
+      /// closes the file
+      void Close();
+
+      /// returns the Win32 error code of the first failed operation, or 0
+      DWORD GetLastError() const;
+
+      /// returns error message of the first failed operation
+      CString GetLastErrorText() const;
+
+      /// returns number of read calls to the operating system
+      unsigned int NumReadCalls() const { return m_numReadCalls; }
+
+   private:
+      /// block of file data read by the I/O thread
+      struct ReadBlock
+      {
+         std::vector<BYTE> m_data;  ///< block data; size is the number of bytes read
+         ULONGLONG m_fileOffset = 0;///< file offset the block was read from
+      };
+
+      /// returns if the file may be memory mapped
+      static bool IsMappableFile(LPCTSTR filename);
+
+      /// memory maps the whole file; returns false when mapping isn't possible
+      bool MapFile();
+
+      /// starts I/O thread
+      void StartReadAhead();
+
+      /// takes the next block that contains the current position; may block;
+      /// returns false at the end of file or on errors
+      bool FetchBlock();
+
+      /// discards all blocks read ahead and restarts reading at the current position
+      void RestartReadAhead();
+
+      /// sets error code, when not already set
+      void SetError(DWORD errorCode);
+
+      /// I/O thread function
+      void RunIoThread();
+
+   private:
+      /// file handle
+      HANDLE m_file;
+
+      /// file mapping handle, when memory mapped
+      HANDLE m_fileMapping;
+
+      /// mapped view of the whole file, when memory mapped
+      const BYTE* m_mappedView;
+
+      /// file options
+      InputFileOptions m_options;
+
+      /// current file position
+      ULONGLONG m_position;
+
+      /// file length
+      ULONGLONG m_length;
+
+      /// block that is currently read by the decoder
+      ReadBlock m_currentBlock;
+
+      /// mutex protecting the block lists, read-ahead position and error code
+      mutable std::mutex m_mutex;
+
+      /// condition that is signaled when free blocks are available or the I/O thread should stop
+      std::condition_variable m_conditionFree;
+
+      /// condition that is signaled when blocks were read
+      std::condition_variable m_conditionRead;
+
+      /// list of free blocks
+      std::vector<ReadBlock> m_freeBlocks;
+
+      /// queue of blocks read ahead, in file order
+      std::deque<ReadBlock> m_readBlocks;
+
+      /// file offset where the I/O thread reads the next block
+      ULONGLONG m_readAheadPosition;
+
+      /// read-ahead generation; incremented when seeking discards the read-ahead blocks
+      unsigned int m_readAheadGeneration;
+
+      /// indicates if the I/O thread should stop
+      bool m_stopIoThread;
+
+      /// Win32 error code of first failed operation
+      DWORD m_lastError;
+
+      /// number of read calls
+      std::atomic<unsigned int> m_numReadCalls;
+
+      /// I/O thread
+      std::thread m_ioThread;
+   };
+
+} // namespace Encoder
@@ -0,0 +1,363 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BufferedOutputFile.cpp
+/// \brief buffered output file with write-behind I/O thread
+//
+#include "stdafx.h"
+#include "BufferedOutputFile.hpp"
+#include "SettingsManager.hpp"
+#include <ulib/win32/ErrorMessage.hpp>
+#include <ulib/thread/Thread.hpp>
+
+using Encoder::OutputFileOptions;
+using Encoder::BufferedOutputFile;
+
+/// alignment of write buffers; matches the page size and all common sector sizes
+const size_t c_bufferAlignment = 4096;
+
+OutputFileOptions OutputFileOptions::FromSettings(SettingsManager& mgr, unsigned int bytesPerSecond)
+{
+   OutputFileOptions options;
+
+   int lengthInSeconds = mgr.QueryValueInt(GeneralInputLengthInSeconds);
+   if (lengthInSeconds > 0 && bytesPerSecond > 0)
+      options.m_preallocateSize = ULONGLONG(lengthInSeconds) * bytesPerSecond;
+
+   options.m_flushOnClose = mgr.QueryValueInt(GeneralOutputFlushOnClose) != 0;
+
+   return options;
+}
+
+BufferedOutputFile::BufferedOutputFile()
+   :m_file(INVALID_HANDLE_VALUE),
+   m_position(0),
+   m_length(0),
+   m_numBuffersInFlight(0),
+   m_stopIoThread(false),
+   m_lastError(0),
+   m_numWriteCalls(0)
+{
+}
+
+BufferedOutputFile::~BufferedOutputFile()
+{
+   try
+   {
+      if (IsOpen())
+         Close();
+   }
+   catch (...)
+   {
+      ATLTRACE(_T("Exception while closing buffered output file\n"));
+   }
+}
+
+bool BufferedOutputFile::Open(LPCTSTR filename, const OutputFileOptions& options)
+{
+   ATLASSERT(!IsOpen()); // must not be open already
+
+   m_options = options;
+   if (m_options.m_bufferSize < c_bufferAlignment)
+      m_options.m_bufferSize = c_bufferAlignment;
+
+   if (m_options.m_numBuffers < 2)
+      m_options.m_numBuffers = 2;
+
+   m_file = ::CreateFile(filename,
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ,
+      nullptr,
+      CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+
+   if (m_file == INVALID_HANDLE_VALUE)
+   {
+      m_lastError = ::GetLastError();
+      return false;
+   }
+
+   // reserve disk space, so that the file system can allocate contiguous
+   // clusters; the file length isn't changed, and the reservation beyond
+   // the end of file is released when the file is closed. errors are ignored,
+   // since not all file systems support this.
+   if (m_options.m_preallocateSize > 0)
+   {
+      FILE_ALLOCATION_INFO allocationInfo = {};
+      allocationInfo.AllocationSize.QuadPart = static_cast<LONGLONG>(m_options.m_preallocateSize);
+
+      ::SetFileInformationByHandle(m_file, FileAllocationInfo, &allocationInfo, sizeof(allocationInfo));
+   }
+
+   m_position = 0;
+   m_length = 0;
+   m_lastError = 0;
+   m_numWriteCalls = 0;
+   m_stopIoThread = false;
+   m_numBuffersInFlight = 0;
+
+   m_freeBuffers.clear();
+   for (unsigned int bufferIndex = 0; bufferIndex < m_options.m_numBuffers; bufferIndex++)
+   {
+      BYTE* buffer = static_cast<BYTE*>(_aligned_malloc(m_options.m_bufferSize, c_bufferAlignment));
+      if (buffer == nullptr)
+         break;
+
+      m_freeBuffers.push_back(AlignedBuffer(buffer));
+   }
+
+   m_pendingBuffers.clear();
+   m_pendingBuffers.reserve(m_freeBuffers.size());
+
+   if (m_freeBuffers.empty())
+   {
+      ::CloseHandle(m_file);
+      m_file = INVALID_HANDLE_VALUE;
+
+      m_lastError = ERROR_NOT_ENOUGH_MEMORY;
+      return false;
+   }
+
+   m_ioThread = std::thread(std::bind(&BufferedOutputFile::RunIoThread, this));
+
+   return true;
+}
+
+bool BufferedOutputFile::Write(const void* data, size_t length)
+{
+   ATLASSERT(IsOpen());
+
+   const BYTE* source = static_cast<const BYTE*>(data);
+
+   while (length > 0)
+   {
+      if (m_currentBuffer.m_data == nullptr &&
+         !AcquireBuffer())
+         return false;
+
+      size_t sizeToCopy = std::min(length, m_options.m_bufferSize - m_currentBuffer.m_fill);
+
+      memcpy(m_currentBuffer.m_data.get() + m_currentBuffer.m_fill, source, sizeToCopy);
+
+      m_currentBuffer.m_fill += sizeToCopy;
+      source += sizeToCopy;
+      length -= sizeToCopy;
+
+      m_position += sizeToCopy;
+      m_length = std::max(m_length, m_position);
+
+      if (m_currentBuffer.m_fill == m_options.m_bufferSize)
+         SubmitCurrentBuffer();
+   }
+
+   return true;
+}
+
+bool BufferedOutputFile::Seek(ULONGLONG position)
+{
+   ATLASSERT(IsOpen());
+
+   if (position == m_position)
+      return true;
+
+   // the current buffer is only valid for a contiguous range of the file
+   SubmitCurrentBuffer();
+
+   m_position = position;
+   m_length = std::max(m_length, m_position);
+
+   return GetLastError() == 0;
+}
+
+size_t BufferedOutputFile::Read(void* data, size_t length)
+{
+   ATLASSERT(IsOpen());
+
+   SubmitCurrentBuffer();
+   WaitForPendingWrites();
+
+   LARGE_INTEGER distance = {};
+   distance.QuadPart = static_cast<LONGLONG>(m_position);
+
+   DWORD bytesRead = 0;
+   if (!::SetFilePointerEx(m_file, distance, nullptr, FILE_BEGIN) ||
+      !::ReadFile(m_file, data, static_cast<DWORD>(length), &bytesRead, nullptr))
+   {
+      SetError(::GetLastError());
+      return 0;
+   }
+
+   m_position += bytesRead;
+
+   return bytesRead;
+}
+
+bool BufferedOutputFile::Close()
+{
+   if (!IsOpen())
+      return GetLastError() == 0;
+
+   SubmitCurrentBuffer();
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopIoThread = true;
+   }
+
+   m_conditionPending.notify_one();
+
+   if (m_ioThread.joinable())
+      m_ioThread.join();
+
+   if (m_options.m_flushOnClose &&
+      !::FlushFileBuffers(m_file))
+   {
+      SetError(::GetLastError());
+   }
+
+   ::CloseHandle(m_file);
+   m_file = INVALID_HANDLE_VALUE;
+
+   m_freeBuffers.clear();
+
+   ATLTRACE(_T("BufferedOutputFile: wrote %I64u bytes with %u write calls\n"),
+      m_length, m_numWriteCalls.load());
+
+   return GetLastError() == 0;
+}
+
+DWORD BufferedOutputFile::GetLastError() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   return m_lastError;
+}
+
+CString BufferedOutputFile::GetLastErrorText() const
+{
+   DWORD lastError = GetLastError();
+   if (lastError == 0)
+      return CString();
+
+   return Win32::ErrorMessage(lastError).ToString();
+}
+
+bool BufferedOutputFile::AcquireBuffer()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   m_conditionWritten.wait(lock, [&]() { return !m_freeBuffers.empty() || m_lastError != 0; });
+
+   if (m_lastError != 0)
+      return false;
+
+   m_currentBuffer.m_data = std::move(m_freeBuffers.back());
+   m_freeBuffers.pop_back();
+
+   m_currentBuffer.m_fill = 0;
+   m_currentBuffer.m_fileOffset = m_position;
+
+   return true;
+}
+
+void BufferedOutputFile::SubmitCurrentBuffer()
+{
+   if (m_currentBuffer.m_data == nullptr)
+      return;
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      if (m_currentBuffer.m_fill == 0)
+         m_freeBuffers.push_back(std::move(m_currentBuffer.m_data));
+      else
+         m_pendingBuffers.push_back(std::move(m_currentBuffer));
+   }
+
+   m_currentBuffer = WriteBuffer();
+
+   m_conditionPending.notify_one();
+}
+
+void BufferedOutputFile::WaitForPendingWrites()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   m_conditionWritten.wait(lock, [&]() { return m_pendingBuffers.empty() && m_numBuffersInFlight == 0; });
+}
+
+void BufferedOutputFile::SetError(DWORD errorCode)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (m_lastError == 0)
+      m_lastError = errorCode;
+}
+
+void BufferedOutputFile::RunIoThread()
+{
+   Thread::SetName(_T("output file I/O thread"));
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   for (;;)
+   {
+      m_conditionPending.wait(lock, [&]() { return !m_pendingBuffers.empty() || m_stopIoThread; });
+
+      if (m_pendingBuffers.empty())
+         break; // stop was requested, and all buffers are written
+
+      WriteBuffer buffer = std::move(m_pendingBuffers.front());
+      m_pendingBuffers.erase(m_pendingBuffers.begin());
+      m_numBuffersInFlight++;
+
+      bool skipWrite = m_lastError != 0;
+
+      lock.unlock();
+
+      if (!skipWrite)
+      {
+         // the offset in the OVERLAPPED struct also works for synchronous
+         // file handles, and lets the buffers be written in any order
+         OVERLAPPED overlapped = {};
+         overlapped.Offset = static_cast<DWORD>(buffer.m_fileOffset & 0xFFFFFFFF);
+         overlapped.OffsetHigh = static_cast<DWORD>(buffer.m_fileOffset >> 32);
+
+         DWORD bytesWritten = 0;
+         BOOL ret = ::WriteFile(m_file,
+            buffer.m_data.get(),
+            static_cast<DWORD>(buffer.m_fill),
+            &bytesWritten,
+            &overlapped);
+
+         m_numWriteCalls++;
+
+         if (!ret)
+            SetError(::GetLastError());
+         else if (bytesWritten != buffer.m_fill)
+            SetError(ERROR_DISK_FULL);
+      }
+
+      lock.lock();
+
+      m_freeBuffers.push_back(std::move(buffer.m_data));
+      m_numBuffersInFlight--;
+
+      m_conditionWritten.notify_all();
+   }
+}
@@ -0,0 +1,197 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BufferedOutputFile.hpp
+/// \brief buffered output file with write-behind I/O thread
+//
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+
+class SettingsManager;
+
+namespace Encoder
+{
+   /// options for opening a buffered output file
+   struct OutputFileOptions
+   {
+      /// ctor; sets default values
+      OutputFileOptions()
+         :m_bufferSize(1024 * 1024),
+         m_numBuffers(4),
+         m_preallocateSize(0),
+         m_flushOnClose(false)
+      {
+      }
+
+      /// returns options for output modules, using the general settings;
+      /// bytesPerSecond is the estimated output data rate, or 0 when unknown
+      static OutputFileOptions FromSettings(SettingsManager& mgr, unsigned int bytesPerSecond);
+
+      /// size of a single write buffer, in bytes
+      size_t m_bufferSize;
+
+      /// number of write buffers; when all buffers are in flight, Write()
+      /// blocks until the I/O thread has written out a buffer
+      unsigned int m_numBuffers;
+
+      /// number of bytes to preallocate on disk, or 0 to not preallocate
+      ULONGLONG m_preallocateSize;
+
+      /// indicates if the file buffers are flushed to disk when closing
+      bool m_flushOnClose;
+   };
+
+   /// \brief output file that collects small writes in large aligned buffers
+   /// \details the buffers are written to disk by a background I/O thread;
+   /// each buffer carries the file offset it is written to, so seeking (e.g.
+   /// to fix up headers) doesn't have to wait for the pending writes.
+   class BufferedOutputFile
+   {
+   public:
+      /// ctor
+      BufferedOutputFile();
+      /// dtor; closes file when still open
+      ~BufferedOutputFile();
+
+      /// deleted copy ctor
+      BufferedOutputFile(const BufferedOutputFile&) = delete;
+      /// deleted copy assignment operator
+      BufferedOutputFile& operator=(const BufferedOutputFile&) = delete;
+
+      /// opens (and truncates) output file; returns false on errors
+      bool Open(LPCTSTR filename, const OutputFileOptions& options = OutputFileOptions());
+
+      /// returns if file is open
+      bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+
+      /// writes data at the current position; returns false on errors
+      bool Write(const void* data, size_t length);
+
+      /// sets new absolute file position
+      bool Seek(ULONGLONG position);
+
+      /// returns current file position
+      ULONGLONG Tell() const { return m_position; }
+
+      /// returns current file length, including not yet written data
+      ULONGLONG Length() const { return m_length; }
+
+      /// reads data at the current position; waits for all pending writes
+      /// first; returns number of bytes read
+      size_t Read(void* data, size_t length);
+
+      /// writes out all pending buffers and closes the file; returns false
+      /// when any write operation has failed
+      bool Close();
+
+      /// returns the Win32 error code of the first failed operation, or 0
+      DWORD GetLastError() const;
+
+      /// returns error message of the first failed operation
+      CString GetLastErrorText() const;
+
+      /// returns number of write calls to the operating system
+      unsigned int NumWriteCalls() const { return m_numWriteCalls; }
+
+   private:
+      /// deleter for aligned buffers
+      struct AlignedFree
+      {
+         /// frees buffer
+         void operator()(BYTE* buffer) const { _aligned_free(buffer); }
+      };
+
+      /// aligned buffer type
+      typedef std::unique_ptr<BYTE, AlignedFree> AlignedBuffer;
+
+      /// buffer to write
+      struct WriteBuffer
+      {
+         AlignedBuffer m_data;      ///< buffer data
+         size_t m_fill = 0;         ///< number of bytes in buffer
+         ULONGLONG m_fileOffset = 0;///< file offset to write buffer to
+      };
+
+      /// takes a free buffer for writing at the current position; may block
+      bool AcquireBuffer();
+
+      /// hands over current buffer to the I/O thread
+      void SubmitCurrentBuffer();
+
+      /// waits until the I/O thread has written out all pending buffers
+      void WaitForPendingWrites();
+
+      /// sets error code, when not already set
+      void SetError(DWORD errorCode);
+
+      /// I/O thread function
+      void RunIoThread();
+
+   private:
+      /// file handle
+      HANDLE m_file;
+
+      /// file options
+      OutputFileOptions m_options;
+
+      /// current file position
+      ULONGLONG m_position;
+
+      /// current file length
+      ULONGLONG m_length;
+
+      /// buffer that is currently filled
+      WriteBuffer m_currentBuffer;
+
+      /// mutex protecting the buffer lists and error code
+      mutable std::mutex m_mutex;
+
+      /// condition that is signaled when buffers are pending or the I/O thread should stop
+      std::condition_variable m_conditionPending;
+
+      /// condition that is signaled when buffers were written out
+      std::condition_variable m_conditionWritten;
+
+      /// list of free buffers
+      std::vector<AlignedBuffer> m_freeBuffers;
+
+      /// queue of buffers to write; reserved for all buffers when opening the
+      /// file, so that submitting a buffer doesn't allocate memory
+      std::vector<WriteBuffer> m_pendingBuffers;
+
+      /// number of buffers currently being written by the I/O thread
+      unsigned int m_numBuffersInFlight;
+
+      /// indicates if the I/O thread should stop after writing all buffers
+      bool m_stopIoThread;
+
+      /// Win32 error code of first failed operation
+      DWORD m_lastError;
+
+      /// number of write calls
+      std::atomic<unsigned int> m_numWriteCalls;
+
+      /// I/O thread
+      std::thread m_ioThread;
+   };
+
+} // namespace Encoder
@@ -22,30 +22,36 @@
 #include "stdafx.h"
 #include "CDExtractTask.hpp"
 #include "SndFileOutputModule.hpp"
+#include "FlacOutputModule.hpp"
+#include "AccurateRipChecksum.hpp"
 #include "UISettings.hpp"
 #include "resource.h"
+#include "BassApiUsage.hpp"
 #include <basscd.h>
 #include "CDRipTitleFormatManager.hpp"
 
 using Encoder::CDExtractTask;
 using Encoder::TrackInfo;
 
-extern std::atomic<unsigned int> s_bassApiusageCount;
-
 CDExtractTask::CDExtractTask(unsigned int dependentTaskId, const CDRipDiscInfo& discinfo, const CDRipTrackInfo& trackinfo)
    :Task(dependentTaskId),
    m_discinfo(discinfo),
    m_trackinfo(trackinfo),
    m_uiSettings(IoCContainer::Current().Resolve<UISettings>()),
-   m_stopped(false),
+   m_writeFlac(false),
+   m_isFirstTrackOfRip(false),
    m_running(false),
    m_finished(false),
-   m_progressInPercent(0)
+   m_progressInPercent(0),
+   m_bytesWritten(0),
+   m_extractTimeInSeconds(0.0)
 {
    m_title = CDRipTitleFormatManager::FormatTitle(m_uiSettings, m_discinfo, m_trackinfo);
 
    if (m_trackinfo.m_rippedFilename.IsEmpty())
    {
+      m_writeFlac = m_uiSettings.cdrip_temp_flac;
+
       CString discTrackTitle = CDRipTitleFormatManager::GetFilenameByTitle(m_title);
 
       CString tempFilename = GetTempFilename(discTrackTitle);
@@ -64,6 +70,17 @@ TaskInfo CDExtractTask::GetTaskInfo()
    desc.Format(IDS_CDEXTRACT_DESC_US,
       m_trackinfo.m_numTrackOnDisc,
       m_title.GetString());
+
+   if (m_finished && m_bytesWritten > 0)
+   {
+      CString statistics;
+      statistics.Format(IDS_CDEXTRACT_STATISTICS_FF,
+         m_bytesWritten / (1024.0 * 1024.0),
+         m_extractTimeInSeconds);
+
+      desc += _T(" ") + statistics;
+   }
+
    info.Description(desc);
 
    info.Status(
@@ -78,6 +95,11 @@ TaskInfo CDExtractTask::GetTaskInfo()
 
 void CDExtractTask::Run()
 {
+   // the log of an earlier rip of the same disc is replaced, even when the
+   // first track fails
+   if (m_isFirstTrackOfRip && m_uiSettings.cdrip_write_log)
+      DeleteFile(GetRipLogFilename());
+
    m_running = true;
    ExtractTrack(m_trackinfo.m_rippedFilename);
    m_running = false;
@@ -86,7 +108,7 @@ void CDExtractTask::Run()
 
 void CDExtractTask::Stop()
 {
-   m_stopped = true;
+   m_taskControl.Stop();
 }
 
 CString CDExtractTask::GetTempFilename(const CString& discTrackTitle) const
@@ -95,10 +117,11 @@ CString CDExtractTask::GetTempFilename(const CString& discTrackTitle) const
    guid.Format(_T("{%08x-%08x}"), ::GetCurrentProcessId(), ::GetCurrentThreadId());
 
    CString tempFilename;
-   tempFilename.Format(_T("(%02u) %s%s.wav"),
+   tempFilename.Format(_T("(%02u) %s%s%s"),
       m_trackinfo.m_numTrackOnDisc + 1,
       discTrackTitle.GetString(),
-      guid.GetString());
+      guid.GetString(),
+      m_writeFlac ? _T(".flac") : _T(".wav"));
 
    tempFilename.Replace(_T("\\"), _T("_"));
    tempFilename.Replace(_T("/"), _T("_"));
@@ -108,7 +131,7 @@ CString CDExtractTask::GetTempFilename(const CString& discTrackTitle) const
 
 bool CDExtractTask::ExtractTrack(const CString& tempFilename)
 {
-   if (m_stopped)
+   if (m_taskControl.IsStopped())
    {
       return false;
    }
@@ -124,10 +147,13 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
    DWORD trackLength = BASS_CD_GetTrackLength(m_discinfo.m_discDrive, m_trackinfo.m_numTrackOnDisc);
    DWORD currentLength = 0;
 
-   if (s_bassApiusageCount++ == 0)
-   {
-      BASS_Init(0, 44100, 0, nullptr, nullptr);
-   }
+   // freed when returning, also on errors
+   BassApiUsage bassApiUsage;
+   bassApiUsage.Init();
+
+   // compensate the drive's read offset, so that the checksums can be
+   // compared with the ones of other drives
+   BASS_CD_SetOffset(m_discinfo.m_discDrive, m_uiSettings.cdrip_read_offset);
 
    HSTREAM hStream = BASS_CD_StreamCreate(m_discinfo.m_discDrive, m_trackinfo.m_numTrackOnDisc,
       BASS_STREAM_DECODE);
@@ -137,9 +163,15 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
    if (hStream == 0 || error != BASS_OK)
       return false;
 
-   Encoder::SndFileOutputModule outputModule;
+   // temporary files are written as FLAC, to reduce the amount of data
+   // written to and read back from the temp folder
+   std::unique_ptr<OutputModule> outputModule;
+   if (m_writeFlac)
+      outputModule = std::make_unique<Encoder::FlacOutputModule>();
+   else
+      outputModule = std::make_unique<Encoder::SndFileOutputModule>();
 
-   if (!outputModule.IsAvailable())
+   if (!outputModule->IsAvailable())
    {
       SetTaskError(IDS_CDRIP_PAGE_WAVE_OUTPUT_NOT_AVAIL);
       return false;
@@ -153,24 +185,28 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
       mgr.setValue(SndFileFormat, SF_FORMAT_WAV);
       mgr.setValue(SndFileSubType, SF_FORMAT_PCM_16);
 
+      // the FLAC file is only read once by the encoder; compress as fast as possible
+      mgr.setValue(FlacCompressionLevel, 0);
+      mgr.setValue(GeneralInputLengthInSeconds, static_cast<int>(trackLength / 176400));
+
       outputTrackInfo.ResetInfos();
       CDReadJob cdReadJob(m_discinfo, m_trackinfo);
       SetTrackInfoFromCDTrackInfo(outputTrackInfo, cdReadJob);
 
-      outputModule.PrepareOutput(mgr);
+      outputModule->PrepareOutput(mgr);
 
       // create folder when it doesn't exist
       CString tempOutputFolder = Path::FolderName(tempFilename);
       if (!Path::FolderExists(tempOutputFolder))
          Path::CreateDirectoryRecursive(tempOutputFolder);
 
-      int ret = outputModule.InitOutput(tempFilename, mgr, outputTrackInfo, samples);
+      int ret = outputModule->InitOutput(tempFilename, mgr, outputTrackInfo, samples);
       if (ret < 0)
       {
          CString text;
          text.Format(IDS_CDRIP_PAGE_ERROR_CREATE_OUTPUT_FILE_S, tempFilename.GetString());
 
-         CString moduleError = outputModule.GetLastError();
+         CString moduleError = outputModule->GetLastError();
          text += _T("\n");
          text += moduleError;
 
@@ -179,8 +215,12 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
       }
    }
 
+   AccurateRipChecksum checksum(m_trackinfo.m_numTrackOnDisc == 0, IsLastAudioTrack(), trackLength / 4);
+
    const unsigned int bufferSize = 65536;
 
+   auto extractStart = std::chrono::steady_clock::now();
+
    std::vector<signed short> vecBuffer(bufferSize);
 
    bool isFinished = true;
@@ -194,16 +234,24 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
 
       if (availBytes == 0)
       {
-         // buffer is empty; wait a bit to fill it
-         Sleep(1);
+         // buffer is empty; wait a bit to fill it, but return immediately when stopped
+         if (!m_taskControl.WaitFor(std::chrono::milliseconds(1)))
+         {
+            isFinished = false;
+            break;
+         }
+
          continue;
       }
 
       samples.PutSamplesInterleaved(&vecBuffer[0], availBytes / sizeof(vecBuffer[0]) / 2);
 
+      checksum.Add(vecBuffer.data(), availBytes / sizeof(vecBuffer[0]) / 2);
+
       currentLength += availBytes;
 
-      if (m_stopped)
+      // wait while paused; returns false when stopped
+      if (!m_taskControl.CheckPoint())
       {
          isFinished = false;
          break;
@@ -211,21 +259,86 @@ bool CDExtractTask::ExtractTrack(const CString& tempFilename)
 
       m_progressInPercent = currentLength * 100 / trackLength;
 
-      int ret = outputModule.EncodeSamples(samples);
+      int ret = outputModule->EncodeSamples(samples);
       if (ret < 0)
+      {
+         isFinished = false;
          break;
+      }
    }
 
+   m_taskControl.LeaveWorkerThread();
+
    BASS_StreamFree(hStream);
 
-   if (--s_bassApiusageCount == 0)
+   bassApiUsage.Free();
+
+   outputModule->DoneOutput();
+
+   m_extractTimeInSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - extractStart).count();
+
+   WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+   if (GetFileAttributesEx(tempFilename, GetFileExInfoStandard, &attributes))
+      m_bytesWritten = (ULONGLONG(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+
+   ATLTRACE(_T("CDExtractTask: track %u, %I64u bytes written in %.1f seconds\n"),
+      m_trackinfo.m_numTrackOnDisc + 1, m_bytesWritten, m_extractTimeInSeconds);
+
+   if (isFinished && m_uiSettings.cdrip_write_log)
+      WriteRipLog(checksum);
+
+   return isFinished;
+}
+
+bool CDExtractTask::IsLastAudioTrack() const
+{
+   unsigned int nextTrack = m_trackinfo.m_numTrackOnDisc + 1;
+   if (nextTrack >= m_discinfo.m_numTracks)
+      return true;
+
+   DWORD nextTrackLength = BASS_CD_GetTrackLength(m_discinfo.m_discDrive, nextTrack);
+   return nextTrackLength == DWORD(-1) && BASS_ERROR_NOTAUDIO == BASS_ErrorGetCode();
+}
+
+CString CDExtractTask::GetRipLogFilename() const
+{
+   CString discTitle = m_discinfo.m_discTitle.IsEmpty() ? m_discinfo.m_CDID :
+      m_discinfo.m_discArtist.IsEmpty() ? m_discinfo.m_discTitle :
+      m_discinfo.m_discArtist + _T(" - ") + m_discinfo.m_discTitle;
+
+   return Path::Combine(m_uiSettings.m_defaultSettings.outputdir,
+      CDRipTitleFormatManager::GetFilenameByTitle(discTitle) + _T(".log"));
+}
+
+void CDExtractTask::WriteRipLog(const AccurateRipChecksum& checksum) const
+{
+   CString logFilename = GetRipLogFilename();
+
+   CString outputFolder = Path::FolderName(logFilename);
+   if (!Path::FolderExists(outputFolder))
+      Path::CreateDirectoryRecursive(outputFolder);
+
+   bool isNewLog = !Path::FileExists(logFilename);
+
+   FILE* fd = _tfopen(logFilename, isNewLog ? _T("wt, ccs=UTF-8") : _T("at, ccs=UTF-8"));
+   if (fd == nullptr)
+      return;
+
+   if (isNewLog)
    {
-      BASS_Free();
+      _ftprintf(fd, _T("winLAME CD extraction log\n\n"));
+      _ftprintf(fd, _T("Disc: %s - %s\n"), m_discinfo.m_discArtist.GetString(), m_discinfo.m_discTitle.GetString());
+      _ftprintf(fd, _T("CDDB ID: %s\n"), m_discinfo.m_CDID.GetString());
+      _ftprintf(fd, _T("Read offset correction: %+d\n\n"), m_uiSettings.cdrip_read_offset);
    }
 
-   outputModule.DoneOutput();
+   _ftprintf(fd, _T("Track %2u  AccurateRip v1 [%08X]  AccurateRip v2 [%08X]  CRC32 [%08X]\n"),
+      m_trackinfo.m_numTrackOnDisc + 1,
+      checksum.GetChecksumV1(),
+      checksum.GetChecksumV2(),
+      checksum.GetCrc32());
 
-   return isFinished;
+   fclose(fd);
 }
 
 void CDExtractTask::SetTrackInfoFromCDTrackInfo(TrackInfo& encodeTrackInfo, const Encoder::CDReadJob& cdReadJob)
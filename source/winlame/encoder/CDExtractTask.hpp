@@ -24,6 +24,7 @@
 #include "Task.hpp"
 #include "CDRipDiscInfo.hpp"
 #include "CDRipTrackInfo.hpp"
+#include "TaskControl.hpp"
 #include <atomic>
 
 struct UISettings;
@@ -32,6 +33,7 @@ namespace Encoder
 {
    class TrackInfo;
    class CDReadJob;
+   class AccurateRipChecksum;
 
    /// task to extract CD audio track
    class CDExtractTask : public Task
@@ -57,6 +59,13 @@ namespace Encoder
       /// title for this task
       const CString& Title() { return m_title; }
 
+      /// returns task control, e.g. to pause extracting
+      TaskControl& GetTaskControl() { return m_taskControl; }
+
+      /// sets that the task extracts the first track of a rip, which starts
+      /// a new rip log
+      void SetFirstTrackOfRip() { m_isFirstTrackOfRip = true; }
+
       /// Sets track info properties from CD Read job infos
       static void SetTrackInfoFromCDTrackInfo(TrackInfo& encodeTrackInfo, const CDReadJob& cdReadJob);
 
@@ -67,6 +76,17 @@ namespace Encoder
       /// extracts track from CD and stores it in temporary filename
       bool ExtractTrack(const CString& tempFilename);
 
+      /// returns if the track is the last audio track on the disc; a data
+      /// track may follow it on enhanced CDs
+      bool IsLastAudioTrack() const;
+
+      /// returns filename of the rip log, in the output folder
+      CString GetRipLogFilename() const;
+
+      /// appends checksums of the extracted track to the rip log; the log is
+      /// created, with a header, for the first track of a rip
+      void WriteRipLog(const AccurateRipChecksum& checksum) const;
+
    private:
       /// CD disc info
       CDRipDiscInfo m_discinfo;
@@ -80,8 +100,15 @@ namespace Encoder
       /// title of track to extract
       CString m_title;
 
-      /// indicates if task was stopped
-      std::atomic<bool> m_stopped;
+      /// control channel for pausing and stopping the extract loop
+      TaskControl m_taskControl;
+
+      /// indicates if the track is written to a temporary FLAC file instead
+      /// of a wave file
+      bool m_writeFlac;
+
+      /// indicates if the task extracts the first track of a rip
+      bool m_isFirstTrackOfRip;
 
       /// indicates if task is running
       std::atomic<bool> m_running;
@@ -91,6 +118,12 @@ namespace Encoder
 
       /// progress in percent
       std::atomic<unsigned int> m_progressInPercent;
+
+      /// number of bytes written to the output file; set when finished
+      ULONGLONG m_bytesWritten;
+
+      /// time needed to extract the track, in seconds; set when finished
+      double m_extractTimeInSeconds;
    };
 
 } // namespace Encoder
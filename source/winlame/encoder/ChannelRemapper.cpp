@@ -22,52 +22,257 @@
 //
 #include "stdafx.h"
 #include "ChannelRemapper.hpp"
+#include <algorithm>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CHANNELREMAPPER_USE_SSE2
+#endif
 
 using Encoder::ChannelRemapper;
 
-const int MAX_CHANNELS = 6; ///< make this higher to support files with more channels
+const int MAX_CHANNELS = 8; ///< make this higher to support files with more channels
+
+/// factor to convert 16-bit samples to float samples in the range -1.0 to 1.0
+static const float c_sampleFactor16bit = 1.0f / 32768.0f;
 
-/// channel remapping map
+/// channel remapping map; output channel i is taken from input channel
+/// g_channelMap[type][numChannels - 1][i]
 const int g_channelMap[4][MAX_CHANNELS][MAX_CHANNELS] =
 {
    // aacInputChannelMap
    {
-      { 0, },               // mono
-      { 0, 1, },            // l, r
-      { 1, 2, 0, },         // c, l, r -> l, r, c
-      { 1, 2, 0, 3, },      // c, l, r, bc -> l, r, c, bc
-      { 1, 2, 0, 3, 4, },   // c, l, r, bl, br -> l, r, c, bl, br
-      { 1, 2, 0, 5, 3, 4 }  // c, l, r, bl, br, lfe -> l, r, c, lfe, bl, br
+      { 0, },                       // mono
+      { 0, 1, },                    // l, r
+      { 1, 2, 0, },                 // c, l, r -> l, r, c
+      { 1, 2, 0, 3, },              // c, l, r, bc -> l, r, c, bc
+      { 1, 2, 0, 3, 4, },           // c, l, r, bl, br -> l, r, c, bl, br
+      { 1, 2, 0, 5, 3, 4 },         // c, l, r, bl, br, lfe -> l, r, c, lfe, bl, br
+      { 0, 1, 2, 3, 4, 5, 6 },      // no AAC channel configuration; passed through
+      { 1, 2, 0, 7, 5, 6, 3, 4 }    // c, l, r, sl, sr, bl, br, lfe -> l, r, c, lfe, bl, br, sl, sr
    },
    // aacOutputChannelMap
    {
-      { 0, },               // mono
-      { 0, 1, },            // l, r
-      { 2, 0, 1, },         // l, r, c -> c, l, r
-      { 2, 0, 1, 3, },      // l, r, c, bc -> c, l, r, bc
-      { 2, 0, 1, 3, 4, },   // l, r, c, bl, br -> c, l, r, bl, br
-      { 2, 0, 1, 4, 5, 3 }  // l, r, c, lfe, bl, br -> c, l, r, bl, br, lfe
+      { 0, },                       // mono
+      { 0, 1, },                    // l, r
+      { 2, 0, 1, },                 // l, r, c -> c, l, r
+      { 2, 0, 1, 3, },              // l, r, c, bc -> c, l, r, bc
+      { 2, 0, 1, 3, 4, },           // l, r, c, bl, br -> c, l, r, bl, br
+      { 2, 0, 1, 4, 5, 3 },         // l, r, c, lfe, bl, br -> c, l, r, bl, br, lfe
+      { 0, 1, 2, 3, 4, 5, 6 },      // no AAC channel configuration; passed through
+      { 2, 0, 1, 6, 7, 4, 5, 3 }    // l, r, c, lfe, bl, br, sl, sr -> c, l, r, sl, sr, bl, br, lfe
    },
    // oggVorbisInputChannelMap
    {
-      { 0, },               // mono
-      { 0, 1, },            // l, r
-      { 0, 2, 1, },         // l, c, r -> l, r, c
-      { 0, 1, 2, 3, },      // l, r, bl, br
-      { 0, 2, 1, 3, 4, },   // l, c, r, bl, br -> l, r, c, bl, br
-      { 0, 2, 1, 5, 3, 4 }  // l, c, r, bl, br, lfe -> l, r, c, lfe, bl, br
+      { 0, },                       // mono
+      { 0, 1, },                    // l, r
+      { 0, 2, 1, },                 // l, c, r -> l, r, c
+      { 0, 1, 2, 3, },              // l, r, bl, br
+      { 0, 2, 1, 3, 4, },           // l, c, r, bl, br -> l, r, c, bl, br
+      { 0, 2, 1, 5, 3, 4 },         // l, c, r, bl, br, lfe -> l, r, c, lfe, bl, br
+      { 0, 2, 1, 6, 5, 3, 4 },      // l, c, r, sl, sr, bc, lfe -> l, r, c, lfe, bc, sl, sr
+      { 0, 2, 1, 7, 5, 6, 3, 4 }    // l, c, r, sl, sr, bl, br, lfe -> l, r, c, lfe, bl, br, sl, sr
    },
    // oggVorbisOutputChannelMap
    {
-      { 0, },               // mono
-      { 0, 1, },            // l, r
-      { 0, 2, 1, },         // l, r, c -> l, c, r
-      { 0, 1, 2, 3, },      // l, r, bl, br
-      { 0, 2, 1, 3, 4, },   // l, r, c, bl, br -> l, c, r, bl, br
-      { 0, 2, 1, 4, 5, 3 }  // l, r, c, lfe, bl, br -> l, c, r, bl, br, lfe
+      { 0, },                       // mono
+      { 0, 1, },                    // l, r
+      { 0, 2, 1, },                 // l, r, c -> l, c, r
+      { 0, 1, 2, 3, },              // l, r, bl, br
+      { 0, 2, 1, 3, 4, },           // l, r, c, bl, br -> l, c, r, bl, br
+      { 0, 2, 1, 4, 5, 3 },         // l, r, c, lfe, bl, br -> l, c, r, bl, br, lfe
+      { 0, 2, 1, 5, 6, 4, 3 },      // l, r, c, lfe, bc, sl, sr -> l, c, r, sl, sr, bc, lfe
+      { 0, 2, 1, 6, 7, 4, 5, 3 }    // l, r, c, lfe, bl, br, sl, sr -> l, c, r, sl, sr, bl, br, lfe
    }
 };
 
+// Note: The stupid_matrix table and the code in GetDownmixMatrix() is taken
+// from opus-tools' audio-in.c file:
+// https://github.com/xiph/opus-tools/blob/master/src/audio-in.c
+// The following copyright header appears in the file
+//
+/* Copyright 2000-2002, Michael Smith <msmith@xiph.org>
+             2010, Monty <monty@xiph.org>
+   AIFF/AIFC support from OggSquish, (c) 1994-1996 Monty <xiphmont@xiph.org>
+   (From GPL code in oggenc relicensed by permission from Monty and Msmith)
+   File: audio-in.c
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/// maximum number of channels that can be downmixed to stereo
+static const size_t c_maxStereoDownmixChannels = 8;
+
+/// \brief matrix for downsampling from N channels to 2 channels
+static const float stupid_matrix[7][8][2] =
+{
+   /*2*/  {{1,0}, {0,1}},
+   /*3*/  {{1,0}, {0.7071f,0.7071f}, {0,1}},
+   /*4*/  {{1,0}, {0,1},{0.866f,0.5f}, {0.5f,0.866f}},
+   /*5*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}},
+   /*6*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.7071f,0.7071f}},
+   /*7*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.6123f,0.6123f}, {0.7071f,0.7071f}},
+   /*8*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.866f,0.5f}, {0.5f,0.866f}, {0.7071f,0.7071f}},
+};
+
+/// returns channel map row for given number of channels, or nullptr when
+/// the channels are passed through unchanged
+static const int* GetChannelMap(Encoder::T_enChannelMapType channelMapType, size_t numChannels)
+{
+   if (numChannels == 0 || numChannels > MAX_CHANNELS)
+      return nullptr;
+
+   return g_channelMap[channelMapType][numChannels - 1];
+}
+
+/// converts 16-bit samples to float, multiplying them with a factor
+static void ConvertToFloat(const short* samples, size_t numSamples, float factor, float* output)
+{
+   size_t index = 0;
+
+#ifdef CHANNELREMAPPER_USE_SSE2
+   const __m128 factors = _mm_set1_ps(factor);
+
+   for (; index + 8 <= numSamples; index += 8)
+   {
+      __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+
+      // sign-extends the samples to 32 bit, by unpacking each sample into
+      // the high word and shifting it back
+      __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+      __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+
+      _mm_storeu_ps(output + index, _mm_mul_ps(_mm_cvtepi32_ps(low), factors));
+      _mm_storeu_ps(output + index + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), factors));
+   }
+#endif
+
+   for (; index < numSamples; index++)
+      output[index] = float(samples[index]) * factor;
+}
+
+/// converts 32-bit samples to float, multiplying them with a factor
+static void ConvertToFloat(const int* samples, size_t numSamples, float factor, float* output)
+{
+   size_t index = 0;
+
+#ifdef CHANNELREMAPPER_USE_SSE2
+   const __m128 factors = _mm_set1_ps(factor);
+
+   for (; index + 4 <= numSamples; index += 4)
+   {
+      __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+
+      _mm_storeu_ps(output + index, _mm_mul_ps(_mm_cvtepi32_ps(values), factors));
+   }
+#endif
+
+   for (; index < numSamples; index++)
+      output[index] = float(samples[index]) * factor;
+}
+
+/// converts interleaved samples to float and downmixes them to mono or
+/// stereo; the factor is folded into the matrix, and each output sample is
+/// summed up in input channel order, in the SSE2 and the scalar code
+template <typename T>
+static void DownmixToFloat(const T* samples, size_t numSamples, size_t inputNumChannels,
+   const std::vector<float>& downmixMatrix, size_t outputNumChannels, float factor, float* output)
+{
+   ATLASSERT(outputNumChannels == 1 || outputNumChannels == 2);
+   ATLASSERT(downmixMatrix.size() == inputNumChannels * outputNumChannels);
+   ATLASSERT(outputNumChannels == 1 || inputNumChannels <= c_maxStereoDownmixChannels);
+
+   size_t sampleIndex = 0;
+
+#ifdef CHANNELREMAPPER_USE_SSE2
+   if (outputNumChannels == 2)
+   {
+      // two samples are mixed at a time; the lanes contain left and right
+      // channel of the first, then of the second sample
+      __m128 channelFactors[c_maxStereoDownmixChannels];
+      for (size_t channelIndex = 0; channelIndex < inputNumChannels; channelIndex++)
+      {
+         float left = downmixMatrix[channelIndex] * factor;
+         float right = downmixMatrix[inputNumChannels + channelIndex] * factor;
+         channelFactors[channelIndex] = _mm_set_ps(right, left, right, left);
+      }
+
+      for (; sampleIndex + 2 <= numSamples; sampleIndex += 2)
+      {
+         const T* first = samples + sampleIndex * inputNumChannels;
+         const T* second = first + inputNumChannels;
+
+         __m128 sum = _mm_setzero_ps();
+         for (size_t channelIndex = 0; channelIndex < inputNumChannels; channelIndex++)
+         {
+            float firstValue = float(first[channelIndex]);
+            float secondValue = float(second[channelIndex]);
+
+            __m128 values = _mm_set_ps(secondValue, secondValue, firstValue, firstValue);
+            sum = _mm_add_ps(sum, _mm_mul_ps(values, channelFactors[channelIndex]));
+         }
+
+         _mm_storeu_ps(output + sampleIndex * 2, sum);
+      }
+   }
+   else
+   {
+      // four samples are mixed at a time, one in each lane
+      for (; sampleIndex + 4 <= numSamples; sampleIndex += 4)
+      {
+         const T* frame = samples + sampleIndex * inputNumChannels;
+
+         __m128 sum = _mm_setzero_ps();
+         for (size_t channelIndex = 0; channelIndex < inputNumChannels; channelIndex++)
+         {
+            __m128 values = _mm_set_ps(
+               float(frame[3 * inputNumChannels + channelIndex]),
+               float(frame[2 * inputNumChannels + channelIndex]),
+               float(frame[inputNumChannels + channelIndex]),
+               float(frame[channelIndex]));
+
+            sum = _mm_add_ps(sum, _mm_mul_ps(values, _mm_set1_ps(downmixMatrix[channelIndex] * factor)));
+         }
+
+         _mm_storeu_ps(output + sampleIndex, sum);
+      }
+   }
+#endif
+
+   for (; sampleIndex < numSamples; sampleIndex++)
+   {
+      const T* frame = samples + sampleIndex * inputNumChannels;
+
+      for (size_t outputChannelIndex = 0; outputChannelIndex < outputNumChannels; outputChannelIndex++)
+      {
+         const float* channelFactors = downmixMatrix.data() + outputChannelIndex * inputNumChannels;
+
+         float sum = 0.0f;
+         for (size_t channelIndex = 0; channelIndex < inputNumChannels; channelIndex++)
+            sum += float(frame[channelIndex]) * (channelFactors[channelIndex] * factor);
+
+         output[sampleIndex * outputNumChannels + outputChannelIndex] = sum;
+      }
+   }
+}
+
 size_t ChannelRemapper::GetMaxMappedChannel()
 {
    return MAX_CHANNELS;
@@ -75,54 +280,119 @@ size_t ChannelRemapper::GetMaxMappedChannel()
 
 size_t ChannelRemapper::GetMappedChannel(T_enChannelMapType channelMapType, size_t numChannels, size_t inputChannel)
 {
-   if (numChannels >= MAX_CHANNELS ||
-      inputChannel >= MAX_CHANNELS)
-      return 0;
+   const int* channelMap = GetChannelMap(channelMapType, numChannels);
+   if (channelMap == nullptr ||
+      inputChannel >= numChannels)
+      return inputChannel;
 
-   return g_channelMap[channelMapType][numChannels - 1][inputChannel];
+   return static_cast<size_t>(channelMap[inputChannel]);
 }
 
 void ChannelRemapper::ConvertSamplesToFloat(
    short** sampleBuffer, size_t numSamples, size_t numChannels, float** outputBuffer)
 {
    for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
-      for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
-         outputBuffer[channelIndex][sampleIndex] = float(sampleBuffer[channelIndex][sampleIndex]) / 32768.f;
+      ConvertToFloat(sampleBuffer[channelIndex], numSamples, c_sampleFactor16bit, outputBuffer[channelIndex]);
 }
 
 void ChannelRemapper::RemapInterleaved(T_enChannelMapType channelMapType,
    short* sampleBuffer, size_t numSamples, size_t numChannels, short* outputBuffer)
 {
-   auto channelMap = g_channelMap[channelMapType];
+   const int* channelMap = GetChannelMap(channelMapType, numChannels);
+   if (channelMap == nullptr)
+   {
+      std::copy_n(sampleBuffer, numSamples * numChannels, outputBuffer);
+      return;
+   }
 
    for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
-      for (size_t channelIndex = 0; channelIndex < std::min<size_t>(numChannels, MAX_CHANNELS); channelIndex++)
-         outputBuffer[sampleIndex * numChannels + channelIndex] =
-         sampleBuffer[sampleIndex * numChannels + (channelMap[numChannels - 1][channelIndex])];
-
-   // copy the remaining channels
-   if (numChannels > MAX_CHANNELS)
    {
-      for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
-         for (size_t channelIndex = MAX_CHANNELS; channelIndex < numChannels; channelIndex++)
-            outputBuffer[sampleIndex * numChannels + channelIndex] = sampleBuffer[sampleIndex * numChannels + channelIndex];
+      const short* input = sampleBuffer + sampleIndex * numChannels;
+      short* output = outputBuffer + sampleIndex * numChannels;
+
+      for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+         output[channelIndex] = input[channelMap[channelIndex]];
    }
 }
 
 void ChannelRemapper::RemapArrayToFloat(T_enChannelMapType channelMapType,
    short** sampleBuffer, size_t numSamples, size_t numChannels, float** outputBuffer)
 {
-   auto channelMap = g_channelMap[channelMapType];
+   const int* channelMap = GetChannelMap(channelMapType, numChannels);
+
+   for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+   {
+      size_t inputChannelIndex = channelMap != nullptr
+         ? static_cast<size_t>(channelMap[channelIndex])
+         : channelIndex;
+
+      ConvertToFloat(sampleBuffer[inputChannelIndex], numSamples, c_sampleFactor16bit, outputBuffer[channelIndex]);
+   }
+}
+
+bool ChannelRemapper::GetDownmixMatrix(size_t inputNumChannels, size_t outputNumChannels,
+   std::vector<float>& downmixMatrix)
+{
+   if (inputNumChannels <= outputNumChannels ||
+      outputNumChannels > 2 ||
+      outputNumChannels == 0 ||
+      (outputNumChannels == 2 && inputNumChannels > c_maxStereoDownmixChannels))
+      return false;
 
-   for (size_t channelIndex = 0; channelIndex < std::min<size_t>(numChannels, MAX_CHANNELS); channelIndex++)
-      for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
-         outputBuffer[channelIndex][sampleIndex] =
-         float(sampleBuffer[channelMap[numChannels - 1][channelIndex]][sampleIndex]) / 32768.f;
+   downmixMatrix.resize(inputNumChannels * outputNumChannels);
 
-   if (numChannels > MAX_CHANNELS)
+   if (outputNumChannels == 1 && inputNumChannels > c_maxStereoDownmixChannels)
+   {
+      for (size_t i = 0; i < inputNumChannels; i++)
+         downmixMatrix[i] = 1.0f / inputNumChannels;
+   }
+   else if (outputNumChannels == 2)
+   {
+      for (size_t j = 0; j < outputNumChannels; j++)
+         for (size_t i = 0; i < inputNumChannels; i++)
+            downmixMatrix[inputNumChannels * j + i] = stupid_matrix[inputNumChannels - 2][i][j];
+   }
+   else
    {
-      for (size_t channelIndex = MAX_CHANNELS; channelIndex < numChannels; channelIndex++)
-         for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
-            outputBuffer[channelIndex][sampleIndex] = float(sampleBuffer[channelIndex][sampleIndex]) / 32768.f;
+      for (size_t i = 0; i < inputNumChannels; i++)
+         downmixMatrix[i] = stupid_matrix[inputNumChannels - 2][i][0] + stupid_matrix[inputNumChannels - 2][i][1];
    }
+
+   float sum = 0.f;
+   for (size_t i = 0; i < inputNumChannels * outputNumChannels; i++)
+      sum += downmixMatrix[i];
+
+   sum = (float)outputNumChannels / sum;
+   for (size_t i = 0; i < inputNumChannels * outputNumChannels; i++)
+      downmixMatrix[i] *= sum;
+
+   return true;
+}
+
+void ChannelRemapper::ConvertInterleavedToFloat(const short* sampleBuffer,
+   size_t numSamples, size_t numChannels, float factor, float* outputBuffer)
+{
+   ConvertToFloat(sampleBuffer, numSamples * numChannels, factor, outputBuffer);
+}
+
+void ChannelRemapper::ConvertInterleavedToFloat(const int* sampleBuffer,
+   size_t numSamples, size_t numChannels, float factor, float* outputBuffer)
+{
+   ConvertToFloat(sampleBuffer, numSamples * numChannels, factor, outputBuffer);
+}
+
+void ChannelRemapper::DownmixInterleavedToFloat(const short* sampleBuffer,
+   size_t numSamples, size_t inputNumChannels,
+   const std::vector<float>& downmixMatrix, size_t outputNumChannels,
+   float factor, float* outputBuffer)
+{
+   DownmixToFloat(sampleBuffer, numSamples, inputNumChannels, downmixMatrix, outputNumChannels, factor, outputBuffer);
+}
+
+void ChannelRemapper::DownmixInterleavedToFloat(const int* sampleBuffer,
+   size_t numSamples, size_t inputNumChannels,
+   const std::vector<float>& downmixMatrix, size_t outputNumChannels,
+   float factor, float* outputBuffer)
+{
+   DownmixToFloat(sampleBuffer, numSamples, inputNumChannels, downmixMatrix, outputNumChannels, factor, outputBuffer);
 }
@@ -21,6 +21,8 @@
 //
 #pragma once
 
+#include <vector>
+
 namespace Encoder
 {
    /// pre-defined channel map types
@@ -32,14 +34,22 @@ namespace Encoder
       oggVorbisOutputChannelMap = 3,
    };
 
-   /// channel remapper helper class
+   /// \brief channel remapper helper class
+   /// \details Remaps channels between the channel order of a codec and the
+   /// wave file channel order (L, R, C, LFE, BL, BR, SL, SR) used by the
+   /// sample container, converts samples to float and downmixes channels to
+   /// mono or stereo. Converting is fused with remapping or downmixing, so
+   /// that the samples are only read once, and uses SSE2 where available.
+   /// Up to 8 channels (7.1) are remapped; streams with more channels, e.g.
+   /// Ambisonics, are passed through unchanged.
    class ChannelRemapper
    {
    public:
       /// returns number of mappable channels
       static size_t GetMaxMappedChannel();
 
-      /// returns mapped output channel for a given input channel
+      /// returns mapped input channel for a given output channel; returns
+      /// the channel itself when the number of channels isn't mapped
       static size_t GetMappedChannel(T_enChannelMapType channelMapType, size_t numChannels, size_t inputChannel);
 
       /// converts a sample buffer to float, without remapping
@@ -53,6 +63,39 @@ namespace Encoder
       /// remaps an array sample buffer with number of samples and channels to a float stereo output buffer
       static void RemapArrayToFloat(T_enChannelMapType channelMapType,
          short** sampleBuffer, size_t numSamples, size_t numChannels, float** outputBuffer);
+
+      /// calculates matrix for downmixing to mono or stereo; the matrix has
+      /// one row of input channel factors per output channel; more than 8
+      /// channels can only be downmixed to mono; returns false when the
+      /// channels can't be downmixed
+      static bool GetDownmixMatrix(size_t inputNumChannels, size_t outputNumChannels,
+         std::vector<float>& downmixMatrix);
+
+      /// converts an interleaved 16-bit sample buffer to float, multiplying
+      /// each sample with the given factor
+      static void ConvertInterleavedToFloat(const short* sampleBuffer,
+         size_t numSamples, size_t numChannels, float factor, float* outputBuffer);
+
+      /// converts an interleaved 32-bit sample buffer to float, multiplying
+      /// each sample with the given factor
+      static void ConvertInterleavedToFloat(const int* sampleBuffer,
+         size_t numSamples, size_t numChannels, float factor, float* outputBuffer);
+
+      /// converts an interleaved 16-bit sample buffer to float and downmixes
+      /// it using a matrix from GetDownmixMatrix(), multiplying each sample
+      /// with the given factor
+      static void DownmixInterleavedToFloat(const short* sampleBuffer,
+         size_t numSamples, size_t inputNumChannels,
+         const std::vector<float>& downmixMatrix, size_t outputNumChannels,
+         float factor, float* outputBuffer);
+
+      /// converts an interleaved 32-bit sample buffer to float and downmixes
+      /// it using a matrix from GetDownmixMatrix(), multiplying each sample
+      /// with the given factor
+      static void DownmixInterleavedToFloat(const int* sampleBuffer,
+         size_t numSamples, size_t inputNumChannels,
+         const std::vector<float>& downmixMatrix, size_t outputNumChannels,
+         float factor, float* outputBuffer);
    };
 
 } // namespace Encoder
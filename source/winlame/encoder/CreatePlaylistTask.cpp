@@ -21,45 +21,19 @@
 //
 #include "stdafx.h"
 #include "CreatePlaylistTask.hpp"
+#include "Playlist.hpp"
+#include "resource.h"
 #include <ulib/Path.hpp>
 
 using Encoder::CreatePlaylistTask;
 
-CreatePlaylistTask::CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, const EncoderJobList& encoderJobList)
+CreatePlaylistTask::CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, std::shared_ptr<Playlist> playlist)
    :Task(dependentTaskId),
-   m_extendedPlaylist(false), // no length infos available
    m_playlistFilename(playlistFilename),
+   m_playlist(playlist),
    m_finished(false),
    m_stopped(false)
 {
-   std::for_each(encoderJobList.begin(), encoderJobList.end(), [&](const EncoderJob& encoderJob)
-   {
-      PlaylistEntry entry;
-
-      entry.m_filename = encoderJob.OutputFilename();
-      entry.m_title = Path::FilenameAndExt(encoderJob.InputFilename());
-
-      m_playlistEntries.push_back(entry);
-   });
-}
-
-CreatePlaylistTask::CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, const std::vector<::Encoder::CDReadJob>& cdReadJobList)
-   :Task(dependentTaskId),
-   m_extendedPlaylist(true),
-   m_playlistFilename(playlistFilename),
-   m_finished(false),
-   m_stopped(false)
-{
-   std::for_each(cdReadJobList.begin(), cdReadJobList.end(), [&](const CDReadJob& cdReadJob)
-   {
-      PlaylistEntry entry;
-
-      entry.m_filename = cdReadJob.OutputFilename();
-      entry.m_title = cdReadJob.Title();
-      entry.m_trackLengthInSeconds = cdReadJob.TrackInfo().m_trackLengthInSeconds;
-
-      m_playlistEntries.push_back(entry);
-   });
 }
 
 TaskInfo CreatePlaylistTask::GetTaskInfo()
@@ -69,7 +43,7 @@ TaskInfo CreatePlaylistTask::GetTaskInfo()
    info.Name(_T("Playlist: ") + Path::FilenameAndExt(m_playlistFilename));
 
    CString description;
-   description.Format(IDS_PLAYLIST_TASK_DESCRIPTION_SU, m_playlistFilename.GetString(), m_playlistEntries.size());
+   description.Format(IDS_PLAYLIST_TASK_DESCRIPTION_SU, m_playlistFilename.GetString(), m_playlist->GetNumEntries());
    info.Description(description);
 
    info.Progress(m_finished || m_stopped ? 100 : 0);
@@ -85,40 +59,13 @@ void CreatePlaylistTask::Run()
 
    m_finished = false;
 
-   FILE* fd = _tfopen(m_playlistFilename, _T("wt"));
-   if (fd == NULL)
+   // all encoder tasks are finished, so the playlist is written once
+   if (!m_playlist->Write(m_playlistFilename))
    {
       SetTaskError(IDS_PLAYLIST_TASK_ERROR_CREATE_FILE);
       return;
    }
 
-   std::shared_ptr<FILE> spFd{ fd, fclose };
-
-   if (m_extendedPlaylist)
-      _ftprintf(fd, _T("#EXTM3U\n\n"));
-
-   CString rootFolder = Path::FolderName(m_playlistFilename);
-
-   for (size_t entryIndex = 0, maxEntryIndex = m_playlistEntries.size(); entryIndex < maxEntryIndex; entryIndex++)
-   {
-      const PlaylistEntry& entry = m_playlistEntries[entryIndex];
-
-      if (m_extendedPlaylist)
-         _ftprintf(fd, _T("#EXTINF:%u,%s\n"), entry.m_trackLengthInSeconds, entry.m_title.GetString());
-
-      CString relativeFilename = Path::MakeRelativeTo(entry.m_filename, rootFolder);
-      if (relativeFilename.IsEmpty())
-         relativeFilename = entry.m_filename;
-
-      if (relativeFilename.Find(_T(".\\")) == 0)
-         relativeFilename.Delete(0, 2);
-
-      _ftprintf(fd, _T("%s\n"), relativeFilename.GetString());
-
-      if (m_extendedPlaylist)
-         _ftprintf(fd, _T("\n"));
-   }
-
    m_finished = true;
 }
 
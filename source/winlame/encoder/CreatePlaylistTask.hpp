@@ -22,19 +22,19 @@
 #pragma once
 
 #include "Task.hpp"
-#include "UISettings.hpp"
 #include <atomic>
+#include <memory>
 
 namespace Encoder
 {
+   class Playlist;
+
    /// Task to create .m3u playlist file
    class CreatePlaylistTask : public Task
    {
    public:
-      /// ctor, taking list of EncoderJobs
-      CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, const EncoderJobList& encoderjoblist);
-      /// ctor, taking list of CDReadJobs
-      CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, const std::vector<::Encoder::CDReadJob>& cdreadjoblist);
+      /// ctor, taking the playlist that the tasks of the batch report their outputs to
+      CreatePlaylistTask(unsigned int dependentTaskId, const CString& playlistFilename, std::shared_ptr<Playlist> playlist);
       /// dtor
       virtual ~CreatePlaylistTask() {}
 
@@ -48,33 +48,11 @@ namespace Encoder
       virtual void Stop();
 
    private:
-      /// indicates if an extended playlist is created
-      bool m_extendedPlaylist;
-
       /// filename of playlist to write
       CString m_playlistFilename;
 
-      /// single playlist entry
-      struct PlaylistEntry
-      {
-         /// ctor
-         PlaylistEntry()
-            :m_trackLengthInSeconds(0)
-         {
-         }
-
-         /// filename of playlist entry
-         CString m_filename;
-
-         /// title of entry
-         CString m_title;
-
-         /// track length, in seconds
-         unsigned int m_trackLengthInSeconds;
-      };
-
-      /// list of playlist entries
-      std::vector<PlaylistEntry> m_playlistEntries;
+      /// playlist entries
+      std::shared_ptr<Playlist> m_playlist;
 
       /// indicates if task is already finished
       std::atomic<bool> m_finished;
@@ -0,0 +1,338 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CueSheet.cpp
+/// \brief cue sheet parser
+//
+#include "stdafx.h"
+#include "CueSheet.hpp"
+#include "TrackInfo.hpp"
+#include <ulib/UTF8.hpp>
+#include <fstream>
+
+using Encoder::CueSheet;
+using Encoder::CueSheetTrack;
+
+/// returns if the text is valid UTF-8
+static bool IsValidUTF8(const std::string& text)
+{
+   size_t numFollowBytes = 0;
+   for (char ch : text)
+   {
+      unsigned char value = static_cast<unsigned char>(ch);
+
+      if (numFollowBytes > 0)
+      {
+         if ((value & 0xc0) != 0x80)
+            return false;
+
+         numFollowBytes--;
+      }
+      else if ((value & 0xe0) == 0xc0)
+         numFollowBytes = 1;
+      else if ((value & 0xf0) == 0xe0)
+         numFollowBytes = 2;
+      else if ((value & 0xf8) == 0xf0)
+         numFollowBytes = 3;
+      else if (value >= 0x80)
+         return false;
+   }
+
+   return numFollowBytes == 0;
+}
+
+bool CueSheet::Load(const CString& filename)
+{
+   std::ifstream sheet(filename, std::ios::in | std::ios::binary);
+   if (!sheet.is_open())
+      return false;
+
+   std::string content((std::istreambuf_iterator<char>(sheet)), std::istreambuf_iterator<char>());
+
+   // cue sheets are either stored as UTF-8, with or without BOM, or in the
+   // ANSI codepage
+   if (content.compare(0, 3, "\xef\xbb\xbf") == 0)
+      content.erase(0, 3);
+
+   CString text = IsValidUTF8(content)
+      ? UTF8ToString(content.c_str())
+      : CString(content.c_str());
+
+   Parse(text, Path::FolderName(filename));
+
+   return true;
+}
+
+void CueSheet::Parse(const CString& text, const CString& baseFolder)
+{
+   m_tracks.clear();
+   m_currentFilename.Empty();
+   m_isAudioTrack = false;
+
+   int pos = 0;
+   while (pos < text.GetLength())
+   {
+      int endPos = text.Find(_T('\n'), pos);
+      if (endPos == -1)
+         endPos = text.GetLength();
+
+      CString line = text.Mid(pos, endPos - pos);
+      line.Trim();
+
+      if (!line.IsEmpty())
+         ParseLine(line, baseFolder);
+
+      pos = endPos + 1;
+   }
+
+   FinishTrack();
+}
+
+std::vector<CString> CueSheet::GetFilenames() const
+{
+   std::vector<CString> filenamesList;
+
+   for (const CueSheetTrack& track : m_tracks)
+   {
+      if (filenamesList.empty() || filenamesList.back() != track.m_filename)
+         filenamesList.push_back(track.m_filename);
+   }
+
+   return filenamesList;
+}
+
+void CueSheet::GetTrackFrameRange(size_t trackIndex, unsigned int& startFrame, unsigned int& endFrame) const
+{
+   ATLASSERT(trackIndex < m_tracks.size());
+
+   const CueSheetTrack& track = m_tracks[trackIndex];
+
+   // the first track of a file also contains the audio before its INDEX 01,
+   // e.g. a hidden track
+   bool isFirstTrackOfFile = trackIndex == 0 ||
+      m_tracks[trackIndex - 1].m_filename != track.m_filename;
+
+   startFrame = isFirstTrackOfFile ? 0 : track.m_startFrame;
+
+   // the track ends where the next track of the same file starts; the
+   // pregap of the next track belongs to this track
+   bool isLastTrackOfFile = trackIndex + 1 == m_tracks.size() ||
+      m_tracks[trackIndex + 1].m_filename != track.m_filename;
+
+   endFrame = isLastTrackOfFile ? 0 : m_tracks[trackIndex + 1].m_startFrame;
+}
+
+void CueSheet::SetTrackInfo(size_t trackIndex, TrackInfo& trackInfo) const
+{
+   ATLASSERT(trackIndex < m_tracks.size());
+
+   const CueSheetTrack& track = m_tracks[trackIndex];
+
+   if (!track.m_title.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoTitle, track.m_title);
+
+   CString performer = track.m_performer.IsEmpty() ? m_performer : track.m_performer;
+   if (!performer.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoArtist, performer);
+
+   if (!m_performer.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoDiscArtist, m_performer);
+
+   if (!m_title.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoAlbum, m_title);
+
+   CString songwriter = track.m_songwriter.IsEmpty() ? m_songwriter : track.m_songwriter;
+   if (!songwriter.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoComposer, songwriter);
+
+   if (!m_genre.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoGenre, m_genre);
+
+   if (!m_comment.IsEmpty())
+      trackInfo.SetTextInfo(TrackInfoComment, m_comment);
+
+   int year = _ttoi(m_date);
+   if (year > 0)
+      trackInfo.SetNumberInfo(TrackInfoYear, year);
+
+   trackInfo.SetNumberInfo(TrackInfoTrack, static_cast<int>(track.m_trackNumber));
+}
+
+void CueSheet::ParseLine(const CString& line, const CString& baseFolder)
+{
+   std::vector<CString> argumentList = SplitLine(line);
+   if (argumentList.empty())
+      return;
+
+   CString command = argumentList[0];
+   command.MakeUpper();
+
+   bool isTrackCommand = m_isAudioTrack && !m_tracks.empty();
+
+   if (command == _T("FILE") && argumentList.size() >= 2)
+   {
+      CString filename = argumentList[1];
+
+      // check if path is relative
+      if (filename.Find(_T(':')) == -1 && filename.Left(2) != _T("\\\\"))
+      {
+         filename = filename.Left(1) == _T("\\")
+            ? baseFolder.Left(2) + filename // relative to drive
+            : Path::Combine(baseFolder, filename);
+      }
+
+      m_currentFilename = filename;
+
+      // when the file changes between INDEX 00 and INDEX 01, the pregap is
+      // part of the previous file and stays with the previous track
+      if (isTrackCommand && m_tracks.back().m_startFrame == UINT_MAX)
+      {
+         m_tracks.back().m_filename = filename;
+         m_tracks.back().m_pregapStartFrame = UINT_MAX;
+      }
+      else
+         FinishTrack();
+   }
+   else if (command == _T("TRACK") && argumentList.size() >= 3)
+   {
+      FinishTrack();
+
+      // only audio tracks are used; data tracks are skipped
+      CString type = argumentList[2];
+      m_isAudioTrack = type.CompareNoCase(_T("AUDIO")) == 0 && !m_currentFilename.IsEmpty();
+
+      if (m_isAudioTrack)
+      {
+         CueSheetTrack track;
+         track.m_trackNumber = static_cast<unsigned int>(_ttoi(argumentList[1]));
+         track.m_filename = m_currentFilename;
+         track.m_startFrame = UINT_MAX;
+         track.m_pregapStartFrame = UINT_MAX;
+
+         m_tracks.push_back(track);
+      }
+   }
+   else if (command == _T("INDEX") && argumentList.size() >= 3)
+   {
+      if (!isTrackCommand)
+         return;
+
+      CueSheetTrack& track = m_tracks.back();
+
+      int indexNumber = _ttoi(argumentList[1]);
+      unsigned int frame = ParsePosition(argumentList[2]);
+
+      if (indexNumber == 0)
+         track.m_pregapStartFrame = frame;
+      else if (indexNumber == 1)
+         track.m_startFrame = frame;
+   }
+   else if (command == _T("PREGAP") || command == _T("POSTGAP"))
+   {
+      // generated silence that isn't contained in the audio file; ignored
+   }
+   else if (command == _T("TITLE") && argumentList.size() >= 2)
+   {
+      (isTrackCommand ? m_tracks.back().m_title : m_title) = argumentList[1];
+   }
+   else if (command == _T("PERFORMER") && argumentList.size() >= 2)
+   {
+      (isTrackCommand ? m_tracks.back().m_performer : m_performer) = argumentList[1];
+   }
+   else if (command == _T("SONGWRITER") && argumentList.size() >= 2)
+   {
+      (isTrackCommand ? m_tracks.back().m_songwriter : m_songwriter) = argumentList[1];
+   }
+   else if (command == _T("REM") && argumentList.size() >= 3)
+   {
+      CString remCommand = argumentList[1];
+      remCommand.MakeUpper();
+
+      if (remCommand == _T("GENRE"))
+         m_genre = argumentList[2];
+      else if (remCommand == _T("DATE"))
+         m_date = argumentList[2];
+      else if (remCommand == _T("COMMENT"))
+         m_comment = argumentList[2];
+   }
+}
+
+void CueSheet::FinishTrack()
+{
+   if (!m_isAudioTrack || m_tracks.empty())
+      return;
+
+   m_isAudioTrack = false;
+
+   // tracks without INDEX 01 start at their INDEX 00; tracks without any
+   // index can't be located in the audio file and are removed
+   CueSheetTrack& track = m_tracks.back();
+   if (track.m_startFrame == UINT_MAX)
+      track.m_startFrame = track.m_pregapStartFrame;
+
+   if (track.m_startFrame == UINT_MAX)
+      m_tracks.pop_back();
+   else if (track.m_pregapStartFrame == UINT_MAX)
+      track.m_pregapStartFrame = track.m_startFrame;
+}
+
+std::vector<CString> CueSheet::SplitLine(const CString& line)
+{
+   std::vector<CString> argumentList;
+
+   int pos = 0;
+   while (pos < line.GetLength())
+   {
+      TCHAR ch = line[pos];
+      if (ch == _T(' ') || ch == _T('\t'))
+      {
+         pos++;
+         continue;
+      }
+
+      if (ch == _T('\"'))
+      {
+         int endPos = line.Find(_T('\"'), pos + 1);
+         if (endPos == -1)
+            endPos = line.GetLength();
+
+         argumentList.push_back(line.Mid(pos + 1, endPos - pos - 1));
+         pos = endPos + 1;
+      }
+      else
+      {
+         int endPos = pos;
+         while (endPos < line.GetLength() && line[endPos] != _T(' ') && line[endPos] != _T('\t'))
+            endPos++;
+
+         argumentList.push_back(line.Mid(pos, endPos - pos));
+         pos = endPos;
+      }
+   }
+
+   return argumentList;
+}
+
+unsigned int CueSheet::ParsePosition(const CString& position)
+{
+   unsigned int minutes = 0, seconds = 0, frames = 0;
+   if (_stscanf_s(position, _T("%u:%u:%u"), &minutes, &seconds, &frames) != 3)
+      return 0;
+
+   return (minutes * 60 + seconds) * c_framesPerSecond + frames;
+}
@@ -0,0 +1,124 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CueSheet.hpp
+/// \brief cue sheet parser
+//
+#pragma once
+
+#include <vector>
+
+namespace Encoder
+{
+   class TrackInfo;
+
+   /// track of a cue sheet
+   struct CueSheetTrack
+   {
+      /// track number
+      unsigned int m_trackNumber = 0;
+
+      /// audio file that contains the track
+      CString m_filename;
+
+      CString m_title;        ///< track title
+      CString m_performer;    ///< track performer
+      CString m_songwriter;   ///< track songwriter
+
+      /// start of the track in the audio file (INDEX 01), in CD frames
+      unsigned int m_startFrame = 0;
+
+      /// start of the pregap in the audio file (INDEX 00), in CD frames; same
+      /// as m_startFrame when the track has no pregap
+      unsigned int m_pregapStartFrame = 0;
+   };
+
+   /// \brief cue sheet parser
+   /// \details parses FILE, TRACK, INDEX, PREGAP, TITLE, PERFORMER, SONGWRITER
+   /// and REM commands. Positions are stored in CD frames of 1/75 seconds.
+   /// The pregap of a track is appended to the previous track, and audio
+   /// before the first track of a file is added to the first track, so that
+   /// the tracks of a file exactly cover the whole file.
+   class CueSheet
+   {
+   public:
+      /// number of CD frames per second
+      static const unsigned int c_framesPerSecond = 75;
+
+      /// ctor
+      CueSheet() {}
+
+      /// loads cue sheet from file; relative audio filenames are resolved
+      /// using the cue sheet's folder; returns false when the file can't be read
+      bool Load(const CString& filename);
+
+      /// parses cue sheet text; relative audio filenames are resolved using
+      /// the given base folder
+      void Parse(const CString& text, const CString& baseFolder);
+
+      /// returns all audio tracks
+      const std::vector<CueSheetTrack>& Tracks() const { return m_tracks; }
+
+      /// returns all audio filenames, in the order of the tracks
+      std::vector<CString> GetFilenames() const;
+
+      /// \brief returns range of a track in its audio file, in CD frames
+      /// \details the end frame is 0 when the track ends at the end of the file
+      void GetTrackFrameRange(size_t trackIndex, unsigned int& startFrame, unsigned int& endFrame) const;
+
+      /// stores disc and track infos of a track in the track info
+      void SetTrackInfo(size_t trackIndex, TrackInfo& trackInfo) const;
+
+      /// converts CD frame position to sample position
+      static __int64 SampleFromFrame(unsigned int frame, unsigned int samplerateInHz)
+      {
+         return static_cast<__int64>(frame) * samplerateInHz / c_framesPerSecond;
+      }
+
+   private:
+      /// parses a single line of the cue sheet
+      void ParseLine(const CString& line, const CString& baseFolder);
+
+      /// finishes the current track, when it's an audio track
+      void FinishTrack();
+
+      /// splits line into command and arguments; quoted arguments may contain spaces
+      static std::vector<CString> SplitLine(const CString& line);
+
+      /// parses mm:ss:ff position and returns it in CD frames
+      static unsigned int ParsePosition(const CString& position);
+
+   private:
+      CString m_title;        ///< disc title
+      CString m_performer;    ///< disc performer
+      CString m_songwriter;   ///< disc songwriter
+      CString m_genre;        ///< genre, from REM GENRE
+      CString m_date;         ///< date, from REM DATE
+      CString m_comment;      ///< comment, from REM COMMENT
+
+      /// current audio filename, from the last FILE command
+      CString m_currentFilename;
+
+      /// indicates if the current track is an audio track
+      bool m_isAudioTrack = false;
+
+      /// all audio tracks
+      std::vector<CueSheetTrack> m_tracks;
+   };
+
+} // namespace Encoder
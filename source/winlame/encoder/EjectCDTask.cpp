@@ -22,12 +22,11 @@
 #include "stdafx.h"
 #include "EjectCDTask.hpp"
 #include "resource.h"
+#include "BassApiUsage.hpp"
 #include <basscd.h>
 
 using Encoder::EjectCDTask;
 
-extern std::atomic<unsigned int> s_bassApiusageCount;
-
 EjectCDTask::EjectCDTask(unsigned int dependentTaskId, unsigned int discDrive)
    :Task(dependentTaskId),
    m_discDrive(discDrive),
@@ -63,10 +62,8 @@ void EjectCDTask::Run()
 
    m_finished = false;
 
-   if (s_bassApiusageCount++ == 0)
-   {
-      BASS_Init(0, 44100, 0, nullptr, nullptr);
-   }
+   BassApiUsage bassApiUsage;
+   bassApiUsage.Init();
 
    if (BASS_CD_DoorIsLocked(m_discDrive) == FALSE &&
       BASS_CD_DoorIsOpen(m_discDrive) == FALSE)
@@ -80,10 +77,7 @@ void EjectCDTask::Run()
       }
    }
 
-   if (--s_bassApiusageCount == 0)
-   {
-      BASS_Free();
-   }
+   bassApiUsage.Free();
 
    m_finished = true;
 }
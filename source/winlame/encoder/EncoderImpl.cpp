@@ -24,8 +24,19 @@
 #include "EncoderImpl.hpp"
 #include <fstream>
 #include "LameOutputModule.hpp"
+#include "TranscodeCache.hpp"
+#include "BatchJournal.hpp"
+#include "FileSystemCache.hpp"
+#include "Playlist.hpp"
+#include "AudioFileTag.hpp"
+#include "CueSheet.hpp"
+#include "Mp3FrameCopier.hpp"
+#include <ulib/win32/ErrorMessage.hpp>
 #include <sndfile.h>
-#include <ulib/thread/LightweightMutex.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
 
 using namespace Encoder;
 
@@ -38,14 +49,23 @@ EncoderInterface* EncoderInterface::CreateEncoder()
 
 // globals
 
-/// mutex to protect threads from generating the same output filenames
-static LightweightMutex s_mutexTempOutputFile;
+/// maximum number of random temp filenames tried before giving up
+static const unsigned int c_maxTempFilenameTries = 16;
+
+/// maximum difference in length between the encoded samples and the samples
+/// decoded from a lossy output file; lossy formats may add encoder delay
+/// and padding samples
+static const double c_lossyVerifyToleranceInSeconds = 0.25;
 
 // EncoderImpl methods
 
 EncoderImpl::EncoderImpl()
    :m_settingsManager(nullptr),
-   m_moduleManager(IoCContainer::Current().Resolve<Encoder::ModuleManager>())
+   m_moduleManager(IoCContainer::Current().Resolve<Encoder::ModuleManager>()),
+   m_numRangeSamples(-1),
+   m_numDecodedSamples(0),
+   m_multipleOutputs(false),
+   m_mainOutputWritten(false)
 {
 }
 
@@ -86,6 +106,8 @@ void EncoderImpl::StartEncode()
    m_encoderState.m_running = true;
    m_encoderState.m_paused = false;
 
+   m_taskControl.Reset();
+
    // when there's a previous worker thread, it must already have been join()ed
    ATLASSERT(m_workerThread == nullptr || !m_workerThread->joinable());
 
@@ -94,16 +116,33 @@ void EncoderImpl::StartEncode()
          std::bind(&EncoderImpl::Encode, this)));
 }
 
+void EncoderImpl::PauseEncoding()
+{
+   std::unique_lock<std::recursive_mutex> lock(m_mutex);
+   m_encoderState.m_paused = !m_encoderState.m_paused;
+
+   if (m_encoderState.m_paused)
+      m_taskControl.Pause();
+   else
+      m_taskControl.Resume();
+}
+
 void EncoderImpl::StopEncode()
 {
-   // forces encoder to stop
+   // forces encoder to stop; also wakes up a paused main loop
    {
       std::unique_lock<std::recursive_mutex> lock(m_mutex);
       m_encoderState.m_running = false;
       m_encoderState.m_paused = false;
    }
 
-   // wait for thread to finish
+   m_taskControl.Stop();
+
+   WaitEncodeFinished();
+}
+
+void EncoderImpl::WaitEncodeFinished()
+{
    if (m_workerThread != nullptr)
    {
       m_workerThread->join();
@@ -123,14 +162,16 @@ void EncoderImpl::Encode()
 
    m_encoderState.m_percent = 0.f;
    m_encoderState.m_errorCode = 0;
+   m_encoderState.m_copiedOutput = false;
    m_encoderState.m_encodingDescription.Empty();
 
-   bool initOutputModule = false;
+   if (m_encoderSettings.m_batchJournal != nullptr)
+      m_encoderSettings.m_batchJournal->StartJob(m_encoderSettings.m_batchJournalJobId);
 
    ATLASSERT(m_inputModule == nullptr); // must not be set, or else Encode() was called twice!
-   ATLASSERT(m_outputModule == nullptr);
+   ATLASSERT(m_outputs.empty());
 
-   if (m_inputModule != nullptr || m_outputModule != nullptr)
+   if (m_inputModule != nullptr || !m_outputs.empty())
    {
       // end thread
       m_encoderState.m_running = false;
@@ -143,10 +184,9 @@ void EncoderImpl::Encode()
    // get input and output modules
    ModuleManagerImpl* modimpl = reinterpret_cast<ModuleManagerImpl*>(&m_moduleManager);
    m_inputModule = std::unique_ptr<InputModule>(modimpl->ChooseInputModule(m_encoderSettings.m_inputFilename));
-   m_outputModule = std::unique_ptr<OutputModule>(modimpl->GetOutputModule(m_encoderSettings.m_outputModuleID));
 
    if (m_inputModule == nullptr ||
-      m_outputModule == nullptr)
+      !CreateOutputModules(*modimpl))
    {
       // end thread
       m_encoderState.m_running = false;
@@ -162,6 +202,11 @@ void EncoderImpl::Encode()
          HandleError(m_encoderSettings.m_inputFilename, _T("Encoder"), -1, errorMessage);
       }
 
+      if (m_encoderSettings.m_batchJournal != nullptr)
+         m_encoderSettings.m_batchJournal->FinishJob(m_encoderSettings.m_batchJournalJobId);
+
+      m_inputModule.reset();
+      m_outputs.clear();
       return;
    }
 
@@ -170,116 +215,159 @@ void EncoderImpl::Encode()
 
    bool skipFile = false;
 
-   if (!PrepareInputModule(trackInfo))
+   if (!PrepareInputModule(trackInfo) ||
+      !PrepareInputRange())
       skipFile = true;
 
-   CString tempOutputFilename;
-
-   bool skipMoveFile = false;
    if (!skipFile)
    {
-      do
-      {
-         if (!PrepareOutputModule())
-         {
-            skipFile = true;
-            break;
-         }
+      // use the provided track info
+      if (m_encoderSettings.m_useTrackInfo)
+         trackInfo = m_encoderSettings.m_trackInfo;
 
-         // use the provided track info
-         if (m_encoderSettings.m_useTrackInfo)
-            trackInfo = m_encoderSettings.m_trackInfo;
+      // an output that can't be prepared is skipped; the other outputs are
+      // still encoded
+      for (auto& output : m_outputs)
+         PrepareOutput(*output);
 
-         // generate temporary name, in case the output module doesn't support unicode filenames
-         GenerateTempOutFilename(m_encoderSettings.m_outputFilename, tempOutputFilename);
+      m_multipleOutputs = std::count_if(m_outputs.begin(), m_outputs.end(),
+         [](const std::unique_ptr<EncoderOutput>& output) { return !output->m_skipFile && !IsCopiedOutput(*output); }) > 1;
 
-         // create folder when it doesn't exist
-         CString tempOutputFolder = Path::FolderName(tempOutputFilename);
-         if (!Path::FolderExists(tempOutputFolder))
-            Path::CreateDirectoryRecursive(tempOutputFolder);
+      for (auto& output : m_outputs)
+      {
+         if (!output->m_skipFile && !IsCopiedOutput(*output))
+            InitOutputModule(*output, trackInfo);
+      }
 
-         bool bRet = InitOutputModule(tempOutputFilename, trackInfo);
-         initOutputModule = true;
+      FormatEncodingDescription();
 
-         if (!bRet)
-         {
-            skipFile = true;
-            break;
-         }
+      if (std::any_of(m_outputs.begin(), m_outputs.end(),
+         [](const std::unique_ptr<EncoderOutput>& output) { return output->m_isPassThroughOutput; }))
+      {
+         CString passThroughInfo;
+         passThroughInfo.LoadString(IDS_ENCODER_PASS_THROUGH);
 
-         FormatEncodingDescription();
+         if (!m_encoderState.m_encodingDescription.IsEmpty())
+            m_encoderState.m_encodingDescription += _T("\r\n");
 
-      } while (false);
+         m_encoderState.m_encodingDescription += passThroughInfo;
+      }
    }
 
    lock.unlock();
 
-   if (!skipFile && !skipMoveFile)
-      skipFile = MainLoop();
+   bool isEncoding = std::any_of(m_outputs.begin(), m_outputs.end(),
+      [](const std::unique_ptr<EncoderOutput>& output) { return IsEncodingOutput(*output); });
 
-   if (!skipFile)
+   if (!skipFile && isEncoding)
    {
-      // write playlist entry, when enabled
-      if (m_encoderState.m_running && !m_encoderSettings.m_playlistFilename.IsEmpty())
-         WritePlaylistEntry(m_encoderSettings.m_outputFilename);
+      if (m_multipleOutputs)
+      {
+         skipFile = MainLoopMultipleOutputs();
+      }
+      else
+      {
+         auto iter = std::find_if(m_outputs.begin(), m_outputs.end(),
+            [](const std::unique_ptr<EncoderOutput>& output) { return IsEncodingOutput(*output); });
+
+         skipFile = MainLoop(**iter);
+      }
+   }
+
+   // when the input file failed, all outputs are skipped
+   if (skipFile)
+   {
+      for (auto& output : m_outputs)
+         output->m_skipFile = true;
    }
 
    // done with modules
    if (m_inputModule != nullptr)
       m_inputModule->DoneInput();
 
-   if (initOutputModule && m_outputModule != nullptr)
-      m_outputModule->DoneOutput();
+   for (auto& output : m_outputs)
+   {
+      if (output->m_initialized)
+         output->m_outputModule->DoneOutput();
+
+      output->m_outputModule.reset();
+   }
 
-   // delete modules
    m_inputModule.reset();
-   m_outputModule.reset();
 
-   // rename when we used a temporary filename
-   if (!skipFile)
-   {
-      if (!tempOutputFilename.IsEmpty() &&
-         m_encoderSettings.m_outputFilename != tempOutputFilename)
-      {
-         if (m_encoderSettings.m_overwriteExisting)
-            DeleteFile(m_encoderSettings.m_outputFilename);
+   // check the finished output files before they replace any existing files
+   if (!skipFile &&
+      m_encoderSettings.m_verifyOutput &&
+      m_encoderState.m_running)
+      VerifyOutputs();
 
-         // "delete after encoding" flag set, and output file is not input file ?
-         if (m_encoderSettings.m_deleteInputAfterEncode &&
-            m_encoderSettings.m_inputFilename != m_encoderSettings.m_outputFilename)
-            DeleteFile(m_encoderSettings.m_inputFilename);
+   m_mainOutputWritten = !m_outputs.front()->m_skipFile && m_encoderState.m_running;
 
-         MoveFile(tempOutputFilename, m_encoderSettings.m_outputFilename);
-      }
-      else
-      {
-         // delete the old file, if option is set
-         // as no temp output filename was generated, assume the names are different
-         if (m_encoderSettings.m_deleteInputAfterEncode)
-            DeleteFile(m_encoderSettings.m_inputFilename);
-      }
-   }
-   else
+   // report main output to the playlist, when enabled
+   if (m_mainOutputWritten &&
+      m_encoderSettings.m_playlist != nullptr)
+      SetPlaylistEntry();
+
+   // rename when we used a temporary filename
+   for (auto& output : m_outputs)
+      FinishOutput(*output, trackInfo);
+
+   // "delete after encoding" flag set, the whole input file was encoded,
+   // all outputs were written, and no output file is the input file?
+   if (m_encoderSettings.m_deleteInputAfterEncode &&
+      !m_encoderSettings.HasRange() &&
+      std::none_of(m_outputs.begin(), m_outputs.end(),
+         [&](const std::unique_ptr<EncoderOutput>& output)
+         {
+            return output->m_skipFile ||
+               output->m_outputFilename == m_encoderSettings.m_inputFilename;
+         }))
    {
-      // file was skipped; at least delete the temp / output file
-      if (!tempOutputFilename.IsEmpty())
-      {
-         DeleteFile(tempOutputFilename);
-      }
+      DeleteFile(m_encoderSettings.m_inputFilename);
 
-      if (!m_encoderSettings.m_outputFilename.IsEmpty() &&
-         m_encoderSettings.m_outputFilename != tempOutputFilename)
-      {
-         DeleteFile(m_encoderSettings.m_outputFilename);
-      }
+      if (m_encoderSettings.m_fileSystemCache != nullptr)
+         m_encoderSettings.m_fileSystemCache->RemoveFile(m_encoderSettings.m_inputFilename);
    }
 
+   m_outputs.clear();
+
+   // a stopped job isn't finished, and is resumed after a restart
+   if (m_encoderSettings.m_batchJournal != nullptr &&
+      m_encoderState.m_running)
+      m_encoderSettings.m_batchJournal->FinishJob(m_encoderSettings.m_batchJournalJobId);
+
    // end thread
    m_encoderState.m_running = false;
    m_encoderState.m_paused = false;
    m_encoderState.m_finished = true;
 }
 
+bool EncoderImpl::CreateOutputModules(ModuleManagerImpl& moduleManager)
+{
+   m_outputs.clear();
+
+   EncoderOutputSettings mainOutputSettings(m_encoderSettings.m_outputModuleID);
+   mainOutputSettings.m_outputFilename = m_encoderSettings.m_outputFilename;
+
+   std::vector<EncoderOutputSettings> allOutputSettings{ mainOutputSettings };
+   allOutputSettings.insert(allOutputSettings.end(),
+      m_encoderSettings.m_additionalOutputs.begin(),
+      m_encoderSettings.m_additionalOutputs.end());
+
+   for (const EncoderOutputSettings& outputSettings : allOutputSettings)
+   {
+      auto output = std::make_unique<EncoderOutput>(outputSettings);
+      output->m_outputModule.reset(moduleManager.GetOutputModule(outputSettings.m_outputModuleID));
+
+      if (output->m_outputModule == nullptr)
+         return false;
+
+      m_outputs.push_back(std::move(output));
+   }
+
+   return true;
+}
+
 bool EncoderImpl::PrepareInputModule(TrackInfo& trackInfo)
 {
    // init new
@@ -305,17 +393,186 @@ bool EncoderImpl::PrepareInputModule(TrackInfo& trackInfo)
    return true;
 }
 
-bool EncoderImpl::PrepareOutputModule()
+bool EncoderImpl::PrepareInputRange()
+{
+   m_numRangeSamples = -1;
+   m_numDecodedSamples = 0;
+
+   if (!m_encoderSettings.HasRange())
+      return true;
+
+   unsigned int samplerateInHz = static_cast<unsigned int>(m_sampleContainer.GetInputModuleSampleRate());
+
+   __int64 startSample = CueSheet::SampleFromFrame(m_encoderSettings.m_rangeStartFrame, samplerateInHz);
+
+   if (m_encoderSettings.m_rangeEndFrame != 0)
+   {
+      __int64 endSample = CueSheet::SampleFromFrame(m_encoderSettings.m_rangeEndFrame, samplerateInHz);
+      m_numRangeSamples = std::max<__int64>(endSample - startSample, 0);
+   }
+
+   if (startSample == 0)
+      return true;
+
+   int res = m_inputModule->CanSeek()
+      ? m_inputModule->SeekToSample(startSample)
+      : -1;
+
+   if (res < 0)
+   {
+      CString errorMessage = m_inputModule->GetLastError();
+      if (errorMessage.IsEmpty() || !m_inputModule->CanSeek())
+         errorMessage.LoadString(IDS_ENCODER_SEEK_ERROR);
+
+      HandleError(m_encoderSettings.m_inputFilename,
+         m_inputModule->GetModuleName(),
+         -res,
+         errorMessage);
+
+      m_encoderState.m_errorCode = 1;
+      return false;
+   }
+
+   return true;
+}
+
+int EncoderImpl::DecodeInputSamples()
 {
+   // range already completely decoded?
+   if (m_numRangeSamples >= 0 &&
+      m_numDecodedSamples >= m_numRangeSamples)
+      return 0;
+
+   int ret = m_inputModule->DecodeSamples(m_sampleContainer);
+
+   if (ret <= 0)
+      return ret;
+
+   // cut off samples after the end of the range
+   if (m_numRangeSamples >= 0)
+   {
+      __int64 numRemainingSamples = m_numRangeSamples - m_numDecodedSamples;
+      if (m_sampleContainer.GetNumSamples() > numRemainingSamples)
+         m_sampleContainer.LimitNumSamples(static_cast<int>(numRemainingSamples));
+   }
+
+   m_numDecodedSamples += m_sampleContainer.GetNumSamples();
+
+   return ret;
+}
+
+float EncoderImpl::GetPercentDone() const
+{
+   if (m_numRangeSamples <= 0)
+      return m_inputModule->PercentDone();
+
+   return static_cast<float>(m_numDecodedSamples * 100.0 / m_numRangeSamples);
+}
+
+bool EncoderImpl::PrepareOutput(EncoderOutput& output)
+{
+   if (!PrepareOutputModule(output))
+   {
+      output.m_skipFile = true;
+      return false;
+   }
+
+   // create folder when it doesn't exist; the temp file is created in the same folder
+   CreateFolder(Path::FolderName(output.m_outputFilename));
+
+   // generate temporary name, in case the output module doesn't support unicode filenames
+   if (!GenerateTempOutFilename(output.m_outputFilename, output.m_tempOutputFilename))
+   {
+      DWORD error = ::GetLastError();
+
+      CString errorMessage;
+      errorMessage.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
+      errorMessage.AppendFormat(_T(" (%s)"), Win32::ErrorMessage(error).ToString().GetString());
+
+      HandleError(m_encoderSettings.m_inputFilename, _T("Encoder"), -1, errorMessage);
+
+      m_encoderState.m_errorCode = 2;
+      output.m_skipFile = true;
+      return false;
+   }
+
+   if (m_encoderSettings.m_batchJournal != nullptr)
+      m_encoderSettings.m_batchJournal->AddTempFile(m_encoderSettings.m_batchJournalJobId, output.m_tempOutputFilename);
+
+   // copy input file when re-encoding isn't needed; only the tags are
+   // rewritten after copying
+   if (CanPassThrough(output))
+   {
+      if (CopyInputFile(output))
+      {
+         output.m_isPassThroughOutput = true;
+         m_encoderState.m_copiedOutput = true;
+         m_encoderState.m_percent = 100.f;
+         return true;
+      }
+
+      ATLTRACE(_T("EncoderImpl: couldn't copy input file %s, error %u; encoding instead\n"),
+         m_encoderSettings.m_inputFilename.GetString(), GetLastError());
+   }
+
+   // copy output from the cache when the input was already encoded
+   // with the same settings
+   output.m_transcodeCacheKey = CalculateTranscodeCacheKey(output.m_outputModuleID);
+   if (!output.m_transcodeCacheKey.IsEmpty() &&
+      m_encoderSettings.m_transcodeCache->Lookup(output.m_transcodeCacheKey, output.m_tempOutputFilename))
+   {
+      output.m_isCachedOutput = true;
+      m_encoderState.m_copiedOutput = true;
+      m_encoderState.m_percent = 100.f;
+   }
+
+   return true;
+}
+
+bool EncoderImpl::PrepareOutputModule(EncoderOutput& output)
+{
+   bool isMainOutput = &output == m_outputs.front().get();
+
    // prepare output module
-   m_outputModule->PrepareOutput(*m_settingsManager);
+   output.m_outputModule->PrepareOutput(*m_settingsManager);
 
    // do output filename
-   if (m_encoderSettings.m_outputFilename.IsEmpty())
-      m_encoderSettings.m_outputFilename = GetOutputFilename(m_encoderSettings.m_outputFolder, m_encoderSettings.m_inputFilename, *m_outputModule);
+   if (output.m_outputFilename.IsEmpty())
+   {
+      if (isMainOutput)
+      {
+         output.m_outputFilename = GetOutputFilename(m_encoderSettings.m_outputFolder, m_encoderSettings.m_inputFilename, *output.m_outputModule);
+      }
+      else
+      {
+         // additional outputs are stored next to the main output
+         const CString& mainOutputFilename = m_encoderSettings.m_outputFilename;
+         output.m_outputFilename = Path::Combine(Path::FolderName(mainOutputFilename),
+            Path::FilenameOnly(mainOutputFilename) + _T(".") + output.m_outputModule->GetOutputExtension());
+      }
+   }
+
+   // when a previous output already uses the same filename, add extra extension
+   for (const auto& otherOutput : m_outputs)
+   {
+      if (otherOutput.get() == &output)
+         break;
+
+      if (0 == otherOutput->m_outputFilename.CompareNoCase(output.m_outputFilename))
+      {
+         output.m_outputFilename += _T(".");
+         output.m_outputFilename += output.m_outputModule->GetOutputExtension();
+         break;
+      }
+   }
 
    // test if input and output file name is the same file
-   if (!CheckSameInputOutputFilenames(m_encoderSettings.m_inputFilename, m_encoderSettings.m_outputFilename, *m_outputModule))
+   bool isSameFilename = !CheckSameInputOutputFilenames(m_encoderSettings.m_inputFilename, output.m_outputFilename, *output.m_outputModule);
+
+   if (isMainOutput)
+      m_encoderSettings.m_outputFilename = output.m_outputFilename;
+
+   if (isSameFilename)
    {
       m_encoderState.m_errorCode = 2;
       return false;
@@ -323,7 +580,7 @@ bool EncoderImpl::PrepareOutputModule()
 
    // check if outputFilename already exists
    if (!m_encoderSettings.m_overwriteExisting &&
-      Path::FileExists(m_encoderSettings.m_outputFilename))
+      FileExists(output.m_outputFilename))
    {
       m_encoderState.m_errorCode = 2;
       return false;
@@ -359,12 +616,12 @@ bool EncoderImpl::CheckSameInputOutputFilenames(const CString& inputFilename,
    for (int i = 0; i < 2; i++)
    {
       // first, test if output filename already exists
-      if (!Path::FileExists(outputFilename))
+      if (!FileExists(outputFilename))
          break; // no, so we don't need to test
 
       // check if the file's short name is the same
-      CString shortInputFilename = Path::ShortPathName(inputFilename);
-      CString shortOutputFilename = Path::ShortPathName(outputFilename);
+      CString shortInputFilename = ShortPathName(inputFilename);
+      CString shortOutputFilename = ShortPathName(outputFilename);
 
       if (0 == shortInputFilename.CompareNoCase(shortOutputFilename))
       {
@@ -381,7 +638,7 @@ bool EncoderImpl::CheckSameInputOutputFilenames(const CString& inputFilename,
             {
                // when not overwriting original, add extra extension
                outputFilename += _T(".");
-               outputFilename += m_outputModule->GetOutputExtension();
+               outputFilename += outputModule.GetOutputExtension();
             }
             continue;
          }
@@ -396,57 +653,136 @@ bool EncoderImpl::CheckSameInputOutputFilenames(const CString& inputFilename,
    return true;
 }
 
-void EncoderImpl::GenerateTempOutFilename(const CString& originalFilename, CString& tempFilename)
+bool EncoderImpl::FileExists(const CString& filename) const
 {
-   LightweightMutex::LockType lock(s_mutexTempOutputFile);
+   if (m_encoderSettings.m_fileSystemCache != nullptr)
+      return m_encoderSettings.m_fileSystemCache->FileExists(filename);
 
-   tempFilename = originalFilename;
+   return Path::FileExists(filename);
+}
 
+CString EncoderImpl::ShortPathName(const CString& pathName) const
+{
+   if (m_encoderSettings.m_fileSystemCache != nullptr)
+      return m_encoderSettings.m_fileSystemCache->ShortPathName(pathName);
+
+   return Path::ShortPathName(pathName);
+}
+
+void EncoderImpl::CreateFolder(const CString& folderName) const
+{
+   if (m_encoderSettings.m_fileSystemCache != nullptr)
+      m_encoderSettings.m_fileSystemCache->CreateFolder(folderName);
+   else if (!Path::FolderExists(folderName))
+      Path::CreateDirectoryRecursive(folderName);
+}
+
+bool EncoderImpl::GenerateTempOutFilename(const CString& originalFilename, CString& tempFilename)
+{
    CString pathName = Path::FolderName(originalFilename);
    CString fileName = Path::FilenameAndExt(originalFilename);
 
-   // find short name of path
-   CString shortPathName = Path::ShortPathName(pathName);
+   // use short name of path, but only when the path can't be represented in ansi
+   if (CString(CStringA(pathName)) != pathName)
+      pathName = Path::ShortPathName(pathName);
 
    // convert filename to ansi and back, and remove '?' chars
    fileName = CString(CStringA(fileName));
    fileName.Replace(_T('?'), _T('_'));
 
-   // now add a ".temp" suffix
-   unsigned int fileIndex = 0;
-   do
+   // add a random suffix and create the file exclusively; when another
+   // thread or process already created a file with that name, try another
+   // suffix; this needs no lock and no check if the file exists
+   std::random_device randomDevice;
+
+   DWORD error = ERROR_FILE_EXISTS;
+   for (unsigned int numTries = 0; numTries < c_maxTempFilenameTries; numTries++)
    {
-      tempFilename = Path::Combine(shortPathName, fileName);
-      if (fileIndex == 0)
-         tempFilename += _T(".temp");
-      else
+      tempFilename = Path::Combine(pathName, fileName);
+      tempFilename.AppendFormat(_T(".%08x.temp"), randomDevice());
+
+      HANDLE file = ::CreateFile(tempFilename, GENERIC_WRITE, 0, nullptr,
+         CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+      if (file != INVALID_HANDLE_VALUE)
       {
-         tempFilename.AppendFormat(_T(".%u.temp"), fileIndex);
+         ::CloseHandle(file);
+         return true;
       }
 
-      fileIndex++;
+      error = ::GetLastError();
+      if (error != ERROR_FILE_EXISTS &&
+         error != ERROR_ALREADY_EXISTS)
+         break; // e.g. the output folder doesn't exist
    }
-   while (Path::FileExists(tempFilename));
 
-   // create a dummy file so the next thread can't use this filename anymore
-   FILE* fd = _tfopen(tempFilename, _T("wb"));
-   if (fd != nullptr)
-      fclose(fd);
+   // the name must not be used, since the file may belong to another task
+   ATLTRACE(_T("couldn't create temp output file %s, error %u\n"), tempFilename.GetString(), error);
+   tempFilename.Empty();
+
+   ::SetLastError(error);
+   return false;
+}
+
+CString EncoderImpl::CalculateTranscodeCacheKey(int outputModuleID)
+{
+   if (m_encoderSettings.m_transcodeCache == nullptr ||
+      !m_encoderSettings.m_transcodeCache->IsEnabled())
+      return CString();
+
+   // the key is calculated from the whole input file
+   if (m_encoderSettings.HasRange())
+      return CString();
+
+   // nogap encoded files depend on the previous and next file
+   if (outputModuleID == ID_OM_LAME &&
+      m_settingsManager->QueryValueInt(LameOptNoGap) != 0)
+      return CString();
+
+   return TranscodeCache::CalculateKey(
+      m_encoderSettings.m_inputFilename,
+      outputModuleID,
+      *m_settingsManager);
 }
 
-bool EncoderImpl::InitOutputModule(const CString& tempOutputFilename, const TrackInfo& trackInfo)
+bool EncoderImpl::InitOutputModule(EncoderOutput& output, const TrackInfo& trackInfo)
 {
+   // pass on input length, so that output modules can preallocate the output file
+   int numChannels = 0, bitrateInBps = 0, lengthInSeconds = 0, samplerateInHz = 0;
+   m_inputModule->GetInfo(numChannels, bitrateInBps, lengthInSeconds, samplerateInHz);
+
+   if (m_numRangeSamples >= 0 && samplerateInHz > 0)
+      lengthInSeconds = static_cast<int>(m_numRangeSamples / samplerateInHz);
+
+   m_settingsManager->setValue(GeneralInputLengthInSeconds, std::max(lengthInSeconds, 0));
+
+   // with multiple outputs, each output converts the decoded samples in its
+   // own sample container
+   if (m_multipleOutputs)
+   {
+      output.m_sampleContainer.SetInputModuleTraits(
+         m_sampleContainer.GetInputModuleBitsPerSample(),
+         SamplesInterleaved,
+         m_sampleContainer.GetInputModuleSampleRate(),
+         m_sampleContainer.GetInputModuleChannels());
+
+      output.m_sampleContainer.ReserveSamples(m_sampleContainer.GetReservedNumSamples());
+   }
+
    // init output module
-   int res = m_outputModule->InitOutput(tempOutputFilename, *m_settingsManager,
-      trackInfo, m_sampleContainer);
+   int res = output.m_outputModule->InitOutput(output.m_tempOutputFilename, *m_settingsManager,
+      trackInfo, m_multipleOutputs ? output.m_sampleContainer : m_sampleContainer);
+
+   output.m_initialized = true;
 
    // catch errors
    if (res < 0)
    {
-      HandleError(m_encoderSettings.m_inputFilename, m_outputModule->GetModuleName(),
-         -res, m_outputModule->GetLastError());
+      HandleError(m_encoderSettings.m_inputFilename, output.m_outputModule->GetModuleName(),
+         -res, output.m_outputModule->GetLastError());
 
       m_encoderState.m_errorCode = 2;
+      output.m_skipFile = true;
       return false;
    }
 
@@ -455,8 +791,22 @@ bool EncoderImpl::InitOutputModule(const CString& tempOutputFilename, const Trac
 
 void EncoderImpl::FormatEncodingDescription()
 {
+   CString outputDescription;
+   for (const auto& output : m_outputs)
+   {
+      if (!IsEncodingOutput(*output))
+         continue;
+
+      if (!outputDescription.IsEmpty())
+         outputDescription += _T("\r\n");
+
+      outputDescription += output->m_outputModule->GetDescription();
+   }
+
+   if (outputDescription.IsEmpty())
+      return;
+
    CString inputDescription = m_inputModule->GetDescription();
-   CString outputDescription = m_outputModule->GetDescription();
 
    CString containerInfo;
 #ifdef _DEBUG
@@ -489,6 +839,183 @@ bool EncoderImpl::IsLossyInputModule(int inputModuleID)
       inputModuleID == ID_IM_LIBMPG123;
 }
 
+/// returns typical bitrate of LAME VBR quality levels 0 to 9, in bps; the
+/// bitrates are for stereo input and are halved for mono input
+static int GetLameQualityBitrate(int quality, int numChannels)
+{
+   static const int c_bitratesInKbps[10] = { 245, 225, 190, 175, 165, 130, 115, 100, 85, 65 };
+
+   int bitrateInBps = c_bitratesInKbps[std::max(0, std::min(9, quality))] * 1000;
+   return numChannels == 1 ? bitrateInBps / 2 : bitrateInBps;
+}
+
+/// returns nominal bitrate of Vorbis base quality, in bps; the base quality
+/// is given in 1/1000, from -100 to 1000 (q-1 to q10); the bitrates are for
+/// stereo input and are halved for mono input
+static int GetVorbisQualityBitrate(int baseQuality, int numChannels)
+{
+   static const int c_bitratesInKbps[12] = { 45, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 500 };
+
+   // interpolates between the full quality levels, starting at q-1
+   double level = std::max(0.0, std::min(11.0, baseQuality / 100.0 + 1.0));
+   int index = std::min(10, static_cast<int>(level));
+
+   double bitrateInKbps = c_bitratesInKbps[index] +
+      (level - index) * (c_bitratesInKbps[index + 1] - c_bitratesInKbps[index]);
+
+   int bitrateInBps = static_cast<int>(bitrateInKbps * 1000);
+   return numChannels == 1 ? bitrateInBps / 2 : bitrateInBps;
+}
+
+bool EncoderImpl::CanPassThrough(const EncoderOutput& output)
+{
+   // only the whole input file can be copied
+   if (!m_encoderSettings.m_allowPassThrough ||
+      m_encoderSettings.HasRange())
+      return false;
+
+   int inputModuleID = m_inputModule->GetModuleID();
+   if (GetPassThroughOutputModuleID(inputModuleID) != output.m_outputModuleID)
+      return false;
+
+   if (!IsLossyInputModule(inputModuleID))
+   {
+      // lossless input and output; FLAC files decode to the same samples
+      // regardless of the compression level, and sound files must have
+      // the same format
+      return output.m_outputModuleID == ID_OM_FLAC ||
+         IsSameSoundFileFormat();
+   }
+
+   // lossy input and output; re-encoding can only lose quality, unless a
+   // lower bitrate than the input file's bitrate is requested
+   int numChannels = 0, bitrateInBps = 0, lengthInSeconds = 0, samplerateInHz = 0;
+   m_inputModule->GetInfo(numChannels, bitrateInBps, lengthInSeconds, samplerateInHz);
+
+   if (bitrateInBps <= 0 || numChannels <= 0 || samplerateInHz <= 0)
+      return false;
+
+   // there's no resampling setting, so the output has the input's sample
+   // rate; only mono and downmix settings change the number of channels
+   int outputNumChannels = numChannels;
+   int outputSamplerateInHz = samplerateInHz;
+
+   int targetBitrateInBps = 0;
+   switch (output.m_outputModuleID)
+   {
+   case ID_OM_OPUS:
+      targetBitrateInBps = m_settingsManager->QueryValueInt(OpusTargetBitrate) * 1000;
+
+      // the output module downmixes surround input at low bitrates, and
+      // always codes at 48 kHz
+      if (numChannels > 2 && targetBitrateInBps < 16000 * numChannels)
+         outputNumChannels = numChannels > 8 ? 1 : 2;
+
+      outputSamplerateInHz = 48000;
+      break;
+
+   case ID_OM_OGGV:
+      switch (m_settingsManager->QueryValueInt(OggBitrateMode))
+      {
+      case 0: // quality mode
+         targetBitrateInBps = GetVorbisQualityBitrate(m_settingsManager->QueryValueInt(OggBaseQuality), numChannels);
+         break;
+      case 1: // variable bitrate mode
+         targetBitrateInBps = m_settingsManager->QueryValueInt(OggVarMaxBitrate) * 1000;
+         break;
+      default:
+         targetBitrateInBps = m_settingsManager->QueryValueInt(OggVarNominalBitrate) * 1000;
+         break;
+      }
+      break;
+
+   case ID_OM_LAME:
+      // nogap encoded files depend on the previous and next file, and wave
+      // headers need re-encoding
+      if (m_settingsManager->QueryValueInt(LameOptNoGap) != 0 ||
+         m_settingsManager->QueryValueInt(LameWriteWaveHeader) != 0)
+         return false;
+
+      if (m_settingsManager->QueryValueInt(LameSimpleMono) == 1)
+         outputNumChannels = 1;
+
+      if (m_settingsManager->QueryValueInt(LameSimpleQualityOrBitrate) != 0)
+         targetBitrateInBps = GetLameQualityBitrate(m_settingsManager->QueryValueInt(LameSimpleQuality), numChannels);
+      else
+         targetBitrateInBps = m_settingsManager->QueryValueInt(LameSimpleBitrate) * 1000;
+      break;
+
+   default:
+      return false;
+   }
+
+   if (outputNumChannels != numChannels ||
+      outputSamplerateInHz != samplerateInHz)
+      return false;
+
+   // the input module reports the bitrate of the first frame; for VBR MP3
+   // files this may be far below the average, e.g. for a silent frame, so
+   // the average bitrate of all frames is compared instead
+   if (inputModuleID == ID_IM_LIBMPG123)
+   {
+      Mp3FrameCopier frameCopier;
+      if (!frameCopier.Scan(m_encoderSettings.m_inputFilename))
+         return false;
+
+      bitrateInBps = frameCopier.StreamInfo().GetAverageBitrate();
+   }
+
+   return bitrateInBps <= targetBitrateInBps;
+}
+
+bool EncoderImpl::CopyInputFile(const EncoderOutput& output)
+{
+   // MP3 files are copied frame by frame, leaving out the old tags; the
+   // LAME tag with encoder delay and padding is kept
+   if (output.m_outputModuleID == ID_OM_LAME)
+   {
+      Mp3FrameCopier frameCopier;
+      if (!frameCopier.Copy(m_encoderSettings.m_inputFilename, output.m_tempOutputFilename))
+         return false;
+
+      ATLTRACE(_T("EncoderImpl: copied %u MP3 frames, skipped %I64u bytes\n"),
+         frameCopier.StreamInfo().m_numFrames,
+         frameCopier.StreamInfo().m_numSkippedBytes);
+
+      return true;
+   }
+
+   return CopyFile(m_encoderSettings.m_inputFilename, output.m_tempOutputFilename, FALSE) != FALSE;
+}
+
+bool EncoderImpl::IsSameSoundFileFormat() const
+{
+   SF_INFO info = {};
+   SNDFILE* sndfile = sf_open(CStringA(GetAnsiCompatFilename(m_encoderSettings.m_inputFilename)), SFM_READ, &info);
+   if (sndfile == nullptr)
+      return false;
+
+   sf_close(sndfile);
+
+   return
+      (info.format & SF_FORMAT_TYPEMASK) == m_settingsManager->QueryValueInt(SndFileFormat) &&
+      (info.format & SF_FORMAT_SUBMASK) == m_settingsManager->QueryValueInt(SndFileSubType);
+}
+
+int EncoderImpl::GetPassThroughOutputModuleID(int inputModuleID)
+{
+   switch (inputModuleID)
+   {
+   case ID_IM_FLAC: return ID_OM_FLAC;
+   case ID_IM_OGGV: return ID_OM_OGGV;
+   case ID_IM_OPUS: return ID_OM_OPUS;
+   case ID_IM_SNDFILE: return ID_OM_WAVE;
+   case ID_IM_LIBMPG123: return ID_OM_LAME;
+   default:
+      return -1;
+   }
+}
+
 bool EncoderImpl::IsLossyOutputModule(int outputModuleID)
 {
    return
@@ -499,13 +1026,13 @@ bool EncoderImpl::IsLossyOutputModule(int outputModuleID)
       outputModuleID == ID_OM_OPUS;
 }
 
-bool EncoderImpl::MainLoop()
+bool EncoderImpl::MainLoop(EncoderOutput& output)
 {
-   bool skipFile = false;
+   bool inputFailed = false;
 
    do
    {
-      int ret = m_inputModule->DecodeSamples(m_sampleContainer);
+      int ret = DecodeInputSamples();
 
       // no more samples?
       if (ret == 0)
@@ -520,57 +1047,433 @@ bool EncoderImpl::MainLoop()
             m_inputModule->GetLastError());
 
          m_encoderState.m_errorCode = 3;
-         skipFile = true;
+         inputFailed = true;
+         break;
       }
 
       // get percent done
-      m_encoderState.m_percent = m_inputModule->PercentDone();
+      m_encoderState.m_percent = GetPercentDone();
+
+      // the output module may modify the samples in place
+      if (m_encoderSettings.m_verifyOutput)
+         output.m_encodedChecksum.Add(m_sampleContainer);
 
       // stuff all samples received into output module
-      ret = m_outputModule->EncodeSamples(m_sampleContainer);
+      ret = output.m_outputModule->EncodeSamples(m_sampleContainer);
 
       // catch errors
       if (ret < 0)
       {
-         HandleError(m_encoderSettings.m_inputFilename, m_outputModule->GetModuleName(),
-            -ret, m_outputModule->GetLastError());
+         HandleError(m_encoderSettings.m_inputFilename, output.m_outputModule->GetModuleName(),
+            -ret, output.m_outputModule->GetLastError());
 
          m_encoderState.m_errorCode = 4;
-         skipFile = true;
+         output.m_skipFile = true;
       }
 
       // check if we should stop the thread
       if (!m_encoderState.m_running ||
-         skipFile)
+         output.m_skipFile)
          break;
 
-      // sleep if we should pause
-      while (m_encoderState.m_paused)
-         Sleep(50);
+      // wait while paused; returns false when stopped
+      if (!m_taskControl.CheckPoint())
+         break;
    }
    while (true); // outer encoding loop
 
-   return skipFile;
+   m_taskControl.LeaveWorkerThread();
+
+   return inputFailed;
 }
 
-void EncoderImpl::WritePlaylistEntry(const CString& outputFilename)
+bool EncoderImpl::MainLoopMultipleOutputs()
 {
-   CString playlistPathAndFilename = Path::Combine(m_encoderSettings.m_outputFolder, m_encoderSettings.m_playlistFilename);
+   // the decoded samples are passed to the outputs unchanged
+   int bitsPerSample = m_sampleContainer.GetInputModuleBitsPerSample();
+   m_sampleContainer.SetOutputModuleTraits(bitsPerSample, SamplesInterleaved);
 
-   FILE* fd = _tfopen(playlistPathAndFilename, _T("at"));
-   if (fd == nullptr)
-      return;
+   size_t bytesPerSample = static_cast<size_t>(bitsPerSample / 8) * m_sampleContainer.GetInputModuleChannels();
+
+   unsigned int numOutputs = 0;
+   for (auto& output : m_outputs)
+   {
+      if (!IsEncodingOutput(*output))
+         continue;
 
-   // get filename, without path
-   CString filename = Path::FilenameAndExt(outputFilename);
+      EncoderOutput& encoderOutput = *output;
+      output->m_outputThread = std::thread([this, &encoderOutput]() { RunOutputThread(encoderOutput); });
 
-   // write to playlist file
-   _ftprintf(fd, _T("%s\n"), filename.GetString());
-   fclose(fd);
+      numOutputs++;
+   }
+
+   bool inputFailed = false;
+   bool inputFinished = false;
+   std::chrono::steady_clock::duration decodeTime{};
+
+   do
+   {
+      auto decodeStart = std::chrono::steady_clock::now();
+
+      int ret = DecodeInputSamples();
+
+      decodeTime += std::chrono::steady_clock::now() - decodeStart;
+
+      // no more samples?
+      if (ret == 0)
+      {
+         inputFinished = true;
+         break;
+      }
+
+      // catch errors
+      if (ret < 0)
+      {
+         HandleError(m_encoderSettings.m_inputFilename,
+            m_inputModule->GetModuleName(),
+            -ret,
+            m_inputModule->GetLastError());
+
+         m_encoderState.m_errorCode = 3;
+         inputFailed = true;
+         break;
+      }
+
+      // get percent done
+      m_encoderState.m_percent = GetPercentDone();
+
+      int numSamples = 0;
+      void* samples = m_sampleContainer.GetSamplesInterleaved(numSamples);
+
+      if (numSamples > 0)
+      {
+         auto block = std::make_shared<const SampleBlock>(samples, numSamples, bytesPerSample);
+
+         // outputs that failed don't accept any more blocks
+         bool isBlockAccepted = false;
+         for (auto& output : m_outputs)
+         {
+            if (output->m_outputThread.joinable() &&
+               output->m_queue.Push(block))
+               isBlockAccepted = true;
+         }
+
+         if (!isBlockAccepted)
+            break;
+      }
+
+      // check if we should stop the thread
+      if (!m_encoderState.m_running)
+         break;
+
+      // wait while paused; returns false when stopped
+      if (!m_taskControl.CheckPoint())
+         break;
+   }
+   while (true); // outer encoding loop
+
+   // let the outputs encode all queued blocks, unless decoding was stopped
+   for (auto& output : m_outputs)
+   {
+      if (!output->m_outputThread.joinable())
+         continue;
+
+      if (inputFinished)
+         output->m_queue.Close();
+      else
+         output->m_queue.Abort();
+
+      output->m_outputThread.join();
+   }
+
+   m_taskControl.LeaveWorkerThread();
+
+   // report the time that was saved by decoding only once
+   if (inputFinished && numOutputs > 1)
+   {
+      double savedSeconds = std::chrono::duration<double>(decodeTime).count() * (numOutputs - 1);
+
+      CString decodeTimeInfo;
+      decodeTimeInfo.Format(IDS_ENCODER_DECODE_TIME_SAVED, numOutputs, savedSeconds);
+
+      std::unique_lock<std::recursive_mutex> lock(m_mutex);
+      m_encoderState.m_encodingDescription += decodeTimeInfo;
+   }
+
+   return inputFailed;
+}
+
+void EncoderImpl::RunOutputThread(EncoderOutput& output)
+{
+   std::shared_ptr<const SampleBlock> block;
+   while ((block = output.m_queue.Pop()) != nullptr)
+   {
+      // the samples are only read, and the block is shared with the other outputs
+      output.m_sampleContainer.PutSamplesInterleaved(
+         const_cast<BYTE*>(block->m_data.data()), block->m_numSamples);
+
+      if (m_encoderSettings.m_verifyOutput)
+         output.m_encodedChecksum.Add(output.m_sampleContainer);
+
+      int ret = output.m_outputModule->EncodeSamples(output.m_sampleContainer);
+
+      // catch errors; the other outputs continue encoding
+      if (ret < 0)
+      {
+         HandleError(m_encoderSettings.m_inputFilename, output.m_outputModule->GetModuleName(),
+            -ret, output.m_outputModule->GetLastError());
+
+         {
+            // other output threads may set the error code at the same time
+            std::unique_lock<std::recursive_mutex> lock(m_mutex);
+            m_encoderState.m_errorCode = 4;
+         }
+
+         output.m_skipFile = true;
+
+         output.m_queue.Abort();
+         break;
+      }
+   }
+}
+
+void EncoderImpl::VerifyOutputs()
+{
+   // each output is decoded by its own input module instance
+   std::vector<std::thread> verifyThreads;
+
+   for (auto& output : m_outputs)
+   {
+      if (!IsEncodingOutput(*output) ||
+         !IsVerifiableOutput(*output))
+         continue;
+
+      EncoderOutput& encoderOutput = *output;
+      verifyThreads.emplace_back([this, &encoderOutput]()
+      {
+         if (!VerifyOutput(encoderOutput))
+            encoderOutput.m_skipFile = true;
+      });
+   }
+
+   for (std::thread& verifyThread : verifyThreads)
+      verifyThread.join();
+}
+
+/// returns number of bits per sample stored by given sound file subtype, or
+/// 0 when the subtype doesn't store integer PCM samples
+static int GetSoundFileBitsPerSample(int subType)
+{
+   switch (subType)
+   {
+   case SF_FORMAT_PCM_S8:
+   case SF_FORMAT_PCM_U8:
+      return 8;
+   case SF_FORMAT_PCM_16:
+      return 16;
+   case SF_FORMAT_PCM_24:
+      return 24;
+   case SF_FORMAT_PCM_32:
+      return 32;
+   default:
+      return 0;
+   }
+}
+
+bool EncoderImpl::IsVerifiableOutput(const EncoderOutput& output) const
+{
+   // nogap encoded files are only finished with the last file, and MP3 files
+   // with a wave header can't be decoded by the input modules
+   if (output.m_outputModuleID == ID_OM_LAME &&
+      (m_settingsManager->QueryValueInt(LameOptNoGap) != 0 ||
+         m_settingsManager->QueryValueInt(LameWriteWaveHeader) != 0))
+      return false;
+
+   return true;
+}
+
+bool EncoderImpl::VerifyOutput(EncoderOutput& output)
+{
+   // the temporary output file doesn't have the output file's extension
+   ModuleManagerImpl* modimpl = reinterpret_cast<ModuleManagerImpl*>(&m_moduleManager);
+   std::unique_ptr<InputModule> inputModule(modimpl->ChooseInputModule(output.m_outputFilename));
+
+   if (inputModule == nullptr)
+   {
+      ATLTRACE(_T("EncoderImpl: no input module to verify output file %s\n"),
+         output.m_outputFilename.GetString());
+      return true;
+   }
+
+   CString filename = output.m_tempOutputFilename.IsEmpty() ? output.m_outputFilename : output.m_tempOutputFilename;
+
+   TrackInfo trackInfo;
+   SampleContainer samples;
+   SettingsManager settingsManager;
+
+   PcmChecksum decodedChecksum;
+   CString errorMessage;
+
+   int ret = inputModule->InitInput(filename, settingsManager, trackInfo, samples);
+   if (ret >= 0)
+   {
+      samples.SetOutputModuleTraits(32, SamplesInterleaved);
+
+      while ((ret = inputModule->DecodeSamples(samples)) > 0)
+      {
+         decodedChecksum.Add(samples);
+
+         // stop verifying when encoding was stopped
+         if (!m_encoderState.m_running)
+         {
+            inputModule->DoneInput();
+            return true;
+         }
+      }
+   }
+
+   const PcmChecksum& encodedChecksum = output.m_encodedChecksum;
+
+   if (ret < 0)
+   {
+      errorMessage.LoadString(IDS_ENCODER_VERIFY_FAILED);
+      errorMessage.AppendFormat(_T(" (%s)"), inputModule->GetLastError().GetString());
+   }
+   else if (!IsLossyOutputModule(output.m_outputModuleID))
+   {
+      // samples that are stored with less bits than used by the encoded
+      // samples are expected to differ
+      int storedBitsPerSample = samples.GetInputModuleBitsPerSample();
+      if (output.m_outputModuleID == ID_OM_WAVE)
+         storedBitsPerSample = GetSoundFileBitsPerSample(m_settingsManager->QueryValueInt(SndFileSubType));
+
+      if (decodedChecksum.GetNumSamples() != encodedChecksum.GetNumSamples())
+      {
+         errorMessage.LoadString(IDS_ENCODER_VERIFY_FAILED);
+         errorMessage.AppendFormat(_T(" (%I64d samples encoded, %I64d samples decoded)"),
+            encodedChecksum.GetNumSamples(), decodedChecksum.GetNumSamples());
+      }
+      else if (encodedChecksum.IsHashed() &&
+         encodedChecksum.GetPrecision() <= storedBitsPerSample &&
+         decodedChecksum.GetHash() != encodedChecksum.GetHash())
+      {
+         errorMessage.LoadString(IDS_ENCODER_VERIFY_FAILED);
+         errorMessage.AppendFormat(_T(" (PCM checksum %016I64x, expected %016I64x)"),
+            decodedChecksum.GetHash(), encodedChecksum.GetHash());
+      }
+   }
+   else
+   {
+      // lossy output files may have been resampled
+      double encodedSeconds = double(encodedChecksum.GetNumSamples()) / m_sampleContainer.GetInputModuleSampleRate();
+      double decodedSeconds = double(decodedChecksum.GetNumSamples()) / samples.GetInputModuleSampleRate();
+
+      if (std::abs(encodedSeconds - decodedSeconds) > c_lossyVerifyToleranceInSeconds)
+      {
+         errorMessage.LoadString(IDS_ENCODER_VERIFY_FAILED);
+         errorMessage.AppendFormat(_T(" (%.2f seconds encoded, %.2f seconds decoded)"),
+            encodedSeconds, decodedSeconds);
+      }
+   }
+
+   inputModule->DoneInput();
+
+   if (errorMessage.IsEmpty())
+      return true;
+
+   HandleError(m_encoderSettings.m_inputFilename, inputModule->GetModuleName(), 0, errorMessage);
+
+   std::unique_lock<std::recursive_mutex> lock(m_mutex);
+   m_encoderState.m_errorCode = 5;
+
+   return false;
+}
+
+void EncoderImpl::FinishOutput(EncoderOutput& output, const TrackInfo& trackInfo)
+{
+   if (!output.m_skipFile)
+   {
+      if (!output.m_tempOutputFilename.IsEmpty() &&
+         output.m_outputFilename != output.m_tempOutputFilename)
+      {
+         // replace an existing output file in one step, so that there's
+         // always a complete output file, even when the rename fails
+         DWORD moveFlags = MOVEFILE_COPY_ALLOWED;
+         if (m_encoderSettings.m_overwriteExisting)
+            moveFlags |= MOVEFILE_REPLACE_EXISTING;
+
+         if (m_settingsManager->QueryValueInt(GeneralOutputFlushOnClose) != 0)
+            moveFlags |= MOVEFILE_WRITE_THROUGH;
+
+         BOOL moved = MoveFileEx(output.m_tempOutputFilename, output.m_outputFilename, moveFlags);
+
+         if (moved && m_encoderSettings.m_fileSystemCache != nullptr)
+            m_encoderSettings.m_fileSystemCache->AddFile(output.m_outputFilename);
+
+         if (moved && m_encoderSettings.m_batchJournal != nullptr)
+            m_encoderSettings.m_batchJournal->AddOutputFile(m_encoderSettings.m_batchJournalJobId, output.m_outputFilename);
+
+         if (moved && IsCopiedOutput(output))
+         {
+            // the copied output still has the tags of the file it was copied from
+            AudioFileTag tag(trackInfo);
+            tag.ReplaceInFile(output.m_outputFilename);
+         }
+         else if (moved && !output.m_transcodeCacheKey.IsEmpty() &&
+            m_encoderState.m_running && m_encoderState.m_errorCode == 0)
+         {
+            m_encoderSettings.m_transcodeCache->Store(output.m_transcodeCacheKey, output.m_outputFilename);
+         }
+      }
+   }
+   else
+   {
+      // output was skipped; at least delete the temp / output file
+      if (!output.m_tempOutputFilename.IsEmpty())
+      {
+         DeleteFile(output.m_tempOutputFilename);
+      }
+
+      if (!output.m_outputFilename.IsEmpty() &&
+         output.m_outputFilename != output.m_tempOutputFilename)
+      {
+         DeleteFile(output.m_outputFilename);
+
+         if (m_encoderSettings.m_fileSystemCache != nullptr)
+            m_encoderSettings.m_fileSystemCache->RemoveFile(output.m_outputFilename);
+      }
+   }
+}
+
+bool EncoderImpl::GetMainOutput(CString& outputFilename, __int64& numDecodedSamples, int& samplerateInHz) const
+{
+   outputFilename = m_encoderSettings.m_outputFilename;
+   numDecodedSamples = m_numDecodedSamples;
+   samplerateInHz = m_sampleContainer.GetInputModuleSampleRate();
+
+   return m_mainOutputWritten;
+}
+
+void EncoderImpl::SetPlaylistEntry()
+{
+   // the length is calculated from the decoded samples; outputs that were
+   // copied from the input or from the transcode cache keep the length
+   // that was expected when the task was created
+   double lengthInSeconds = 0.0;
+
+   int samplerateInHz = m_sampleContainer.GetInputModuleSampleRate();
+   if (m_numDecodedSamples > 0 && samplerateInHz > 0)
+      lengthInSeconds = static_cast<double>(m_numDecodedSamples) / samplerateInHz;
+
+   m_encoderSettings.m_playlist->SetEncodedEntry(m_encoderSettings.m_playlistEntryIndex,
+      m_encoderSettings.m_outputFilename, lengthInSeconds);
 }
 
 void EncoderImpl::HandleError(LPCTSTR inputFilename, LPCTSTR moduleName, int errorNumber, LPCTSTR errorMessage)
 {
+   // may be called by multiple output threads
+   std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
    ErrorInfo errorInfo;
    errorInfo.m_inputFilename = inputFilename;
    errorInfo.m_moduleName = moduleName;
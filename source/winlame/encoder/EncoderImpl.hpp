@@ -30,9 +30,50 @@
 #include <mutex>
 #include "EncoderState.hpp"
 #include "EncoderSettings.hpp"
+#include "TaskControl.hpp"
+#include "SampleBlockQueue.hpp"
+#include "PcmChecksum.hpp"
 
 namespace Encoder
 {
+   /// state of a single output of the encoder
+   struct EncoderOutput
+   {
+      /// ctor
+      explicit EncoderOutput(const EncoderOutputSettings& settings)
+         :m_outputModuleID(settings.m_outputModuleID),
+         m_outputFilename(settings.m_outputFilename)
+      {
+      }
+
+      int m_outputModuleID;               ///< output module id
+      CString m_outputFilename;           ///< output filename
+      CString m_tempOutputFilename;       ///< temporary output filename
+      CString m_transcodeCacheKey;        ///< transcode cache key; empty when not cached
+
+      /// output module
+      std::unique_ptr<OutputModule> m_outputModule;
+
+      /// sample container with the output module's traits; only used when
+      /// encoding to multiple outputs
+      SampleContainer m_sampleContainer;
+
+      /// queue of decoded sample blocks; only used when encoding to multiple outputs
+      SampleBlockQueue m_queue;
+
+      /// output thread; only used when encoding to multiple outputs
+      std::thread m_outputThread;
+
+      /// checksum of all samples passed to the output module; only used
+      /// when verifying outputs
+      PcmChecksum m_encodedChecksum;
+
+      bool m_initialized = false;         ///< indicates if InitOutput() was called
+      bool m_isCachedOutput = false;      ///< indicates if output was copied from the transcode cache
+      bool m_isPassThroughOutput = false; ///< indicates if input file was copied without re-encoding
+      bool m_skipFile = false;            ///< indicates if the output failed or was skipped
+   };
+
    /// encoder implementation class
    class EncoderImpl : public EncoderInterface
    {
@@ -75,27 +116,45 @@ namespace Encoder
       virtual void StartEncode() override;
 
       /// pauses encoding
-      virtual void PauseEncoding() override
-      {
-         std::unique_lock<std::recursive_mutex> lock(m_mutex);
-         m_encoderState.m_paused = !m_encoderState.m_paused;
-      }
+      virtual void PauseEncoding() override;
 
       /// stops encoding
       virtual void StopEncode() override;
 
+      /// waits until the encoding thread has finished
+      virtual void WaitEncodeFinished() override;
+
+      /// returns task control, e.g. to change the encoding priority
+      TaskControl& GetTaskControl() { return m_taskControl; }
+
+      /// returns if the main output was written, and its filename, the
+      /// number of decoded samples and their sample rate; the number of
+      /// samples is 0 when the output was copied instead of encoded; call
+      /// after encoding has finished
+      bool GetMainOutput(CString& outputFilename, __int64& numDecodedSamples, int& samplerateInHz) const;
+
       /// creates output filename from input title (for reading CDs)
       static CString GetOutputFilenameByInputTitle(const CString& outputPath, const CString& inputTitle, const OutputModule& outputModule);
 
       /// creates output filename from input filename
       static CString GetOutputFilename(const CString& outputPath, const CString& inputFilename, const OutputModule& outputModule);
 
+      /// generates a unique temporary output filename in the folder of the
+      /// output file, and creates an empty file with that name; returns false
+      /// and an empty filename when no file could be created, and the Win32
+      /// error code can be retrieved with GetLastError()
+      static bool GenerateTempOutFilename(const CString& originalFilename, CString& tempFilename);
+
       /// returns if input module with given id is lossy
       static bool IsLossyInputModule(int inputModuleId);
 
       /// returns if output module with given id is lossy
       static bool IsLossyOutputModule(int outputModuleID);
 
+      /// returns ID of the output module that writes the same codec that
+      /// given input module reads, or -1 when there's none
+      static int GetPassThroughOutputModuleID(int inputModuleID);
+
    protected:
       /// encodes using encoder settings
       void Encode();
@@ -103,27 +162,109 @@ namespace Encoder
       /// prepares input module for work
       bool PrepareInputModule(TrackInfo& trackInfo);
 
-      /// prepares output module for work; step 1 of 2; see InitOutputModule()
-      bool PrepareOutputModule();
+      /// seeks to the start of the range to encode, when only a range of the
+      /// input file is encoded
+      bool PrepareInputRange();
+
+      /// decodes samples from the input module; stops at the end of the range
+      /// to encode; returns the input module's result
+      int DecodeInputSamples();
+
+      /// returns percent done of the input file, or of the range to encode
+      float GetPercentDone() const;
+
+      /// creates output modules for the main output and all additional outputs;
+      /// returns false when an output module isn't available
+      bool CreateOutputModules(ModuleManagerImpl& moduleManager);
+
+      /// prepares output for work, and looks up output in transcode cache;
+      /// step 1 of 2; see InitOutputModule()
+      bool PrepareOutput(EncoderOutput& output);
+
+      /// prepares output module for work; determines output filename
+      bool PrepareOutputModule(EncoderOutput& output);
 
       /// checks if the input and output filenames are the same and modifies output filename
       bool CheckSameInputOutputFilenames(const CString& inputFilename,
          CString& outputFilename, OutputModule& outputModule);
 
-      /// generates temporary output filename
-      void GenerateTempOutFilename(const CString& originalFilename, CString& tempFilename);
+      /// returns if given file exists; uses the file system cache, when set
+      bool FileExists(const CString& filename) const;
+
+      /// returns short path name of given file; uses the file system cache, when set
+      CString ShortPathName(const CString& pathName) const;
+
+      /// creates given folder when it doesn't exist; uses the file system
+      /// cache, when set
+      void CreateFolder(const CString& folderName) const;
+
+      /// calculates transcode cache key for current input file; returns an
+      /// empty key when the output must not be cached
+      CString CalculateTranscodeCacheKey(int outputModuleID);
 
-      /// inits output module; step 2 of 2; see PrepareOutputModule()
-      bool InitOutputModule(const CString& tempOutputFilename, const TrackInfo& trackInfo);
+      /// inits output module; step 2 of 2; see PrepareOutput()
+      bool InitOutputModule(EncoderOutput& output, const TrackInfo& trackInfo);
 
       /// formats encoding description
       void FormatEncodingDescription();
 
-      /// main encoding loop; returns if file should be skipped
-      bool MainLoop();
+      /// returns if samples have to be encoded for given output
+      static bool IsEncodingOutput(const EncoderOutput& output)
+      {
+         return output.m_initialized && !output.m_skipFile;
+      }
+
+      /// returns if the output file is copied instead of encoded, either from
+      /// the transcode cache or from the input file
+      static bool IsCopiedOutput(const EncoderOutput& output)
+      {
+         return output.m_isCachedOutput || output.m_isPassThroughOutput;
+      }
+
+      /// \brief returns if the input file can be copied to the output unchanged
+      /// \details this is the case when the output module writes the same codec
+      /// as the input file, and re-encoding wouldn't change the audio data, or
+      /// would only lose quality, with the same sample rate and channels;
+      /// only the tags are rewritten then
+      bool CanPassThrough(const EncoderOutput& output);
+
+      /// copies input file to the output's temporary output filename
+      bool CopyInputFile(const EncoderOutput& output);
+
+      /// returns if the input file's sound file format is the same as the
+      /// format set for the wave output module
+      bool IsSameSoundFileFormat() const;
+
+      /// main encoding loop for a single output; returns if input file failed
+      bool MainLoop(EncoderOutput& output);
 
-      /// writes playlist entry
-      void WritePlaylistEntry(const CString& outputFilename);
+      /// \brief main encoding loop for multiple outputs; returns if input file failed
+      /// \details decodes the input file once and passes the sample blocks to
+      /// the output threads; an output that fails doesn't stop the others
+      bool MainLoopMultipleOutputs();
+
+      /// output thread function; encodes sample blocks from the output's queue
+      void RunOutputThread(EncoderOutput& output);
+
+      /// verifies all encoded outputs at the same time; outputs that fail
+      /// verification are skipped
+      void VerifyOutputs();
+
+      /// \brief decodes the output file again and checks it; returns false
+      /// when the output file is damaged
+      /// \details checks that the output file can be decoded without errors.
+      /// Lossless output files must contain exactly the samples that were
+      /// encoded; for lossy output files, the length is compared.
+      bool VerifyOutput(EncoderOutput& output);
+
+      /// returns if output file of given output can be verified
+      bool IsVerifiableOutput(const EncoderOutput& output) const;
+
+      /// renames temporary output file, or deletes it when the output was skipped
+      void FinishOutput(EncoderOutput& output, const TrackInfo& trackInfo);
+
+      /// reports the encoded main output to the playlist
+      void SetPlaylistEntry();
 
       /// error handler function
       void HandleError(LPCTSTR inputFilename, LPCTSTR moduleName, int errorNumber, LPCTSTR errorMessage);
@@ -155,12 +296,28 @@ namespace Encoder
       /// input module
       std::unique_ptr<InputModule> m_inputModule;
 
-      /// input module
-      std::unique_ptr<OutputModule> m_outputModule;
+      /// main output and all additional outputs
+      std::vector<std::unique_ptr<EncoderOutput>> m_outputs;
 
-      /// sample container
+      /// sample container of the input module
       SampleContainer m_sampleContainer;
 
+      /// number of samples in the range to encode, or -1 when encoding until
+      /// the end of the input file
+      __int64 m_numRangeSamples;
+
+      /// number of samples decoded so far, of the range or of the whole input file
+      __int64 m_numDecodedSamples;
+
+      /// indicates if samples are encoded to multiple outputs
+      bool m_multipleOutputs;
+
+      /// indicates if the main output was written and not skipped
+      bool m_mainOutputWritten;
+
+      /// control channel for pausing and stopping the main loop
+      TaskControl m_taskControl;
+
       /// mutex to protect encoder state
       mutable std::recursive_mutex m_mutex;
 
@@ -49,7 +49,11 @@ namespace Encoder
    public:
       /// ctor
       explicit EncoderJob(const CString& inputFilename)
-         :m_inputFilename(inputFilename)
+         :m_inputFilename(inputFilename),
+         m_useTrackInfo(false),
+         m_rangeStartFrame(0),
+         m_rangeEndFrame(0),
+         m_inputLengthInSeconds(0)
       {
       }
 
@@ -67,15 +71,67 @@ namespace Encoder
       /// returns track info
       TrackInfo& GetTrackInfo() { return m_trackInfo; }
 
+      /// returns title used to generate the output filename; empty when the
+      /// input filename is used
+      CString Title() const { return m_title; }
+
+      /// returns if the track info should be used instead of the track info
+      /// read from the input file
+      bool UseTrackInfo() const { return m_useTrackInfo; }
+
+      /// returns if only a range of the input file is encoded
+      bool HasRange() const { return m_rangeStartFrame != 0 || m_rangeEndFrame != 0; }
+
+      /// returns start of the range to encode, in CD frames
+      unsigned int RangeStartFrame() const { return m_rangeStartFrame; }
+
+      /// returns end of the range to encode, in CD frames; 0 means end of file
+      unsigned int RangeEndFrame() const { return m_rangeEndFrame; }
+
+      /// returns length of the input file, in seconds; 0 when unknown
+      unsigned int InputLengthInSeconds() const { return m_inputLengthInSeconds; }
+
+      /// returns filename of the cue sheet that the job's track was read
+      /// from; empty when the job isn't a cue sheet track
+      CString CueSheetFilename() const { return m_cueSheetFilename; }
+
       // setter
 
       /// sets output filename
       void OutputFilename(const CString& outputFilename) { m_outputFilename = outputFilename; }
 
+      /// sets title used to generate the output filename
+      void Title(const CString& title) { m_title = title; }
+
+      /// sets if the track info should be used instead of the track info
+      /// read from the input file
+      void UseTrackInfo(bool useTrackInfo) { m_useTrackInfo = useTrackInfo; }
+
+      /// sets range of the input file to encode, in CD frames; an end frame
+      /// of 0 means end of file
+      void Range(unsigned int startFrame, unsigned int endFrame)
+      {
+         m_rangeStartFrame = startFrame;
+         m_rangeEndFrame = endFrame;
+      }
+
+      /// sets length of the input file, in seconds, as determined when the
+      /// file was added
+      void InputLengthInSeconds(unsigned int inputLengthInSeconds) { m_inputLengthInSeconds = inputLengthInSeconds; }
+
+      /// sets filename of the cue sheet that the job's track was read from
+      void CueSheetFilename(const CString& cueSheetFilename) { m_cueSheetFilename = cueSheetFilename; }
+
    private:
       CString m_inputFilename;   ///< input filename
       CString m_outputFilename;  ///< output filename
       TrackInfo m_trackInfo;     ///< track info
+      CString m_title;           ///< title for output filename
+      bool m_useTrackInfo;       ///< indicates if track info is used
+      unsigned int m_rangeStartFrame;  ///< start of range, in CD frames
+      unsigned int m_rangeEndFrame;    ///< end of range, in CD frames
+      unsigned int m_inputLengthInSeconds;   ///< input file length, in seconds
+      CString m_cueSheetFilename;   ///< cue sheet filename; empty when not a cue sheet track
    };
 
    /// error info
@@ -123,6 +179,9 @@ namespace Encoder
       /// stops encoding
       virtual void StopEncode() = 0;
 
+      /// waits until the encoding thread has finished
+      virtual void WaitEncodeFinished() = 0;
+
       /// dtor
       virtual ~EncoderInterface() {}
 
@@ -23,6 +23,25 @@
 
 namespace Encoder
 {
+   class TranscodeCache;
+   class BatchJournal;
+   class FileSystemCache;
+   class Playlist;
+
+   /// settings for an additional output of the same input file
+   struct EncoderOutputSettings
+   {
+      /// ctor
+      explicit EncoderOutputSettings(int outputModuleID = -1)
+         :m_outputModuleID(outputModuleID)
+      {
+      }
+
+      int m_outputModuleID;      ///< output module id that should be used
+      CString m_outputFilename;  ///< output filename; when empty, the output filename is
+                                 ///< generated by changing the extension of the main output filename
+   };
+
    /// settings for the encoder
    struct EncoderSettings
    {
@@ -30,10 +49,10 @@ namespace Encoder
       CString m_outputFolder;       ///< output folder
       bool m_outputSameFolder;      ///< indicates if output should be in same folder as input folder
       CString m_outputFilename;     ///< output filename
-      CString m_playlistFilename;   ///< playlist filename, without path
       int m_outputModuleID;         ///< output module id that should be used
       bool m_overwriteExisting;     ///< indicates if existing output files can be overwritten
       bool m_deleteInputAfterEncode;///< indicates if input file should be deleted after encoding
+      bool m_verifyOutput;          ///< indicates if encoded output files are decoded again and checked
 
       /// track info to store in output
       TrackInfo m_trackInfo;
@@ -42,13 +61,65 @@ namespace Encoder
       /// the input file
       bool m_useTrackInfo;
 
+      /// indicates if the input file may be copied to the output without
+      /// re-encoding; not used for temporary files that were written with
+      /// the fastest settings
+      bool m_allowPassThrough;
+
+      /// transcode cache to look up and store output files, or nullptr when
+      /// no cache is used
+      TranscodeCache* m_transcodeCache;
+
+      /// batch journal to record the progress of the job in, or nullptr
+      /// when the job isn't recorded
+      BatchJournal* m_batchJournal;
+
+      /// job ID in the batch journal
+      unsigned int m_batchJournalJobId;
+
+      /// file system cache shared by all tasks of the batch, or nullptr when
+      /// the file system is queried directly
+      std::shared_ptr<FileSystemCache> m_fileSystemCache;
+
+      /// playlist of the batch that the encoded output is reported to, or
+      /// nullptr when no playlist is written
+      std::shared_ptr<Playlist> m_playlist;
+
+      /// index of the job's entry in the playlist
+      size_t m_playlistEntryIndex;
+
+      /// \brief additional outputs of the input file
+      /// \details the input file is decoded once, and the samples are
+      /// encoded to the main output and all additional outputs at the same
+      /// time; all outputs use the same settings manager
+      std::vector<EncoderOutputSettings> m_additionalOutputs;
+
+      /// start of the range of the input file to encode, in CD frames of
+      /// 1/75 seconds; used when splitting disc images by cue sheet tracks
+      unsigned int m_rangeStartFrame;
+
+      /// end of the range of the input file to encode, in CD frames; 0 when
+      /// the range ends at the end of the input file
+      unsigned int m_rangeEndFrame;
+
+      /// returns if only a range of the input file is encoded
+      bool HasRange() const { return m_rangeStartFrame != 0 || m_rangeEndFrame != 0; }
+
       /// default ctor
       EncoderSettings()
          :m_outputSameFolder(false),
          m_outputModuleID(-1),
          m_overwriteExisting(false),
          m_deleteInputAfterEncode(false),
-         m_useTrackInfo(false)
+         m_verifyOutput(false),
+         m_useTrackInfo(false),
+         m_allowPassThrough(true),
+         m_transcodeCache(nullptr),
+         m_batchJournal(nullptr),
+         m_batchJournalJobId(0),
+         m_playlistEntryIndex(0),
+         m_rangeStartFrame(0),
+         m_rangeEndFrame(0)
       {
       }
    };
@@ -33,6 +33,7 @@ namespace Encoder
          :m_running(false),
          m_paused(false),
          m_finished(false),
+         m_copiedOutput(false),
          m_percent(0.f),
          m_errorCode(0)
       {
@@ -48,6 +49,7 @@ namespace Encoder
          :m_running((bool)otherState.m_running),
          m_paused((bool)otherState.m_paused),
          m_finished((bool)otherState.m_finished),
+         m_copiedOutput((bool)otherState.m_copiedOutput),
          m_percent((float)otherState.m_percent),
          m_encodingDescription(otherState.m_encodingDescription),
          m_errorCode((int)otherState.m_errorCode)
@@ -59,6 +61,7 @@ namespace Encoder
          :m_running((bool)otherState.m_running),
          m_paused((bool)otherState.m_paused),
          m_finished((bool)otherState.m_finished),
+         m_copiedOutput((bool)otherState.m_copiedOutput),
          m_percent((float)otherState.m_percent),
          m_encodingDescription(otherState.m_encodingDescription),
          m_errorCode((int)otherState.m_errorCode)
@@ -71,6 +74,7 @@ namespace Encoder
          m_running = (bool)otherState.m_running;
          m_paused = (bool)otherState.m_paused;
          m_finished = (bool)otherState.m_finished;
+         m_copiedOutput = (bool)otherState.m_copiedOutput;
          m_percent = (float)otherState.m_percent;
          m_encodingDescription = otherState.m_encodingDescription;
          m_errorCode = (int)otherState.m_errorCode;
@@ -84,6 +88,7 @@ namespace Encoder
          m_running = (bool)otherState.m_running;
          m_paused = (bool)otherState.m_paused;
          m_finished = (bool)otherState.m_finished;
+         m_copiedOutput = (bool)otherState.m_copiedOutput;
          m_percent = (float)otherState.m_percent;
          m_encodingDescription = otherState.m_encodingDescription;
          m_errorCode = (int)otherState.m_errorCode;
@@ -100,6 +105,10 @@ namespace Encoder
       /// indicates if encoder has been finished
       std::atomic<bool> m_finished;
 
+      /// indicates if an output was copied from the input file or from the
+      /// transcode cache, instead of being encoded
+      std::atomic<bool> m_copiedOutput;
+
       /// indicates percent done
       float m_percent;
 
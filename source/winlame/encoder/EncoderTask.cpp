@@ -21,6 +21,12 @@
 //
 #include "stdafx.h"
 #include "EncoderTask.hpp"
+#include "EncodingCostModel.hpp"
+#include "WorkerProcessPool.hpp"
+#include "BatchJournal.hpp"
+#include "FileSystemCache.hpp"
+#include "Playlist.hpp"
+#include <chrono>
 
 using Encoder::EncoderTask;
 using Encoder::EncoderTaskSettings;
@@ -83,17 +89,174 @@ void EncoderTask::Run()
    m_encoderState.m_running = true;
    m_stopped = false;
 
-   EncoderImpl::Encode();
+   auto encodeStart = std::chrono::steady_clock::now();
+   auto pausedTimeStart = EncoderImpl::GetTaskControl().PausedTime();
+
+   if (m_settings.m_workerProcessPool != nullptr)
+      EncodeInWorkerProcess();
+   else
+      EncoderImpl::Encode();
+
+   // the time the task was paused doesn't count as encoding time
+   auto pausedTime = EncoderImpl::GetTaskControl().PausedTime() - pausedTimeStart;
+   double runTimeInSeconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - encodeStart - pausedTime).count();
 
    CheckErrors();
+
+   // files that weren't encoded aren't written to the playlist
+   if (m_settings.m_playlist != nullptr &&
+      (m_stopped || !ErrorText().IsEmpty()))
+      m_settings.m_playlist->SetFailedEntry(m_settings.m_playlistEntryIndex);
+
+   // only successfully encoded files tell how long encoding takes; with
+   // additional outputs, the run time can't be split up by output module,
+   // and copied outputs weren't encoded at all
+   if (m_settings.m_costModel != nullptr &&
+      m_settings.m_additionalOutputs.empty() &&
+      !m_encoderState.m_copiedOutput &&
+      !m_stopped &&
+      ErrorText().IsEmpty())
+   {
+      m_settings.m_costModel->AddMeasurement(m_settings.m_outputModuleID,
+         m_settings.m_inputLengthInSeconds, runTimeInSeconds);
+   }
 }
 
 void EncoderTask::Stop()
 {
    m_stopped = true;
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutexWorkerProcess);
+      if (m_workerProcess != nullptr)
+         m_workerProcess->StopJob();
+   }
+
    EncoderImpl::StopEncode();
 }
 
+double EncoderTask::EstimatedCost() const
+{
+   if (m_settings.m_costModel == nullptr)
+      return m_settings.m_inputLengthInSeconds;
+
+   // all outputs are encoded by the same task
+   double estimatedCost = m_settings.m_costModel->EstimateCost(
+      m_settings.m_outputModuleID, m_settings.m_inputLengthInSeconds);
+
+   for (const EncoderOutputSettings& outputSettings : m_settings.m_additionalOutputs)
+   {
+      estimatedCost += m_settings.m_costModel->EstimateCost(
+         outputSettings.m_outputModuleID, m_settings.m_inputLengthInSeconds);
+   }
+
+   return estimatedCost;
+}
+
+void EncoderTask::EncodeInWorkerProcess()
+{
+   std::shared_ptr<WorkerProcess> workerProcess = m_settings.m_workerProcessPool->Acquire();
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutexWorkerProcess);
+      m_workerProcess = workerProcess;
+   }
+
+   // the worker process can't write to the batch journal, so the task
+   // records start and end of the job
+   BatchJournal* batchJournal = m_settings.m_batchJournal;
+   if (batchJournal != nullptr)
+      batchJournal->StartJob(m_settings.m_batchJournalJobId);
+
+   bool finished = false;
+   bool stopped = false;
+
+   if (workerProcess != nullptr &&
+      !m_stopped &&
+      workerProcess->SendJob(EncoderImpl::GetEncoderSettings(), m_settings.m_settingsManager))
+   {
+      WorkerProcess::Message message;
+      while (!finished && workerProcess->ReceiveMessage(message))
+      {
+         switch (message.m_type)
+         {
+         case WorkerProcess::Message::typeState:
+         {
+            std::unique_lock<std::recursive_mutex> lock(m_mutex);
+            m_encoderState.m_percent = message.m_percent;
+            m_encoderState.m_encodingDescription = message.m_description;
+            break;
+         }
+
+         case WorkerProcess::Message::typeError:
+            EncoderImpl::HandleError(message.m_errorInfo.m_inputFilename, message.m_errorInfo.m_moduleName,
+               message.m_errorInfo.m_errorNumber, message.m_errorInfo.m_errorMessage);
+            break;
+
+         case WorkerProcess::Message::typeOutput:
+            if (m_settings.m_playlist != nullptr)
+            {
+               double lengthInSeconds = 0.0;
+               if (message.m_numDecodedSamples > 0 && message.m_samplerateInHz > 0)
+                  lengthInSeconds = static_cast<double>(message.m_numDecodedSamples) / message.m_samplerateInHz;
+
+               m_settings.m_playlist->SetEncodedEntry(m_settings.m_playlistEntryIndex,
+                  message.m_outputFilename, lengthInSeconds);
+            }
+            break;
+
+         case WorkerProcess::Message::typeFinished:
+            m_encoderState.m_errorCode = message.m_errorCode;
+            m_encoderState.m_copiedOutput = message.m_copiedOutput;
+            stopped = message.m_stopped;
+            finished = true;
+            break;
+
+         default:
+            ATLASSERT(false);
+            break;
+         }
+      }
+   }
+
+   if (!finished && !m_stopped)
+   {
+      // the worker process ended while encoding; only this file failed
+      CString errorMessage;
+      errorMessage.LoadString(workerProcess == nullptr
+         ? IDS_ENCODER_WORKER_PROCESS_START_FAILED
+         : IDS_ENCODER_WORKER_PROCESS_ENDED);
+
+      EncoderImpl::HandleError(m_settings.m_inputFilename, _T("Encoder"), -1, errorMessage);
+      m_encoderState.m_errorCode = -1;
+   }
+
+   if (batchJournal != nullptr &&
+      !stopped && !m_stopped)
+      batchJournal->FinishJob(m_settings.m_batchJournalJobId);
+
+   // the worker process wrote the output files and may have deleted the
+   // input file, without updating the file system cache
+   if (m_settings.m_fileSystemCache != nullptr)
+   {
+      m_settings.m_fileSystemCache->InvalidateFolder(m_settings.m_outputFolder);
+      m_settings.m_fileSystemCache->InvalidateFolder(Path::FolderName(m_settings.m_inputFilename));
+   }
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutexWorkerProcess);
+      m_workerProcess.reset();
+   }
+
+   if (finished)
+      m_settings.m_workerProcessPool->Release(workerProcess);
+
+   m_encoderState.m_running = false;
+   m_encoderState.m_paused = false;
+   m_encoderState.m_finished = true;
+}
+
 void EncoderTask::CheckErrors()
 {
    auto allErrors = EncoderImpl::GetAllErrorInfos();
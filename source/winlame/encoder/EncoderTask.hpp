@@ -28,17 +28,35 @@
 
 namespace Encoder
 {
+   class EncodingCostModel;
+   class WorkerProcessPool;
+   class WorkerProcess;
+
    /// settings for EncoderTask
    struct EncoderTaskSettings : public EncoderSettings
    {
       /// ctor
       EncoderTaskSettings()
+         :m_inputLengthInSeconds(0.0),
+         m_costModel(nullptr),
+         m_workerProcessPool(nullptr)
       {
       }
 
       /// title
       CString m_title;
 
+      /// length of the audio to encode, in seconds; 0 when unknown
+      double m_inputLengthInSeconds;
+
+      /// cost model to estimate the run time of the task and to add the
+      /// measured run time to, or nullptr when no cost model is used
+      EncodingCostModel* m_costModel;
+
+      /// pool of worker processes to encode the file in, or nullptr when the
+      /// file is encoded in the winLAME process
+      WorkerProcessPool* m_workerProcessPool;
+
       /// the settings manager to use
       SettingsManager m_settingsManager;
    };
@@ -63,6 +81,9 @@ namespace Encoder
       /// task should be aborted, e.g. when program is closed
       virtual void Stop();
 
+      /// returns estimated run time of the task, in seconds, or 0 when unknown
+      virtual double EstimatedCost() const;
+
       /// output filename for this task
       const CString& OutputFilename() const { return EncoderImpl::GetEncoderSettings().m_outputFilename; }
 
@@ -70,6 +91,9 @@ namespace Encoder
       CString GenerateOutputFilename(const CString& inputTitle);
 
    private:
+      /// encodes the file in a worker process
+      void EncodeInWorkerProcess();
+
       /// checks errors and adds error texts from error handler to task result
       void CheckErrors();
 
@@ -82,6 +106,13 @@ namespace Encoder
 
       /// indicates if encoder thread has stopped
       std::atomic<bool> m_stopped;
+
+      /// mutex protecting the worker process
+      std::mutex m_mutexWorkerProcess;
+
+      /// worker process encoding the file; nullptr when not encoding in a
+      /// worker process
+      std::shared_ptr<WorkerProcess> m_workerProcess;
    };
 
 } // namespace Encoder
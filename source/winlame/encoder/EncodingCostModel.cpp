@@ -0,0 +1,87 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file EncodingCostModel.cpp
+/// \brief model for the run time of encoder tasks
+//
+#include "stdafx.h"
+#include "EncodingCostModel.hpp"
+
+using Encoder::EncodingCostModel;
+
+EncodingCostModel::EncodingCostModel(const CString& costFactorsText)
+{
+   // format is "<module id>:<factor>;<module id>:<factor>;..."
+   int pos = 0;
+   CString entry = costFactorsText.Tokenize(_T(";"), pos);
+   while (pos >= 0)
+   {
+      int outputModuleId = 0;
+      double costFactor = 0.0;
+      if (_stscanf_s(entry, _T("%i:%lf"), &outputModuleId, &costFactor) == 2 &&
+         costFactor > 0.0)
+      {
+         m_costFactors[outputModuleId] = costFactor;
+      }
+
+      entry = costFactorsText.Tokenize(_T(";"), pos);
+   }
+}
+
+double EncodingCostModel::EstimateCost(int outputModuleId, double inputLengthInSeconds) const
+{
+   return inputLengthInSeconds * GetCostFactor(outputModuleId);
+}
+
+void EncodingCostModel::AddMeasurement(int outputModuleId, double inputLengthInSeconds, double runTimeInSeconds)
+{
+   if (inputLengthInSeconds <= 0.0 || runTimeInSeconds <= 0.0)
+      return;
+
+   double measuredCostFactor = runTimeInSeconds / inputLengthInSeconds;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = m_costFactors.find(outputModuleId);
+   if (iter == m_costFactors.end())
+   {
+      m_costFactors[outputModuleId] = measuredCostFactor;
+      return;
+   }
+
+   iter->second += c_measurementWeight * (measuredCostFactor - iter->second);
+}
+
+double EncodingCostModel::GetCostFactor(int outputModuleId) const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = m_costFactors.find(outputModuleId);
+   return iter != m_costFactors.end() ? iter->second : c_defaultCostFactor;
+}
+
+CString EncodingCostModel::GetCostFactorsText() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   CString text;
+   for (const auto& costFactor : m_costFactors)
+      text.AppendFormat(_T("%i:%g;"), costFactor.first, costFactor.second);
+
+   return text;
+}
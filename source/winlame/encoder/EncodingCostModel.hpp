@@ -0,0 +1,76 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file EncodingCostModel.hpp
+/// \brief model for the run time of encoder tasks
+//
+#pragma once
+
+#include <map>
+#include <mutex>
+
+namespace Encoder
+{
+   /// \brief model for the run time of encoder tasks
+   /// \details the run time of an encoder task is estimated as the length of
+   /// the input file, times a cost factor of the output module. The cost
+   /// factors are learned from the run times of finished encoder tasks, as a
+   /// moving average, and are stored in the settings so that they are known
+   /// on the next start. All methods may be called by multiple encoder
+   /// threads at the same time.
+   class EncodingCostModel
+   {
+   public:
+      /// cost factor of output modules that weren't measured yet
+      static constexpr double c_defaultCostFactor = 1.0;
+
+      /// weight of a new measurement in the moving average of a cost factor
+      static constexpr double c_measurementWeight = 0.3;
+
+      /// ctor; takes cost factors as returned by GetCostFactorsText()
+      explicit EncodingCostModel(const CString& costFactorsText = CString());
+
+      /// deleted copy ctor
+      EncodingCostModel(const EncodingCostModel&) = delete;
+      /// deleted copy assignment operator
+      EncodingCostModel& operator=(const EncodingCostModel&) = delete;
+
+      /// returns estimated run time of encoding an input file of given
+      /// length with given output module, in seconds
+      double EstimateCost(int outputModuleId, double inputLengthInSeconds) const;
+
+      /// adds measured run time of encoding an input file of given length
+      /// with given output module
+      void AddMeasurement(int outputModuleId, double inputLengthInSeconds, double runTimeInSeconds);
+
+      /// returns cost factor of given output module, in seconds run time per
+      /// second of audio
+      double GetCostFactor(int outputModuleId) const;
+
+      /// returns all cost factors as text, to store in the settings
+      CString GetCostFactorsText() const;
+
+   private:
+      /// mutex protecting the cost factors
+      mutable std::mutex m_mutex;
+
+      /// cost factors, by output module ID
+      std::map<int, double> m_costFactors;
+   };
+
+} // namespace Encoder
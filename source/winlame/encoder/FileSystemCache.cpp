@@ -0,0 +1,171 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FileSystemCache.cpp
+/// \brief cache for file system queries of a batch of encoder tasks
+//
+#include "stdafx.h"
+#include "FileSystemCache.hpp"
+#include <ulib/Path.hpp>
+
+using Encoder::FileSystemCache;
+
+FileSystemCache::FileSystemCache()
+   :m_numFileSystemCalls(0)
+{
+}
+
+bool FileSystemCache::FileExists(const CString& filename)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   Folder& folder = GetFolder(Path::FolderName(filename));
+
+   return folder.m_filenames.find(GetKey(Path::FilenameAndExt(filename))) != folder.m_filenames.end();
+}
+
+bool FileSystemCache::FolderExists(const CString& folderName)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   return GetFolder(folderName).m_exists;
+}
+
+void FileSystemCache::CreateFolder(const CString& folderName)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (GetFolder(folderName).m_exists)
+      return;
+
+   Path::CreateDirectoryRecursive(folderName);
+   m_numFileSystemCalls++;
+
+   // the created folder and parent folders are listed again when needed
+   CString key = GetKey(folderName);
+   for (auto iter = m_folders.begin(); iter != m_folders.end();)
+   {
+      if (!iter->second.m_exists && key.Find(iter->first) == 0)
+         iter = m_folders.erase(iter);
+      else
+         ++iter;
+   }
+}
+
+CString FileSystemCache::ShortPathName(const CString& pathName)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   CString key = GetKey(pathName);
+
+   auto iter = m_shortPathNames.find(key);
+   if (iter != m_shortPathNames.end())
+      return iter->second;
+
+   CString shortPathName = Path::ShortPathName(pathName);
+   m_numFileSystemCalls++;
+
+   m_shortPathNames[key] = shortPathName;
+
+   return shortPathName;
+}
+
+void FileSystemCache::AddFile(const CString& filename)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   // when the folder isn't cached yet, it's listed when needed
+   auto iter = m_folders.find(GetKey(Path::FolderName(filename)));
+   if (iter == m_folders.end())
+      return;
+
+   iter->second.m_exists = true;
+   iter->second.m_filenames.insert(GetKey(Path::FilenameAndExt(filename)));
+}
+
+void FileSystemCache::RemoveFile(const CString& filename)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = m_folders.find(GetKey(Path::FolderName(filename)));
+   if (iter != m_folders.end())
+      iter->second.m_filenames.erase(GetKey(Path::FilenameAndExt(filename)));
+
+   // the short path name of a file created later with the same name may differ
+   m_shortPathNames.erase(GetKey(filename));
+}
+
+void FileSystemCache::InvalidateFolder(const CString& folderName)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   m_folders.erase(GetKey(folderName));
+}
+
+unsigned int FileSystemCache::GetNumFileSystemCalls() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   return m_numFileSystemCalls;
+}
+
+FileSystemCache::Folder& FileSystemCache::GetFolder(const CString& folderName)
+{
+   CString key = GetKey(folderName);
+
+   auto iter = m_folders.find(key);
+   if (iter != m_folders.end())
+      return iter->second;
+
+   Folder& folder = m_folders[key];
+
+   WIN32_FIND_DATA findData = {};
+   HANDLE find = FindFirstFileEx(Path::Combine(folderName, _T("*")),
+      FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+   m_numFileSystemCalls++;
+
+   if (find == INVALID_HANDLE_VALUE)
+   {
+      // an empty root folder has no "." and ".." entries
+      folder.m_exists = GetLastError() == ERROR_FILE_NOT_FOUND;
+      return folder;
+   }
+
+   folder.m_exists = true;
+
+   do
+   {
+      if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+         folder.m_filenames.insert(GetKey(findData.cFileName));
+
+      m_numFileSystemCalls++; // for the FindNextFile() call below
+   } while (FindNextFile(find, &findData));
+
+   FindClose(find);
+
+   return folder;
+}
+
+CString FileSystemCache::GetKey(const CString& pathName)
+{
+   CString key = pathName;
+   key.TrimRight(_T('\\'));
+   key.MakeLower();
+
+   return key;
+}
@@ -0,0 +1,104 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FileSystemCache.hpp
+/// \brief cache for file system queries of a batch of encoder tasks
+//
+#pragma once
+
+#include <map>
+#include <set>
+#include <mutex>
+
+namespace Encoder
+{
+   /// \brief cache for file system queries of a batch of encoder tasks
+   /// \details Every encoder task checks if its output file already exists,
+   /// compares short path names and creates the output folder. On network
+   /// shares each of these queries is a round trip. The cache lists each
+   /// folder once and answers the queries from memory. Files written or
+   /// deleted by the encoder tasks are added to or removed from the cache;
+   /// changes by other processes aren't noticed, so the cache is only used
+   /// for one batch of tasks. All methods may be called by multiple encoder
+   /// threads at the same time.
+   class FileSystemCache
+   {
+   public:
+      /// ctor
+      FileSystemCache();
+
+      /// deleted copy ctor
+      FileSystemCache(const FileSystemCache&) = delete;
+      /// deleted copy assignment operator
+      FileSystemCache& operator=(const FileSystemCache&) = delete;
+
+      /// returns if given file exists
+      bool FileExists(const CString& filename);
+
+      /// returns if given folder exists
+      bool FolderExists(const CString& folderName);
+
+      /// creates given folder and all parent folders, when not existing yet
+      void CreateFolder(const CString& folderName);
+
+      /// returns short path name of given file or folder
+      CString ShortPathName(const CString& pathName);
+
+      /// adds file that was created by an encoder task
+      void AddFile(const CString& filename);
+
+      /// removes file that was deleted by an encoder task
+      void RemoveFile(const CString& filename);
+
+      /// removes listing of given folder, e.g. after another process wrote
+      /// to it; the folder is listed again when needed
+      void InvalidateFolder(const CString& folderName);
+
+      /// returns number of file system calls made so far
+      unsigned int GetNumFileSystemCalls() const;
+
+   private:
+      /// cached folder listing
+      struct Folder
+      {
+         bool m_exists = false;           ///< indicates if the folder exists
+         std::set<CString> m_filenames;   ///< lowercase names of all files in the folder
+      };
+
+      /// returns cached listing of given folder; lists the folder when not
+      /// cached yet; the cache mutex must be locked
+      Folder& GetFolder(const CString& folderName);
+
+      /// returns key for given file or folder name
+      static CString GetKey(const CString& pathName);
+
+   private:
+      /// mutex protecting folders, short path names and statistics
+      mutable std::mutex m_mutex;
+
+      /// all folder listings, by folder key
+      std::map<CString, Folder> m_folders;
+
+      /// short path names, by path key
+      std::map<CString, CString> m_shortPathNames;
+
+      /// number of file system calls made
+      unsigned int m_numFileSystemCalls;
+   };
+
+} // namespace Encoder
@@ -22,10 +22,7 @@
 //
 #include "stdafx.h"
 #include "resource.h"
-#include <fstream>
 #include "FlacInputModule.hpp"
-#include <sys/types.h>
-#include <sys/stat.h>
 #include "FLAC/metadata.h"
 #include "AudioFileTag.hpp"
 
@@ -33,6 +30,7 @@ using Encoder::FlacInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
 using Encoder::FLAC_context;
+using Encoder::BufferedInputFile;
 
 namespace Encoder
 {
@@ -44,6 +42,7 @@ namespace Encoder
       unsigned int numSamplesInReservoir = 0;      ///< number of samples in reservoir
       unsigned int totalLengthInMs = 0;            ///< total length in ms
       bool abortFlag = false;                      ///< abort flag
+      BufferedInputFile* inputFile = nullptr;      ///< input file
 
       /// ctor
       FLAC_context()
@@ -60,6 +59,69 @@ const unsigned int m_flacFrameSize = 576;
 
 // callbacks
 
+static FLAC__StreamDecoderReadStatus FLAC_ReadCallback(const FLAC__StreamDecoder* decoder,
+   FLAC__byte buffer[],
+   size_t* bytes,
+   void* clientData)
+{
+   FLAC_context* context = (FLAC_context*)clientData;
+
+   if (*bytes == 0)
+      return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+
+   *bytes = context->inputFile->Read(buffer, *bytes);
+
+   if (*bytes == 0)
+   {
+      return context->inputFile->GetLastError() != 0
+         ? FLAC__STREAM_DECODER_READ_STATUS_ABORT
+         : FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+   }
+
+   return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+static FLAC__StreamDecoderSeekStatus FLAC_SeekCallback(const FLAC__StreamDecoder* decoder,
+   FLAC__uint64 absoluteByteOffset,
+   void* clientData)
+{
+   FLAC_context* context = (FLAC_context*)clientData;
+
+   return context->inputFile->Seek(static_cast<LONGLONG>(absoluteByteOffset), SEEK_SET)
+      ? FLAC__STREAM_DECODER_SEEK_STATUS_OK
+      : FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+}
+
+static FLAC__StreamDecoderTellStatus FLAC_TellCallback(const FLAC__StreamDecoder* decoder,
+   FLAC__uint64* absoluteByteOffset,
+   void* clientData)
+{
+   FLAC_context* context = (FLAC_context*)clientData;
+
+   *absoluteByteOffset = context->inputFile->Tell();
+
+   return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+}
+
+static FLAC__StreamDecoderLengthStatus FLAC_LengthCallback(const FLAC__StreamDecoder* decoder,
+   FLAC__uint64* streamLength,
+   void* clientData)
+{
+   FLAC_context* context = (FLAC_context*)clientData;
+
+   *streamLength = context->inputFile->Length();
+
+   return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+}
+
+static FLAC__bool FLAC_EofCallback(const FLAC__StreamDecoder* decoder,
+   void* clientData)
+{
+   FLAC_context* context = (FLAC_context*)clientData;
+
+   return context->inputFile->IsEndOfFile();
+}
+
 static FLAC__StreamDecoderWriteStatus FLAC_WriteCallback(
    const FLAC__StreamDecoder* decoder,
    const FLAC__Frame* frame,
@@ -210,21 +272,30 @@ int FlacInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    AudioFileTag tag{ trackinfo };
    tag.ReadFromFile(infilename);
 
+   if (!m_inputFile.Open(infilename))
+   {
+      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
+      return -1;
+   }
+
    // find out length of file
-   struct _stat64 statbuf;
-   ::_tstat64(infilename, &statbuf);
-   m_fileLength = statbuf.st_size;
+   m_fileLength = m_inputFile.Length();
 
    m_flacContext = new FLAC_context;
    memset((void*)m_flacContext, 0, sizeof(FLAC_context));
    //m_flacContext->trackInfo = &trackinfo;
+   m_flacContext->inputFile = &m_inputFile;
 
    m_flacDecoder = FLAC__stream_decoder_new();
 
    // open stream
-   CStringA ansiFilename(GetAnsiCompatFilename(infilename));
-   FLAC__StreamDecoderInitStatus initStatus = FLAC__stream_decoder_init_file(m_flacDecoder,
-      ansiFilename,
+   FLAC__StreamDecoderInitStatus initStatus = FLAC__stream_decoder_init_stream(m_flacDecoder,
+      FLAC_ReadCallback,
+      FLAC_SeekCallback,
+      FLAC_TellCallback,
+      FLAC_LengthCallback,
+      FLAC_EofCallback,
       FLAC_WriteCallback,
       FLAC_MetadataCallback,
       FLAC_ErrorCallback,
@@ -269,16 +340,15 @@ int FlacInputModule::DecodeSamples(SampleContainer& samples)
 {
    while (m_flacContext->numSamplesInReservoir < m_flacFrameSize)
    {
-      if (FLAC__stream_decoder_get_state(m_flacDecoder) == FLAC__STREAM_DECODER_END_OF_STREAM)
-      {
-         return 0;
-      }
-      else if (!FLAC__stream_decoder_process_single(m_flacDecoder))
-      {
-         return 0;
-      }
+      // at the end of the stream, return the remaining samples in the reservoir
+      if (FLAC__stream_decoder_get_state(m_flacDecoder) == FLAC__STREAM_DECODER_END_OF_STREAM ||
+         !FLAC__stream_decoder_process_single(m_flacDecoder))
+         break;
    }
 
+   if (m_flacContext->numSamplesInReservoir == 0)
+      return 0;
+
    unsigned int numSamples = std::min(m_flacContext->numSamplesInReservoir, m_flacFrameSize);
 
    FLAC__pack_pcm_signed_little_endian(
@@ -306,6 +376,46 @@ float FlacInputModule::PercentDone() const
    return float(__int64(m_samplePosition))*100.f / __int64(m_flacContext->streamInfo.total_samples);
 }
 
+bool FlacInputModule::CanSeek() const
+{
+   return m_flacDecoder != nullptr;
+}
+
+__int64 FlacInputModule::GetTotalSamples() const
+{
+   if (m_flacContext == nullptr ||
+      m_flacContext->streamInfo.total_samples == 0)
+      return -1;
+
+   return static_cast<__int64>(m_flacContext->streamInfo.total_samples);
+}
+
+int FlacInputModule::SeekToSample(__int64 samplePosition)
+{
+   if (m_flacDecoder == nullptr || samplePosition < 0)
+      return -1;
+
+   // samples decoded before seeking aren't used anymore; the decoder writes
+   // the samples of the frame, starting at the seek position
+   m_flacContext->numSamplesInReservoir = 0;
+
+   if (!FLAC__stream_decoder_seek_absolute(m_flacDecoder, static_cast<FLAC__uint64>(samplePosition)))
+   {
+      // the decoder must be flushed after a seek error
+      if (FLAC__stream_decoder_get_state(m_flacDecoder) == FLAC__STREAM_DECODER_SEEK_ERROR)
+         FLAC__stream_decoder_flush(m_flacDecoder);
+
+      m_flacContext->numSamplesInReservoir = 0;
+
+      m_lastError.LoadString(IDS_ENCODER_SEEK_ERROR);
+      return -1;
+   }
+
+   m_samplePosition = static_cast<FLAC__uint64>(samplePosition);
+
+   return 0;
+}
+
 void FlacInputModule::DoneInput()
 {
    if (m_flacDecoder)
@@ -326,4 +436,6 @@ void FlacInputModule::DoneInput()
       delete m_flacContext;
       m_flacContext = nullptr;
    }
+
+   m_inputFile.Close();
 }
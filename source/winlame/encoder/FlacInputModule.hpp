@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedInputFile.hpp"
 #include "FLAC/stream_decoder.h"
 
 namespace Encoder
@@ -70,6 +71,15 @@ namespace Encoder
       /// returns the number of percent done
       virtual float PercentDone() const override;
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
@@ -86,6 +96,9 @@ namespace Encoder
       /// flac context
       FLAC_context* m_flacContext;
 
+      /// input file
+      BufferedInputFile m_inputFile;
+
       /// input buffer
       std::vector<FLAC__int32> m_inputBuffer;
 
@@ -0,0 +1,476 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlacOutputModule.cpp
+/// \brief FLAC output module
+//
+#include "stdafx.h"
+#include "resource.h"
+#include "FlacOutputModule.hpp"
+#include "FLAC/metadata.h"
+#include <ulib/UTF8.hpp>
+#include "App.hpp"
+#include <thread>
+#include <algorithm>
+
+using Encoder::FlacOutputModule;
+using Encoder::TrackInfo;
+using Encoder::SampleContainer;
+
+/// interval of seek points in the seek table, in seconds
+const unsigned int c_seekPointIntervalInSeconds = 10;
+
+/// size of the padding block; leaves room for editing tags later without
+/// having to rewrite the whole file
+const unsigned int c_paddingSize = 8192;
+
+/// maximum number of encoder threads
+const unsigned int c_maxEncoderThreads = 64;
+
+FlacOutputModule::FlacOutputModule()
+   :m_encoder(nullptr),
+   m_vorbisComment(nullptr),
+   m_bitsPerSample(16),
+   m_compressionLevel(5),
+   m_numThreads(1)
+{
+   m_moduleId = ID_OM_FLAC;
+}
+
+FlacOutputModule::~FlacOutputModule()
+{
+   Cleanup();
+}
+
+bool FlacOutputModule::IsAvailable() const
+{
+   // always available
+   return true;
+}
+
+CString FlacOutputModule::GetDescription() const
+{
+   CString desc;
+   desc.Format(IDS_FORMAT_INFO_FLAC_OUTPUT,
+      m_channels,
+      m_samplerate,
+      m_bitsPerSample,
+      m_compressionLevel,
+      m_numThreads);
+
+   return desc;
+}
+
+void FlacOutputModule::GetVersionString(CString& version, int special) const
+{
+   UNUSED(special);
+   version = FLAC__VERSION_STRING;
+}
+
+int FlacOutputModule::InitOutput(LPCTSTR outfilename,
+   SettingsManager& mgr, const TrackInfo& trackInfo,
+   SampleContainer& samples)
+{
+   m_samplerate = samples.GetInputModuleSampleRate();
+   m_channels = samples.GetInputModuleChannels();
+
+   // the input sample size is kept, up to 24 bit; 32 bit samples are
+   // mostly produced by decoders of lossy formats and are reduced
+   int inputBitsPerSample = samples.GetInputModuleBitsPerSample();
+   m_bitsPerSample = std::min(inputBitsPerSample, 24);
+
+   if (m_channels < 1 || m_channels > FLAC__MAX_CHANNELS ||
+      !FLAC__format_sample_rate_is_valid(m_samplerate) ||
+      m_bitsPerSample < FLAC__MIN_BITS_PER_SAMPLE)
+   {
+      m_lastError.LoadString(IDS_ENCODER_INVALID_FILE_FORMAT);
+      m_lastError.AppendFormat(_T(" (%i channels, %i Hz, %i bit)"),
+         m_channels, m_samplerate, inputBitsPerSample);
+      return -1;
+   }
+
+   m_encoder = FLAC__stream_encoder_new();
+   if (m_encoder == nullptr)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      return -1;
+   }
+
+   if (!SetEncoderOptions(mgr))
+      return -1;
+
+   // the estimate is used to place the seek points; libFLAC writes the
+   // exact number of samples into the stream info when finishing
+   FLAC__uint64 totalSamplesEstimate =
+      FLAC__uint64(std::max(mgr.QueryValueInt(GeneralInputLengthInSeconds), 0)) * m_samplerate;
+
+   FLAC__stream_encoder_set_total_samples_estimate(m_encoder, totalSamplesEstimate);
+
+   if (!CreateMetadata(trackInfo, totalSamplesEstimate))
+      return -1;
+
+   FLAC__stream_encoder_set_metadata(m_encoder, m_metadata.data(), static_cast<uint32_t>(m_metadata.size()));
+
+   if (!OpenOutputFile(outfilename, mgr))
+      return -1;
+
+   FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream(m_encoder,
+      WriteCallback, SeekCallback, TellCallback, nullptr, this);
+
+   if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      m_lastError.AppendFormat(_T(" (%hs)"), FLAC__StreamEncoderInitStatusString[status]);
+      return -1;
+   }
+
+   // samples are always fetched as 32 bit and shifted down to the FLAC
+   // sample size in place, so that 24 bit samples are passed unchanged
+   samples.SetOutputModuleTraits(32, SamplesInterleaved, m_samplerate, m_channels);
+
+   return 0;
+}
+
+int FlacOutputModule::EncodeSamples(SampleContainer& samples)
+{
+   int numSamples = 0;
+   FLAC__int32* buffer = static_cast<FLAC__int32*>(samples.GetSamplesInterleaved(numSamples));
+
+   if (numSamples == 0)
+      return 0;
+
+   int shift = 32 - m_bitsPerSample;
+   int roundBit = shift > 0 ? (1 << (shift - 1)) : 0;
+   int highValue = std::numeric_limits<int>::max() - roundBit + 1;
+
+   size_t numValues = size_t(numSamples) * m_channels;
+   for (size_t index = 0; index < numValues; index++)
+   {
+      int sample = buffer[index];
+
+      if (sample < highValue)
+         sample += roundBit;
+
+      buffer[index] = sample >> shift;
+   }
+
+   if (!FLAC__stream_encoder_process_interleaved(m_encoder, buffer, static_cast<uint32_t>(numSamples)))
+   {
+      SetEncoderStateError();
+      return -1;
+   }
+
+   return numSamples;
+}
+
+void FlacOutputModule::DoneOutput()
+{
+   // encodes remaining samples, then updates stream info and seek table
+   if (m_encoder != nullptr &&
+      !FLAC__stream_encoder_finish(m_encoder))
+   {
+      SetEncoderStateError();
+      ATLTRACE(_T("FlacOutputModule: error finishing output file: %s\n"), m_lastError.GetString());
+   }
+
+   if (m_outputFile.IsOpen() &&
+      !m_outputFile.Close())
+   {
+      ATLTRACE(_T("FlacOutputModule: error closing output file: %s\n"),
+         m_outputFile.GetLastErrorText().GetString());
+   }
+
+   Cleanup();
+}
+
+bool FlacOutputModule::SetEncoderOptions(SettingsManager& mgr)
+{
+   m_compressionLevel = std::clamp(mgr.QueryValueInt(FlacCompressionLevel), 0, 8);
+
+   bool ret =
+      FLAC__stream_encoder_set_channels(m_encoder, static_cast<uint32_t>(m_channels)) &&
+      FLAC__stream_encoder_set_bits_per_sample(m_encoder, static_cast<uint32_t>(m_bitsPerSample)) &&
+      FLAC__stream_encoder_set_sample_rate(m_encoder, static_cast<uint32_t>(m_samplerate)) &&
+      FLAC__stream_encoder_set_compression_level(m_encoder, static_cast<uint32_t>(m_compressionLevel));
+
+   if (!ret)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      return false;
+   }
+
+   m_numThreads = 1;
+
+#if FLAC_API_VERSION_CURRENT >= 14
+   // frame-parallel encoding is available since libFLAC 1.5.0
+   if (mgr.QueryValueInt(FlacMultithreaded) != 0)
+   {
+      unsigned int numThreads = std::clamp(std::thread::hardware_concurrency(), 1U, c_maxEncoderThreads);
+
+      uint32_t result = FLAC__stream_encoder_set_num_threads(m_encoder, numThreads);
+      if (result == FLAC__STREAM_ENCODER_SET_NUM_THREADS_OK)
+         m_numThreads = numThreads;
+      else
+         ATLTRACE(_T("FlacOutputModule: couldn't use %u threads (error %u); encoding single-threaded\n"),
+            numThreads, result);
+   }
+#endif
+
+   return true;
+}
+
+bool FlacOutputModule::CreateMetadata(const TrackInfo& trackInfo, FLAC__uint64 totalSamplesEstimate)
+{
+   m_vorbisComment = FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT);
+   if (m_vorbisComment == nullptr)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      return false;
+   }
+
+   m_metadata.push_back(m_vorbisComment);
+
+   AddVorbisComments(trackInfo);
+   AddFrontCoverPicture(trackInfo);
+
+   // seek points are only reserved when the length is known; libFLAC fills
+   // in the file offsets while encoding
+   if (totalSamplesEstimate > 0)
+   {
+      FLAC__StreamMetadata* seekTable = FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE);
+      if (seekTable == nullptr)
+      {
+         m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+         return false;
+      }
+
+      m_metadata.push_back(seekTable);
+
+      if (!FLAC__metadata_object_seektable_template_append_spaced_points_by_samples(seekTable,
+         c_seekPointIntervalInSeconds * static_cast<uint32_t>(m_samplerate), totalSamplesEstimate) ||
+         !FLAC__metadata_object_seektable_template_sort(seekTable, true))
+      {
+         m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+         return false;
+      }
+   }
+
+   FLAC__StreamMetadata* padding = FLAC__metadata_object_new(FLAC__METADATA_TYPE_PADDING);
+   if (padding == nullptr)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_INIT_ENCODER);
+      return false;
+   }
+
+   padding->length = c_paddingSize;
+   m_metadata.push_back(padding);
+
+   return true;
+}
+
+void FlacOutputModule::AddVorbisComments(const TrackInfo& trackInfo)
+{
+   CString text;
+   text.Format(_T("winLAME %s"), App::Version().GetString());
+   AddVorbisComment("ENCODER", text);
+
+   text.Format(_T("--compression-level-%i"), m_compressionLevel);
+   AddVorbisComment("ENCODER_OPTIONS", text);
+
+   bool avail = false;
+   text = trackInfo.GetTextInfo(TrackInfoArtist, avail);
+   if (avail)
+      AddVorbisComment("ARTIST", text);
+
+   text = trackInfo.GetTextInfo(TrackInfoTitle, avail);
+   if (avail)
+      AddVorbisComment("TITLE", text);
+
+   text = trackInfo.GetTextInfo(TrackInfoAlbum, avail);
+   if (avail)
+      AddVorbisComment("ALBUM", text);
+
+   text = trackInfo.GetTextInfo(TrackInfoDiscArtist, avail);
+   if (avail)
+      AddVorbisComment("ALBUMARTIST", text);
+
+   text = trackInfo.GetTextInfo(TrackInfoComposer, avail);
+   if (avail)
+      AddVorbisComment("COMPOSER", text);
+
+   text = trackInfo.GetTextInfo(TrackInfoComment, avail);
+   if (avail)
+      AddVorbisComment("COMMENT", text);
+
+   int year = trackInfo.GetNumberInfo(TrackInfoYear, avail);
+   if (avail && year != -1)
+   {
+      text.Format(_T("%i"), year);
+      AddVorbisComment("DATE", text);
+   }
+
+   int trackNumber = trackInfo.GetNumberInfo(TrackInfoTrack, avail);
+   if (avail && trackNumber > 0)
+   {
+      text.Format(_T("%i"), trackNumber);
+      AddVorbisComment("TRACKNUMBER", text);
+   }
+
+   int discNumber = trackInfo.GetNumberInfo(TrackInfoDiscNumber, avail);
+   if (avail && discNumber > 0)
+   {
+      text.Format(_T("%i"), discNumber);
+      AddVorbisComment("DISCNUMBER", text);
+   }
+
+   text = trackInfo.GetTextInfo(TrackInfoGenre, avail);
+   if (avail)
+      AddVorbisComment("GENRE", text);
+}
+
+void FlacOutputModule::AddFrontCoverPicture(const TrackInfo& trackInfo)
+{
+   std::vector<unsigned char> imageData;
+   if (!trackInfo.GetBinaryInfo(TrackInfoFrontCover, imageData) ||
+      imageData.empty())
+      return;
+
+   FLAC__StreamMetadata* picture = FLAC__metadata_object_new(FLAC__METADATA_TYPE_PICTURE);
+   if (picture == nullptr)
+      return;
+
+   picture->data.picture.type = FLAC__STREAM_METADATA_PICTURE_TYPE_FRONT_COVER;
+
+   const unsigned char pngSignature[] = { 0x89, 'P', 'N', 'G' };
+   bool isPng = imageData.size() > sizeof(pngSignature) &&
+      memcmp(imageData.data(), pngSignature, sizeof(pngSignature)) == 0;
+
+   if (!FLAC__metadata_object_picture_set_mime_type(picture,
+      const_cast<char*>(isPng ? "image/png" : "image/jpeg"), true) ||
+      !FLAC__metadata_object_picture_set_data(picture,
+         imageData.data(), static_cast<FLAC__uint32>(imageData.size()), true))
+   {
+      ATLTRACE(_T("FlacOutputModule: couldn't store front cover picture\n"));
+      FLAC__metadata_object_delete(picture);
+      return;
+   }
+
+   m_metadata.push_back(picture);
+}
+
+void FlacOutputModule::AddVorbisComment(const char* name, const CString& value)
+{
+   std::vector<char> utf8Buffer;
+   StringToUTF8(value, utf8Buffer);
+
+   FLAC__StreamMetadata_VorbisComment_Entry entry = {};
+   if (!FLAC__metadata_object_vorbiscomment_entry_from_name_value_pair(&entry, name, utf8Buffer.data()))
+   {
+      ATLTRACE(_T("FlacOutputModule: couldn't create Vorbis comment %hs\n"), name);
+      return;
+   }
+
+   // entry memory is taken over by the metadata block
+   if (!FLAC__metadata_object_vorbiscomment_append_comment(m_vorbisComment, entry, false))
+   {
+      ATLTRACE(_T("FlacOutputModule: couldn't add Vorbis comment %hs\n"), name);
+      free(entry.entry);
+   }
+}
+
+bool FlacOutputModule::OpenOutputFile(LPCTSTR outputFilename, SettingsManager& mgr)
+{
+   // lossless compression usually ends up at about 60% of the PCM data rate
+   unsigned int bytesPerSecond = static_cast<unsigned int>(
+      m_samplerate * m_channels * ((m_bitsPerSample + 7) / 8) * 6 / 10);
+
+   if (!m_outputFile.Open(outputFilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
+   {
+      m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_outputFile.GetLastErrorText().GetString());
+      return false;
+   }
+
+   return true;
+}
+
+void FlacOutputModule::SetEncoderStateError()
+{
+   if (m_outputFile.GetLastError() != 0)
+   {
+      m_lastError.LoadString(IDS_ENCODER_ERROR_WRITE_OUTPUT);
+      m_lastError.AppendFormat(_T(" (%s)"), m_outputFile.GetLastErrorText().GetString());
+      return;
+   }
+
+   FLAC__StreamEncoderState state = FLAC__stream_encoder_get_state(m_encoder);
+   m_lastError.Format(_T("FLAC encoder error: %hs"), FLAC__StreamEncoderStateString[state]);
+}
+
+void FlacOutputModule::Cleanup()
+{
+   if (m_encoder != nullptr)
+   {
+      FLAC__stream_encoder_delete(m_encoder);
+      m_encoder = nullptr;
+   }
+
+   for (FLAC__StreamMetadata* metadata : m_metadata)
+      FLAC__metadata_object_delete(metadata);
+
+   m_metadata.clear();
+   m_vorbisComment = nullptr;
+}
+
+FLAC__StreamEncoderWriteStatus FlacOutputModule::WriteCallback(const FLAC__StreamEncoder* encoder,
+   const FLAC__byte buffer[], size_t bytes, uint32_t samples, uint32_t currentFrame, void* clientData)
+{
+   UNUSED(encoder);
+   UNUSED(samples);
+   UNUSED(currentFrame);
+
+   FlacOutputModule* module = static_cast<FlacOutputModule*>(clientData);
+
+   return module->m_outputFile.Write(buffer, bytes)
+      ? FLAC__STREAM_ENCODER_WRITE_STATUS_OK
+      : FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+}
+
+FLAC__StreamEncoderSeekStatus FlacOutputModule::SeekCallback(const FLAC__StreamEncoder* encoder,
+   FLAC__uint64 absoluteByteOffset, void* clientData)
+{
+   UNUSED(encoder);
+
+   FlacOutputModule* module = static_cast<FlacOutputModule*>(clientData);
+
+   return module->m_outputFile.Seek(absoluteByteOffset)
+      ? FLAC__STREAM_ENCODER_SEEK_STATUS_OK
+      : FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+}
+
+FLAC__StreamEncoderTellStatus FlacOutputModule::TellCallback(const FLAC__StreamEncoder* encoder,
+   FLAC__uint64* absoluteByteOffset, void* clientData)
+{
+   UNUSED(encoder);
+
+   FlacOutputModule* module = static_cast<FlacOutputModule*>(clientData);
+
+   *absoluteByteOffset = module->m_outputFile.Tell();
+
+   return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+}
@@ -0,0 +1,135 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlacOutputModule.hpp
+/// \brief FLAC output module
+//
+#pragma once
+
+#include "ModuleInterface.hpp"
+#include "BufferedOutputFile.hpp"
+#include "FLAC/stream_encoder.h"
+
+namespace Encoder
+{
+   /// \brief FLAC output module
+   /// \details encodes using the libFLAC stream encoder; frames are encoded
+   /// by multiple worker threads, when libFLAC supports it. The seek table
+   /// is reserved before encoding and filled in by libFLAC when the output
+   /// file is finished.
+   class FlacOutputModule : public OutputModule
+   {
+   public:
+      /// ctor
+      FlacOutputModule();
+      /// dtor
+      virtual ~FlacOutputModule();
+
+      /// returns the module name
+      virtual CString GetModuleName() const override { return _T("FLAC Encoder"); }
+
+      /// returns the last error
+      virtual CString GetLastError() const override { return m_lastError; }
+
+      /// returns if the module is available
+      virtual bool IsAvailable() const override;
+
+      /// returns description of current file
+      virtual CString GetDescription() const override;
+
+      /// returns version string
+      virtual void GetVersionString(CString& version, int special = 0) const override;
+
+      /// returns the extension the output module produces
+      virtual CString GetOutputExtension() const override { return _T("flac"); }
+
+      /// initializes the output module
+      virtual int InitOutput(LPCTSTR outfilename, SettingsManager& mgr,
+         const TrackInfo& trackInfo, SampleContainer& samples) override;
+
+      /// encodes samples from the sample container
+      virtual int EncodeSamples(SampleContainer& samples) override;
+
+      /// cleans up the output module
+      virtual void DoneOutput() override;
+
+   private:
+      /// sets up encoder options
+      bool SetEncoderOptions(SettingsManager& mgr);
+
+      /// creates all metadata blocks to write before the audio frames
+      bool CreateMetadata(const TrackInfo& trackInfo, FLAC__uint64 totalSamplesEstimate);
+
+      /// adds Vorbis comments from track info
+      void AddVorbisComments(const TrackInfo& trackInfo);
+
+      /// adds front cover picture from track info, if available
+      void AddFrontCoverPicture(const TrackInfo& trackInfo);
+
+      /// adds a single Vorbis comment to the metadata
+      void AddVorbisComment(const char* name, const CString& value);
+
+      /// opens output file
+      bool OpenOutputFile(LPCTSTR outputFilename, SettingsManager& mgr);
+
+      /// sets last error from current encoder state
+      void SetEncoderStateError();
+
+      /// frees encoder and metadata blocks
+      void Cleanup();
+
+      /// called by libFLAC to write encoded data
+      static FLAC__StreamEncoderWriteStatus WriteCallback(const FLAC__StreamEncoder* encoder,
+         const FLAC__byte buffer[], size_t bytes, uint32_t samples, uint32_t currentFrame, void* clientData);
+
+      /// called by libFLAC to seek in the output file, e.g. to update the
+      /// stream info and seek table
+      static FLAC__StreamEncoderSeekStatus SeekCallback(const FLAC__StreamEncoder* encoder,
+         FLAC__uint64 absoluteByteOffset, void* clientData);
+
+      /// called by libFLAC to get the current output file position
+      static FLAC__StreamEncoderTellStatus TellCallback(const FLAC__StreamEncoder* encoder,
+         FLAC__uint64* absoluteByteOffset, void* clientData);
+
+   private:
+      /// last error occured
+      CString m_lastError;
+
+      /// libFLAC encoder
+      FLAC__StreamEncoder* m_encoder;
+
+      /// metadata blocks; owned by the module, since libFLAC doesn't free them
+      std::vector<FLAC__StreamMetadata*> m_metadata;
+
+      /// Vorbis comment metadata block; also contained in m_metadata
+      FLAC__StreamMetadata* m_vorbisComment;
+
+      /// output file
+      BufferedOutputFile m_outputFile;
+
+      /// number of bits per sample in the FLAC stream
+      int m_bitsPerSample;
+
+      /// compression level, from 0 to 8
+      int m_compressionLevel;
+
+      /// number of threads used for encoding
+      unsigned int m_numThreads;
+   };
+
+} // namespace Encoder
@@ -58,6 +58,23 @@ namespace Encoder
       /// returns the number of percent done
       virtual float PercentDone() const { return 0.f; }
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const { return false; }
+
+      /// returns total number of samples per channel of the current file,
+      /// or -1 when unknown
+      virtual __int64 GetTotalSamples() const { return -1; }
+
+      /// \brief seeks to a sample position in the current file
+      /// \details the position is counted in samples per channel, starting at 0;
+      /// the next call to DecodeSamples() returns samples starting exactly at
+      /// this position. Returns 0 on success, or a negative value on error.
+      virtual int SeekToSample(__int64 samplePosition)
+      {
+         UNUSED(samplePosition);
+         return -1;
+      }
+
       /// called when done with decoding
       virtual void DoneInput() = 0;
    };
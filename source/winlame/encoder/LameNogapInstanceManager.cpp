@@ -21,35 +21,49 @@
 //
 #include "stdafx.h"
 #include "LameNogapInstanceManager.hpp"
+#include <ulib/Path.hpp>
 
 using Encoder::LameNogapInstanceManager;
 
-int LameNogapInstanceManager::s_nextNogapInstanceId = 0;
-
 LameNogapInstanceManager::LameNogapInstanceManager()
+   :m_nextNogapInstanceId(0)
+{
+}
+
+LameNogapInstanceManager::~LameNogapInstanceManager()
 {
+   // chains that were stopped or failed before their last file still have
+   // their instance stored
+   for (auto& iter : m_allInstances)
+      nlame_delete(iter.second);
 }
 
 int LameNogapInstanceManager::NextNogapInstanceId()
 {
-   return s_nextNogapInstanceId++;
+   return m_nextNogapInstanceId++;
 }
 
 bool LameNogapInstanceManager::IsRegistered(int nogapInstanceId) const
 {
+   std::unique_lock<std::mutex> lock(m_mutex);
+
    auto iter = m_allInstances.find(nogapInstanceId);
    return iter != m_allInstances.end();
 }
 
 void LameNogapInstanceManager::RegisterInstance(int nogapInstanceId, nlame_instance_t* instance)
 {
-   ATLASSERT(!IsRegistered(nogapInstanceId)); // must not be registered yet
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   ATLASSERT(m_allInstances.find(nogapInstanceId) == m_allInstances.end()); // must not be registered yet
 
    m_allInstances[nogapInstanceId] = instance;
 }
 
 nlame_instance_t* LameNogapInstanceManager::GetInstance(int nogapInstanceId)
 {
+   std::unique_lock<std::mutex> lock(m_mutex);
+
    auto iter = m_allInstances.find(nogapInstanceId);
    if (iter == m_allInstances.end())
       return nullptr;
@@ -57,9 +71,55 @@ nlame_instance_t* LameNogapInstanceManager::GetInstance(int nogapInstanceId)
    return iter->second;
 }
 
+nlame_instance_t* LameNogapInstanceManager::TakeInstance(int nogapInstanceId)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = m_allInstances.find(nogapInstanceId);
+   if (iter == m_allInstances.end())
+      return nullptr;
+
+   nlame_instance_t* instance = iter->second;
+   m_allInstances.erase(iter);
+
+   return instance;
+}
+
 void LameNogapInstanceManager::UnregisterInstance(int nogapInstanceId)
 {
-   ATLASSERT(IsRegistered(nogapInstanceId)); // must have been registered
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   ATLASSERT(m_allInstances.find(nogapInstanceId) != m_allInstances.end()); // must have been registered
 
    m_allInstances.erase(nogapInstanceId);
 }
+
+CString LameNogapInstanceManager::GetChainKey(const EncoderJob& job)
+{
+   // the disc images of multiple cue sheets may be stored in the same folder
+   CString key;
+   if (!job.CueSheetFilename().IsEmpty())
+      key = _T("cue|") + job.CueSheetFilename();
+   else
+   {
+      // the tracks of an album are usually stored in the same folder
+      key = _T("folder|") + Path::FolderName(job.InputFilename());
+
+      const TrackInfo& trackInfo = job.GetTrackInfo();
+
+      bool avail = false;
+      CString album = trackInfo.GetTextInfo(TrackInfoAlbum, avail);
+      if (job.UseTrackInfo() && avail && !album.IsEmpty())
+      {
+         key += _T("|album|") + album;
+
+         int discNumber = trackInfo.GetNumberInfo(TrackInfoDiscNumber, avail);
+         if (avail)
+            key.AppendFormat(_T("|%i"), discNumber);
+      }
+   }
+
+   key.MakeLower();
+
+   return key;
+}
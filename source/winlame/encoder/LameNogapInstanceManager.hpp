@@ -22,17 +22,33 @@
 #pragma once
 
 #include "nlame.h"
+#include "EncoderInterface.hpp"
 #include <map>
+#include <mutex>
+#include <atomic>
 
 namespace Encoder
 {
-   /// instance manager for nlame instances used for nogap encoding
+   /// \brief instance manager for nlame instances used for nogap encoding
+   /// \details each nogap chain, e.g. an album, uses its own nogap instance
+   /// ID; the files of a chain are encoded one after another, but multiple
+   /// chains may be encoded at the same time. Between two files of a chain,
+   /// the nlame instance is stored here. All methods may be called by
+   /// multiple encoder threads at the same time.
    class LameNogapInstanceManager
    {
    public:
       /// ctor
       LameNogapInstanceManager();
 
+      /// dtor; deletes instances of chains that were never finished
+      ~LameNogapInstanceManager();
+
+      /// deleted copy ctor
+      LameNogapInstanceManager(const LameNogapInstanceManager&) = delete;
+      /// deleted copy assignment operator
+      LameNogapInstanceManager& operator=(const LameNogapInstanceManager&) = delete;
+
       /// returns next free nogap instance ID
       int NextNogapInstanceId();
 
@@ -45,12 +61,27 @@ namespace Encoder
       /// returns saved nlame instance for nogap encoding
       nlame_instance_t* GetInstance(int nogapInstanceId);
 
+      /// \brief removes saved nlame instance for nogap encoding and returns it
+      /// \details the caller owns the instance, until it's registered again
+      /// for the next file of the chain; returns nullptr when no instance is
+      /// registered, e.g. for the first file of a chain
+      nlame_instance_t* TakeInstance(int nogapInstanceId);
+
       /// unregisters an instance again
       void UnregisterInstance(int nogapInstanceId);
 
+      /// \brief returns key of the nogap chain an encoder job belongs to
+      /// \details All tracks of a cue sheet form one chain. Other tracks
+      /// form one chain per album and disc number, when the album is known
+      /// from the job's track info, and one chain per folder otherwise.
+      static CString GetChainKey(const EncoderJob& job);
+
    private:
       /// next nogap instance ID
-      static int s_nextNogapInstanceId;
+      std::atomic<int> m_nextNogapInstanceId;
+
+      /// mutex protecting the instance map
+      mutable std::mutex m_mutex;
 
       /// mapping from instance ID to instance
       std::map<int, nlame_instance_t*> m_allInstances;
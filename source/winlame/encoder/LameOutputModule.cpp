@@ -21,19 +21,24 @@
 /// \brief contains the implementation of the LAME output module
 //
 #include "stdafx.h"
-#include <fstream>
 #include "resource.h"
 #include "LameOutputModule.hpp"
 #include "LameNogapInstanceManager.hpp"
 #include "WaveMp3Header.hpp"
 #include "Id3v1Tag.hpp"
 #include "AudioFileTag.hpp"
-#include <ulib/win32/ErrorMessage.hpp>
+#include <mutex>
 
 using Encoder::LameOutputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
 
+/// \brief mutex serializing the creation of LAME instances
+/// \details lame_init() and lame_init_params() fill global lookup tables of
+/// the LAME library, e.g. for quantization and for the decoder used for
+/// finding the replay gain, without synchronizing
+static std::mutex s_mutexLameInit;
+
 LameOutputModule::LameOutputModule()
    :m_instance(nullptr),
    m_writeInfoTag(true),
@@ -110,10 +115,14 @@ int LameOutputModule::InitOutput(LPCTSTR outfilename,
    // open output file
    m_mp3Filename = outfilename;
 
-   m_outputFile.open(outfilename, std::ios::out | std::ios::binary);
-   if (!m_outputFile.is_open())
+   // estimate output size for CBR and ABR encoding
+   unsigned int bytesPerSecond = 0;
+   if (mgr.QueryValueInt(LameSimpleQualityOrBitrate) == 0)
+      bytesPerSecond = static_cast<unsigned int>(mgr.QueryValueInt(LameSimpleBitrate)) * 1000 / 8;
+
+   if (!m_outputFile.Open(outfilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
    {
-      CString lastErrorText = Win32::ErrorMessage().ToString();
+      CString lastErrorText = m_outputFile.GetLastErrorText();
 
       m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
       m_lastError.AppendFormat(_T(" (message \"%s\", filename \"%s\")"), lastErrorText.GetString(), outfilename);
@@ -137,11 +146,11 @@ int LameOutputModule::InitOutput(LPCTSTR outfilename,
    {
       m_nogapInstanceId = mgr.QueryValueInt(LameNoGapInstanceId);
 
-      // use last stored nlame instance
-      if (m_nogapInstanceManager.IsRegistered(m_nogapInstanceId))
+      // use last stored nlame instance; it belongs to this module until
+      // it's stored again for the next file of the chain
+      m_instance = m_nogapInstanceManager.TakeInstance(m_nogapInstanceId);
+      if (m_instance != nullptr)
       {
-         m_instance = m_nogapInstanceManager.GetInstance(m_nogapInstanceId);
-
          // set callbacks
          nlame_callback_set(m_instance, nle_callback_error, LameErrorCallback);
          nlame_callback_set(m_instance, nle_callback_debug, LameErrorCallback);
@@ -156,6 +165,8 @@ int LameOutputModule::InitOutput(LPCTSTR outfilename,
 
    if (m_instance == nullptr)
    {
+      std::unique_lock<std::mutex> lock(s_mutexLameInit);
+
       // init nlame
       m_instance = nlame_new();
 
@@ -275,7 +286,7 @@ int LameOutputModule::EncodeFrame()
    // write out data when available
    if (ret > 0)
    {
-      m_outputFile.write(reinterpret_cast<char*>(m_mp3OutputBuffer.data()), ret);
+      m_outputFile.Write(m_mp3OutputBuffer.data(), ret);
       m_numDataBytesWritten += ret;
    }
 
@@ -337,7 +348,7 @@ void LameOutputModule::FlushOutputBuffer()
 
    if (ret > 0)
    {
-      m_outputFile.write(reinterpret_cast<char*>(m_mp3OutputBuffer.data()), ret);
+      m_outputFile.Write(m_mp3OutputBuffer.data(), ret);
       m_numDataBytesWritten += ret;
    }
 }
@@ -356,7 +367,7 @@ void LameOutputModule::FinishEncoding()
    //       since that that might confuse some software
    if (!m_writeWaveHeader && /* !m_nogapEncoding && */ m_ID33v1Tag != nullptr)
    {
-      m_outputFile.write((char*)m_ID33v1Tag->GetData(), 128);
+      m_outputFile.Write(m_ID33v1Tag->GetData(), 128);
    }
 
    if (m_writeWaveHeader)
@@ -365,8 +376,8 @@ void LameOutputModule::FinishEncoding()
       FixupWaveMp3Header(m_outputFile, m_numDataBytesWritten, m_numSamplesEncoded);
    }
 
-   // close file
-   m_outputFile.close();
+   // close file; writes out all pending buffers
+   m_outputFile.Close();
 
    // add VBR info tag to mp3 file
    // note: since nlame_write_vbr_infotag() seeks to the front of the output
@@ -387,16 +398,12 @@ void LameOutputModule::FreeLameInstance()
 {
    if (m_nogapEncoding)
    {
+      // store instance for the next file of the chain; the last file of
+      // the chain took the instance already
       if (!m_nogapIsLastFile)
-      {
-         if (!m_nogapInstanceManager.IsRegistered(m_nogapInstanceId))
-            m_nogapInstanceManager.RegisterInstance(m_nogapInstanceId, m_instance);
-      }
+         m_nogapInstanceManager.RegisterInstance(m_nogapInstanceId, m_instance);
       else
-      {
-         m_nogapInstanceManager.UnregisterInstance(m_nogapInstanceId);
          nlame_delete(m_instance);
-      }
    }
    else
    {
@@ -407,7 +414,7 @@ void LameOutputModule::FreeLameInstance()
 
 void LameOutputModule::DoneOutput()
 {
-   if (m_outputFile.is_open())
+   if (m_outputFile.IsOpen())
       FinishEncoding();
 
    if (m_instance != nullptr)
@@ -546,7 +553,7 @@ void LameOutputModule::AddPaddingForID3v2AndLameTag(const TrackInfo& trackInfo)
    {
       paddingSize += nlame_get_vbr_infotag_length(m_instance);
 
-      m_fileOffsetVbrInfoTag = paddingSize + static_cast<long>(m_outputFile.tellp());
+      m_fileOffsetVbrInfoTag = paddingSize + static_cast<long>(m_outputFile.Tell());
    }
 
    if (paddingSize > 0)
@@ -555,7 +562,7 @@ void LameOutputModule::AddPaddingForID3v2AndLameTag(const TrackInfo& trackInfo)
       while (paddingSize > 0)
       {
          size_t sizeToWrite = std::min(size_t(paddingSize), paddingBuffer.size());
-         m_outputFile.write(paddingBuffer.data(), sizeToWrite);
+         m_outputFile.Write(paddingBuffer.data(), sizeToWrite);
 
          paddingSize -= int(sizeToWrite);
       }
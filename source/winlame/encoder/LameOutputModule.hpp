@@ -22,7 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
-#include <iosfwd>
+#include "BufferedOutputFile.hpp"
 #include "nlame.h"
 
 namespace Encoder
@@ -102,8 +102,8 @@ namespace Encoder
       /// nlame instance
       nlame_instance_t* m_instance;
 
-      /// output file stream
-      std::ofstream m_outputFile;
+      /// output file
+      BufferedOutputFile m_outputFile;
 
       /// output mp3 filename
       CString m_mp3Filename;
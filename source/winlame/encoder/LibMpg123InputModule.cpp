@@ -28,10 +28,12 @@
 using Encoder::LibMpg123InputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::BufferedInputFile;
 
 LibMpg123InputModule::LibMpg123InputModule()
 :m_isAtEndOfFile(false),
-m_fileSize(0L)
+m_fileSize(0L),
+m_isScanned(false)
 {
    m_moduleId = ID_IM_LIBMPG123;
 }
@@ -135,19 +137,14 @@ int LibMpg123InputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
 
    m_decoder.reset(handle, mpg123_delete);
 
-   FILE* fd = nullptr;
-   errno_t err = _tfopen_s(&fd, infilename, _T("rb"));
-
-   if (err != 0 || fd == nullptr)
+   if (!m_inputFile.Open(infilename))
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
       return -1;
    }
 
-   m_inputFile.reset(fd, fclose);
-
-   if (!GetFileSize())
-      return -1;
+   m_fileSize = m_inputFile.Length();
 
    GetTrackInfo(infilename, trackInfo);
 
@@ -180,6 +177,12 @@ void LibMpg123InputModule::GetInfo(int& numChannels, int& bitrateInBps, int& len
    off_t numTotalSamples = mpg123_length(m_decoder.get());
 
    lengthInSeconds = numTotalSamples / samplerateInHz;
+
+   // the frame info contains the bitrate of the current frame only; for VBR
+   // and ABR files the length is known from the Xing frame, so the average
+   // bitrate is calculated from the file size instead; tags are included
+   if (frameInfo.vbr != MPG123_CBR && numTotalSamples > 0)
+      bitrateInBps = static_cast<int>(double(m_fileSize) * 8.0 * samplerateInHz / numTotalSamples);
 }
 
 int LibMpg123InputModule::DecodeSamples(SampleContainer& samples)
@@ -213,67 +216,88 @@ int LibMpg123InputModule::DecodeSamples(SampleContainer& samples)
 float LibMpg123InputModule::PercentDone() const
 {
    if (m_decoder == nullptr ||
-      m_inputFile == nullptr ||
+      !m_inputFile.IsOpen() ||
       m_fileSize == 0)
       return 0.0f;
 
-   if (feof(m_inputFile.get()) ||
+   if (m_inputFile.IsEndOfFile() ||
       m_isAtEndOfFile)
       return 100.0f;
 
-   long pos = ftell(m_inputFile.get());
+   ULONGLONG pos = m_inputFile.Tell();
 
    return float(pos) * 100.0f / m_fileSize;
 }
 
-void LibMpg123InputModule::DoneInput()
+bool LibMpg123InputModule::CanSeek() const
 {
-   m_isAtEndOfFile = true;
+   return m_decoder != nullptr;
+}
 
-   if (m_decoder != nullptr)
-      mpg123_close(m_decoder.get());
+__int64 LibMpg123InputModule::GetTotalSamples() const
+{
+   if (m_decoder == nullptr)
+      return -1;
 
-   m_decoder.reset();
+   // without scanning, the length is only estimated for files without a Xing
+   // or LAME header; scanning also builds the seek index
+   if (!m_isScanned)
+      m_isScanned = mpg123_scan(m_decoder.get()) == MPG123_OK;
+
+   off_t numTotalSamples = mpg123_length(m_decoder.get());
+
+   return numTotalSamples >= 0 ? numTotalSamples : -1;
 }
 
-bool LibMpg123InputModule::GetFileSize()
+int LibMpg123InputModule::SeekToSample(__int64 samplePosition)
 {
-   errno_t err = fseek(m_inputFile.get(), 0, SEEK_END);
-   if (err != 0)
+   if (m_decoder == nullptr)
+      return -1;
+
+   // seeking is sample accurate, since the decoder is used without the
+   // MPG123_FUZZY flag; gapless decoding removes the encoder delay and padding
+   off_t ret = mpg123_seek(m_decoder.get(), static_cast<off_t>(samplePosition), SEEK_SET);
+   if (ret < 0)
    {
-      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
-      m_inputFile.reset();
-      return false;
+      m_lastError.LoadString(IDS_ENCODER_SEEK_ERROR);
+      m_lastError.AppendFormat(_T(" (%hs)"), mpg123_strerror(m_decoder.get()));
+      return -1;
    }
 
-   m_fileSize = ftell(m_inputFile.get());
+   m_isAtEndOfFile = false;
 
-   err = fseek(m_inputFile.get(), 0, SEEK_SET);
-   if (err != 0)
-   {
-      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
-      m_inputFile.reset();
-      return false;
-   }
+   return 0;
+}
 
-   return true;
+void LibMpg123InputModule::DoneInput()
+{
+   m_isAtEndOfFile = true;
+   m_isScanned = false;
+
+   if (m_decoder != nullptr)
+      mpg123_close(m_decoder.get());
+
+   m_decoder.reset();
+
+   m_inputFile.Close();
 }
 
 static mpg123_ssize_t ReadFromFile(void* handle, void* buffer, size_t size)
 {
-   return fread(buffer, 1, size, (FILE*)handle);
+   return static_cast<BufferedInputFile*>(handle)->Read(buffer, size);
 }
 
 static off_t SeekInFile(void* handle, off_t offset, int direction)
 {
-   if (fseek((FILE*)handle, offset, direction) != 0)
+   BufferedInputFile* inputFile = static_cast<BufferedInputFile*>(handle);
+   if (!inputFile->Seek(offset, direction))
       return (off_t)-1;
-   return ftell((FILE*)handle);
+   return static_cast<off_t>(inputFile->Tell());
 }
 
 static void CleanupFile(void* handle)
 {
-   // don't fclose the handle here, since m_inputFile will do that for us
+   // don't close the file here, since m_inputFile will do that for us
    UNUSED(handle);
 }
 
@@ -281,7 +305,7 @@ bool LibMpg123InputModule::OpenStream()
 {
    mpg123_replace_reader_handle(m_decoder.get(), ReadFromFile, SeekInFile, CleanupFile);
 
-   int ret = mpg123_open_handle(m_decoder.get(), m_inputFile.get());
+   int ret = mpg123_open_handle(m_decoder.get(), &m_inputFile);
    if (ret != MPG123_OK)
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
@@ -302,11 +326,10 @@ bool LibMpg123InputModule::GetTrackInfo(const CString& filename, TrackInfo& trac
    // search for id3v1 tag
    if (!found)
    {
-      errno_t err = fseek(m_inputFile.get(), -128L, SEEK_END);
-      if (err == 0)
+      if (m_inputFile.Seek(-128L, SEEK_END))
       {
          Id3v1Tag id3tag;
-         int ret = fread(id3tag.GetData(), 128, 1, m_inputFile.get());
+         size_t ret = m_inputFile.Read(id3tag.GetData(), 128);
          if (ret == 128 && id3tag.IsValidTag())
          {
             // store found id3 tag infos
@@ -315,8 +338,7 @@ bool LibMpg123InputModule::GetTrackInfo(const CString& filename, TrackInfo& trac
          }
       }
 
-      err = fseek(m_inputFile.get(), 0, SEEK_SET);
-      if (err != 0)
+      if (!m_inputFile.Seek(0, SEEK_SET))
          return false;
    }
 
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedInputFile.hpp"
 #define MPG123_ENUM_API
 #include <mpg123.h>
 
@@ -70,13 +71,19 @@ namespace Encoder
       /// returns the number of percent done
       virtual float PercentDone() const override;
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
    private:
-      /// reads file size from opened input file
-      bool GetFileSize();
-
       /// opens m3 stream from input file
       bool OpenStream();
 
@@ -97,16 +104,19 @@ namespace Encoder
       CString m_lastError;
 
       /// input file
-      std::shared_ptr<FILE> m_inputFile;
+      BufferedInputFile m_inputFile;
 
       /// file size of input file
-      long m_fileSize;
+      ULONGLONG m_fileSize;
 
       /// handle to the mpg123 decoder
       std::shared_ptr<mpg123_handle> m_decoder;
 
       /// indicates if the decoder is at the end of the file
       bool m_isAtEndOfFile;
+
+      /// indicates if the whole file was scanned to get the exact length
+      mutable bool m_isScanned;
    };
 
 } // namespace Encoder
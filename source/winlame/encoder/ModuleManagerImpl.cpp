@@ -22,6 +22,8 @@
 #include "stdafx.h"
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <mutex>
 #include "ModuleManagerImpl.hpp"
 #include "LameOutputModule.hpp"
 #include "OggVorbisOutputModule.hpp"
@@ -37,6 +39,7 @@
 #include "SpeexInputModule.hpp"
 #include "OpusInputModule.hpp"
 #include "OpusOutputModule.hpp"
+#include "FlacOutputModule.hpp"
 #include "LibMpg123InputModule.hpp"
 #include "resource.h"
 
@@ -44,83 +47,191 @@ using namespace Encoder;
 
 // global functions
 
-/// max number of input modules GetNewInputModule can return
-const size_t c_maxInputModule = 9;
+/// descriptor of an input or output module; known at compile time, so that
+/// no module has to be created to find a module by ID
+template <typename TModule>
+struct ModuleDescriptor
+{
+   /// module ID
+   int m_moduleId;
+
+   /// creates a new module instance
+   TModule* (*m_createModule)();
+};
+
+/// creates a new module instance of given type
+template <typename TModule, typename TConcreteModule>
+TModule* CreateModule()
+{
+   return new TConcreteModule;
+}
+
+/// all input modules, in the order in which they are chosen for a file
+const ModuleDescriptor<InputModule> c_inputModuleDescriptors[] =
+{
+   { ID_IM_LIBMPG123, &CreateModule<InputModule, LibMpg123InputModule> },
+   { ID_IM_OPUS, &CreateModule<InputModule, OpusInputModule> },
+   { ID_IM_OGGV, &CreateModule<InputModule, OggVorbisInputModule> },
+   { ID_IM_AAC, &CreateModule<InputModule, AacInputModule> },
+   { ID_IM_MONKEYSAUDIO, &CreateModule<InputModule, MonkeysAudioInputModule> },
+   { ID_IM_FLAC, &CreateModule<InputModule, FlacInputModule> },
+   { ID_IM_BASS, &CreateModule<InputModule, BassInputModule> },
+   { ID_IM_SPEEX, &CreateModule<InputModule, SpeexInputModule> },
+   { ID_IM_SNDFILE, &CreateModule<InputModule, SndFileInputModule> },
+};
+
+/// max number of input modules
+const size_t c_maxInputModule = sizeof(c_inputModuleDescriptors) / sizeof(*c_inputModuleDescriptors);
+
+/// all output modules, in the order in which they are presented
+const ModuleDescriptor<OutputModule> c_outputModuleDescriptors[] =
+{
+   { ID_OM_LAME, &CreateModule<OutputModule, LameOutputModule> },
+   { ID_OM_OPUS, &CreateModule<OutputModule, OpusOutputModule> },
+   { ID_OM_OGGV, &CreateModule<OutputModule, OggVorbisOutputModule> },
+   { ID_OM_WAVE, &CreateModule<OutputModule, SndFileOutputModule> },
+   { ID_OM_BASSWMA, &CreateModule<OutputModule, BassWmaOutputModule> },
+   { ID_OM_AAC, &CreateModule<OutputModule, AacOutputModule> },
+   { ID_OM_FLAC, &CreateModule<OutputModule, FlacOutputModule> },
+};
+
+/// max number of output modules
+const size_t c_maxOutputModule = sizeof(c_outputModuleDescriptors) / sizeof(*c_outputModuleDescriptors);
+
+/// \brief infos about a module that are probed on first use
+/// \details probing a module may load DLLs or initialize codec libraries;
+/// the infos are cached for the whole process, since the availability of a
+/// module doesn't change while running, and module managers may be created
+/// more than once
+struct ProbedModuleInfo
+{
+   bool m_isProbed = false;      ///< indicates if the module was probed already
+   bool m_isAvailable = false;   ///< indicates if the module is available
+   CString m_moduleName;         ///< module name
+   CString m_filterString;       ///< filter string; only set for input modules
+};
+
+/// mutex protecting the probed module infos
+static std::mutex s_mutexProbedModuleInfos;
+
+/// probed infos of all input modules, by descriptor index
+static ProbedModuleInfo s_probedInputModuleInfos[c_maxInputModule];
 
-/// returns a new input module by index
-InputModule* GetNewInputModule(size_t index)
+/// probed infos of all output modules, by descriptor index
+static ProbedModuleInfo s_probedOutputModuleInfos[c_maxOutputModule];
+
+/// probes input module with given descriptor index, when not done already;
+/// the returned infos don't change anymore
+static const ProbedModuleInfo& ProbeInputModule(size_t descriptorIndex)
 {
-   InputModule* inputModule = nullptr;
-   switch (index)
+   std::unique_lock<std::mutex> lock(s_mutexProbedModuleInfos);
+
+   ProbedModuleInfo& info = s_probedInputModuleInfos[descriptorIndex];
+   if (!info.m_isProbed)
    {
-   case 0:
-      inputModule = new LibMpg123InputModule;
-      break;
-   case 1:
-      inputModule = new OpusInputModule;
-      break;
-   case 2:
-      inputModule = new OggVorbisInputModule;
-      break;
-   case 3:
-      inputModule = new AacInputModule;
-      break;
-   case 4:
-      inputModule = new MonkeysAudioInputModule;
-      break;
-   case 5:
-      inputModule = new FlacInputModule;
-      break;
-   case 6:
-      inputModule = new BassInputModule;
-      break;
-   case 7:
-      inputModule = new SpeexInputModule;
-      break;
-   case 8:
-      inputModule = new SndFileInputModule;
-      break;
-   default:
-      ATLASSERT(false);
-      break;
+      auto probeStart = std::chrono::steady_clock::now();
+
+      std::unique_ptr<InputModule> inputModule(c_inputModuleDescriptors[descriptorIndex].m_createModule());
+
+      info.m_isAvailable = inputModule->IsAvailable();
+      info.m_moduleName = inputModule->GetModuleName();
+      if (info.m_isAvailable)
+         info.m_filterString = inputModule->GetFilterString();
+
+      info.m_isProbed = true;
+
+      ATLTRACE(_T("probed input module %s in %.1f ms\n"), info.m_moduleName.GetString(),
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - probeStart).count());
    }
 
-   return inputModule;
+   return info;
 }
 
-/// max number of output modules GetNewOutputModule can return
-const size_t c_maxOutputModule = 6;
-
-/// returns a new output module by index
-OutputModule* GetNewOutputModule(size_t index)
+/// probes output module with given descriptor index, when not done already;
+/// the returned infos don't change anymore
+static const ProbedModuleInfo& ProbeOutputModule(size_t descriptorIndex)
 {
-   OutputModule* outputModule = NULL;
-   switch (index)
+   std::unique_lock<std::mutex> lock(s_mutexProbedModuleInfos);
+
+   ProbedModuleInfo& info = s_probedOutputModuleInfos[descriptorIndex];
+   if (!info.m_isProbed)
    {
-   case 0:
-      outputModule = new LameOutputModule;
-      break;
-   case 1:
-      outputModule = new OpusOutputModule;
-      break;
-   case 2:
-      outputModule = new OggVorbisOutputModule;
-      break;
-   case 3:
-      outputModule = new SndFileOutputModule;
-      break;
-   case 4:
-      outputModule = new BassWmaOutputModule;
-      break;
-   case 5:
-      outputModule = new AacOutputModule;
-      break;
-   default:
-      ATLASSERT(false);
-      break;
+      auto probeStart = std::chrono::steady_clock::now();
+
+      std::unique_ptr<OutputModule> outputModule(c_outputModuleDescriptors[descriptorIndex].m_createModule());
+
+      info.m_isAvailable = outputModule->IsAvailable();
+      info.m_moduleName = outputModule->GetModuleName();
+      info.m_isProbed = true;
+
+      ATLTRACE(_T("probed output module %s in %.1f ms\n"), info.m_moduleName.GetString(),
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - probeStart).count());
    }
 
-   return outputModule;
+   return info;
+}
+
+/// returns descriptor indices of all available input modules; probes all
+/// input modules on first call
+static const std::vector<size_t>& GetAvailableInputModules()
+{
+   static const std::vector<size_t> s_availableInputModules = []()
+   {
+      std::vector<size_t> availableInputModules;
+      for (size_t descriptorIndex = 0; descriptorIndex < c_maxInputModule; descriptorIndex++)
+         if (ProbeInputModule(descriptorIndex).m_isAvailable)
+            availableInputModules.push_back(descriptorIndex);
+
+      return availableInputModules;
+   }();
+
+   return s_availableInputModules;
+}
+
+/// returns descriptor indices of all available output modules; probes all
+/// output modules on first call
+static const std::vector<size_t>& GetAvailableOutputModules()
+{
+   static const std::vector<size_t> s_availableOutputModules = []()
+   {
+      std::vector<size_t> availableOutputModules;
+      for (size_t descriptorIndex = 0; descriptorIndex < c_maxOutputModule; descriptorIndex++)
+         if (ProbeOutputModule(descriptorIndex).m_isAvailable)
+            availableOutputModules.push_back(descriptorIndex);
+
+      return availableOutputModules;
+   }();
+
+   return s_availableOutputModules;
+}
+
+/// returns if filter string contains given lowercase file extension, e.g. ".mp3"
+static bool FilterStringContainsExtension(const CString& filterString, const std::tstring& extension)
+{
+   CString lowerFilter = filterString;
+   lowerFilter.MakeLower();
+   std::tstring filter = lowerFilter.GetString();
+
+   std::tstring::size_type pos;
+   do
+   {
+      // search for second string delimited by a | char
+      pos = filter.find_first_of('|');
+      if (pos != std::tstring::npos)
+      {
+         filter.erase(0, pos + 1);
+         pos = filter.find_first_of('|');
+         if (pos == std::tstring::npos)
+            break;
+
+         // check if the extension is in the filter wildcard pattern
+         std::tstring temp(filter.c_str(), pos);
+         if (temp.find(extension.c_str()) != std::tstring::npos)
+            return true;
+      }
+   } while (pos != std::tstring::npos);
+
+   return false;
 }
 
 void ModuleManagerImpl::GetFilterString(CString& filterstring) const
@@ -198,56 +309,46 @@ bool ModuleManagerImpl::GetAudioFileInfo(LPCTSTR filename,
 
 ModuleManagerImpl::ModuleManagerImpl()
 {
-   // check which output modules are available
-   for (size_t i = 0; i < c_maxOutputModule; i++)
-   {
-      OutputModule* outputModule = GetNewOutputModule(i);
+   // modules are probed on first use
+}
 
-      if (outputModule != nullptr)
-      {
-         if (outputModule->IsAvailable())
-         {
-            m_outputModules.push_back(outputModule);
-            m_mapOutputModuleIdToModuleIndex.insert(
-               std::make_pair(outputModule->GetModuleID(), i));
-         }
-         else
-            delete outputModule;
-      }
-   }
+ModuleManagerImpl::~ModuleManagerImpl()
+{
+}
 
-   // check which input modules are available
-   for (size_t i = 0; i < c_maxInputModule; i++)
-   {
-      InputModule* inputModule = GetNewInputModule(i);
+size_t ModuleManagerImpl::GetInputModuleCount() const
+{
+   return GetAvailableInputModules().size();
+}
 
-      if (inputModule != nullptr)
-      {
-         if (inputModule->IsAvailable())
-            m_inputModules.push_back(inputModule);
-         else
-            delete inputModule;
-      }
-   }
+CString ModuleManagerImpl::GetInputModuleName(size_t index) const
+{
+   return ProbeInputModule(GetAvailableInputModules()[index]).m_moduleName;
 }
 
-ModuleManagerImpl::~ModuleManagerImpl()
+int ModuleManagerImpl::GetInputModuleID(size_t index) const
 {
-   // delete all output modules
-    size_t max = m_outputModules.size();
-   for (size_t i = 0; i < max; i++)
-      delete m_outputModules[i];
+   return c_inputModuleDescriptors[GetAvailableInputModules()[index]].m_moduleId;
+}
 
-   // delete all input modules
-   max = m_inputModules.size();
-   for (size_t i = 0; i < max; i++)
-      delete m_inputModules[i];
+CString ModuleManagerImpl::GetInputModuleFilterString(size_t index) const
+{
+   return ProbeInputModule(GetAvailableInputModules()[index]).m_filterString;
 }
 
-InputModule* ModuleManagerImpl::ChooseInputModule(LPCTSTR filename)
+InputModule* ModuleManagerImpl::GetInputModuleInstance(size_t index)
 {
-   InputModule* inputModule = nullptr;
+   std::unique_lock<std::mutex> lock(m_mutexInputModuleInstances);
+
+   std::unique_ptr<InputModule>& inputModule = m_inputModuleInstances[index];
+   if (inputModule == nullptr)
+      inputModule.reset(c_inputModuleDescriptors[GetAvailableInputModules()[index]].m_createModule());
 
+   return inputModule.get();
+}
+
+InputModule* ModuleManagerImpl::ChooseInputModule(LPCTSTR filename)
+{
    // get file extension
    std::tstring extension(filename);
    std::tstring::size_type pos = extension.find_last_of('.');
@@ -259,86 +360,84 @@ InputModule* ModuleManagerImpl::ChooseInputModule(LPCTSTR filename)
    lowerExtension.MakeLower();
    extension = lowerExtension.GetString();
 
-   // search all filter strings for file extension
-   size_t max = GetInputModuleCount();
-   for (size_t i = 0; i < max && inputModule == nullptr; i++)
+   // search all filter strings for file extension; modules after the first
+   // matching one don't have to be probed
+   for (size_t descriptorIndex = 0; descriptorIndex < c_maxInputModule; descriptorIndex++)
    {
-      CString lowerFilter = GetInputModuleFilterString(i);
-      lowerFilter.MakeLower();
-      std::tstring filter = lowerFilter.GetString();
+      const ProbedModuleInfo& info = ProbeInputModule(descriptorIndex);
 
-      do
+      if (info.m_isAvailable &&
+         FilterStringContainsExtension(info.m_filterString, extension))
       {
-         // search for second string delimited by a | char
-         pos = filter.find_first_of('|');
-         if (pos != std::tstring::npos)
-         {
-            filter.erase(0, pos + 1);
-            pos = filter.find_first_of('|');
-            if (pos == std::tstring::npos)
-               break;
+         return c_inputModuleDescriptors[descriptorIndex].m_createModule();
+      }
+   }
+
+   return nullptr;
+}
 
-            // check if the extension is in the filter wildcard pattern
-            std::tstring temp(filter.c_str(), pos);
-            std::tstring::size_type pos2 = temp.find(extension.c_str());
+size_t ModuleManagerImpl::GetOutputModuleCount()
+{
+   return GetAvailableOutputModules().size();
+}
 
-            if (pos2 != std::tstring::npos)
-            {
-               // clone input module
-               inputModule = m_inputModules[i]->CloneModule();
-               break;
-            }
-         }
-      } while (pos != std::tstring::npos);
-   }
+CString ModuleManagerImpl::GetOutputModuleName(size_t index)
+{
+   return ProbeOutputModule(GetAvailableOutputModules()[index]).m_moduleName;
+}
 
-   return inputModule;
+int ModuleManagerImpl::GetOutputModuleID(size_t index)
+{
+   return c_outputModuleDescriptors[GetAvailableOutputModules()[index]].m_moduleId;
 }
 
 OutputModule* ModuleManagerImpl::GetOutputModule(int moduleId)
 {
-   // search output module per id
-   OutputModule* outputModule = nullptr;
-
-   size_t max = GetOutputModuleCount();
-   for (size_t i = 0; i < max; i++)
-      if (GetOutputModuleID(i) == moduleId)
+   // search output module per id; only this module has to be probed
+   for (size_t descriptorIndex = 0; descriptorIndex < c_maxOutputModule; descriptorIndex++)
+   {
+      if (c_outputModuleDescriptors[descriptorIndex].m_moduleId == moduleId)
       {
-         std::map<int, size_t>::iterator pos =
-            m_mapOutputModuleIdToModuleIndex.find(moduleId);
-
-         if (pos == m_mapOutputModuleIdToModuleIndex.end())
-            continue; // should not happen, normally
+         if (!ProbeOutputModule(descriptorIndex).m_isAvailable)
+            return nullptr;
 
-         outputModule = GetNewOutputModule(pos->second);
-         break;
+         return c_outputModuleDescriptors[descriptorIndex].m_createModule();
       }
+   }
 
-   return outputModule;
+   return nullptr;
 }
 
 void ModuleManagerImpl::GetModuleVersionString(CString& version,
    int moduleId, int special)
 {
+   version.Empty();
+
    // search all input modules for module ID
-   size_t max = GetInputModuleCount();
-   for (size_t i = 0; i < max; i++)
-      if (GetInputModuleID(i) == moduleId)
+   for (size_t descriptorIndex = 0; descriptorIndex < c_maxInputModule; descriptorIndex++)
+      if (c_inputModuleDescriptors[descriptorIndex].m_moduleId == moduleId)
       {
-         m_inputModules[i]->GetVersionString(version, special);
+         if (ProbeInputModule(descriptorIndex).m_isAvailable)
+         {
+            std::unique_ptr<InputModule> inputModule(c_inputModuleDescriptors[descriptorIndex].m_createModule());
+            inputModule->GetVersionString(version, special);
+         }
+
          return;
       }
 
    // and now all output modules
-   max = GetOutputModuleCount();
-   for (size_t i = 0; i < max; i++)
-      if (GetOutputModuleID(i) == moduleId)
+   for (size_t descriptorIndex = 0; descriptorIndex < c_maxOutputModule; descriptorIndex++)
+      if (c_outputModuleDescriptors[descriptorIndex].m_moduleId == moduleId)
       {
-         m_outputModules[i]->GetVersionString(version, special);
+         if (ProbeOutputModule(descriptorIndex).m_isAvailable)
+         {
+            std::unique_ptr<OutputModule> outputModule(c_outputModuleDescriptors[descriptorIndex].m_createModule());
+            outputModule->GetVersionString(version, special);
+         }
+
          return;
       }
-
-   version.Empty();
 }
 
 CString Encoder::GetAnsiCompatFilename(LPCTSTR filename)
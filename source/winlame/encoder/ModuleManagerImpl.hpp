@@ -22,12 +22,18 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include "ModuleManager.hpp"
 #include "ModuleInterface.hpp"
 
 namespace Encoder
 {
-   /// module manager implementation class
+   /// \brief module manager implementation class
+   /// \details the available modules are probed on first use, and only as far
+   /// as needed, e.g. only the output module that is used, or the input
+   /// modules up to the one that can open a file; the results are cached for
+   /// the whole process, so creating a module manager is cheap
    class ModuleManagerImpl : public ModuleManager
    {
    public:
@@ -48,34 +54,19 @@ namespace Encoder
       // input module
 
       /// returns the number of available input modules
-      virtual size_t GetInputModuleCount() const override
-      {
-         return m_inputModules.size();
-      }
+      virtual size_t GetInputModuleCount() const override;
 
       /// returns the name of the input module
-      virtual CString GetInputModuleName(size_t index) const override
-      {
-         return m_inputModules[index]->GetModuleName();
-      }
+      virtual CString GetInputModuleName(size_t index) const override;
 
       /// returns the input module ID
-      virtual int GetInputModuleID(size_t index) const override
-      {
-         return m_inputModules[index]->GetModuleID();
-      }
+      virtual int GetInputModuleID(size_t index) const override;
 
       /// returns the input module filter string
-      virtual CString GetInputModuleFilterString(size_t index) const override
-      {
-         return m_inputModules[index]->GetFilterString();
-      }
+      virtual CString GetInputModuleFilterString(size_t index) const override;
 
       /// returns input module instance
-      virtual InputModule* GetInputModuleInstance(size_t index) override
-      {
-         return m_inputModules[index];
-      }
+      virtual InputModule* GetInputModuleInstance(size_t index) override;
 
       /// chooses an input module suitable for opening file with given filename;
       /// pointer has to be deleted!
@@ -84,22 +75,13 @@ namespace Encoder
       // output module
 
       /// returns the number of available output modules
-      virtual size_t GetOutputModuleCount() override
-      {
-         return m_outputModules.size();
-      }
+      virtual size_t GetOutputModuleCount() override;
 
       /// returns the name of an output module
-      virtual CString GetOutputModuleName(size_t index) override
-      {
-         return m_outputModules[index]->GetModuleName();
-      }
+      virtual CString GetOutputModuleName(size_t index) override;
 
       /// returns the output module ID
-      virtual int GetOutputModuleID(size_t index) override
-      {
-         return m_outputModules[index]->GetModuleID();
-      }
+      virtual int GetOutputModuleID(size_t index) override;
 
       /// retrieves a module version string
       virtual void GetModuleVersionString(CString& version, int moduleId, int special = 0) override;
@@ -108,14 +90,11 @@ namespace Encoder
       OutputModule* GetOutputModule(int moduleId);
 
    private:
-      /// all available output modules
-      std::vector<OutputModule*> m_outputModules;
+      /// mutex protecting the input module instances
+      std::mutex m_mutexInputModuleInstances;
 
-      /// all available input modules
-      std::vector<InputModule*> m_inputModules;
-
-      /// output module ID to index mapping
-      std::map<int, size_t> m_mapOutputModuleIdToModuleIndex;
+      /// input module instances returned by GetInputModuleInstance(), by index
+      std::map<size_t, std::unique_ptr<InputModule>> m_inputModuleInstances;
    };
 
 } //namespace Encoder
@@ -27,6 +27,7 @@
 #include "resource.h"
 #include <cstdio>
 #include <cassert>
+#include <mutex>
 #include "AudioFileTag.hpp"
 
 #define PLATFORM_WINDOWS
@@ -63,8 +64,15 @@ namespace MonkeysAudio
          }
       }
 
-      /// loads library
+      /// loads library; only the first call loads it, since the function
+      /// pointers are used by all module instances, on all encoder threads
       void Load()
+      {
+         std::call_once(m_loadOnceFlag, [this]() { LoadOnce(); });
+      }
+
+      /// loads library and functions
+      void LoadOnce()
       {
          m_module = ::LoadLibraryA("MACDll.dll");
 
@@ -109,6 +117,9 @@ namespace MonkeysAudio
          return ret == 0;
       }
 
+      /// flag to load the library only once
+      std::once_flag m_loadOnceFlag;
+
       /// module handle
       HMODULE m_module;
 
@@ -403,6 +414,33 @@ int MonkeysAudioInputModule::DecodeSamples(SampleContainer& samples)
    return static_cast<int>(numBlocksRetrieved);
 }
 
+bool MonkeysAudioInputModule::CanSeek() const
+{
+   return m_handle != nullptr;
+}
+
+__int64 MonkeysAudioInputModule::GetTotalSamples() const
+{
+   return m_handle != nullptr ? m_numTotalSamples : -1;
+}
+
+int MonkeysAudioInputModule::SeekToSample(__int64 samplePosition)
+{
+   ATLASSERT(s_dll.IsAvail() && m_handle != nullptr);
+
+   // the position is given in blocks, which are samples per channel
+   int retval = s_dll.Seek(m_handle, samplePosition);
+   if (retval != 0)
+   {
+      m_lastError = MonkeysAudio::EncodeMonkeyErrorString(retval);
+      return -retval;
+   }
+
+   m_numCurrentSamples = samplePosition;
+
+   return 0;
+}
+
 void MonkeysAudioInputModule::DoneInput()
 {
    if (m_handle)
@@ -80,6 +80,15 @@ namespace Encoder
          return m_numTotalSamples != 0 ? float(m_numCurrentSamples)*100.f / float(m_numTotalSamples) : 0.f;
       }
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
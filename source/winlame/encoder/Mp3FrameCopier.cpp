@@ -0,0 +1,461 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Mp3FrameCopier.cpp
+/// \brief copies MPEG layer 3 audio frames without re-encoding
+//
+#include "stdafx.h"
+#include "Mp3FrameCopier.hpp"
+#include "BufferedInputFile.hpp"
+#include "BufferedOutputFile.hpp"
+#include <array>
+
+using Encoder::Mp3FrameCopier;
+using Encoder::BufferedInputFile;
+using Encoder::BufferedOutputFile;
+
+/// size of blocks read from the input file
+static const size_t c_readBlockSize = 256 * 1024;
+
+/// length of an MPEG audio frame header
+static const size_t c_frameHeaderLength = 4;
+
+/// layer III bitrates in kbps, for MPEG 1 and for MPEG 2 / 2.5, by bitrate index
+static const unsigned int c_bitrateTable[2][16] =
+{
+   { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+   { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+};
+
+/// MPEG 1 sample rates, by sample rate index
+static const unsigned int c_samplerateTable[3] = { 44100, 48000, 32000 };
+
+/// offset of the music length in the LAME tag
+static const size_t c_lameTagMusicLengthOffset = 28;
+
+/// offset of the music CRC in the LAME tag
+static const size_t c_lameTagMusicCrcOffset = 32;
+
+/// offset of the CRC of the Info frame in the LAME tag; the CRC is calculated
+/// over all bytes of the Info frame before this offset
+static const size_t c_lameTagCrcOffset = 34;
+
+/// reads 32-bit big endian value
+static unsigned int ReadBigEndian32(const BYTE* data)
+{
+   return (unsigned int(data[0]) << 24) | (unsigned int(data[1]) << 16) | (unsigned int(data[2]) << 8) | data[3];
+}
+
+/// writes 32-bit big endian value
+static void WriteBigEndian32(BYTE* data, unsigned int value)
+{
+   data[0] = static_cast<BYTE>(value >> 24);
+   data[1] = static_cast<BYTE>(value >> 16);
+   data[2] = static_cast<BYTE>(value >> 8);
+   data[3] = static_cast<BYTE>(value);
+}
+
+/// writes 16-bit big endian value
+static void WriteBigEndian16(BYTE* data, unsigned short value)
+{
+   data[0] = static_cast<BYTE>(value >> 8);
+   data[1] = static_cast<BYTE>(value);
+}
+
+/// updates CRC-16 (polynomial 0x8005, reflected), as used by the LAME tag
+static unsigned short UpdateCrc16(unsigned short crc, const BYTE* data, size_t length)
+{
+   static const std::array<unsigned short, 256> c_crcTable = []()
+   {
+      std::array<unsigned short, 256> table = {};
+      for (unsigned int index = 0; index < 256; index++)
+      {
+         unsigned int value = index;
+         for (int bit = 0; bit < 8; bit++)
+            value = (value & 1) != 0 ? (value >> 1) ^ 0xa001 : value >> 1;
+
+         table[index] = static_cast<unsigned short>(value);
+      }
+
+      return table;
+   }();
+
+   for (size_t index = 0; index < length; index++)
+      crc = static_cast<unsigned short>((crc >> 8) ^ c_crcTable[(crc ^ data[index]) & 0xff]);
+
+   return crc;
+}
+
+bool Mp3FrameCopier::Copy(const CString& inputFilename, const CString& outputFilename)
+{
+   BufferedInputFile inputFile;
+   if (!OpenInputFile(inputFile, inputFilename))
+      return false;
+
+   BufferedOutputFile outputFile;
+   if (!outputFile.Open(outputFilename))
+      return false;
+
+   if (!ReadFrames(inputFile, &outputFile))
+      return false;
+
+   // the Info frame still describes the input file, which may contain
+   // junk data or truncated frames that weren't copied
+   if (m_streamInfo.m_hasInfoFrame &&
+      m_streamInfo.m_numFrames > 0 &&
+      !UpdateInfoFrame(outputFile))
+      return false;
+
+   return outputFile.Close() &&
+      m_streamInfo.m_numFrames > 0;
+}
+
+bool Mp3FrameCopier::Scan(const CString& inputFilename)
+{
+   BufferedInputFile inputFile;
+   if (!OpenInputFile(inputFile, inputFilename))
+      return false;
+
+   return ReadFrames(inputFile, nullptr) &&
+      m_streamInfo.m_numFrames > 0;
+}
+
+bool Mp3FrameCopier::OpenInputFile(BufferedInputFile& inputFile, const CString& inputFilename)
+{
+   m_streamInfo = Mp3StreamInfo();
+   m_buffer.clear();
+   m_bufferPos = 0;
+   m_infoFrame.clear();
+   m_infoHeaderOffset = 0;
+   m_lameTagOffset = 0;
+   m_frameOffsets.clear();
+   m_musicCrc = 0;
+
+   if (!inputFile.Open(inputFilename))
+      return false;
+
+   ULONGLONG audioStart = 0, audioEnd = 0;
+   if (!FindAudioRange(inputFile, audioStart, audioEnd) ||
+      !inputFile.Seek(static_cast<LONGLONG>(audioStart), SEEK_SET))
+      return false;
+
+   m_remainingBytes = audioEnd - audioStart;
+
+   return true;
+}
+
+bool Mp3FrameCopier::ReadFrames(BufferedInputFile& inputFile, BufferedOutputFile* outputFile)
+{
+   FrameHeader firstHeader;
+   bool isFirstFrame = true;
+   bool isSynced = false;
+   ULONGLONG outputPos = 0;
+
+   while (FillBuffer(inputFile, c_frameHeaderLength) >= c_frameHeaderLength)
+   {
+      FrameHeader header;
+      if (!ParseFrameHeader(&m_buffer[m_bufferPos], header) ||
+         (!isFirstFrame && !IsSameStream(firstHeader, header)))
+      {
+         m_bufferPos++;
+         m_streamInfo.m_numSkippedBytes++;
+         isSynced = false;
+         continue;
+      }
+
+      size_t numAvailable = FillBuffer(inputFile, header.m_frameLength + c_frameHeaderLength);
+      if (numAvailable < header.m_frameLength)
+      {
+         // truncated frame at the end of the file
+         m_streamInfo.m_numSkippedBytes += numAvailable;
+         break;
+      }
+
+      const BYTE* frameData = &m_buffer[m_bufferPos];
+
+      // after losing sync, a frame is only accepted when another frame
+      // follows; this prevents false sync words in junk data
+      if (!isSynced &&
+         numAvailable >= header.m_frameLength + c_frameHeaderLength)
+      {
+         FrameHeader nextHeader;
+         if (!ParseFrameHeader(frameData + header.m_frameLength, nextHeader) ||
+            !IsSameStream(header, nextHeader))
+         {
+            m_bufferPos++;
+            m_streamInfo.m_numSkippedBytes++;
+            continue;
+         }
+      }
+
+      isSynced = true;
+
+      bool isInfoFrame = false;
+      if (isFirstFrame)
+      {
+         firstHeader = header;
+         isFirstFrame = false;
+
+         m_streamInfo.m_samplesPerFrame = header.m_samplesPerFrame;
+         m_streamInfo.m_samplerateInHz = header.m_samplerateInHz;
+         m_streamInfo.m_numChannels = header.m_numChannels;
+
+         isInfoFrame = ParseInfoFrame(frameData, header);
+         if (isInfoFrame)
+            m_infoFrame.assign(frameData, frameData + header.m_frameLength);
+      }
+
+      if (!isInfoFrame)
+      {
+         m_streamInfo.m_numFrames++;
+         m_streamInfo.m_numAudioBytes += header.m_frameLength;
+
+         if (outputFile != nullptr)
+         {
+            m_frameOffsets.push_back(static_cast<unsigned int>(outputPos));
+
+            if (m_lameTagOffset != 0)
+               m_musicCrc = UpdateCrc16(m_musicCrc, frameData, header.m_frameLength);
+         }
+      }
+
+      if (outputFile != nullptr &&
+         !outputFile->Write(frameData, header.m_frameLength))
+         return false;
+
+      outputPos += header.m_frameLength;
+      m_bufferPos += header.m_frameLength;
+   }
+
+   return inputFile.GetLastError() == 0;
+}
+
+bool Mp3FrameCopier::ParseFrameHeader(const BYTE* data, FrameHeader& header)
+{
+   // sync word
+   if (data[0] != 0xff || (data[1] & 0xe0) != 0xe0)
+      return false;
+
+   unsigned int version = (data[1] >> 3) & 3;
+   unsigned int layer = (data[1] >> 1) & 3;
+   unsigned int bitrateIndex = (data[2] >> 4) & 15;
+   unsigned int samplerateIndex = (data[2] >> 2) & 3;
+   unsigned int protection = data[1] & 1;
+   unsigned int padding = (data[2] >> 1) & 1;
+   unsigned int channelMode = (data[3] >> 6) & 3;
+
+   // only layer III; reserved version and sample rate values and free
+   // format bitrates are rejected
+   if (version == 1 || layer != 1 ||
+      bitrateIndex == 0 || bitrateIndex == 15 ||
+      samplerateIndex == 3)
+      return false;
+
+   bool isMpeg1 = version == 3;
+
+   unsigned int bitrateInKbps = c_bitrateTable[isMpeg1 ? 0 : 1][bitrateIndex];
+
+   header.m_version = version;
+   header.m_samplerateInHz = c_samplerateTable[samplerateIndex] >> (isMpeg1 ? 0 : version == 2 ? 1 : 2);
+   header.m_numChannels = channelMode == 3 ? 1 : 2;
+   header.m_samplesPerFrame = isMpeg1 ? 1152 : 576;
+   header.m_hasCrc = protection == 0;
+   header.m_frameLength = (header.m_samplesPerFrame / 8) * bitrateInKbps * 1000 / header.m_samplerateInHz + padding;
+
+   return true;
+}
+
+bool Mp3FrameCopier::IsSameStream(const FrameHeader& header1, const FrameHeader& header2)
+{
+   return header1.m_version == header2.m_version &&
+      header1.m_samplerateInHz == header2.m_samplerateInHz &&
+      header1.m_numChannels == header2.m_numChannels;
+}
+
+bool Mp3FrameCopier::FindAudioRange(BufferedInputFile& inputFile, ULONGLONG& audioStart, ULONGLONG& audioEnd)
+{
+   audioStart = 0;
+   audioEnd = inputFile.Length();
+
+   // ID3v2 tag at the start; the size is stored as a syncsafe integer
+   BYTE id3v2Header[10] = {};
+   if (inputFile.Read(id3v2Header, sizeof(id3v2Header)) == sizeof(id3v2Header) &&
+      memcmp(id3v2Header, "ID3", 3) == 0 &&
+      ((id3v2Header[6] | id3v2Header[7] | id3v2Header[8] | id3v2Header[9]) & 0x80) == 0)
+   {
+      unsigned int tagSize =
+         (unsigned int(id3v2Header[6]) << 21) | (unsigned int(id3v2Header[7]) << 14) |
+         (unsigned int(id3v2Header[8]) << 7) | id3v2Header[9];
+
+      bool hasFooter = (id3v2Header[5] & 0x10) != 0;
+
+      audioStart = sizeof(id3v2Header) + tagSize + (hasFooter ? 10 : 0);
+   }
+
+   // ID3v1 tag at the end
+   BYTE id3v1Header[3] = {};
+   if (audioEnd >= audioStart + 128 &&
+      inputFile.Seek(static_cast<LONGLONG>(audioEnd - 128), SEEK_SET) &&
+      inputFile.Read(id3v1Header, sizeof(id3v1Header)) == sizeof(id3v1Header) &&
+      memcmp(id3v1Header, "TAG", 3) == 0)
+   {
+      audioEnd -= 128;
+   }
+
+   // APEv2 tag before the ID3v1 tag or at the end; the size in the footer
+   // includes the footer, but not the header
+   BYTE apeFooter[32] = {};
+   if (audioEnd >= audioStart + sizeof(apeFooter) &&
+      inputFile.Seek(static_cast<LONGLONG>(audioEnd - sizeof(apeFooter)), SEEK_SET) &&
+      inputFile.Read(apeFooter, sizeof(apeFooter)) == sizeof(apeFooter) &&
+      memcmp(apeFooter, "APETAGEX", 8) == 0)
+   {
+      ULONGLONG tagSize =
+         apeFooter[12] | (unsigned int(apeFooter[13]) << 8) |
+         (unsigned int(apeFooter[14]) << 16) | (unsigned int(apeFooter[15]) << 24);
+
+      bool hasHeader = (apeFooter[23] & 0x80) != 0;
+      tagSize += hasHeader ? 32 : 0;
+
+      if (tagSize <= audioEnd - audioStart)
+         audioEnd -= tagSize;
+   }
+
+   return audioStart < audioEnd;
+}
+
+bool Mp3FrameCopier::ParseInfoFrame(const BYTE* data, const FrameHeader& header)
+{
+   // the Xing/Info header follows the side info, and the CRC, if present
+   size_t offset = c_frameHeaderLength + (header.m_hasCrc ? 2 : 0) +
+      (header.m_version == 3
+         ? (header.m_numChannels == 1 ? 17 : 32)
+         : (header.m_numChannels == 1 ? 9 : 17));
+
+   if (offset + 8 > header.m_frameLength ||
+      (memcmp(data + offset, "Xing", 4) != 0 && memcmp(data + offset, "Info", 4) != 0))
+      return false;
+
+   m_streamInfo.m_hasInfoFrame = true;
+   m_infoHeaderOffset = offset;
+
+   // skip optional fields: frames, bytes, TOC and quality
+   unsigned int flags = ReadBigEndian32(data + offset + 4);
+   offset += 8;
+
+   if (flags & 1) offset += 4;
+   if (flags & 2) offset += 4;
+   if (flags & 4) offset += 100;
+   if (flags & 8) offset += 4;
+
+   // LAME tag; encoder delay and padding are stored as two 12-bit values
+   // at offset 21
+   if (offset + 24 <= header.m_frameLength &&
+      (memcmp(data + offset, "LAME", 4) == 0 || memcmp(data + offset, "Lavf", 4) == 0 || memcmp(data + offset, "Lavc", 4) == 0))
+   {
+      const BYTE* delayPadding = data + offset + 21;
+
+      // the CRCs can only be updated when the whole LAME tag is present
+      if (offset + c_lameTagCrcOffset + 2 <= header.m_frameLength)
+         m_lameTagOffset = offset;
+
+      m_streamInfo.m_hasLameTag = true;
+      m_streamInfo.m_encoderDelay = (unsigned int(delayPadding[0]) << 4) | (delayPadding[1] >> 4);
+      m_streamInfo.m_encoderPadding = ((unsigned int(delayPadding[1]) & 0x0f) << 8) | delayPadding[2];
+   }
+
+   return true;
+}
+
+bool Mp3FrameCopier::UpdateInfoFrame(BufferedOutputFile& outputFile)
+{
+   BYTE* frameData = m_infoFrame.data();
+
+   // the byte counts include the Info frame
+   unsigned int streamLength = static_cast<unsigned int>(outputFile.Length());
+
+   // update optional fields: frames, bytes and TOC
+   size_t offset = m_infoHeaderOffset + 4;
+   unsigned int flags = ReadBigEndian32(frameData + offset);
+   offset += 4;
+
+   if (flags & 1)
+   {
+      WriteBigEndian32(frameData + offset, m_streamInfo.m_numFrames);
+      offset += 4;
+   }
+
+   if (flags & 2)
+   {
+      WriteBigEndian32(frameData + offset, streamLength);
+      offset += 4;
+   }
+
+   if (flags & 4)
+   {
+      // each entry is the position of the frame at 1% steps of the
+      // duration, relative to the stream length, in 1/256
+      for (size_t index = 0; index < 100; index++)
+      {
+         size_t frameIndex = index * m_frameOffsets.size() / 100;
+         ULONGLONG position = m_frameOffsets[frameIndex];
+
+         frameData[offset + index] = static_cast<BYTE>(
+            std::min<ULONGLONG>(255, position * 256 / streamLength));
+      }
+   }
+
+   if (m_lameTagOffset != 0)
+   {
+      BYTE* lameTag = frameData + m_lameTagOffset;
+
+      WriteBigEndian32(lameTag + c_lameTagMusicLengthOffset, streamLength);
+      WriteBigEndian16(lameTag + c_lameTagMusicCrcOffset, m_musicCrc);
+      WriteBigEndian16(lameTag + c_lameTagCrcOffset,
+         UpdateCrc16(0, frameData, m_lameTagOffset + c_lameTagCrcOffset));
+   }
+
+   ULONGLONG endPosition = outputFile.Tell();
+
+   return outputFile.Seek(0) &&
+      outputFile.Write(frameData, m_infoFrame.size()) &&
+      outputFile.Seek(endPosition);
+}
+
+size_t Mp3FrameCopier::FillBuffer(BufferedInputFile& inputFile, size_t numBytes)
+{
+   size_t numAvailable = m_buffer.size() - m_bufferPos;
+
+   if (numAvailable < numBytes && m_remainingBytes > 0)
+   {
+      // move remaining data to the front
+      m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_bufferPos);
+      m_bufferPos = 0;
+
+      size_t numToRead = static_cast<size_t>(std::min<ULONGLONG>(m_remainingBytes, c_readBlockSize));
+
+      m_buffer.resize(numAvailable + numToRead);
+      size_t numRead = inputFile.Read(m_buffer.data() + numAvailable, numToRead);
+      m_buffer.resize(numAvailable + numRead);
+
+      m_remainingBytes = numRead < numToRead ? 0 : m_remainingBytes - numRead;
+      numAvailable += numRead;
+   }
+
+   return numAvailable;
+}
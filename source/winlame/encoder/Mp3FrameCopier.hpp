@@ -0,0 +1,181 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Mp3FrameCopier.hpp
+/// \brief copies MPEG layer 3 audio frames without re-encoding
+//
+#pragma once
+
+#include <vector>
+
+namespace Encoder
+{
+   class BufferedInputFile;
+   class BufferedOutputFile;
+
+   /// infos about a copied MP3 stream
+   struct Mp3StreamInfo
+   {
+      /// number of audio frames; the Xing/Info frame isn't counted
+      unsigned int m_numFrames = 0;
+
+      /// number of samples per frame and channel
+      unsigned int m_samplesPerFrame = 0;
+
+      /// sample rate, in Hz
+      unsigned int m_samplerateInHz = 0;
+
+      /// number of channels
+      unsigned int m_numChannels = 0;
+
+      /// indicates if the stream starts with a Xing or Info frame
+      bool m_hasInfoFrame = false;
+
+      /// indicates if the Info frame contains a LAME tag with encoder delay and padding
+      bool m_hasLameTag = false;
+
+      /// encoder delay at the start, in samples, from the LAME tag
+      unsigned int m_encoderDelay = 0;
+
+      /// encoder padding at the end, in samples, from the LAME tag
+      unsigned int m_encoderPadding = 0;
+
+      /// number of bytes of all audio frames; the Xing/Info frame isn't counted
+      ULONGLONG m_numAudioBytes = 0;
+
+      /// number of bytes that didn't belong to any frame, e.g. junk data
+      /// between frames; tags at the start and end of the file aren't counted
+      ULONGLONG m_numSkippedBytes = 0;
+
+      /// returns average bitrate of all audio frames, in bps; for VBR streams
+      /// this differs from the bitrate of the first frame
+      int GetAverageBitrate() const
+      {
+         if (m_numFrames == 0 || m_samplesPerFrame == 0)
+            return 0;
+
+         double lengthInSeconds = static_cast<double>(m_numFrames) * m_samplesPerFrame / m_samplerateInHz;
+         return static_cast<int>(m_numAudioBytes * 8 / lengthInSeconds);
+      }
+
+      /// returns number of samples per channel, after removing encoder delay and padding
+      __int64 GetNumSamples() const
+      {
+         __int64 numSamples = static_cast<__int64>(m_numFrames) * m_samplesPerFrame;
+         return std::max<__int64>(numSamples - m_encoderDelay - m_encoderPadding, 0);
+      }
+   };
+
+   /// \brief copies the audio frames of an MP3 file into a new file
+   /// \details the ID3v2 tag at the start and the ID3v1 and APEv2 tags at the
+   /// end of the file are left out, as well as junk data between frames and
+   /// truncated frames. The Xing/Info frame is kept, so that the encoder
+   /// delay and padding in the LAME tag still trim the decoded samples
+   /// exactly; its frame and byte counts, its seek table and the LAME tag
+   /// CRCs are updated to match the frames that were copied. Only MPEG
+   /// layer 3 streams with a constant sample rate and channel count are
+   /// copied; free format streams aren't supported.
+   class Mp3FrameCopier
+   {
+   public:
+      /// ctor
+      Mp3FrameCopier() {}
+
+      /// copies all audio frames from the input file to a new output file;
+      /// returns false when the input file isn't a supported MP3 stream or on
+      /// I/O errors
+      bool Copy(const CString& inputFilename, const CString& outputFilename);
+
+      /// reads all audio frames of the input file without copying them, e.g.
+      /// to determine the average bitrate; returns false when the input file
+      /// isn't a supported MP3 stream or on I/O errors
+      bool Scan(const CString& inputFilename);
+
+      /// returns infos about the stream copied last
+      const Mp3StreamInfo& StreamInfo() const { return m_streamInfo; }
+
+   private:
+      /// MPEG audio frame header
+      struct FrameHeader
+      {
+         unsigned int m_version = 0;         ///< version bits; 3: MPEG 1, 2: MPEG 2, 0: MPEG 2.5
+         unsigned int m_samplerateInHz = 0;  ///< sample rate
+         unsigned int m_numChannels = 0;     ///< number of channels
+         unsigned int m_samplesPerFrame = 0; ///< samples per frame and channel
+         bool m_hasCrc = false;              ///< indicates if a CRC follows the header
+         size_t m_frameLength = 0;           ///< frame length in bytes, including header
+      };
+
+      /// parses MPEG layer 3 frame header; returns false when the data isn't a valid header
+      static bool ParseFrameHeader(const BYTE* data, FrameHeader& header);
+
+      /// returns if both frames belong to the same stream
+      static bool IsSameStream(const FrameHeader& header1, const FrameHeader& header2);
+
+      /// determines the range of the file that contains audio frames, without tags
+      static bool FindAudioRange(BufferedInputFile& inputFile, ULONGLONG& audioStart, ULONGLONG& audioEnd);
+
+      /// opens input file and seeks to the first audio frame
+      bool OpenInputFile(BufferedInputFile& inputFile, const CString& inputFilename);
+
+      /// reads all audio frames from the input file and writes them to the
+      /// output file, if any
+      bool ReadFrames(BufferedInputFile& inputFile, BufferedOutputFile* outputFile);
+
+      /// parses Xing/Info frame and LAME tag; returns false when the frame is an audio frame
+      bool ParseInfoFrame(const BYTE* data, const FrameHeader& header);
+
+      /// updates the Xing/Info frame and LAME tag with the infos of the
+      /// copied frames, and writes it again at the start of the output file
+      bool UpdateInfoFrame(BufferedOutputFile& outputFile);
+
+      /// reads more data into the buffer, until given number of bytes are
+      /// available; returns number of available bytes
+      size_t FillBuffer(BufferedInputFile& inputFile, size_t numBytes);
+
+   private:
+      /// infos about the stream
+      Mp3StreamInfo m_streamInfo;
+
+      /// buffer with data read from the input file
+      std::vector<BYTE> m_buffer;
+
+      /// current position in the buffer
+      size_t m_bufferPos = 0;
+
+      /// number of bytes of the audio range that weren't read into the buffer yet
+      ULONGLONG m_remainingBytes = 0;
+
+      /// Xing/Info frame, as read from the input file
+      std::vector<BYTE> m_infoFrame;
+
+      /// offset of the Xing/Info header in the Info frame
+      size_t m_infoHeaderOffset = 0;
+
+      /// offset of the LAME tag in the Info frame, or 0 when there's none
+      size_t m_lameTagOffset = 0;
+
+      /// offsets of all copied audio frames in the output file; used to
+      /// calculate the seek table
+      std::vector<unsigned int> m_frameOffsets;
+
+      /// CRC-16 of all copied audio frames, as stored in the LAME tag
+      unsigned short m_musicCrc = 0;
+   };
+
+} // namespace Encoder
@@ -22,18 +22,18 @@
 #pragma once
 
 #include <ogg/ogg.h>
+#include "BufferedInputFile.hpp"
 
 namespace Encoder
 {
    /// \brief wrapper for ogg input streams
-   /// \details reads in bytes from passed FILE, and outputs ogg_packet's
+   /// \details reads in bytes from passed input file, and outputs ogg_packet's
    class OggInputStream
    {
    public:
-      /// ctor
-      OggInputStream(FILE* fd, bool bFreeFd)
-         :m_fd(fd),
-         m_freeFd(bFreeFd),
+      /// ctor; the input file must outlive the stream
+      explicit OggInputStream(BufferedInputFile& inputFile)
+         :m_inputFile(inputFile),
          m_endOfStream(false),
          m_streamInit(false)
       {
@@ -43,24 +43,21 @@ namespace Encoder
          memset(&m_currentPage, 0, sizeof(m_currentPage));
       }
 
-      /// dtor; auto-closes stream and file
+      /// dtor; auto-closes stream
       ~OggInputStream()
       {
          ogg_sync_clear(&m_sync);
          ogg_stream_clear(&m_stream);
-
-         if (m_freeFd)
-            fclose(m_fd);
       }
 
-      /// returns file ptr
-      FILE* GetFd() const { return m_fd; }
+      /// returns input file
+      BufferedInputFile& GetInputFile() const { return m_inputFile; }
 
       /// reads more data from file into stream
       void ReadInput(size_t uiSize)
       {
          char* data = ogg_sync_buffer(&m_sync, uiSize);
-         size_t uiRead = fread(data, sizeof(char), uiSize, m_fd);
+         size_t uiRead = m_inputFile.Read(data, uiSize);
 
          if (uiRead == 0)
             m_endOfStream = true;
@@ -71,7 +68,7 @@ namespace Encoder
       /// returns if stream is at its end
       bool IsEndOfStream() const
       {
-         return m_endOfStream || feof(m_fd);
+         return m_endOfStream || m_inputFile.IsEndOfFile();
       }
 
       /// reads next packet
@@ -107,10 +104,7 @@ namespace Encoder
 
    private:
       /// file to read from
-      FILE* m_fd;
-
-      /// indicates if m_fd is freed in dtor
-      bool m_freeFd;
+      BufferedInputFile& m_inputFile;
 
       /// indicates if stream is at end
       bool m_endOfStream;
@@ -31,6 +31,7 @@
 using Encoder::OggVorbisInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::BufferedInputFile;
 
 extern CString GetOggVorbisVersionString();
 
@@ -39,22 +40,30 @@ const int c_oggInputBufferSize = 512 * 6; // must be a multiple of max channels
 
 static size_t ReadDataSource(void* buffer, size_t size, size_t count, void* dataSource)
 {
-   return fread(buffer, size, count, reinterpret_cast<FILE*>(dataSource));
+   if (size == 0)
+      return 0;
+
+   BufferedInputFile* inputFile = reinterpret_cast<BufferedInputFile*>(dataSource);
+   return inputFile->Read(buffer, size * count) / size;
 }
 
 static int SeekDataSource(void* dataSource, ogg_int64_t offset, int whence)
 {
-   return _fseeki64(reinterpret_cast<FILE*>(dataSource), offset, whence);
+   BufferedInputFile* inputFile = reinterpret_cast<BufferedInputFile*>(dataSource);
+   return inputFile->Seek(offset, whence) ? 0 : -1;
 }
 
 static int CloseDataSource(void* dataSource)
 {
-   return fclose(reinterpret_cast<FILE*>(dataSource));
+   // don't close the file here, since DoneInput() will do that for us
+   UNUSED(dataSource);
+   return 0;
 }
 
 static long FilePosDataSource(void* dataSource)
 {
-   return ftell(reinterpret_cast<FILE*>(dataSource));
+   BufferedInputFile* inputFile = reinterpret_cast<BufferedInputFile*>(dataSource);
+   return static_cast<long>(inputFile->Tell());
 }
 
 /// ogg vorbis reading callbacks
@@ -68,8 +77,7 @@ ov_callbacks c_callbacks =
 
 OggVorbisInputModule::OggVorbisInputModule()
    :m_numCurrentSamples(0),
-   m_numMaxSamples(0),
-   m_inputFile(nullptr)
+   m_numMaxSamples(0)
 {
    m_moduleId = ID_IM_OGGV;
 
@@ -145,16 +153,15 @@ int OggVorbisInputModule::InitInput(LPCTSTR m_inputFilename,
 {
    IsAvailable();
 
-   m_inputFile = _wfopen(m_inputFilename, _T("rb"));
-
-   if (m_inputFile == NULL)
+   if (!m_inputFile.Open(m_inputFilename))
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
       return -1;
    }
 
    // open ogg vorbis file
-   if (ov_open_callbacks(m_inputFile, &m_vf, NULL, 0, c_callbacks) < 0)
+   if (ov_open_callbacks(&m_inputFile, &m_vf, NULL, 0, c_callbacks) < 0)
    {
       m_lastError.Format(IDS_ENCODER_INVALID_FILE_FORMAT);
       return -2;
@@ -230,11 +237,37 @@ int OggVorbisInputModule::DecodeSamples(SampleContainer& samples)
    return ret;
 }
 
+bool OggVorbisInputModule::CanSeek() const
+{
+   return ov_seekable(&m_vf) != 0;
+}
+
+__int64 OggVorbisInputModule::GetTotalSamples() const
+{
+   return m_numMaxSamples > 0 ? m_numMaxSamples : -1;
+}
+
+int OggVorbisInputModule::SeekToSample(__int64 samplePosition)
+{
+   // seeking is sample accurate; the decoder state is restored by decoding
+   // the preceding packet
+   int ret = ov_pcm_seek(&m_vf, samplePosition);
+   if (ret != 0)
+   {
+      m_lastError.LoadString(IDS_ENCODER_SEEK_ERROR);
+      return -1;
+   }
+
+   m_numCurrentSamples = samplePosition;
+
+   return 0;
+}
+
 void OggVorbisInputModule::DoneInput()
 {
    ov_clear(&m_vf);
 
-   fclose(m_inputFile);
+   m_inputFile.Close();
 }
 
 void OggVorbisInputModule::GetTrackInfo(TrackInfo& trackInfo)
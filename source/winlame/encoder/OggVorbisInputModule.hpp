@@ -22,7 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
-#include <cstdio>
+#include "BufferedInputFile.hpp"
 #include <../include/vorbis/vorbisfile.h>
 
 namespace Encoder
@@ -73,6 +73,15 @@ namespace Encoder
          return m_numMaxSamples > 0 ? float(m_numCurrentSamples)*100.f / m_numMaxSamples : 0.f;
       }
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
@@ -91,7 +100,7 @@ namespace Encoder
       __int64 m_numMaxSamples;
 
       /// input file
-      FILE* m_inputFile;
+      BufferedInputFile m_inputFile;
 
       /// decoding file struct
       mutable OggVorbis_File m_vf;
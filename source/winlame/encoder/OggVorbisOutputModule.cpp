@@ -21,7 +21,6 @@
 /// \brief contains the implementation of the ogg vorbis output module
 //
 #include "stdafx.h"
-#include <fstream>
 #include "resource.h"
 #include "OggVorbisOutputModule.hpp"
 #include "OpusOutputModule.hpp"
@@ -162,8 +161,12 @@ int OggVorbisOutputModule::InitOutput(LPCTSTR outfilename,
    m_channels = samples.GetInputModuleChannels();
    m_samplerate = samples.GetInputModuleSampleRate();
 
-   m_outputStream.open(CStringA(outfilename).GetString(), std::ios::out | std::ios::binary);
-   if (!m_outputStream.is_open())
+   // estimate output size when a nominal bitrate is used
+   unsigned int bytesPerSecond = 0;
+   if (mgr.QueryValueInt(OggBitrateMode) != 0)
+      bytesPerSecond = static_cast<unsigned int>(mgr.QueryValueInt(OggVarNominalBitrate)) * 1000 / 8;
+
+   if (!m_outputFile.Open(outfilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
    {
       m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
       return -1;
@@ -398,8 +401,8 @@ void OggVorbisOutputModule::WriteHeader()
       if (result == 0)
          break;
 
-      m_outputStream.write(reinterpret_cast<char*>(m_og.header), m_og.header_len);
-      m_outputStream.write(reinterpret_cast<char*>(m_og.body), m_og.body_len);
+      m_outputFile.Write(m_og.header, m_og.header_len);
+      m_outputFile.Write(m_og.body, m_og.body_len);
    }
 }
 
@@ -459,8 +462,8 @@ void OggVorbisOutputModule::WriteBlocks()
             if (result == 0)
                break;
 
-            m_outputStream.write(reinterpret_cast<char*>(m_og.header), m_og.header_len);
-            m_outputStream.write(reinterpret_cast<char*>(m_og.body), m_og.body_len);
+            m_outputFile.Write(m_og.header, m_og.header_len);
+            m_outputFile.Write(m_og.body, m_og.body_len);
 
             // this could be set above, but for illustrative purposes, I do
             // it here (to show that vorbis does know where the stream ends)
@@ -491,5 +494,5 @@ void OggVorbisOutputModule::DoneOutput()
    // ogg_page and ogg_packet structs always point to storage in
    // libvorbis.  They're never freed or manipulated directly
 
-   m_outputStream.close();
+   m_outputFile.Close();
 }
@@ -22,7 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
-#include <iosfwd>
+#include "BufferedOutputFile.hpp"
 #include "vorbis/codec.h"
 
 namespace Encoder
@@ -81,8 +81,8 @@ namespace Encoder
       void WriteBlocks();
 
    private:
-      /// output file stream
-      std::ofstream m_outputStream;
+      /// output file
+      BufferedOutputFile m_outputFile;
 
       /// last error occured
       CString m_lastError;
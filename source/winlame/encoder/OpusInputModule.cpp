@@ -27,6 +27,7 @@
 using Encoder::OpusInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::BufferedInputFile;
 
 OpusInputModule::OpusInputModule()
    :m_numTotalSamples(0)
@@ -83,17 +84,15 @@ CString OpusInputModule::GetFilterString() const
 int OpusInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    TrackInfo& trackInfo, SampleContainer& samples)
 {
-   FILE* fd = nullptr;
-   errno_t err = _tfopen_s(&fd, infilename, _T("rb"));
-
-   if (err != 0 || fd == nullptr)
+   if (!m_inputStream.Open(infilename))
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputStream.GetLastErrorText().GetString());
       return -1;
    }
 
    int errorCode = 0;
-   OggOpusFile* file = op_open_callbacks(fd, &m_callbacks, nullptr, 0, &errorCode);
+   OggOpusFile* file = op_open_callbacks(&m_inputStream, &m_callbacks, nullptr, 0, &errorCode);
 
    if (file != nullptr)
       m_inputFile.reset(file, op_free);
@@ -164,9 +163,39 @@ float OpusInputModule::PercentDone() const
    return percentValue * 100.f;
 }
 
+bool OpusInputModule::CanSeek() const
+{
+   return m_inputFile != nullptr &&
+      op_seekable(m_inputFile.get()) != 0;
+}
+
+__int64 OpusInputModule::GetTotalSamples() const
+{
+   return m_numTotalSamples > 0 ? m_numTotalSamples : -1;
+}
+
+int OpusInputModule::SeekToSample(__int64 samplePosition)
+{
+   if (m_inputFile == nullptr)
+      return -1;
+
+   // the sample position is always at 48 kHz; opusfile decodes the pre-roll
+   // before the seek position itself
+   int ret = op_pcm_seek(m_inputFile.get(), samplePosition);
+   if (ret != 0)
+   {
+      m_lastError.LoadString(IDS_ENCODER_SEEK_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), ErrorTextFromCode(ret));
+      return -1;
+   }
+
+   return 0;
+}
+
 void OpusInputModule::DoneInput()
 {
    m_inputFile.reset();
+   m_inputStream.Close();
 }
 
 void OpusInputModule::GetTrackInfo(TrackInfo& trackInfo)
@@ -317,24 +346,25 @@ LPCTSTR OpusInputModule::ErrorTextFromCode(int errorCode)
 
 int OpusInputModule::ReadStream(void* stream, unsigned char* buffer, int numBytes)
 {
-   FILE* fd = reinterpret_cast<FILE*>(stream);
-   return fread(buffer, 1, numBytes, fd);
+   BufferedInputFile* inputStream = reinterpret_cast<BufferedInputFile*>(stream);
+   return static_cast<int>(inputStream->Read(buffer, numBytes));
 }
 
 int OpusInputModule::SeekStream(void* stream, opus_int64 offset, int whence)
 {
-   FILE* fd = reinterpret_cast<FILE*>(stream);
-   return _fseeki64(fd, offset, whence);
+   BufferedInputFile* inputStream = reinterpret_cast<BufferedInputFile*>(stream);
+   return inputStream->Seek(offset, whence) ? 0 : -1;
 }
 
 opus_int64 OpusInputModule::PosStream(void* stream)
 {
-   FILE* fd = reinterpret_cast<FILE*>(stream);
-   return _ftelli64(fd);
+   BufferedInputFile* inputStream = reinterpret_cast<BufferedInputFile*>(stream);
+   return static_cast<opus_int64>(inputStream->Tell());
 }
 
 int OpusInputModule::CloseStream(void* stream)
 {
-   FILE* fd = reinterpret_cast<FILE*>(stream);
-   return fclose(fd);
+   // don't close the stream here, since DoneInput() will do that for us
+   UNUSED(stream);
+   return 0;
 }
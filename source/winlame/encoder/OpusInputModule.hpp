@@ -22,6 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedInputFile.hpp"
 #include <../include/opus/opusfile.h>
 
 namespace Encoder
@@ -69,6 +70,15 @@ namespace Encoder
       /// returns the number of percent done
       virtual float PercentDone() const override;
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
@@ -98,6 +108,9 @@ namespace Encoder
       /// file callbacks
       OpusFileCallbacks m_callbacks;
 
+      /// input file stream read by the decoder
+      BufferedInputFile m_inputStream;
+
       /// input file
       std::shared_ptr<OggOpusFile> m_inputFile;
 
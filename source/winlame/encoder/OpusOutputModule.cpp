@@ -24,6 +24,7 @@
 #include "OpusOutputModule.hpp"
 #include <ulib/UTF8.hpp>
 #include "App.hpp"
+#include "ChannelRemapper.hpp"
 #include <wincrypt.h>
 #include <ogg/ogg.h>
 
@@ -126,16 +127,14 @@ int OpusEncData::write_callback(void* user_data, const unsigned char* ptr, opus_
    OpusEncData* data = (OpusEncData*)user_data;
    data->bytes_written += len;
    data->pages_out++;
-   return fwrite(ptr, 1, len, data->m_outputFile.get()) != (size_t)len;
+   return data->m_outputFile.Write(ptr, len) ? 0 : 1;
 }
 
 int OpusEncData::close_callback(void* user_data)
 {
    OpusEncData* data = (OpusEncData*)user_data;
 
-   int ret = fclose(data->m_outputFile.get()) != 0;
-   data->m_outputFile.reset();
-   return ret;
+   return data->m_outputFile.Close() ? 0 : 1;
 }
 
 void OpusEncData::packet_callback(void* user_data, const unsigned char* packet_ptr, opus_int32 packet_len, opus_uint32 flags)
@@ -161,6 +160,7 @@ void OpusEncData::packet_callback(void* user_data, const unsigned char* packet_p
 using Encoder::OpusOutputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::ChannelRemapper;
 
 OpusOutputModule::OpusOutputModule()
    :m_bitrateInBps(-1),
@@ -240,7 +240,7 @@ int OpusOutputModule::InitOutput(LPCTSTR outfilename,
    if (!StoreTrackInfos(trackInfo))
       return -1;
 
-   if (!OpenOutputFile(outfilename))
+   if (!OpenOutputFile(outfilename, mgr))
       return -1;
 
    if (!InitEncoder())
@@ -254,6 +254,16 @@ int OpusOutputModule::InitOutput(LPCTSTR outfilename,
    // set up output traits
    samples.SetOutputModuleTraits(m_32bitMode ? 32 : 16, SamplesInterleaved, m_samplerate, m_channels);
 
+   // the input buffer holds less than a frame of samples, plus one block;
+   // reserve it, so that encoding doesn't allocate memory
+   size_t maxInputBufferSize = static_cast<size_t>(m_numSamplesPerFrame) +
+      static_cast<size_t>(std::max(samples.GetReservedNumSamples(), 512)) * m_channels;
+
+   if (m_32bitMode)
+      m_inputInt32Buffer.reserve(maxInputBufferSize);
+   else
+      m_inputInt16Buffer.reserve(maxInputBufferSize);
+
    return 0;
 }
 
@@ -426,9 +436,6 @@ bool OpusOutputModule::InitEncoder()
 
    m_inputFloatBuffer.resize(m_numSamplesPerFrame);
 
-   if (m_downmix != 0)
-      m_downmixFloatBuffer.resize(m_numSamplesPerFrame);
-
    return true;
 }
 
@@ -526,17 +533,18 @@ bool OpusOutputModule::SetEncoderOptions()
    return true;
 }
 
-bool OpusOutputModule::OpenOutputFile(LPCTSTR outputFilename)
+bool OpusOutputModule::OpenOutputFile(LPCTSTR outputFilename, SettingsManager& mgr)
 {
-   FILE* fout = _tfopen(outputFilename, _T("wb"));
+   unsigned int bytesPerSecond = m_bitrateInBps > 0 ? static_cast<unsigned int>(m_bitrateInBps) / 8 : 0;
 
-   if (fout != nullptr)
+   if (!m_encoder.m_outputFile.Open(outputFilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
    {
-      m_encoder.m_outputFile.reset(fout, ::fclose);
-      return true;
+      m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_encoder.m_outputFile.GetLastErrorText().GetString());
+      return false;
    }
 
-   return false;
+   return true;
 }
 
 long OpusOutputModule::ReadFloatSamples16(float* buffer, int samples)
@@ -545,12 +553,15 @@ long OpusOutputModule::ReadFloatSamples16(float* buffer, int samples)
 
    //ATLTRACE(_T("ReadFloatSamples16: Requesting %i samples, returning %i samples\n"), samples, numSamples / m_channels);
 
-   constexpr int16_t scaleFactor = std::numeric_limits<int16_t>::max();
+   constexpr float factor = 1.0f / std::numeric_limits<int16_t>::max();
 
-   for (int i = 0; i < numSamples; i++)
-   {
-      buffer[i] = float(m_inputInt16Buffer[i]) / scaleFactor;
-   }
+   // converts and downmixes in one pass
+   if (!m_downmixMatrix.empty())
+      ChannelRemapper::DownmixInterleavedToFloat(m_inputInt16Buffer.data(), numSamples / m_channels, m_channels,
+         m_downmixMatrix, m_downmix, factor, buffer);
+   else
+      ChannelRemapper::ConvertInterleavedToFloat(m_inputInt16Buffer.data(), numSamples / m_channels, m_channels,
+         factor, buffer);
 
    // remove samples from input buffer
    m_inputInt16Buffer.erase(m_inputInt16Buffer.begin(), m_inputInt16Buffer.begin() + numSamples);
@@ -564,12 +575,15 @@ long OpusOutputModule::ReadFloatSamples32(float* buffer, int samples)
 
    //ATLTRACE(_T("ReadFloatSamples32: Requesting %i samples, returning %i samples\n"), samples, numSamples / m_channels);
 
-   constexpr int32_t scaleFactor = std::numeric_limits<int32_t>::max();
+   constexpr float factor = 1.0f / std::numeric_limits<int32_t>::max();
 
-   for (int i = 0; i < numSamples; i++)
-   {
-      buffer[i] = float(m_inputInt32Buffer[i]) / scaleFactor;
-   }
+   // converts and downmixes in one pass
+   if (!m_downmixMatrix.empty())
+      ChannelRemapper::DownmixInterleavedToFloat(m_inputInt32Buffer.data(), numSamples / m_channels, m_channels,
+         m_downmixMatrix, m_downmix, factor, buffer);
+   else
+      ChannelRemapper::ConvertInterleavedToFloat(m_inputInt32Buffer.data(), numSamples / m_channels, m_channels,
+         factor, buffer);
 
    // remove samples from input buffer
    m_inputInt32Buffer.erase(m_inputInt32Buffer.begin(), m_inputInt32Buffer.begin() + numSamples);
@@ -673,9 +687,6 @@ bool OpusOutputModule::EncodeInputBufferFrame()
       m_outputStreamAtEnd = true;
    }
 
-   if (!m_downmixMatrix.empty())
-      DownmixSamples(nb_samples);
-
    int ret = ope_encoder_write_float(m_encoder.enc, m_inputFloatBuffer.data(), nb_samples);
    if (ret != OPE_OK)
    {
@@ -712,115 +723,13 @@ std::string OpusOutputModule::GetMetadataBlockPicture(const std::vector<unsigned
    return base64image;
 }
 
-// Note: The stupid_matrix table and the code in SetupDownmix() and
-// DownmixSamples() is taken from opus-tools' audio-in.c file:
-// https://github.com/xiph/opus-tools/blob/master/src/audio-in.c
-// The following copyright header appears in the file
-//
-/* Copyright 2000-2002, Michael Smith <msmith@xiph.org>
-             2010, Monty <monty@xiph.org>
-   AIFF/AIFC support from OggSquish, (c) 1994-1996 Monty <xiphmont@xiph.org>
-   (From GPL code in oggenc relicensed by permission from Monty and Msmith)
-   File: audio-in.c
-   Redistribution and use in source and binary forms, with or without
-   modification, are permitted provided that the following conditions
-   are met:
-   - Redistributions of source code must retain the above copyright
-   notice, this list of conditions and the following disclaimer.
-   - Redistributions in binary form must reproduce the above copyright
-   notice, this list of conditions and the following disclaimer in the
-   documentation and/or other materials provided with the distribution.
-   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
-   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
-   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
-   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
-   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
-   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
-   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
-
-/// \brief matrix for downsampling from N channels to 2 channels
-static const float stupid_matrix[7][8][2] =
-{
-   /*2*/  {{1,0}, {0,1}},
-   /*3*/  {{1,0}, {0.7071f,0.7071f}, {0,1}},
-   /*4*/  {{1,0}, {0,1},{0.866f,0.5f}, {0.5f,0.866f}},
-   /*5*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}},
-   /*6*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.7071f,0.7071f}},
-   /*7*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.6123f,0.6123f}, {0.7071f,0.7071f}},
-   /*8*/  {{1,0}, {0.7071f,0.7071f}, {0,1}, {0.866f,0.5f}, {0.5f,0.866f}, {0.866f,0.5f}, {0.5f,0.866f}, {0.7071f,0.7071f}},
-};
-
 bool OpusOutputModule::SetupDownmix(size_t inputNumChannels, size_t outputNumChannels)
 {
-   if (inputNumChannels <= outputNumChannels || outputNumChannels > 2 || inputNumChannels == 0 || outputNumChannels == 0)
-   {
-      m_lastError = _T("Downmix must actually downmix and only knows mono/stereo out.");
-      return false;
-   }
-
-   if (outputNumChannels == 2 && inputNumChannels > 8)
+   if (!ChannelRemapper::GetDownmixMatrix(inputNumChannels, outputNumChannels, m_downmixMatrix))
    {
-      m_lastError = _T("Downmix only knows how to mix >8ch to mono.");
+      m_lastError = _T("Downmix must actually downmix, only knows mono/stereo out and only knows how to mix >8ch to mono.");
       return false;
    }
 
-   m_downmixMatrix.resize(inputNumChannels * outputNumChannels);
-
-   if (outputNumChannels == 1 && inputNumChannels > 8)
-   {
-      for (size_t i = 0; i < inputNumChannels; i++)
-         m_downmixMatrix[i] = 1.0f / inputNumChannels;
-   }
-   else if (outputNumChannels == 2)
-   {
-      for (size_t j = 0; j < outputNumChannels; j++)
-         for (size_t i = 0; i < inputNumChannels; i++)
-            m_downmixMatrix[inputNumChannels * j + i] = stupid_matrix[inputNumChannels - 2][i][j];
-   }
-   else
-   {
-      for (size_t i = 0; i < inputNumChannels; i++)
-         m_downmixMatrix[i] = stupid_matrix[inputNumChannels - 2][i][0] + stupid_matrix[inputNumChannels - 2][i][1];
-   }
-
-   float sum = 0.f;
-   for (size_t i = 0; i < inputNumChannels * outputNumChannels; i++)
-      sum += m_downmixMatrix[i];
-
-   sum = (float)outputNumChannels / sum;
-   for (size_t i = 0; i < inputNumChannels * outputNumChannels; i++)
-      m_downmixMatrix[i] *= sum;
-
    return true;
 }
-
-void OpusOutputModule::DownmixSamples(opus_int32& numSamplesPerChannel)
-{
-   ATLASSERT(m_downmix == 1 || m_downmix == 2); // downmix value must be 1 or 2
-
-   size_t inputNumChannels = m_channels;
-   size_t outputNumChannels = m_downmix;
-
-   for (opus_int32 i = 0; i < numSamplesPerChannel; i++)
-   {
-      for (size_t j = 0; j < outputNumChannels; j++)
-      {
-         float* sample = &m_downmixFloatBuffer[i * outputNumChannels + j];
-         *sample = 0.f;
-
-         for (size_t k = 0; k < inputNumChannels; k++)
-         {
-            *sample += m_inputFloatBuffer[i * inputNumChannels + k] * m_downmixMatrix[inputNumChannels * j + k];
-         }
-      }
-   }
-
-   numSamplesPerChannel = numSamplesPerChannel * m_downmix / m_channels;
-
-   std::swap(m_downmixFloatBuffer, m_inputFloatBuffer);
-}
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedOutputFile.hpp"
 #include <opus/opusenc.h>
 
 
@@ -46,7 +47,7 @@ namespace Encoder
       std::shared_ptr<OggOpusComments> m_comments;
 
       /// output file
-      std::shared_ptr<FILE> m_outputFile;
+      BufferedOutputFile m_outputFile;
 
       opus_int64 total_bytes;
       opus_int64 bytes_written;
@@ -118,17 +119,14 @@ namespace Encoder
       bool SetEncoderOptions();
 
       /// opens output file
-      bool OpenOutputFile(LPCTSTR outputFilename);
+      bool OpenOutputFile(LPCTSTR outputFilename, SettingsManager& mgr);
 
-      /// reads float samples from 16-bit buffer
+      /// reads float samples from 16-bit buffer, downmixing them when set up
       long ReadFloatSamples16(float* buffer, int samples);
 
-      /// reads float samples from 32-bit buffer
+      /// reads float samples from 32-bit buffer, downmixing them when set up
       long ReadFloatSamples32(float* buffer, int samples);
 
-      /// downmix samples in input float sample buffer
-      void DownmixSamples(opus_int32& numSamplesPerChannel);
-
       /// refills input sample buffer from sample container
       int RefillInputSampleBuffer(SampleContainer& samples);
 
@@ -188,9 +186,6 @@ namespace Encoder
       /// matrix for factors for downmixing channels
       std::vector<float> m_downmixMatrix;
 
-      /// buffer for downmixed float samples
-      std::vector<float> m_downmixFloatBuffer;
-
       /// indicates if the input module supports 32-bit samples
       bool m_32bitMode;
 
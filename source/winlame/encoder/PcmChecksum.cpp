@@ -0,0 +1,113 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PcmChecksum.cpp
+/// \brief running checksum of PCM samples
+//
+#include "stdafx.h"
+#include "PcmChecksum.hpp"
+#include "SampleContainer.hpp"
+
+using Encoder::PcmChecksum;
+
+/// FNV-1a 64-bit offset basis
+static const unsigned __int64 c_fnvOffsetBasis = 14695981039346656037ULL;
+
+/// FNV-1a 64-bit prime
+static const unsigned __int64 c_fnvPrime = 1099511628211ULL;
+
+PcmChecksum::PcmChecksum()
+   :m_numSamples(0),
+   m_isHashed(true),
+   m_hash(c_fnvOffsetBasis),
+   m_usedBits(0)
+{
+}
+
+void PcmChecksum::Add(SampleContainer& samples)
+{
+   int numSamples = 0;
+
+   if (samples.GetOutputModuleSampleFormat() != SamplesInterleaved)
+   {
+      samples.GetSamplesArray(numSamples);
+
+      m_numSamples += numSamples;
+      m_isHashed = false;
+      return;
+   }
+
+   const void* sampleBuffer = samples.GetSamplesInterleaved(numSamples);
+
+   AddInterleaved(sampleBuffer, numSamples,
+      samples.GetOutputModuleChannels(),
+      samples.GetOutputModuleBitsPerSample());
+}
+
+void PcmChecksum::AddInterleaved(const void* samples, int numSamples, int numChannels, int bitsPerSample)
+{
+   int bytesPerSample = bitsPerSample / 8;
+   if (bytesPerSample < 1 || bytesPerSample > 4)
+   {
+      m_numSamples += numSamples;
+      m_isHashed = false;
+      return;
+   }
+
+   const BYTE* sampleBytes = static_cast<const BYTE*>(samples);
+   size_t numValues = size_t(numSamples) * numChannels;
+
+   unsigned __int64 hash = m_hash;
+   unsigned int usedBits = m_usedBits;
+
+   for (size_t index = 0; index < numValues; index++)
+   {
+      // samples are stored little-endian; left-justify them to 32 bit
+      unsigned int value = 0;
+      for (int byteIndex = 0; byteIndex < bytesPerSample; byteIndex++)
+         value |= static_cast<unsigned int>(sampleBytes[byteIndex]) << (8 * (4 - bytesPerSample + byteIndex));
+
+      sampleBytes += bytesPerSample;
+
+      usedBits |= value;
+
+      // FNV-1a, but hashing a 32-bit value per step instead of a byte
+      hash ^= value;
+      hash *= c_fnvPrime;
+   }
+
+   m_hash = hash;
+   m_usedBits = usedBits;
+   m_numSamples += numSamples;
+}
+
+int PcmChecksum::GetPrecision() const
+{
+   if (m_usedBits == 0)
+      return 0;
+
+   int precision = 32;
+   unsigned int usedBits = m_usedBits;
+   while ((usedBits & 1) == 0)
+   {
+      usedBits >>= 1;
+      precision--;
+   }
+
+   return precision;
+}
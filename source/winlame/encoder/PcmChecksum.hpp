@@ -0,0 +1,75 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PcmChecksum.hpp
+/// \brief running checksum of PCM samples
+//
+#pragma once
+
+namespace Encoder
+{
+   class SampleContainer;
+
+   /// \brief running checksum of PCM samples
+   /// \details counts samples and calculates a 64-bit FNV-1a style hash over all
+   /// samples, converted to 32 bit, left-justified. Samples with different
+   /// bits per sample therefore have the same checksum when they describe
+   /// the same audio data, e.g. the samples passed to an output module and
+   /// the samples decoded from the output file again.
+   class PcmChecksum
+   {
+   public:
+      /// ctor
+      PcmChecksum();
+
+      /// adds samples stored in the sample container, in the output module
+      /// format; samples in channel array format are only counted
+      void Add(SampleContainer& samples);
+
+      /// adds interleaved samples with given bits per sample
+      void AddInterleaved(const void* samples, int numSamples, int numChannels, int bitsPerSample);
+
+      /// returns number of samples added, per channel
+      __int64 GetNumSamples() const { return m_numSamples; }
+
+      /// returns if all samples added were hashed, and not only counted
+      bool IsHashed() const { return m_isHashed; }
+
+      /// returns hash over all samples
+      unsigned __int64 GetHash() const { return m_hash; }
+
+      /// returns number of significant bits used by the hashed samples; a
+      /// file format that stores at least this number of bits stores the
+      /// samples without loss
+      int GetPrecision() const;
+
+   private:
+      /// number of samples, per channel
+      __int64 m_numSamples;
+
+      /// indicates if all samples were hashed
+      bool m_isHashed;
+
+      /// hash value
+      unsigned __int64 m_hash;
+
+      /// bits used by any of the hashed samples
+      unsigned int m_usedBits;
+   };
+
+} // namespace Encoder
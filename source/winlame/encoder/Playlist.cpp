@@ -0,0 +1,135 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Playlist.cpp
+/// \brief playlist of the output files of a batch of encoder tasks
+//
+#include "stdafx.h"
+#include "Playlist.hpp"
+#include <ulib/Path.hpp>
+#include <cmath>
+
+using Encoder::Playlist;
+
+void Playlist::AddEntry(const CString& filename, const CString& title, double lengthInSeconds)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   Entry& entry = GetEntry(m_numAddedEntries++);
+
+   entry.m_title = title;
+
+   // the encoder task may already have set the actual values
+   if (!entry.m_isEncoded)
+   {
+      entry.m_filename = filename;
+      entry.m_lengthInSeconds = lengthInSeconds;
+   }
+}
+
+void Playlist::SetEncodedEntry(size_t entryIndex, const CString& filename, double lengthInSeconds)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   Entry& entry = GetEntry(entryIndex);
+
+   entry.m_filename = filename;
+   entry.m_isEncoded = true;
+
+   if (lengthInSeconds > 0.0)
+      entry.m_lengthInSeconds = lengthInSeconds;
+}
+
+void Playlist::SetFailedEntry(size_t entryIndex)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   GetEntry(entryIndex).m_isFailed = true;
+}
+
+size_t Playlist::GetNumEntries() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   return m_numAddedEntries;
+}
+
+CString Playlist::Format(const CString& rootFolder) const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   CString text = _T("#EXTM3U\n\n");
+
+   for (size_t entryIndex = 0; entryIndex < m_numAddedEntries; entryIndex++)
+   {
+      const Entry& entry = m_entries[entryIndex];
+
+      if (entry.m_isFailed ||
+         entry.m_filename.IsEmpty())
+         continue;
+
+      // -1 is used for unknown lengths
+      int lengthInSeconds = entry.m_lengthInSeconds > 0.0
+         ? static_cast<int>(std::lround(entry.m_lengthInSeconds))
+         : -1;
+
+      text.AppendFormat(_T("#EXTINF:%i,%s\n"), lengthInSeconds, entry.m_title.GetString());
+
+      CString relativeFilename = Path::MakeRelativeTo(entry.m_filename, rootFolder);
+      if (relativeFilename.IsEmpty())
+         relativeFilename = entry.m_filename;
+
+      if (relativeFilename.Find(_T(".\\")) == 0)
+         relativeFilename.Delete(0, 2);
+
+      text.AppendFormat(_T("%s\n\n"), relativeFilename.GetString());
+   }
+
+   return text;
+}
+
+bool Playlist::Write(const CString& playlistFilename) const
+{
+   CString text = Format(Path::FolderName(playlistFilename));
+
+   CString tempFilename = playlistFilename + _T(".temp");
+
+   FILE* fd = _tfopen(tempFilename, _T("wt"));
+   if (fd == nullptr)
+      return false;
+
+   bool written = _fputts(text, fd) >= 0;
+   written = fclose(fd) == 0 && written;
+
+   if (!written ||
+      !MoveFileEx(tempFilename, playlistFilename, MOVEFILE_REPLACE_EXISTING))
+   {
+      DeleteFile(tempFilename);
+      return false;
+   }
+
+   return true;
+}
+
+Playlist::Entry& Playlist::GetEntry(size_t entryIndex)
+{
+   if (entryIndex >= m_entries.size())
+      m_entries.resize(entryIndex + 1);
+
+   return m_entries[entryIndex];
+}
@@ -0,0 +1,98 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Playlist.hpp
+/// \brief playlist of the output files of a batch of encoder tasks
+//
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+namespace Encoder
+{
+   /// \brief playlist of the output files of a batch of encoder tasks
+   /// \details The playlist has one entry per job, in the order of the jobs.
+   /// Entries are added when the tasks are created, with the expected
+   /// output filename and length. Encoder tasks replace these with the
+   /// actual output filename and the exact length of the decoded samples,
+   /// or mark the entry as failed. Since tasks may finish in any order and
+   /// may already be running while further entries are added, entries are
+   /// addressed by their index. When all tasks are done, the playlist is
+   /// written once as extended M3U playlist. All methods may be called by
+   /// multiple encoder threads at the same time.
+   class Playlist
+   {
+   public:
+      /// ctor
+      Playlist() = default;
+
+      /// deleted copy ctor
+      Playlist(const Playlist&) = delete;
+      /// deleted copy assignment operator
+      Playlist& operator=(const Playlist&) = delete;
+
+      /// adds entry with the expected output filename and length, in job
+      /// order; a length of 0 means unknown
+      void AddEntry(const CString& filename, const CString& title, double lengthInSeconds);
+
+      /// sets actual output filename and length of an encoded entry
+      void SetEncodedEntry(size_t entryIndex, const CString& filename, double lengthInSeconds);
+
+      /// marks entry as failed; failed entries aren't written
+      void SetFailedEntry(size_t entryIndex);
+
+      /// returns number of entries added
+      size_t GetNumEntries() const;
+
+      /// formats playlist as extended M3U; filenames are made relative to
+      /// the root folder when possible
+      CString Format(const CString& rootFolder) const;
+
+      /// writes playlist to given file; the file is written under a
+      /// temporary name first and then renamed, so that there's always a
+      /// complete playlist file; returns false on errors
+      bool Write(const CString& playlistFilename) const;
+
+   private:
+      /// single playlist entry
+      struct Entry
+      {
+         CString m_filename;              ///< output filename
+         CString m_title;                 ///< title of entry
+         double m_lengthInSeconds = 0.0;  ///< length, in seconds; 0 when unknown
+         bool m_isEncoded = false;        ///< indicates if the entry was encoded
+         bool m_isFailed = false;         ///< indicates if encoding the entry failed
+      };
+
+      /// returns entry with given index; adds entries when necessary; the
+      /// mutex must be locked
+      Entry& GetEntry(size_t entryIndex);
+
+   private:
+      /// mutex protecting entries
+      mutable std::mutex m_mutex;
+
+      /// all entries, by index
+      std::vector<Entry> m_entries;
+
+      /// number of entries added by AddEntry()
+      size_t m_numAddedEntries = 0;
+   };
+
+} // namespace Encoder
@@ -0,0 +1,93 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SampleBlockQueue.cpp
+/// \brief bounded queue of decoded sample blocks
+//
+#include "stdafx.h"
+#include "SampleBlockQueue.hpp"
+
+using Encoder::SampleBlockQueue;
+
+SampleBlockQueue::SampleBlockQueue(size_t maxNumBlocks)
+   :m_maxNumBlocks(maxNumBlocks),
+   m_closed(false),
+   m_aborted(false)
+{
+   ATLASSERT(maxNumBlocks > 0);
+}
+
+bool SampleBlockQueue::Push(std::shared_ptr<const SampleBlock> block)
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionNotFull.wait(lock, [&]() { return m_blocks.size() < m_maxNumBlocks || m_closed || m_aborted; });
+
+      if (m_closed || m_aborted)
+         return false;
+
+      m_blocks.push_back(block);
+   }
+
+   m_conditionNotEmpty.notify_one();
+
+   return true;
+}
+
+std::shared_ptr<const SampleBlock> SampleBlockQueue::Pop()
+{
+   std::shared_ptr<const SampleBlock> block;
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionNotEmpty.wait(lock, [&]() { return !m_blocks.empty() || m_closed || m_aborted; });
+
+      if (m_aborted || m_blocks.empty())
+         return nullptr;
+
+      block = m_blocks.front();
+      m_blocks.pop_front();
+   }
+
+   m_conditionNotFull.notify_one();
+
+   return block;
+}
+
+void SampleBlockQueue::Close()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_closed = true;
+   }
+
+   m_conditionNotEmpty.notify_all();
+   m_conditionNotFull.notify_all();
+}
+
+void SampleBlockQueue::Abort()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_aborted = true;
+      m_blocks.clear();
+   }
+
+   m_conditionNotEmpty.notify_all();
+   m_conditionNotFull.notify_all();
+}
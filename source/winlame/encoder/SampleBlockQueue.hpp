@@ -0,0 +1,102 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SampleBlockQueue.hpp
+/// \brief bounded queue of decoded sample blocks
+//
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+namespace Encoder
+{
+   /// block of decoded samples, in interleaved format
+   struct SampleBlock
+   {
+      /// ctor; copies samples
+      SampleBlock(const void* samples, int numSamples, size_t bytesPerSample)
+         :m_data(static_cast<const BYTE*>(samples), static_cast<const BYTE*>(samples) + numSamples * bytesPerSample),
+         m_numSamples(numSamples)
+      {
+      }
+
+      /// sample data
+      std::vector<BYTE> m_data;
+
+      /// number of samples, per channel
+      int m_numSamples;
+   };
+
+   /// \brief bounded queue of sample blocks
+   /// \details passes sample blocks from the decoding thread to one output
+   /// thread. Pushing blocks waits while the queue is full, so that a slow
+   /// output limits the memory used for decoded samples.
+   class SampleBlockQueue
+   {
+   public:
+      /// ctor; uses given maximum number of queued blocks
+      explicit SampleBlockQueue(size_t maxNumBlocks = 8);
+
+      /// deleted copy ctor
+      SampleBlockQueue(const SampleBlockQueue&) = delete;
+      /// deleted copy assignment operator
+      SampleBlockQueue& operator=(const SampleBlockQueue&) = delete;
+
+      /// adds block to the queue; waits while the queue is full; returns
+      /// false when the queue was closed or aborted
+      bool Push(std::shared_ptr<const SampleBlock> block);
+
+      /// removes next block from the queue; waits while the queue is empty;
+      /// returns nullptr when the queue was closed and all blocks were
+      /// removed, or when it was aborted
+      std::shared_ptr<const SampleBlock> Pop();
+
+      /// closes queue; blocks already queued can still be removed
+      void Close();
+
+      /// aborts queue; removes all queued blocks and wakes up all waiting threads
+      void Abort();
+
+   private:
+      /// maximum number of queued blocks
+      size_t m_maxNumBlocks;
+
+      /// mutex protecting the queue
+      std::mutex m_mutex;
+
+      /// condition that is signaled when a block was added or the queue was closed
+      std::condition_variable m_conditionNotEmpty;
+
+      /// condition that is signaled when a block was removed or the queue was closed
+      std::condition_variable m_conditionNotFull;
+
+      /// queued blocks
+      std::deque<std::shared_ptr<const SampleBlock>> m_blocks;
+
+      /// indicates if the queue was closed
+      bool m_closed;
+
+      /// indicates if the queue was aborted
+      bool m_aborted;
+   };
+
+} // namespace Encoder
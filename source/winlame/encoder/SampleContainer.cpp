@@ -22,6 +22,7 @@
 #include "stdafx.h"
 #include "SampleContainer.hpp"
 #include <cstring>
+#include <algorithm>
 
 using Encoder::SampleContainer;
 using Encoder::SampleFormatType;
@@ -30,7 +31,8 @@ SampleContainer::SampleContainer()
    :m_channelArray(nullptr),
    m_interleaved(nullptr),
    m_numBytesAvail(0),
-   m_numSamplesAvail(0)
+   m_numSamplesAvail(0),
+   m_numSamplesReserved(0)
 {
    source.format = SamplesUnknown;
    target.format = SamplesUnknown;
@@ -51,6 +53,16 @@ void SampleContainer::SetInputModuleTraits(int bitsPerSample,
    source.numChannels = numChannels;
 }
 
+void SampleContainer::ReserveSamples(int numSamples)
+{
+   m_numSamplesReserved = std::max(m_numSamplesReserved, numSamples);
+
+   // output buffers already set up?
+   if (target.format != SamplesUnknown &&
+      numSamples > m_numBytesAvail)
+      ReallocMemory(numSamples);
+}
+
 void SampleContainer::SetOutputModuleTraits(int bitsPerSample,
    SampleFormatType format, int samplerateInHz, int numChannels)
 {
@@ -65,8 +77,8 @@ void SampleContainer::SetOutputModuleTraits(int bitsPerSample,
    target.samplerateInHz = samplerateInHz;
    target.numChannels = numChannels;
 
-   // initial value
-   m_numBytesAvail = 512;
+   // initial value; at least the number of samples the input module reserved
+   m_numBytesAvail = std::max(512, m_numSamplesReserved);
 
    // set up channel array or interleaved memory
    switch (format)
@@ -93,9 +105,10 @@ void SampleContainer::SetOutputModuleTraits(int bitsPerSample,
 
 void SampleContainer::PutSamplesInterleaved(void* samples, int numSamples)
 {
-   // check if there is enough space in the buffer
+   // check if there is enough space in the buffer; grow in bigger steps, so
+   // that slowly growing block sizes don't reallocate every time
    if (numSamples > m_numBytesAvail)
-      ReallocMemory(numSamples);
+      ReallocMemory(std::max(numSamples, m_numBytesAvail * 2));
 
    // conversion from interleaved to ...
 
@@ -130,9 +143,10 @@ void SampleContainer::PutSamplesInterleaved(void* samples, int numSamples)
 
 void SampleContainer::PutSamplesArray(void** samples, int numSamples)
 {
-   // check if there is enough space in the buffer
+   // check if there is enough space in the buffer; grow in bigger steps, so
+   // that slowly growing block sizes don't reallocate every time
    if (numSamples > m_numBytesAvail)
-      ReallocMemory(numSamples);
+      ReallocMemory(std::max(numSamples, m_numBytesAvail * 2));
 
    // conversion from channel array to ...
 
@@ -177,6 +191,15 @@ void** SampleContainer::GetSamplesArray(int& numSamples)
    return m_channelArray;
 }
 
+void SampleContainer::LimitNumSamples(int maxNumSamples)
+{
+   if (maxNumSamples < 0)
+      maxNumSamples = 0;
+
+   if (m_numSamplesAvail > maxNumSamples)
+      m_numSamplesAvail = maxNumSamples;
+}
+
 void SampleContainer::ReallocMemory(int newSamples)
 {
    m_numBytesAvail = newSamples;
@@ -75,7 +75,7 @@ namespace Encoder
          int samplerateInHz, int numChannels);
 
       /// returns the input module sample rate
-      int GetInputModuleSampleRate() { return source.samplerateInHz; }
+      int GetInputModuleSampleRate() const { return source.samplerateInHz; }
 
       /// returns the input module number of channels
       int GetInputModuleChannels() { return source.numChannels; }
@@ -83,6 +83,15 @@ namespace Encoder
       /// returns the input module bits per sample
       int GetInputModuleBitsPerSample() { return source.bitsPerSample; }
 
+      /// \brief reserves memory for blocks of up to given number of samples, per channel
+      /// \details Input modules call this in InitInput() with the largest
+      /// block they decode, so that storing samples doesn't allocate memory
+      /// while encoding.
+      void ReserveSamples(int numSamples);
+
+      /// returns the number of samples per channel reserved by the input module
+      int GetReservedNumSamples() const { return m_numSamplesReserved; }
+
       // output module functions
 
       /// sets traits of the output module
@@ -98,6 +107,9 @@ namespace Encoder
       /// returns the input module bits per sample
       int GetOutputModuleBitsPerSample() { return target.bitsPerSample; }
 
+      /// returns the output module sample format
+      SampleFormatType GetOutputModuleSampleFormat() const { return target.format; }
+
       // functions to put samples in or get samples out
 
       /// stores samples in interleaved format in the sample container
@@ -112,6 +124,13 @@ namespace Encoder
       /// retrieves samples in channel array format
       void** GetSamplesArray(int& numSamples);
 
+      /// returns number of samples currently stored, per channel
+      int GetNumSamples() const { return m_numSamplesAvail; }
+
+      /// limits number of stored samples, e.g. to cut off samples at the end
+      /// of a range; the remaining samples are discarded
+      void LimitNumSamples(int maxNumSamples);
+
    private:
       /// reallocates internal output buffers
       void ReallocMemory(int newSampleSize);
@@ -143,6 +162,9 @@ namespace Encoder
 
       /// number of available samples
       int m_numSamplesAvail;
+
+      /// number of samples per channel reserved by the input module
+      int m_numSamplesReserved;
    };
 
 } // namespace Encoder
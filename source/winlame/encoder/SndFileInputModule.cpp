@@ -30,6 +30,7 @@
 using Encoder::SndFileInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::BufferedInputFile;
 
 /// sndfile input buffer size
 const int c_sndfileInputBufferSize = 512;
@@ -120,12 +121,25 @@ int SndFileInputModule::InitInput(LPCTSTR infilename,
    m_sampleCount = 0;
 
    // opens the file for reading
+   if (!m_inputFile.Open(infilename))
+   {
+      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
+
+      return -1;
+   }
+
+   static SF_VIRTUAL_IO s_virtualIO =
+   {
+      &SndFileInputModule::VirtualGetFileLength,
+      &SndFileInputModule::VirtualSeek,
+      &SndFileInputModule::VirtualRead,
+      &SndFileInputModule::VirtualWrite,
+      &SndFileInputModule::VirtualTell,
+   };
+
    memset(&m_sfinfo, 0, sizeof(m_sfinfo));
-#ifdef UNICODE
-   m_sndfile = sf_wchar_open(infilename, SFM_READ, &m_sfinfo);
-#else
-   m_sndfile = sf_open(CStringA(GetAnsiCompatFilename(infilename)), SFM_READ, &m_sfinfo);
-#endif
+   m_sndfile = sf_open_virtual(&s_virtualIO, SFM_READ, &m_sfinfo, &m_inputFile);
 
    if (m_sndfile == nullptr)
    {
@@ -180,6 +194,7 @@ int SndFileInputModule::InitInput(LPCTSTR infilename,
    // set up input traits
    samples.SetInputModuleTraits(m_numOutputBits, SamplesInterleaved,
       m_sfinfo.samplerate, m_sfinfo.channels);
+   samples.ReserveSamples(c_sndfileInputBufferSize);
 
    return 0;
 }
@@ -294,9 +309,77 @@ float SndFileInputModule::PercentDone() const
    return m_sfinfo.frames != 0 ? float(m_sampleCount)*100.f / float(m_sfinfo.frames) : 0.f;
 }
 
+bool SndFileInputModule::CanSeek() const
+{
+   return m_sndfile != nullptr && m_sfinfo.seekable != 0;
+}
+
+__int64 SndFileInputModule::GetTotalSamples() const
+{
+   return m_sndfile != nullptr && m_sfinfo.frames > 0 ? m_sfinfo.frames : -1;
+}
+
+int SndFileInputModule::SeekToSample(__int64 samplePosition)
+{
+   if (m_sndfile == nullptr)
+      return -1;
+
+   sf_count_t ret = sf_seek(m_sndfile, samplePosition, SEEK_SET);
+   if (ret < 0)
+   {
+      m_lastError.LoadString(IDS_ENCODER_SEEK_ERROR);
+      m_lastError.AppendFormat(_T(" (%hs)"), sf_strerror(m_sndfile));
+      return -1;
+   }
+
+   m_sampleCount = static_cast<int>(samplePosition);
+
+   return 0;
+}
+
 void SndFileInputModule::DoneInput()
 {
    sf_close(m_sndfile);
+   m_sndfile = nullptr;
+
+   m_inputFile.Close();
+}
+
+sf_count_t SndFileInputModule::VirtualGetFileLength(void* userData)
+{
+   BufferedInputFile& inputFile = *reinterpret_cast<BufferedInputFile*>(userData);
+   return static_cast<sf_count_t>(inputFile.Length());
+}
+
+sf_count_t SndFileInputModule::VirtualSeek(sf_count_t offset, int whence, void* userData)
+{
+   BufferedInputFile& inputFile = *reinterpret_cast<BufferedInputFile*>(userData);
+
+   if (!inputFile.Seek(offset, whence))
+      return -1;
+
+   return static_cast<sf_count_t>(inputFile.Tell());
+}
+
+sf_count_t SndFileInputModule::VirtualRead(void* ptr, sf_count_t count, void* userData)
+{
+   BufferedInputFile& inputFile = *reinterpret_cast<BufferedInputFile*>(userData);
+   return static_cast<sf_count_t>(inputFile.Read(ptr, static_cast<size_t>(count)));
+}
+
+sf_count_t SndFileInputModule::VirtualWrite(const void* ptr, sf_count_t count, void* userData)
+{
+   // input files are never written to
+   UNUSED(ptr);
+   UNUSED(count);
+   UNUSED(userData);
+   return 0;
+}
+
+sf_count_t SndFileInputModule::VirtualTell(void* userData)
+{
+   BufferedInputFile& inputFile = *reinterpret_cast<BufferedInputFile*>(userData);
+   return static_cast<sf_count_t>(inputFile.Tell());
 }
 
 bool SndFileInputModule::WaveGetID3Tag(LPCTSTR wavfile, TrackInfo& trackInfo)
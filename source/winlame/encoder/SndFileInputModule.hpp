@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedInputFile.hpp"
 #define ENABLE_SNDFILE_WINDOWS_PROTOTYPES 1
 #include <sndfile.h>
 
@@ -71,6 +72,15 @@ namespace Encoder
       /// returns the number of percent done
       virtual float PercentDone() const override;
 
+      /// returns if the input module can seek to a sample position in the current file
+      virtual bool CanSeek() const override;
+
+      /// returns total number of samples per channel of the current file
+      virtual __int64 GetTotalSamples() const override;
+
+      /// seeks to a sample position in the current file
+      virtual int SeekToSample(__int64 samplePosition) override;
+
       /// called when done with decoding
       virtual void DoneInput() override;
 
@@ -81,7 +91,25 @@ namespace Encoder
       /// retrieves track infos from tags read by libsndfile
       void GetTrackInfos(TrackInfo& trackInfo);
 
+      /// virtual I/O callback: returns file length
+      static sf_count_t VirtualGetFileLength(void* userData);
+
+      /// virtual I/O callback: seeks in file
+      static sf_count_t VirtualSeek(sf_count_t offset, int whence, void* userData);
+
+      /// virtual I/O callback: reads from file
+      static sf_count_t VirtualRead(void* ptr, sf_count_t count, void* userData);
+
+      /// virtual I/O callback: writes to file; not supported for input files
+      static sf_count_t VirtualWrite(const void* ptr, sf_count_t count, void* userData);
+
+      /// virtual I/O callback: returns current file position
+      static sf_count_t VirtualTell(void* userData);
+
    private:
+      /// input file
+      BufferedInputFile m_inputFile;
+
       /// file handle
       SNDFILE* m_sndfile;
 
@@ -25,6 +25,7 @@
 #include "SndFileOutputModule.hpp"
 #include "SndFileFormats.hpp"
 #include "App.hpp"
+#include <algorithm>
 
 using Encoder::SndFileOutputModule;
 using Encoder::TrackInfo;
@@ -96,26 +97,6 @@ int SndFileOutputModule::InitOutput(LPCTSTR outfilename,
 
    m_sfinfo.format = m_format | m_subType;
 
-   // opens the file for writing
-#ifdef UNICODE
-   m_sndfile = sf_wchar_open(outfilename, SFM_WRITE, &m_sfinfo);
-#else
-   m_sndfile = sf_open(CStringA(outfilename), SFM_WRITE, &m_sfinfo);
-#endif
-
-   if (m_sndfile == nullptr)
-   {
-      char buffer[512];
-      sf_error_str(m_sndfile, buffer, 512);
-
-      m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
-      m_lastError.AppendFormat(_T(" (%hs)"), buffer);
-
-      return -1;
-   }
-
-   SetTrackInfo(trackInfo);
-
    int numOutputBits;
    switch (m_subType)
    {
@@ -135,9 +116,50 @@ int SndFileOutputModule::InitOutput(LPCTSTR outfilename,
       break;
    }
 
+   // opens the file for writing; the size estimate is exact for PCM formats
+   unsigned int bytesPerSecond = static_cast<unsigned int>(m_sfinfo.samplerate * m_sfinfo.channels * (numOutputBits / 8));
+
+   if (!m_outputFile.Open(outfilename, OutputFileOptions::FromSettings(mgr, bytesPerSecond)))
+   {
+      m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_outputFile.GetLastErrorText().GetString());
+
+      return -1;
+   }
+
+   static SF_VIRTUAL_IO s_virtualIO =
+   {
+      &SndFileOutputModule::VirtualGetFileLength,
+      &SndFileOutputModule::VirtualSeek,
+      &SndFileOutputModule::VirtualRead,
+      &SndFileOutputModule::VirtualWrite,
+      &SndFileOutputModule::VirtualTell,
+   };
+
+   m_sndfile = sf_open_virtual(&s_virtualIO, SFM_WRITE, &m_sfinfo, &m_outputFile);
+
+   if (m_sndfile == nullptr)
+   {
+      char buffer[512];
+      sf_error_str(m_sndfile, buffer, 512);
+
+      m_lastError.LoadString(IDS_ENCODER_OUTPUT_FILE_CREATE_ERROR);
+      m_lastError.AppendFormat(_T(" (%hs)"), buffer);
+
+      m_outputFile.Close();
+
+      return -1;
+   }
+
+   SetTrackInfo(trackInfo);
+
    // set up output traits
    samples.SetOutputModuleTraits(numOutputBits, SamplesInterleaved);
 
+   if (m_subType == SF_FORMAT_FLOAT ||
+      m_subType == SF_FORMAT_DOUBLE)
+      m_floatBuffer.reserve(static_cast<size_t>(std::max(samples.GetReservedNumSamples(), 512)) * m_sfinfo.channels);
+
    return 0;
 }
 
@@ -159,12 +181,12 @@ int SndFileOutputModule::EncodeSamples(SampleContainer& samples)
    {
       int* intSampleBuffer = (int*)sampleBuffer;
 
-      std::vector<float> floatBuffer(numSamples * m_sfinfo.channels);
+      m_floatBuffer.resize(numSamples * m_sfinfo.channels);
 
       for (int i = 0; i < numSamples * m_sfinfo.channels; i++)
-         floatBuffer[i] = float(intSampleBuffer[i]) / (1UL << 31);
+         m_floatBuffer[i] = float(intSampleBuffer[i]) / (1UL << 31);
 
-      ret = sf_write_float(m_sndfile, floatBuffer.data(), floatBuffer.size());
+      ret = sf_write_float(m_sndfile, m_floatBuffer.data(), m_floatBuffer.size());
    }
    else if (samples.GetOutputModuleBitsPerSample() == 32)
    {
@@ -187,6 +209,9 @@ int SndFileOutputModule::EncodeSamples(SampleContainer& samples)
 void SndFileOutputModule::DoneOutput()
 {
    sf_close(m_sndfile);
+   m_sndfile = nullptr;
+
+   m_outputFile.Close();
 }
 
 void SndFileOutputModule::SetTrackInfo(const TrackInfo& trackInfo)
@@ -242,3 +267,44 @@ void SndFileOutputModule::SetTrackInfo(const TrackInfo& trackInfo)
    text.Format("winLAME %ls", App::Version().GetString());
    sf_set_string(m_sndfile, SF_STR_SOFTWARE, text.GetString());
 }
+
+sf_count_t SndFileOutputModule::VirtualGetFileLength(void* userData)
+{
+   BufferedOutputFile& outputFile = *reinterpret_cast<BufferedOutputFile*>(userData);
+   return static_cast<sf_count_t>(outputFile.Length());
+}
+
+sf_count_t SndFileOutputModule::VirtualSeek(sf_count_t offset, int whence, void* userData)
+{
+   BufferedOutputFile& outputFile = *reinterpret_cast<BufferedOutputFile*>(userData);
+
+   sf_count_t newPosition = offset;
+   if (whence == SEEK_CUR)
+      newPosition += static_cast<sf_count_t>(outputFile.Tell());
+   else if (whence == SEEK_END)
+      newPosition += static_cast<sf_count_t>(outputFile.Length());
+
+   if (newPosition < 0 ||
+      !outputFile.Seek(static_cast<ULONGLONG>(newPosition)))
+      return -1;
+
+   return newPosition;
+}
+
+sf_count_t SndFileOutputModule::VirtualRead(void* ptr, sf_count_t count, void* userData)
+{
+   BufferedOutputFile& outputFile = *reinterpret_cast<BufferedOutputFile*>(userData);
+   return static_cast<sf_count_t>(outputFile.Read(ptr, static_cast<size_t>(count)));
+}
+
+sf_count_t SndFileOutputModule::VirtualWrite(const void* ptr, sf_count_t count, void* userData)
+{
+   BufferedOutputFile& outputFile = *reinterpret_cast<BufferedOutputFile*>(userData);
+   return outputFile.Write(ptr, static_cast<size_t>(count)) ? count : 0;
+}
+
+sf_count_t SndFileOutputModule::VirtualTell(void* userData)
+{
+   BufferedOutputFile& outputFile = *reinterpret_cast<BufferedOutputFile*>(userData);
+   return static_cast<sf_count_t>(outputFile.Tell());
+}
@@ -23,8 +23,10 @@
 #pragma once
 
 #include "ModuleInterface.hpp"
+#include "BufferedOutputFile.hpp"
 #define ENABLE_SNDFILE_WINDOWS_PROTOTYPES 1
 #include <sndfile.h>
+#include <vector>
 
 namespace Encoder
 {
@@ -70,10 +72,28 @@ namespace Encoder
       /// sets track info for sndfile to write
       void SetTrackInfo(const TrackInfo& trackInfo);
 
+      /// virtual I/O callback: returns file length
+      static sf_count_t VirtualGetFileLength(void* userData);
+
+      /// virtual I/O callback: seeks in file
+      static sf_count_t VirtualSeek(sf_count_t offset, int whence, void* userData);
+
+      /// virtual I/O callback: reads from file
+      static sf_count_t VirtualRead(void* ptr, sf_count_t count, void* userData);
+
+      /// virtual I/O callback: writes to file
+      static sf_count_t VirtualWrite(const void* ptr, sf_count_t count, void* userData);
+
+      /// virtual I/O callback: returns current file position
+      static sf_count_t VirtualTell(void* userData);
+
    private:
       /// file handle
       SNDFILE* m_sndfile;
 
+      /// output file; libsndfile writes to it using virtual I/O callbacks
+      BufferedOutputFile m_outputFile;
+
       /// soundfile info
       SF_INFO m_sfinfo;
 
@@ -85,6 +105,9 @@ namespace Encoder
 
       /// format subtype to write
       int m_subType;
+
+      /// buffer for converting samples to float; reserved in InitOutput()
+      std::vector<float> m_floatBuffer;
    };
 
 } // namespace Encoder
@@ -23,11 +23,12 @@
 #include "SpeexInputModule.hpp"
 #include "resource.h"
 #include <speex/speex_callbacks.h>
-#include <initializer_list>
+#include <algorithm>
 
 using Encoder::SpeexInputModule;
 using Encoder::TrackInfo;
 using Encoder::SampleContainer;
+using Encoder::BufferedInputFile;
 
 SpeexInputModule::SpeexInputModule()
    :m_fileSize(0),
@@ -105,33 +106,16 @@ CString SpeexInputModule::GetFilterString() const
 int SpeexInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    TrackInfo& trackInfo, SampleContainer& samples)
 {
-   FILE* fd = nullptr;
-   errno_t err = _tfopen_s(&fd, infilename, _T("rb"));
-
-   if (err != 0 || fd == nullptr)
+   if (!m_inputFile.Open(infilename))
    {
       m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
+      m_lastError.AppendFormat(_T(" (%s)"), m_inputFile.GetLastErrorText().GetString());
       return -1;
    }
 
-   err = fseek(fd, 0, SEEK_END);
-   if (err != 0)
-   {
-      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
-      fclose(fd);
-      return -1;
-   }
+   m_fileSize = m_inputFile.Length();
 
-   m_fileSize = ftell(fd);
-   err = fseek(fd, 0, SEEK_SET);
-   if (err != 0)
-   {
-      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
-      fclose(fd);
-      return -1;
-   }
-
-   m_inputStream.reset(new OggInputStream(fd, false));
+   m_inputStream.reset(new OggInputStream(m_inputFile));
 
    size_t numTryReads = 3;
    while (!m_inputStream->IsEndOfStream() && numTryReads > 0)
@@ -154,7 +138,8 @@ int SpeexInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    if (m_header == nullptr)
    {
       m_lastError = _T("Couldn't read Speex header");
-      fclose(fd);
+      m_inputStream.reset();
+      m_inputFile.Close();
       return -1;
    }
 
@@ -164,16 +149,20 @@ int SpeexInputModule::InitInput(LPCTSTR infilename, SettingsManager& mgr,
    samples.SetInputModuleTraits(16, SamplesInterleaved,
       m_header->rate, m_header->nb_channels);
 
+   // a packet decodes to the same number of samples every time, so all
+   // buffers can be allocated up front
+   spx_int32_t frameSize = 0;
+   speex_decoder_ctl(m_decoderState.get(), SPEEX_GET_FRAME_SIZE, &frameSize);
+
+   int maxNumSamples = frameSize * std::max(m_header->frames_per_packet, 1);
+   m_sampleBuffer.reserve(static_cast<size_t>(maxNumSamples) * m_header->nb_channels);
+   samples.ReserveSamples(maxNumSamples);
+
    // re-init file
-   err = fseek(fd, 0, SEEK_SET);
-   if (err != 0)
-   {
-      m_lastError.LoadString(IDS_ENCODER_INPUT_FILE_OPEN_ERROR);
-      fclose(fd);
-      return -1;
-   }
+   m_inputStream.reset();
+   m_inputFile.Seek(0, SEEK_SET);
 
-   m_inputStream.reset(new OggInputStream(fd, true));
+   m_inputStream.reset(new OggInputStream(m_inputFile));
 
    m_packetCount = 0;
 
@@ -216,18 +205,18 @@ int SpeexInputModule::DecodeSamples(SampleContainer& samples)
          }
          else
          {
-            std::vector<short> sampleBuffer;
+            m_sampleBuffer.clear();
 
-            int iRet = DecodePacket(packet, sampleBuffer);
+            int iRet = DecodePacket(packet, m_sampleBuffer);
 
             if (iRet == 0)
                return 0;
 
-            ATLASSERT(!sampleBuffer.empty());
+            ATLASSERT(!m_sampleBuffer.empty());
 
-            samples.PutSamplesInterleaved(sampleBuffer.data(), sampleBuffer.size() / m_header->nb_channels);
+            samples.PutSamplesInterleaved(m_sampleBuffer.data(), m_sampleBuffer.size() / m_header->nb_channels);
 
-            return sampleBuffer.size();
+            return m_sampleBuffer.size();
          }
 
       m_packetCount++;
@@ -246,9 +235,9 @@ float SpeexInputModule::PercentDone() const
    if (m_inputStream->IsEndOfStream())
       return 100.0f;
 
-   long lPos = ftell(m_inputStream->GetFd());
+   ULONGLONG pos = m_inputStream->GetInputFile().Tell();
 
-   return float(lPos) * 100.0f / m_fileSize;
+   return float(pos) * 100.0f / m_fileSize;
 }
 
 void SpeexInputModule::DoneInput()
@@ -256,6 +245,9 @@ void SpeexInputModule::DoneInput()
    speex_bits_destroy(&m_bits);
    m_header.reset();
    m_decoderState.reset();
+
+   m_inputStream.reset();
+   m_inputFile.Close();
 }
 
 void SpeexInputModule::InitDecoder()
@@ -328,8 +320,7 @@ int SpeexInputModule::DecodePacket(ogg_packet& packet, std::vector<short>& sampl
       if (numChannels == 2)
          speex_decode_stereo_int(outputBuffer, frameSize, &m_stereo);
 
-      samples.insert(samples.end(),
-         std::initializer_list<short>(outputBuffer, outputBuffer + frameSize * numChannels));
+      samples.insert(samples.end(), outputBuffer, outputBuffer + frameSize * numChannels);
    }
 
    return samples.size();
@@ -341,13 +332,9 @@ void SpeexInputModule::CalcSampleCount() const
    if (m_inputStream == nullptr)
       return;
 
-   FILE* fd = m_inputStream->GetFd();
-   if (fd == nullptr)
-      return;
+   BufferedInputFile& inputFile = m_inputStream->GetInputFile();
 
-   long currentPos = ftell(fd);
-   if (currentPos < 0)
-      return;
+   ULONGLONG currentPos = inputFile.Tell();
 
    ogg_int64_t sampleCount = 0;
    ogg_int64_t samplesPerPacket = 0;
@@ -376,8 +363,7 @@ void SpeexInputModule::CalcSampleCount() const
       }
    }
 
-   int ret = fseek(fd, currentPos, SEEK_SET);
-   if (ret != 0)
+   if (!inputFile.Seek(static_cast<LONGLONG>(currentPos), SEEK_SET))
       return;
 
    m_sampleCount = sampleCount;
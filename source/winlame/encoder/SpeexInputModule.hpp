@@ -93,11 +93,14 @@ namespace Encoder
       /// last error text
       CString m_lastError;
 
+      /// input file; must be declared before the input stream that reads from it
+      BufferedInputFile m_inputFile;
+
       /// input stream
       std::shared_ptr<OggInputStream> m_inputStream;
 
       /// file size
-      long m_fileSize;
+      ULONGLONG m_fileSize;
 
       /// packet count
       unsigned int m_packetCount;
@@ -116,6 +119,9 @@ namespace Encoder
 
       /// encoder state
       std::shared_ptr<void> m_decoderState;
+
+      /// decoded samples of the current packet; reserved in InitInput()
+      std::vector<short> m_sampleBuffer;
    };
 
 } // namespace Encoder
@@ -0,0 +1,134 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TaskControl.cpp
+/// \brief control channel for pausing, resuming and stopping a task
+//
+#include "stdafx.h"
+#include "TaskControl.hpp"
+
+using Encoder::TaskControl;
+
+/// returns Win32 thread priority for task priority
+static int ThreadPriorityFromTaskPriority(TaskControl::Priority priority)
+{
+   switch (priority)
+   {
+   case TaskControl::priorityLow: return THREAD_PRIORITY_BELOW_NORMAL;
+   case TaskControl::priorityHigh: return THREAD_PRIORITY_ABOVE_NORMAL;
+   default:
+      return THREAD_PRIORITY_NORMAL;
+   }
+}
+
+TaskControl::TaskControl()
+   :m_paused(false),
+   m_stopped(false),
+   m_pausedTime(std::chrono::steady_clock::duration::zero()),
+   m_priority(priorityNormal),
+   m_appliedPriority(priorityNormal)
+{
+}
+
+void TaskControl::Reset()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_paused = false;
+   m_stopped = false;
+   m_pausedTime = std::chrono::steady_clock::duration::zero();
+}
+
+void TaskControl::Pause()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if (!m_paused)
+      m_pauseStart = std::chrono::steady_clock::now();
+
+   m_paused = true;
+}
+
+void TaskControl::Resume()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_paused)
+         m_pausedTime += std::chrono::steady_clock::now() - m_pauseStart;
+
+      m_paused = false;
+   }
+
+   m_conditionResumed.notify_all();
+}
+
+void TaskControl::Stop()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped = true;
+   }
+
+   m_conditionResumed.notify_all();
+}
+
+std::chrono::steady_clock::duration TaskControl::PausedTime() const
+{
+   // the wall clock time is used, since multiple worker threads may wait
+   // at their check points at the same time
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (m_paused)
+      return m_pausedTime + (std::chrono::steady_clock::now() - m_pauseStart);
+
+   return m_pausedTime;
+}
+
+bool TaskControl::CheckPoint()
+{
+   Priority priority = m_priority;
+   if (priority != m_appliedPriority)
+   {
+      SetThreadPriority(GetCurrentThread(), ThreadPriorityFromTaskPriority(priority));
+      m_appliedPriority = priority;
+   }
+
+   // fast path: flags are only read, no lock is taken
+   if (m_paused && !m_stopped)
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionResumed.wait(lock, [&]() { return !m_paused || m_stopped; });
+   }
+
+   return !m_stopped;
+}
+
+bool TaskControl::WaitFor(std::chrono::milliseconds waitTime)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_conditionResumed.wait_for(lock, waitTime, [&]() { return m_stopped.load(); });
+
+   return !m_stopped;
+}
+
+void TaskControl::LeaveWorkerThread()
+{
+   if (m_appliedPriority != priorityNormal)
+   {
+      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+      m_appliedPriority = priorityNormal;
+   }
+}
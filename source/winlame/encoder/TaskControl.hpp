@@ -0,0 +1,127 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TaskControl.hpp
+/// \brief control channel for pausing, resuming and stopping a task
+//
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+namespace Encoder
+{
+   /// \brief control channel for a running task
+   /// \details the controlling thread (e.g. the UI or a command line runner)
+   /// pauses, resumes or stops the task, or changes its priority; the worker
+   /// loop calls CheckPoint() after each block of work. Checking costs only
+   /// a few atomic reads, and a paused worker waits on a condition variable,
+   /// so that it doesn't use any CPU time and wakes up immediately when
+   /// resumed or stopped.
+   class TaskControl
+   {
+   public:
+      /// task priority
+      enum Priority
+      {
+         priorityLow = 0,     ///< runs with below normal thread priority
+         priorityNormal = 1,  ///< runs with normal thread priority
+         priorityHigh = 2,    ///< runs with above normal thread priority
+      };
+
+      /// ctor
+      TaskControl();
+
+      /// deleted copy ctor
+      TaskControl(const TaskControl&) = delete;
+      /// deleted copy assignment operator
+      TaskControl& operator=(const TaskControl&) = delete;
+
+      /// resets pause and stop state, e.g. before starting the task again
+      void Reset();
+
+      /// pauses the task at the next check point
+      void Pause();
+
+      /// resumes a paused task
+      void Resume();
+
+      /// returns if the task is paused
+      bool IsPaused() const { return m_paused; }
+
+      /// stops the task at the next check point; also wakes up a paused task
+      void Stop();
+
+      /// returns if the task was stopped
+      bool IsStopped() const { return m_stopped; }
+
+      /// returns the time the task was paused since the last Reset(),
+      /// including the current pause
+      std::chrono::steady_clock::duration PausedTime() const;
+
+      /// sets new task priority; applied to the worker thread at the next check point
+      void SetPriority(Priority priority) { m_priority = priority; }
+
+      /// returns task priority
+      Priority GetPriority() const { return m_priority; }
+
+      /// \brief check point for the worker loop
+      /// \details applies a changed priority to the calling thread and blocks
+      /// as long as the task is paused; returns false when the task was
+      /// stopped and the worker loop should exit
+      bool CheckPoint();
+
+      /// waits for the given time, e.g. for a device to deliver data, or until
+      /// the task is stopped; returns false when the task was stopped
+      bool WaitFor(std::chrono::milliseconds waitTime);
+
+      /// restores the thread priority of the calling worker thread, when it
+      /// was changed by CheckPoint(); call when the worker loop exits, since
+      /// the thread may be reused for other tasks
+      void LeaveWorkerThread();
+
+   private:
+      /// mutex that is locked when changing the paused or stopped flag
+      mutable std::mutex m_mutex;
+
+      /// condition that is signaled when the task is resumed or stopped
+      std::condition_variable m_conditionResumed;
+
+      /// indicates if the task is paused
+      std::atomic<bool> m_paused;
+
+      /// indicates if the task was stopped
+      std::atomic<bool> m_stopped;
+
+      /// start of the current pause; protected by mutex
+      std::chrono::steady_clock::time_point m_pauseStart;
+
+      /// time the task was paused, not including the current pause;
+      /// protected by mutex
+      std::chrono::steady_clock::duration m_pausedTime;
+
+      /// requested priority
+      std::atomic<Priority> m_priority;
+
+      /// priority applied to the worker thread; only used by the worker thread
+      Priority m_appliedPriority;
+   };
+
+} // namespace Encoder
@@ -0,0 +1,384 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TranscodeCache.cpp
+/// \brief cache for encoded output files
+//
+#include "stdafx.h"
+#include "TranscodeCache.hpp"
+#include "SettingsManager.hpp"
+#include "BufferedInputFile.hpp"
+#include <bcrypt.h>
+#include <algorithm>
+
+#pragma comment(lib, "bcrypt.lib")
+
+using Encoder::TranscodeCache;
+using Encoder::TranscodeCacheStatistics;
+
+/// file extension of cached output files
+static LPCTSTR c_cacheEntryExtension = _T(".cache");
+
+/// version of the cache key; increment when the encoded output changes, e.g.
+/// when updating an encoder library
+static const unsigned int c_cacheKeyVersion = 1;
+
+/// calculates SHA-256 hashes, using the Windows CNG API
+class Sha256Hash
+{
+public:
+   /// ctor
+   Sha256Hash()
+      :m_algorithm(nullptr),
+      m_hash(nullptr)
+   {
+      if (BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&m_algorithm, BCRYPT_SHA256_ALGORITHM, nullptr, 0)))
+         BCryptCreateHash(m_algorithm, &m_hash, nullptr, 0, nullptr, 0, 0);
+   }
+
+   /// dtor
+   ~Sha256Hash()
+   {
+      if (m_hash != nullptr)
+         BCryptDestroyHash(m_hash);
+
+      if (m_algorithm != nullptr)
+         BCryptCloseAlgorithmProvider(m_algorithm, 0);
+   }
+
+   /// returns if the hash object was created
+   bool IsValid() const { return m_hash != nullptr; }
+
+   /// adds data to the hash
+   void Update(const void* data, size_t length)
+   {
+      BCryptHashData(m_hash, static_cast<PUCHAR>(const_cast<void*>(data)), static_cast<ULONG>(length), 0);
+   }
+
+   /// finishes hash and returns it as hex string
+   CString Finish()
+   {
+      BYTE digest[32] = {};
+      if (!BCRYPT_SUCCESS(BCryptFinishHash(m_hash, digest, sizeof(digest), 0)))
+         return CString();
+
+      CString text;
+      for (BYTE value : digest)
+         text.AppendFormat(_T("%02x"), value);
+
+      return text;
+   }
+
+private:
+   /// algorithm provider
+   BCRYPT_ALG_HANDLE m_algorithm;
+
+   /// hash object
+   BCRYPT_HASH_HANDLE m_hash;
+};
+
+/// returns if the setting affects the encoded audio; the other settings
+/// only control how the output file is written
+static bool IsSettingAffectingOutput(int variableId)
+{
+   return
+      variableId != LameNoGapInstanceId &&
+      variableId != GeneralIsLastFile &&
+      variableId != GeneralInputLengthInSeconds &&
+      variableId != GeneralOutputFlushOnClose;
+}
+
+TranscodeCache::TranscodeCache(const CString& cacheFolder, ULONGLONG maxSizeInBytes)
+   :m_cacheFolder(cacheFolder),
+   m_maxSize(maxSizeInBytes),
+   m_accessCounter(0)
+{
+   m_statistics.m_maxSize = maxSizeInBytes;
+
+   if (!IsEnabled())
+      return;
+
+   if (!Path::FolderExists(m_cacheFolder))
+      Path::CreateDirectoryRecursive(m_cacheFolder);
+
+   ScanCacheFolder();
+}
+
+CString TranscodeCache::CalculateKey(const CString& inputFilename, int outputModuleId,
+   SettingsManager& settingsManager)
+{
+   Sha256Hash hash;
+   if (!hash.IsValid())
+      return CString();
+
+   hash.Update(&c_cacheKeyVersion, sizeof(c_cacheKeyVersion));
+   hash.Update(&outputModuleId, sizeof(outputModuleId));
+
+   for (int variableId = VarFirst + 1; variableId < VarLast; variableId++)
+   {
+      if (!IsSettingAffectingOutput(variableId))
+         continue;
+
+      int value = settingsManager.QueryValueInt(static_cast<unsigned short>(variableId));
+
+      hash.Update(&variableId, sizeof(variableId));
+      hash.Update(&value, sizeof(value));
+   }
+
+   BufferedInputFile inputFile;
+   if (!inputFile.Open(inputFilename))
+      return CString();
+
+   ULONGLONG length = inputFile.Length();
+   hash.Update(&length, sizeof(length));
+
+   std::vector<BYTE> buffer(1024 * 1024);
+   size_t numRead = 0;
+   while ((numRead = inputFile.Read(buffer.data(), buffer.size())) > 0)
+      hash.Update(buffer.data(), numRead);
+
+   if (inputFile.GetLastError() != 0 ||
+      inputFile.Tell() != length)
+      return CString();
+
+   return hash.Finish();
+}
+
+bool TranscodeCache::Lookup(const CString& key, const CString& outputFilename)
+{
+   if (!IsEnabled() || key.IsEmpty())
+      return false;
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      auto iter = m_entries.find(key);
+      if (iter == m_entries.end())
+      {
+         m_statistics.m_numMisses++;
+         return false;
+      }
+
+      // readers prevent the entry from being evicted while copying
+      iter->second.m_numReaders++;
+      iter->second.m_lastAccess = ++m_accessCounter;
+   }
+
+   // copy outside of the lock, since the output files may be large; on file
+   // systems that support it, CopyFile() clones the file's blocks
+   CString entryFilename = GetEntryFilename(key);
+   bool copied = CopyFile(entryFilename, outputFilename, FALSE) != FALSE;
+
+   if (copied)
+   {
+      // update the last write time, so that the LRU order is kept when
+      // the cache folder is scanned again
+      HANDLE file = CreateFile(entryFilename, FILE_WRITE_ATTRIBUTES,
+         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+
+      if (file != INVALID_HANDLE_VALUE)
+      {
+         FILETIME now = {};
+         GetSystemTimeAsFileTime(&now);
+         SetFileTime(file, nullptr, nullptr, &now);
+         CloseHandle(file);
+      }
+   }
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = m_entries.find(key);
+   ATLASSERT(iter != m_entries.end());
+
+   iter->second.m_numReaders--;
+
+   if (copied)
+   {
+      m_statistics.m_numHits++;
+   }
+   else
+   {
+      ATLTRACE(_T("TranscodeCache: couldn't copy cached file %s, error %u\n"),
+         entryFilename.GetString(), GetLastError());
+
+      // the cached file is missing or unreadable; forget about it
+      m_statistics.m_numMisses++;
+
+      if (iter->second.m_numReaders == 0)
+      {
+         m_statistics.m_currentSize -= iter->second.m_size;
+         m_entries.erase(iter);
+         DeleteFile(entryFilename);
+      }
+
+      DeleteFile(outputFilename);
+   }
+
+   m_statistics.m_numEntries = m_entries.size();
+
+   return copied;
+}
+
+void TranscodeCache::Store(const CString& key, const CString& outputFilename)
+{
+   if (!IsEnabled() || key.IsEmpty())
+      return;
+
+   WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+   if (!GetFileAttributesEx(outputFilename, GetFileExInfoStandard, &attributes))
+      return;
+
+   ULONGLONG size = (ULONGLONG(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+   if (size > m_maxSize)
+      return;
+
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_entries.find(key) != m_entries.end())
+         return; // another thread already stored the same output
+   }
+
+   // copy to a temporary file first, so that a cache file is always complete
+   CString entryFilename = GetEntryFilename(key);
+
+   CString tempFilename;
+   tempFilename.Format(_T("%s.%08x-%08x.tmp"),
+      entryFilename.GetString(),
+      ::GetCurrentProcessId(),
+      ::GetCurrentThreadId());
+
+   if (!CopyFile(outputFilename, tempFilename, FALSE))
+   {
+      ATLTRACE(_T("TranscodeCache: couldn't store file %s, error %u\n"),
+         outputFilename.GetString(), GetLastError());
+      DeleteFile(tempFilename);
+      return;
+   }
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   if (m_entries.find(key) != m_entries.end() ||
+      !MoveFileEx(tempFilename, entryFilename, MOVEFILE_REPLACE_EXISTING))
+   {
+      DeleteFile(tempFilename);
+      return;
+   }
+
+   Entry& entry = m_entries[key];
+   entry.m_size = size;
+   entry.m_lastAccess = ++m_accessCounter;
+
+   m_statistics.m_numStored++;
+   m_statistics.m_currentSize += size;
+
+   EvictEntries();
+
+   m_statistics.m_numEntries = m_entries.size();
+}
+
+TranscodeCacheStatistics TranscodeCache::GetStatistics() const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   return m_statistics;
+}
+
+void TranscodeCache::ScanCacheFolder()
+{
+   struct FoundFile
+   {
+      CString m_key;
+      ULONGLONG m_size;
+      ULONGLONG m_lastWriteTime;
+   };
+
+   std::vector<FoundFile> foundFiles;
+
+   WIN32_FIND_DATA findData = {};
+   HANDLE find = FindFirstFile(Path::Combine(m_cacheFolder, CString(_T("*")) + c_cacheEntryExtension), &findData);
+   if (find == INVALID_HANDLE_VALUE)
+      return;
+
+   do
+   {
+      if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+         continue;
+
+      CString filename = findData.cFileName;
+
+      FoundFile foundFile;
+      foundFile.m_key = filename.Left(filename.GetLength() - static_cast<int>(_tcslen(c_cacheEntryExtension)));
+      foundFile.m_size = (ULONGLONG(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+      foundFile.m_lastWriteTime = (ULONGLONG(findData.ftLastWriteTime.dwHighDateTime) << 32) | findData.ftLastWriteTime.dwLowDateTime;
+
+      foundFiles.push_back(foundFile);
+
+   } while (FindNextFile(find, &findData));
+
+   FindClose(find);
+
+   // assign access counter values in the order the files were last used
+   std::sort(foundFiles.begin(), foundFiles.end(), [](const FoundFile& lhs, const FoundFile& rhs)
+   {
+      return lhs.m_lastWriteTime < rhs.m_lastWriteTime;
+   });
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   for (const FoundFile& foundFile : foundFiles)
+   {
+      Entry& entry = m_entries[foundFile.m_key];
+      entry.m_size = foundFile.m_size;
+      entry.m_lastAccess = ++m_accessCounter;
+
+      m_statistics.m_currentSize += foundFile.m_size;
+   }
+
+   EvictEntries();
+
+   m_statistics.m_numEntries = m_entries.size();
+}
+
+CString TranscodeCache::GetEntryFilename(const CString& key) const
+{
+   return Path::Combine(m_cacheFolder, key + c_cacheEntryExtension);
+}
+
+void TranscodeCache::EvictEntries()
+{
+   while (m_statistics.m_currentSize > m_maxSize)
+   {
+      auto oldestIter = m_entries.end();
+      for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+      {
+         if (iter->second.m_numReaders == 0 &&
+            (oldestIter == m_entries.end() || iter->second.m_lastAccess < oldestIter->second.m_lastAccess))
+            oldestIter = iter;
+      }
+
+      // all remaining entries are currently copied
+      if (oldestIter == m_entries.end())
+         break;
+
+      DeleteFile(GetEntryFilename(oldestIter->first));
+
+      m_statistics.m_currentSize -= oldestIter->second.m_size;
+      m_statistics.m_numEvicted++;
+
+      m_entries.erase(oldestIter);
+   }
+}
@@ -0,0 +1,142 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TranscodeCache.hpp
+/// \brief cache for encoded output files
+//
+#pragma once
+
+#include <map>
+#include <mutex>
+
+class SettingsManager;
+
+namespace Encoder
+{
+   /// statistics of the transcode cache
+   struct TranscodeCacheStatistics
+   {
+      /// number of lookups that found a cached output file
+      unsigned int m_numHits = 0;
+
+      /// number of lookups that didn't find a cached output file
+      unsigned int m_numMisses = 0;
+
+      /// number of output files stored in the cache
+      unsigned int m_numStored = 0;
+
+      /// number of cached output files removed to stay below the size limit
+      unsigned int m_numEvicted = 0;
+
+      /// number of cached output files
+      size_t m_numEntries = 0;
+
+      /// size of all cached output files, in bytes
+      ULONGLONG m_currentSize = 0;
+
+      /// maximum size of all cached output files, in bytes
+      ULONGLONG m_maxSize = 0;
+   };
+
+   /// \brief cache for encoded output files
+   /// \details output files are stored under a key that is calculated from
+   /// the content of the input file, the output module ID and the encoder
+   /// settings. When the same input file is encoded again with the same
+   /// settings, e.g. into another output folder, the cached output file is
+   /// copied instead. The cache folder is limited in size; the least
+   /// recently used output files are removed first. All methods may be
+   /// called by multiple encoder threads at the same time.
+   class TranscodeCache
+   {
+   public:
+      /// ctor; uses given cache folder and maximum size; an empty folder
+      /// name or a size of 0 disables the cache
+      TranscodeCache(const CString& cacheFolder, ULONGLONG maxSizeInBytes);
+
+      /// deleted copy ctor
+      TranscodeCache(const TranscodeCache&) = delete;
+      /// deleted copy assignment operator
+      TranscodeCache& operator=(const TranscodeCache&) = delete;
+
+      /// returns if the cache is enabled
+      bool IsEnabled() const { return !m_cacheFolder.IsEmpty() && m_maxSize > 0; }
+
+      /// returns cache folder
+      const CString& GetCacheFolder() const { return m_cacheFolder; }
+
+      /// returns maximum size of all cached output files
+      ULONGLONG GetMaxSize() const { return m_maxSize; }
+
+      /// \brief calculates cache key for encoding an input file
+      /// \details the key is a SHA-256 hash of the input file content, the
+      /// output module ID and all settings that affect the encoded audio;
+      /// returns an empty string when the input file can't be read
+      static CString CalculateKey(const CString& inputFilename, int outputModuleId,
+         SettingsManager& settingsManager);
+
+      /// copies cached output file with given key to the output filename;
+      /// returns false when the key isn't in the cache
+      bool Lookup(const CString& key, const CString& outputFilename);
+
+      /// stores output file under given key; may remove least recently used
+      /// output files to stay below the size limit
+      void Store(const CString& key, const CString& outputFilename);
+
+      /// returns current cache statistics
+      TranscodeCacheStatistics GetStatistics() const;
+
+   private:
+      /// cache entry
+      struct Entry
+      {
+         ULONGLONG m_size = 0;            ///< size of the cached output file
+         ULONGLONG m_lastAccess = 0;      ///< access counter value of last access
+         unsigned int m_numReaders = 0;   ///< number of lookups currently copying the file
+      };
+
+      /// reads all entries from the cache folder
+      void ScanCacheFolder();
+
+      /// returns filename of the cached output file for given key
+      CString GetEntryFilename(const CString& key) const;
+
+      /// removes least recently used entries until the size limit is met;
+      /// the cache mutex must be locked
+      void EvictEntries();
+
+   private:
+      /// cache folder
+      CString m_cacheFolder;
+
+      /// maximum size of all cached output files
+      ULONGLONG m_maxSize;
+
+      /// mutex protecting entries, access counter and statistics
+      mutable std::mutex m_mutex;
+
+      /// all cache entries, by key
+      std::map<CString, Entry> m_entries;
+
+      /// access counter; incremented on every lookup and store
+      ULONGLONG m_accessCounter;
+
+      /// cache statistics
+      TranscodeCacheStatistics m_statistics;
+   };
+
+} // namespace Encoder
@@ -128,6 +128,7 @@ WL_VARMAP_ENTRY1(FacilitySndFile, _T("sndFile"), _T("LibSndFile"))
 WL_VARMAP_ENTRY1(FacilityAAC, _T("aac"), _T("AAC"))
 WL_VARMAP_ENTRY1(FacilityWma, _T("wma"), _T("WMA"))
 WL_VARMAP_ENTRY1(FacilityOpus, _T("opus"), _T("Opus"))
+WL_VARMAP_ENTRY1(FacilityFlac, _T("flac"), _T("FLAC"))
 WL_VARMAP_END()
 
 
@@ -140,6 +141,7 @@ WL_VARMAP_ENTRY1(ID_OM_WAVE, _T("sndFile"), _T("LibSndFile"))
 WL_VARMAP_ENTRY1(ID_OM_AAC, _T("aac"), _T("AAC"))
 WL_VARMAP_ENTRY1(ID_OM_BASSWMA, _T("wma"), _T("WMA"))
 WL_VARMAP_ENTRY1(ID_OM_OPUS, _T("opus"), _T("Opus"))
+WL_VARMAP_ENTRY1(ID_OM_FLAC, _T("flac"), _T("FLAC"))
 WL_VARMAP_END()
 
 
@@ -186,7 +188,12 @@ WL_VARMAP_ENTRY(OpusTargetBitrate, _T("opusTargetBitrate"), _T("Opus Target Bitr
 WL_VARMAP_ENTRY(OpusComplexity, _T("opusComplexity"), _T("Opus Complexity"), 10)
 WL_VARMAP_ENTRY(OpusBitrateMode, _T("opusBitrateMode"), _T("Opus Bitrate Mode"), 0)
 
+WL_VARMAP_ENTRY(FlacCompressionLevel, _T("flacCompressionLevel"), _T("FLAC Compression Level"), 5)
+WL_VARMAP_ENTRY(FlacMultithreaded, _T("flacMultithreaded"), _T("FLAC multithreaded encoding"), 1)
+
 WL_VARMAP_ENTRY(GeneralIsLastFile, _T("isLastFile"), _T("is last file"), 0)
+WL_VARMAP_ENTRY(GeneralInputLengthInSeconds, _T("inputLength"), _T("input length in seconds"), 0)
+WL_VARMAP_ENTRY(GeneralOutputFlushOnClose, _T("outputFlushOnClose"), _T("flush output file on close"), 0)
 WL_VARMAP_END()
 
 
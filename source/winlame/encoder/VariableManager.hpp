@@ -64,6 +64,7 @@ enum
    FacilityAAC,
    FacilityWma,
    FacilityOpus,
+   FacilityFlac,
 };
 
 
@@ -114,6 +115,12 @@ enum
    OpusComplexity,
    OpusBitrateMode,
 
+   GeneralInputLengthInSeconds,
+   GeneralOutputFlushOnClose,
+
+   FlacCompressionLevel,
+   FlacMultithreaded,
+
    VarLast
 };
 
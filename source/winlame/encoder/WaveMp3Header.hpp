@@ -21,10 +21,10 @@
 //
 #pragma once
 
-#include <iosfwd>
-
 namespace Encoder
 {
+   class BufferedOutputFile;
+
    // global functions
 
    /// writes RIFF wave mp3 header to output stream
@@ -33,14 +33,14 @@ namespace Encoder
    /// \param samplerateInHz mp3 file sample rate
    /// \param bitrateInBps bitrate of the mp3
    /// \param codecDelay codec sample delay when decoding
-   void WriteWaveMp3Header(std::ofstream& outputFile, unsigned int numChannels,
+   void WriteWaveMp3Header(BufferedOutputFile& outputFile, unsigned int numChannels,
       unsigned int samplerateInHz, unsigned int bitrateInBps, unsigned short codecDelay);
 
    /// fixes fact chunk and riff header lengths; seeks around in the file
    /// \param outputFile output file stream to write to
    /// \param dataLength number of mp3 data bytes written
    /// \param numSamples number of samples written
-   void FixupWaveMp3Header(std::ofstream& outputFile, unsigned int dataLength,
+   void FixupWaveMp3Header(BufferedOutputFile& outputFile, unsigned int dataLength,
       unsigned int numSamples);
 
 } // namespace Encoder
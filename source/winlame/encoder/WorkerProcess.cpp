@@ -0,0 +1,719 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerProcess.cpp
+/// \brief worker process that encodes files outside of the winLAME process
+//
+#include "stdafx.h"
+#include "WorkerProcess.hpp"
+#include "EncoderImpl.hpp"
+#include "SettingsManager.hpp"
+#include "ModuleManagerImpl.hpp"
+#include "LameNogapInstanceManager.hpp"
+#include "TranscodeCache.hpp"
+#include <ulib/CommandLineParser.hpp>
+#include <atomic>
+
+using Encoder::WorkerProcess;
+using Encoder::EncoderSettings;
+
+/// command line option that starts a worker process
+static LPCTSTR c_workerCommandLineOption = _T("--encoder-worker");
+
+/// size of the pipe buffers
+static const DWORD c_pipeBufferSize = 64 * 1024;
+
+/// interval in which the worker process sends the encoder state
+static const DWORD c_stateIntervalInMilliseconds = 250;
+
+/// number of worker processes started by this process; used for unique names
+static std::atomic<unsigned int> s_numStartedWorkers{ 0 };
+
+/// escapes text, so that it can be stored in a tab separated message line
+static CStringA EscapeText(const CString& text)
+{
+   CString escapedText = text;
+   escapedText.Replace(_T("\\"), _T("\\\\"));
+   escapedText.Replace(_T("\t"), _T("\\t"));
+   escapedText.Replace(_T("\r"), _T("\\r"));
+   escapedText.Replace(_T("\n"), _T("\\n"));
+
+   return CStringA(CT2A(escapedText, CP_UTF8));
+}
+
+/// unescapes text stored with EscapeText()
+static CString UnescapeText(const CStringA& escapedText)
+{
+   CString text(CA2T(escapedText, CP_UTF8));
+
+   CString unescapedText;
+   for (int pos = 0; pos < text.GetLength(); pos++)
+   {
+      TCHAR ch = text[pos];
+      if (ch == _T('\\') && pos + 1 < text.GetLength())
+      {
+         ch = text[++pos];
+         if (ch == _T('t'))
+            ch = _T('\t');
+         else if (ch == _T('r'))
+            ch = _T('\r');
+         else if (ch == _T('n'))
+            ch = _T('\n');
+      }
+
+      unescapedText += ch;
+   }
+
+   return unescapedText;
+}
+
+/// formats binary data as hex text
+static CStringA FormatHexText(const std::vector<unsigned char>& data)
+{
+   static const char c_hexDigits[] = "0123456789abcdef";
+
+   CStringA text;
+   LPSTR buffer = text.GetBuffer(static_cast<int>(data.size() * 2));
+
+   for (size_t index = 0; index < data.size(); index++)
+   {
+      buffer[index * 2] = c_hexDigits[data[index] >> 4];
+      buffer[index * 2 + 1] = c_hexDigits[data[index] & 0x0f];
+   }
+
+   text.ReleaseBuffer(static_cast<int>(data.size() * 2));
+
+   return text;
+}
+
+/// parses hex text formatted with FormatHexText()
+static std::vector<unsigned char> ParseHexText(const CStringA& text)
+{
+   std::vector<unsigned char> data(text.GetLength() / 2);
+
+   for (size_t index = 0; index < data.size(); index++)
+   {
+      char digits[3] = { text[static_cast<int>(index * 2)], text[static_cast<int>(index * 2 + 1)], 0 };
+      data[index] = static_cast<unsigned char>(strtoul(digits, nullptr, 16));
+   }
+
+   return data;
+}
+
+/// splits message line into tab separated fields
+static std::vector<CStringA> SplitLine(const CStringA& line)
+{
+   std::vector<CStringA> fields;
+
+   int start = 0;
+   for (;;)
+   {
+      int pos = line.Find('\t', start);
+      if (pos == -1)
+      {
+         fields.push_back(line.Mid(start));
+         break;
+      }
+
+      fields.push_back(line.Mid(start, pos - start));
+      start = pos + 1;
+   }
+
+   return fields;
+}
+
+/// splits message into lines
+static std::vector<CStringA> SplitMessage(const CStringA& message)
+{
+   std::vector<CStringA> lines;
+
+   int start = 0;
+   while (start < message.GetLength())
+   {
+      int pos = message.Find('\n', start);
+      if (pos == -1)
+         pos = message.GetLength();
+
+      lines.push_back(message.Mid(start, pos - start));
+      start = pos + 1;
+   }
+
+   return lines;
+}
+
+/// reads a message from the client end of the pipe; used by the worker process
+static bool ReadPipeMessage(HANDLE pipe, CStringA& message)
+{
+   message.Empty();
+
+   for (;;)
+   {
+      char buffer[4096];
+      DWORD numRead = 0;
+      BOOL result = ReadFile(pipe, buffer, sizeof(buffer), &numRead, nullptr);
+
+      if (!result && GetLastError() != ERROR_MORE_DATA)
+         return false;
+
+      message.Append(buffer, static_cast<int>(numRead));
+
+      if (result)
+         return true;
+   }
+}
+
+/// writes a message to the client end of the pipe; used by the worker process
+static bool WritePipeMessage(HANDLE pipe, const CStringA& message)
+{
+   DWORD numWritten = 0;
+   return WriteFile(pipe, message.GetString(), static_cast<DWORD>(message.GetLength()), &numWritten, nullptr) &&
+      numWritten == static_cast<DWORD>(message.GetLength());
+}
+
+/// runs a single encoding job in the worker process
+static void RunWorkerJob(HANDLE pipe, HANDLE stopEvent, const CStringA& jobMessage)
+{
+   EncoderSettings encoderSettings;
+   SettingsManager settingsManager;
+   CString transcodeCacheFolder;
+   ULONGLONG transcodeCacheMaxSize = 0;
+
+   if (!WorkerProcess::ParseJobMessage(jobMessage, encoderSettings, settingsManager,
+      transcodeCacheFolder, transcodeCacheMaxSize))
+   {
+      WritePipeMessage(pipe, "finished\t-1\t0\t0");
+      return;
+   }
+
+   // the cache folder is scanned for every job, since other worker
+   // processes and the winLAME process store and remove files, too
+   std::unique_ptr<TranscodeCache> transcodeCache;
+   if (!transcodeCacheFolder.IsEmpty())
+   {
+      transcodeCache = std::make_unique<TranscodeCache>(transcodeCacheFolder, transcodeCacheMaxSize);
+      encoderSettings.m_transcodeCache = transcodeCache.get();
+   }
+
+   Encoder::EncoderImpl encoder;
+   encoder.SetEncoderSettings(encoderSettings);
+   encoder.SetSettingsManager(&settingsManager);
+
+   encoder.StartEncode();
+
+   // the stop event is also used to wait between sending the encoder states
+   bool stopped = false;
+   Encoder::EncoderState lastState;
+   lastState.m_percent = -1.f;
+
+   while (encoder.IsRunning())
+   {
+      if (WaitForSingleObject(stopEvent, c_stateIntervalInMilliseconds) == WAIT_OBJECT_0)
+      {
+         stopped = true;
+         encoder.StopEncode();
+         break;
+      }
+
+      Encoder::EncoderState state = encoder.GetEncoderState();
+
+      if (state.m_percent != lastState.m_percent ||
+         state.m_encodingDescription != lastState.m_encodingDescription)
+      {
+         CStringA message;
+         message.Format("state\t%d\t", static_cast<int>(state.m_percent * 100.f));
+         message += EscapeText(state.m_encodingDescription);
+
+         if (!WritePipeMessage(pipe, message))
+         {
+            stopped = true;
+            encoder.StopEncode();
+            break;
+         }
+
+         lastState = state;
+      }
+   }
+
+   encoder.WaitEncodeFinished();
+
+   Encoder::EncoderState state = encoder.GetEncoderState();
+
+   CStringA stateMessage;
+   stateMessage.Format("state\t%d\t", static_cast<int>(state.m_percent * 100.f));
+   stateMessage += EscapeText(state.m_encodingDescription);
+   WritePipeMessage(pipe, stateMessage);
+
+   for (const Encoder::ErrorInfo& errorInfo : encoder.GetAllErrorInfos())
+   {
+      CStringA errorMessage;
+      errorMessage.Format("error\t%d\t", errorInfo.m_errorNumber);
+      errorMessage += EscapeText(errorInfo.m_inputFilename) + "\t" +
+         EscapeText(errorInfo.m_moduleName) + "\t" +
+         EscapeText(errorInfo.m_errorMessage);
+
+      WritePipeMessage(pipe, errorMessage);
+   }
+
+   // the winLAME process reports the main output to the playlist
+   CString outputFilename;
+   __int64 numDecodedSamples = 0;
+   int samplerateInHz = 0;
+   if (!stopped &&
+      encoder.GetMainOutput(outputFilename, numDecodedSamples, samplerateInHz))
+   {
+      CStringA outputMessage;
+      outputMessage.Format("output\t%I64d\t%d\t", numDecodedSamples, samplerateInHz);
+      outputMessage += EscapeText(outputFilename);
+
+      WritePipeMessage(pipe, outputMessage);
+   }
+
+   CStringA finishedMessage;
+   finishedMessage.Format("finished\t%d\t%d\t%d", static_cast<int>(state.m_errorCode), stopped ? 1 : 0,
+      state.m_copiedOutput ? 1 : 0);
+   WritePipeMessage(pipe, finishedMessage);
+}
+
+WorkerProcess::WorkerProcess()
+   :m_process(nullptr),
+   m_pipe(INVALID_HANDLE_VALUE),
+   m_stopEvent(nullptr),
+   m_pipeEvent(nullptr)
+{
+}
+
+WorkerProcess::~WorkerProcess()
+{
+   // closing the pipe ends the worker process after its current job
+   if (m_pipe != INVALID_HANDLE_VALUE)
+      CloseHandle(m_pipe);
+
+   if (m_process != nullptr)
+   {
+      if (m_stopEvent != nullptr)
+         SetEvent(m_stopEvent);
+
+      if (WaitForSingleObject(m_process, 5000) != WAIT_OBJECT_0)
+         TerminateProcess(m_process, 1);
+
+      CloseHandle(m_process);
+   }
+
+   if (m_stopEvent != nullptr)
+      CloseHandle(m_stopEvent);
+
+   if (m_pipeEvent != nullptr)
+      CloseHandle(m_pipeEvent);
+}
+
+bool WorkerProcess::Start(const CString& executableFilename)
+{
+   ATLASSERT(m_process == nullptr); // Start() must only be called once
+
+   unsigned int workerNumber = ++s_numStartedWorkers;
+
+   CString pipeName;
+   pipeName.Format(_T("\\\\.\\pipe\\winLAME-worker-%u-%u"), GetCurrentProcessId(), workerNumber);
+
+   CString stopEventName;
+   stopEventName.Format(_T("Local\\winLAME-worker-stop-%u-%u"), GetCurrentProcessId(), workerNumber);
+
+   m_pipe = CreateNamedPipe(pipeName,
+      PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+      PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+      1, c_pipeBufferSize, c_pipeBufferSize, 0, nullptr);
+
+   m_stopEvent = CreateEvent(nullptr, TRUE, FALSE, stopEventName);
+   m_pipeEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+   if (m_pipe == INVALID_HANDLE_VALUE ||
+      m_stopEvent == nullptr ||
+      m_pipeEvent == nullptr)
+   {
+      ATLTRACE(_T("WorkerProcess: couldn't create pipe or events, error %u\n"), GetLastError());
+      return false;
+   }
+
+   CString commandLine;
+   commandLine.Format(_T("\"%s\" %s %s %s"),
+      executableFilename.GetString(),
+      c_workerCommandLineOption,
+      pipeName.GetString(),
+      stopEventName.GetString());
+
+   STARTUPINFO startupInfo = {};
+   startupInfo.cb = sizeof(startupInfo);
+
+   PROCESS_INFORMATION processInfo = {};
+
+   BOOL created = CreateProcess(nullptr, commandLine.GetBuffer(), nullptr, nullptr, FALSE,
+      CREATE_NO_WINDOW, nullptr, nullptr, &startupInfo, &processInfo);
+   commandLine.ReleaseBuffer();
+
+   if (!created)
+   {
+      ATLTRACE(_T("WorkerProcess: couldn't start worker process, error %u\n"), GetLastError());
+      return false;
+   }
+
+   CloseHandle(processInfo.hThread);
+   m_process = processInfo.hProcess;
+
+   OVERLAPPED overlapped = {};
+   overlapped.hEvent = m_pipeEvent;
+
+   DWORD numTransferred = 0;
+   BOOL result = ConnectNamedPipe(m_pipe, &overlapped);
+
+   return WaitPipeOperation(result, overlapped, numTransferred);
+}
+
+bool WorkerProcess::IsAlive() const
+{
+   return m_process != nullptr &&
+      WaitForSingleObject(m_process, 0) == WAIT_TIMEOUT;
+}
+
+bool WorkerProcess::SendJob(const EncoderSettings& encoderSettings, SettingsManager& settingsManager)
+{
+   ResetEvent(m_stopEvent);
+
+   return WriteMessage(FormatJobMessage(encoderSettings, settingsManager));
+}
+
+bool WorkerProcess::ReceiveMessage(Message& message)
+{
+   CStringA text;
+   if (!ReadMessage(text))
+      return false;
+
+   std::vector<CStringA> fields = SplitLine(text);
+
+   if (fields[0] == "state" && fields.size() == 3)
+   {
+      message.m_type = Message::typeState;
+      message.m_percent = atoi(fields[1]) / 100.f;
+      message.m_description = UnescapeText(fields[2]);
+      return true;
+   }
+
+   if (fields[0] == "error" && fields.size() == 5)
+   {
+      message.m_type = Message::typeError;
+      message.m_errorInfo.m_errorNumber = atoi(fields[1]);
+      message.m_errorInfo.m_inputFilename = UnescapeText(fields[2]);
+      message.m_errorInfo.m_moduleName = UnescapeText(fields[3]);
+      message.m_errorInfo.m_errorMessage = UnescapeText(fields[4]);
+      return true;
+   }
+
+   if (fields[0] == "output" && fields.size() == 4)
+   {
+      message.m_type = Message::typeOutput;
+      message.m_numDecodedSamples = _atoi64(fields[1]);
+      message.m_samplerateInHz = atoi(fields[2]);
+      message.m_outputFilename = UnescapeText(fields[3]);
+      return true;
+   }
+
+   if (fields[0] == "finished" && fields.size() == 4)
+   {
+      message.m_type = Message::typeFinished;
+      message.m_errorCode = atoi(fields[1]);
+      message.m_stopped = fields[2] == "1";
+      message.m_copiedOutput = fields[3] == "1";
+      return true;
+   }
+
+   ATLTRACE(_T("WorkerProcess: received invalid message\n"));
+   return false;
+}
+
+void WorkerProcess::StopJob()
+{
+   if (m_stopEvent != nullptr)
+      SetEvent(m_stopEvent);
+}
+
+CStringA WorkerProcess::FormatJobMessage(const EncoderSettings& encoderSettings, SettingsManager& settingsManager)
+{
+   CStringA message("job\n");
+
+   message += "input\t" + EscapeText(encoderSettings.m_inputFilename) + "\n";
+   message += "outputFolder\t" + EscapeText(encoderSettings.m_outputFolder) + "\n";
+   message += "outputFilename\t" + EscapeText(encoderSettings.m_outputFilename) + "\n";
+
+   message.AppendFormat("outputSameFolder\t%d\n", encoderSettings.m_outputSameFolder ? 1 : 0);
+   message.AppendFormat("outputModuleID\t%d\n", encoderSettings.m_outputModuleID);
+   message.AppendFormat("overwriteExisting\t%d\n", encoderSettings.m_overwriteExisting ? 1 : 0);
+   message.AppendFormat("deleteInputAfterEncode\t%d\n", encoderSettings.m_deleteInputAfterEncode ? 1 : 0);
+   message.AppendFormat("verifyOutput\t%d\n", encoderSettings.m_verifyOutput ? 1 : 0);
+   message.AppendFormat("useTrackInfo\t%d\n", encoderSettings.m_useTrackInfo ? 1 : 0);
+   message.AppendFormat("allowPassThrough\t%d\n", encoderSettings.m_allowPassThrough ? 1 : 0);
+   message.AppendFormat("rangeStartFrame\t%u\n", encoderSettings.m_rangeStartFrame);
+   message.AppendFormat("rangeEndFrame\t%u\n", encoderSettings.m_rangeEndFrame);
+
+   const TranscodeCache* transcodeCache = encoderSettings.m_transcodeCache;
+   if (transcodeCache != nullptr && transcodeCache->IsEnabled())
+   {
+      message += "transcodeCacheFolder\t" + EscapeText(transcodeCache->GetCacheFolder()) + "\n";
+      message.AppendFormat("transcodeCacheMaxSize\t%I64u\n", transcodeCache->GetMaxSize());
+   }
+
+   for (const EncoderOutputSettings& outputSettings : encoderSettings.m_additionalOutputs)
+   {
+      message.AppendFormat("additionalOutput\t%d\t", outputSettings.m_outputModuleID);
+      message += EscapeText(outputSettings.m_outputFilename) + "\n";
+   }
+
+   for (int variableId = VarFirst + 1; variableId < VarLast; variableId++)
+   {
+      message.AppendFormat("setting\t%d\t%d\n", variableId,
+         settingsManager.QueryValueInt(static_cast<unsigned short>(variableId)));
+   }
+
+   const TrackInfo& trackInfo = encoderSettings.m_trackInfo;
+
+   for (int type = TrackInfoTitle; type <= TrackInfoComposer; type++)
+   {
+      bool avail = false;
+      CString text = trackInfo.GetTextInfo(static_cast<TrackInfoTextType>(type), avail);
+      if (avail)
+      {
+         message.AppendFormat("text\t%d\t", type);
+         message += EscapeText(text) + "\n";
+      }
+   }
+
+   for (int type = TrackInfoYear; type <= TrackInfoDiscNumber; type++)
+   {
+      bool avail = false;
+      int number = trackInfo.GetNumberInfo(static_cast<TrackInfoNumberType>(type), avail);
+      if (avail)
+         message.AppendFormat("number\t%d\t%d\n", type, number);
+   }
+
+   std::vector<unsigned char> binaryInfo;
+   if (trackInfo.GetBinaryInfo(TrackInfoFrontCover, binaryInfo))
+   {
+      message.AppendFormat("binary\t%d\t", TrackInfoFrontCover);
+      message += FormatHexText(binaryInfo) + "\n";
+   }
+
+   return message;
+}
+
+bool WorkerProcess::ParseJobMessage(const CStringA& message, EncoderSettings& encoderSettings, SettingsManager& settingsManager,
+   CString& transcodeCacheFolder, ULONGLONG& transcodeCacheMaxSize)
+{
+   transcodeCacheFolder.Empty();
+   transcodeCacheMaxSize = 0;
+
+   std::vector<CStringA> lines = SplitMessage(message);
+   if (lines.empty() || lines[0] != "job")
+      return false;
+
+   for (size_t index = 1; index < lines.size(); index++)
+   {
+      std::vector<CStringA> fields = SplitLine(lines[index]);
+      if (fields.size() < 2)
+         return false;
+
+      const CStringA& key = fields[0];
+      const CStringA& value = fields[1];
+
+      if (key == "input")
+         encoderSettings.m_inputFilename = UnescapeText(value);
+      else if (key == "outputFolder")
+         encoderSettings.m_outputFolder = UnescapeText(value);
+      else if (key == "outputFilename")
+         encoderSettings.m_outputFilename = UnescapeText(value);
+      else if (key == "outputSameFolder")
+         encoderSettings.m_outputSameFolder = value == "1";
+      else if (key == "outputModuleID")
+         encoderSettings.m_outputModuleID = atoi(value);
+      else if (key == "overwriteExisting")
+         encoderSettings.m_overwriteExisting = value == "1";
+      else if (key == "deleteInputAfterEncode")
+         encoderSettings.m_deleteInputAfterEncode = value == "1";
+      else if (key == "verifyOutput")
+         encoderSettings.m_verifyOutput = value == "1";
+      else if (key == "useTrackInfo")
+         encoderSettings.m_useTrackInfo = value == "1";
+      else if (key == "allowPassThrough")
+         encoderSettings.m_allowPassThrough = value == "1";
+      else if (key == "rangeStartFrame")
+         encoderSettings.m_rangeStartFrame = strtoul(value, nullptr, 10);
+      else if (key == "rangeEndFrame")
+         encoderSettings.m_rangeEndFrame = strtoul(value, nullptr, 10);
+      else if (key == "transcodeCacheFolder")
+         transcodeCacheFolder = UnescapeText(value);
+      else if (key == "transcodeCacheMaxSize")
+         transcodeCacheMaxSize = _strtoui64(value, nullptr, 10);
+      else if (fields.size() == 3)
+      {
+         if (key == "additionalOutput")
+         {
+            EncoderOutputSettings outputSettings(atoi(value));
+            outputSettings.m_outputFilename = UnescapeText(fields[2]);
+            encoderSettings.m_additionalOutputs.push_back(outputSettings);
+         }
+         else if (key == "setting")
+            settingsManager.setValue(static_cast<unsigned short>(atoi(value)), atoi(fields[2]));
+         else if (key == "text")
+            encoderSettings.m_trackInfo.SetTextInfo(static_cast<TrackInfoTextType>(atoi(value)), UnescapeText(fields[2]));
+         else if (key == "number")
+            encoderSettings.m_trackInfo.SetNumberInfo(static_cast<TrackInfoNumberType>(atoi(value)), atoi(fields[2]));
+         else if (key == "binary")
+            encoderSettings.m_trackInfo.SetBinaryInfo(static_cast<TrackInfoBinaryType>(atoi(value)), ParseHexText(fields[2]));
+         else
+            return false;
+      }
+      else
+         return false;
+   }
+
+   return true;
+}
+
+bool WorkerProcess::IsWorkerCommandLine(LPCTSTR commandLine)
+{
+   return commandLine != nullptr &&
+      _tcsncmp(commandLine, c_workerCommandLineOption, _tcslen(c_workerCommandLineOption)) == 0;
+}
+
+int WorkerProcess::RunWorker(LPCTSTR commandLine)
+{
+   // same DLL search path as the winLAME process
+   SetDllDirectory(_T(""));
+
+   CommandLineParser parser(commandLine);
+
+   CString option, pipeName, stopEventName;
+   if (!parser.GetNext(option) ||
+      !parser.GetNext(pipeName) ||
+      !parser.GetNext(stopEventName))
+      return 1;
+
+   HANDLE pipe = CreateFile(pipeName, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+   if (pipe == INVALID_HANDLE_VALUE)
+      return 1;
+
+   DWORD pipeMode = PIPE_READMODE_MESSAGE;
+   SetNamedPipeHandleState(pipe, &pipeMode, nullptr, nullptr);
+
+   HANDLE stopEvent = OpenEvent(SYNCHRONIZE, FALSE, stopEventName);
+   if (stopEvent == nullptr)
+   {
+      CloseHandle(pipe);
+      return 1;
+   }
+
+   HRESULT hr = ::CoInitialize(nullptr);
+   ATLASSERT(SUCCEEDED(hr));
+   UNUSED(hr);
+
+   {
+      // the encoder resolves the module manager from the IoC container
+      IoCContainer& ioc = IoCContainer::Current();
+
+      LameNogapInstanceManager lameNogapInstanceManager;
+      ioc.Register<LameNogapInstanceManager>(std::ref(lameNogapInstanceManager));
+
+      ModuleManagerImpl moduleManager;
+      ioc.Register<ModuleManager>(std::ref(moduleManager));
+
+      // the worker process ends when the winLAME process closes the pipe
+      CStringA jobMessage;
+      while (ReadPipeMessage(pipe, jobMessage))
+         RunWorkerJob(pipe, stopEvent, jobMessage);
+   }
+
+   CloseHandle(stopEvent);
+   CloseHandle(pipe);
+
+   ::CoUninitialize();
+
+   return 0;
+}
+
+bool WorkerProcess::WriteMessage(const CStringA& message)
+{
+   OVERLAPPED overlapped = {};
+   overlapped.hEvent = m_pipeEvent;
+
+   DWORD numWritten = 0;
+   BOOL result = WriteFile(m_pipe, message.GetString(), static_cast<DWORD>(message.GetLength()), nullptr, &overlapped);
+
+   return WaitPipeOperation(result, overlapped, numWritten) &&
+      numWritten == static_cast<DWORD>(message.GetLength());
+}
+
+bool WorkerProcess::ReadMessage(CStringA& message)
+{
+   message.Empty();
+
+   for (;;)
+   {
+      char buffer[4096];
+
+      OVERLAPPED overlapped = {};
+      overlapped.hEvent = m_pipeEvent;
+
+      DWORD numRead = 0;
+      BOOL result = ReadFile(m_pipe, buffer, sizeof(buffer), nullptr, &overlapped);
+
+      bool completed = WaitPipeOperation(result, overlapped, numRead);
+      if (!completed && GetLastError() != ERROR_MORE_DATA)
+         return false;
+
+      message.Append(buffer, static_cast<int>(numRead));
+
+      if (completed)
+         return true;
+   }
+}
+
+bool WorkerProcess::WaitPipeOperation(BOOL result, OVERLAPPED& overlapped, DWORD& numTransferred)
+{
+   if (!result)
+   {
+      DWORD error = GetLastError();
+
+      if (error == ERROR_PIPE_CONNECTED)
+         return true;
+
+      if (error != ERROR_IO_PENDING &&
+         error != ERROR_MORE_DATA)
+         return false;
+
+      // a crashed worker process doesn't complete the operation
+      HANDLE handles[2] = { overlapped.hEvent, m_process };
+
+      if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+      {
+         CancelIoEx(m_pipe, &overlapped);
+         GetOverlappedResult(m_pipe, &overlapped, &numTransferred, TRUE);
+
+         SetLastError(ERROR_BROKEN_PIPE);
+         return false;
+      }
+   }
+
+   return GetOverlappedResult(m_pipe, &overlapped, &numTransferred, FALSE) != FALSE;
+}
@@ -0,0 +1,135 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerProcess.hpp
+/// \brief worker process that encodes files outside of the winLAME process
+//
+#pragma once
+
+#include "EncoderInterface.hpp"
+#include "EncoderSettings.hpp"
+
+class SettingsManager;
+
+namespace Encoder
+{
+   /// \brief worker process that encodes files
+   /// \details A worker process is a second instance of the winLAME
+   /// executable, started with the --encoder-worker command line option. It
+   /// receives encoding jobs over a named pipe, encodes them with its own
+   /// encoder and sends back the encoder state, errors and the result. When
+   /// an input or output module crashes, only the worker process ends, and
+   /// the winLAME process keeps running. The methods are used by the winLAME
+   /// process; RunWorker() is the main function of the worker process.
+   class WorkerProcess
+   {
+   public:
+      /// message received from the worker process
+      struct Message
+      {
+         /// message type
+         enum Type
+         {
+            typeState = 0, ///< encoder state changed
+            typeError,     ///< encoder reported an error
+            typeOutput,    ///< main output was written
+            typeFinished,  ///< encoding job finished
+         };
+
+         Type m_type = typeState;      ///< message type
+         float m_percent = 0.f;        ///< percent done; typeState only
+         CString m_description;        ///< encoding description; typeState only
+         ErrorInfo m_errorInfo;        ///< error info; typeError only
+         CString m_outputFilename;     ///< main output filename; typeOutput only
+         __int64 m_numDecodedSamples = 0; ///< number of decoded samples; typeOutput only
+         int m_samplerateInHz = 0;     ///< sample rate of the decoded samples; typeOutput only
+         int m_errorCode = 0;          ///< encoder error code; typeFinished only
+         bool m_stopped = false;       ///< indicates if the job was stopped; typeFinished only
+         bool m_copiedOutput = false;  ///< indicates if an output was copied instead of encoded; typeFinished only
+      };
+
+      /// ctor
+      WorkerProcess();
+      /// dtor; ends worker process
+      ~WorkerProcess();
+
+      /// deleted copy ctor
+      WorkerProcess(const WorkerProcess&) = delete;
+      /// deleted copy assignment operator
+      WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+      /// starts worker process, using given executable; returns false when
+      /// the process couldn't be started
+      bool Start(const CString& executableFilename);
+
+      /// returns if the worker process is still running
+      bool IsAlive() const;
+
+      /// sends encoding job to the worker process
+      bool SendJob(const EncoderSettings& encoderSettings, SettingsManager& settingsManager);
+
+      /// receives next message from the worker process; blocks until a
+      /// message arrives; returns false when the worker process ended
+      bool ReceiveMessage(Message& message);
+
+      /// stops the currently running job; may be called from any thread
+      void StopJob();
+
+      /// \brief formats encoding job message
+      /// \details The transcode cache isn't shared with the worker process;
+      /// only its folder and size are sent.
+      static CStringA FormatJobMessage(const EncoderSettings& encoderSettings, SettingsManager& settingsManager);
+
+      /// parses encoding job message; returns the transcode cache folder and
+      /// size separately, or an empty folder when no cache is used; returns
+      /// false when the message is invalid
+      static bool ParseJobMessage(const CStringA& message, EncoderSettings& encoderSettings, SettingsManager& settingsManager,
+         CString& transcodeCacheFolder, ULONGLONG& transcodeCacheMaxSize);
+
+      /// returns if the command line starts a worker process
+      static bool IsWorkerCommandLine(LPCTSTR commandLine);
+
+      /// main function of the worker process; returns the process exit code
+      static int RunWorker(LPCTSTR commandLine);
+
+   private:
+      /// writes a message to the pipe
+      bool WriteMessage(const CStringA& message);
+
+      /// reads a message from the pipe
+      bool ReadMessage(CStringA& message);
+
+      /// waits until an overlapped pipe operation completes, or the worker
+      /// process ends
+      bool WaitPipeOperation(BOOL result, OVERLAPPED& overlapped, DWORD& numTransferred);
+
+   private:
+      /// worker process handle
+      HANDLE m_process;
+
+      /// server end of the named pipe, opened for overlapped I/O
+      HANDLE m_pipe;
+
+      /// event signaled to stop the currently running job
+      HANDLE m_stopEvent;
+
+      /// event used for overlapped pipe operations
+      HANDLE m_pipeEvent;
+   };
+
+} // namespace Encoder
@@ -0,0 +1,65 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerProcessPool.cpp
+/// \brief pool of worker processes that encode files
+//
+#include "stdafx.h"
+#include "WorkerProcessPool.hpp"
+
+using Encoder::WorkerProcessPool;
+using Encoder::WorkerProcess;
+
+WorkerProcessPool::WorkerProcessPool(const CString& executableFilename)
+   :m_executableFilename(executableFilename)
+{
+}
+
+std::shared_ptr<WorkerProcess> WorkerProcessPool::Acquire()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      while (!m_idleWorkerProcesses.empty())
+      {
+         std::shared_ptr<WorkerProcess> workerProcess = m_idleWorkerProcesses.back();
+         m_idleWorkerProcesses.pop_back();
+
+         if (workerProcess->IsAlive())
+            return workerProcess;
+      }
+   }
+
+   // start the new process outside of the lock, since it takes a while
+   std::shared_ptr<WorkerProcess> workerProcess = std::make_shared<WorkerProcess>();
+
+   if (!workerProcess->Start(m_executableFilename))
+      return nullptr;
+
+   return workerProcess;
+}
+
+void WorkerProcessPool::Release(std::shared_ptr<WorkerProcess> workerProcess)
+{
+   if (workerProcess == nullptr ||
+      !workerProcess->IsAlive())
+      return;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_idleWorkerProcesses.push_back(workerProcess);
+}
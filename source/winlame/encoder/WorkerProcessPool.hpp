@@ -0,0 +1,67 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerProcessPool.hpp
+/// \brief pool of worker processes that encode files
+//
+#pragma once
+
+#include "WorkerProcess.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Encoder
+{
+   /// \brief pool of worker processes
+   /// \details Keeps idle worker processes running, so that each encoding
+   /// job doesn't have to start a new process. A worker process that ended,
+   /// e.g. because a module crashed, isn't returned to the pool; the next
+   /// job starts a new worker process instead. All methods may be called by
+   /// multiple task threads at the same time.
+   class WorkerProcessPool
+   {
+   public:
+      /// ctor; uses given executable for the worker processes
+      explicit WorkerProcessPool(const CString& executableFilename);
+
+      /// deleted copy ctor
+      WorkerProcessPool(const WorkerProcessPool&) = delete;
+      /// deleted copy assignment operator
+      WorkerProcessPool& operator=(const WorkerProcessPool&) = delete;
+
+      /// returns an idle worker process, or starts a new one; returns
+      /// nullptr when no worker process could be started
+      std::shared_ptr<WorkerProcess> Acquire();
+
+      /// returns worker process to the pool after its job finished; worker
+      /// processes that ended are discarded
+      void Release(std::shared_ptr<WorkerProcess> workerProcess);
+
+   private:
+      /// executable filename of the worker processes
+      CString m_executableFilename;
+
+      /// mutex protecting the idle worker processes
+      std::mutex m_mutex;
+
+      /// idle worker processes
+      std::vector<std::shared_ptr<WorkerProcess>> m_idleWorkerProcesses;
+   };
+
+} // namespace Encoder
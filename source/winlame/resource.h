@@ -49,6 +49,7 @@
 #define IDD_PAGE_OPUS_SETTINGS          1040
 #define IDD_PAGE_FINISH                 1041
 #define IDD_VIEW_TASKDETAILS            1042
+#define IDD_PAGE_FLAC_SETTINGS          1043
 #define IDC_WIZARDPAGE_HELP             3002
 #define IDC_STATIC_TIMECOUNT            3010
 #define IDC_INPUT_BUTTON_PLAY           3100
@@ -172,6 +173,9 @@
 #define IDC_OPUS_RADIO_BRCMODE1         4504
 #define IDC_OPUS_RADIO_BRCMODE2         4505
 #define IDC_OPUS_RADIO_BRCMODE3         4506
+#define IDC_FLAC_SLIDER_COMPRESSION     4510
+#define IDC_FLAC_STATIC_COMPRESSION     4511
+#define IDC_FLAC_CHECK_MULTITHREADED    4512
 #define IDC_STATIC_ICON_TASK_TYPE       4600
 #define IDC_STATIC_TEXT_TASK_TYPE       4601
 #define IDC_STATIC_LABEL_FILENAME_TRACK 4602
@@ -180,8 +184,8 @@
 #define IDC_SETTINGS_COMBO_LANGUAGE     5000
 #define IDC_SETTINGS_EDIT_CPU_CORES     5001
 #define IDC_SETTINGS_SPIN_CPU_CORES     5002
-#define IDC_SETTINGS_STATIC_NOTE_CPU_CORES 5003
 #define IDC_SETTINGS_CHECK_AUTO_TASKS   5004
+#define IDC_SETTINGS_CHECK_ALLOW_PASS_THROUGH 5005
 #define IDC_STATIC_COVERART             5100
 #define IDC_CRASH_STATIC_TEXT           6000
 #define IDC_CRASH_LIST_RESULTS          6001
@@ -296,6 +300,14 @@
 #define IDS_PLAYLIST_TASK_DESCRIPTION_SU 41613
 #define IDS_EJECT_CD_TASK_TITLE         41614
 #define IDS_EJECT_CD_TASK_DESCRIPTION   41615
+#define IDS_ENCODER_DECODE_TIME_SAVED   41616
+#define IDS_ENCODER_SEEK_ERROR          41617
+#define IDS_ENCODER_PASS_THROUGH        41618
+#define IDS_ENCODER_VERIFY_FAILED       41619
+#define IDS_CDEXTRACT_STATISTICS_FF     41620
+#define IDS_BATCH_JOURNAL_RESUME_U      41621
+#define IDS_ENCODER_WORKER_PROCESS_START_FAILED 41622
+#define IDS_ENCODER_WORKER_PROCESS_ENDED 41623
 #define IDS_FILTER_AAC_INPUT            41700
 #define IDS_FILTER_BASS_INPUT           41701
 #define IDS_FILTER_BASS_WMA_INPUT       41702
@@ -343,6 +355,7 @@
 #define IDS_FORMAT_INFO_OPUS_OUTPUT     42025
 #define IDS_FORMAT_INFO_MPG123_INPUT    42026
 #define IDS_FORMAT_INFO_OPUS_OUTPUT_DOWNMIX 42027
+#define IDS_FORMAT_INFO_FLAC_OUTPUT     42028
 #define IDS_FREEDB_LIST_ALBUMNAME       42100
 #define IDS_FREEDB_LIST_GENRE           42101
 #define IDS_OPUS_INVALID_BITRATE        42200
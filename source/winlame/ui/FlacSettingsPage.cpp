@@ -0,0 +1,115 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2016-2018 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlacSettingsPage.cpp
+/// \brief FLAC encoder settings page
+//
+#include "stdafx.h"
+#include "FlacSettingsPage.hpp"
+#include "WizardPageHost.hpp"
+#include <ulib/IoCContainer.hpp>
+#include "UISettings.hpp"
+#include "OutputSettingsPage.hpp"
+#include "PresetSelectionPage.hpp"
+#include "FinishPage.hpp"
+
+using namespace UI;
+
+LRESULT FlacSettingsPage::OnInitDialog(UINT /*uMsg*/, WPARAM /*wParam*/, LPARAM /*lParam*/, BOOL& /*bHandled*/)
+{
+   DoDataExchange(DDX_LOAD);
+   DlgResize_Init(false, false);
+
+   // set up range of slider control
+   m_sliderCompressionLevel.SetRangeMin(0);
+   m_sliderCompressionLevel.SetRangeMax(8);
+   m_sliderCompressionLevel.SetTicFreq(1);
+
+   LoadData();
+
+   return 1;
+}
+
+LRESULT FlacSettingsPage::OnButtonOK(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hWndCtl*/, BOOL& /*bHandled*/)
+{
+   SaveData();
+
+   m_pageHost.SetWizardPage(std::shared_ptr<WizardPage>(new FinishPage(m_pageHost)));
+
+   return 0;
+}
+
+LRESULT FlacSettingsPage::OnButtonCancel(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hWndCtl*/, BOOL& /*bHandled*/)
+{
+   SaveData();
+
+   return 0;
+}
+
+LRESULT FlacSettingsPage::OnButtonBack(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hWndCtl*/, BOOL& /*bHandled*/)
+{
+   SaveData();
+
+   PresetManagerInterface& presetManager = IoCContainer::Current().Resolve<PresetManagerInterface>();
+
+   if (m_uiSettings.preset_avail && presetManager.getPresetCount() > 0)
+      m_pageHost.SetWizardPage(std::shared_ptr<WizardPage>(new PresetSelectionPage(m_pageHost)));
+   else
+      m_pageHost.SetWizardPage(std::shared_ptr<WizardPage>(new OutputSettingsPage(m_pageHost)));
+
+   return 0;
+}
+
+void FlacSettingsPage::UpdateCompressionLevel()
+{
+   int pos = m_sliderCompressionLevel.GetPos();
+
+   CString text;
+   text.Format(_T("%i"), pos);
+   SetDlgItemText(IDC_FLAC_STATIC_COMPRESSION, text);
+}
+
+void FlacSettingsPage::LoadData()
+{
+   SettingsManager& mgr = m_uiSettings.settings_manager;
+
+   // compression level slider
+   int value = mgr.queryValueInt(FlacCompressionLevel);
+   if (value < 0 || value > 8)
+      value = 5;
+
+   m_sliderCompressionLevel.SetPos(value);
+
+   UpdateCompressionLevel();
+
+   // multithreaded encoding
+   CheckDlgButton(IDC_FLAC_CHECK_MULTITHREADED,
+      mgr.queryValueInt(FlacMultithreaded) != 0 ? BST_CHECKED : BST_UNCHECKED);
+}
+
+void FlacSettingsPage::SaveData()
+{
+   DoDataExchange(DDX_SAVE);
+
+   SettingsManager& mgr = m_uiSettings.settings_manager;
+
+   mgr.setValue(FlacCompressionLevel, m_sliderCompressionLevel.GetPos());
+
+   mgr.setValue(FlacMultithreaded,
+      IsDlgButtonChecked(IDC_FLAC_CHECK_MULTITHREADED) == BST_CHECKED ? 1 : 0);
+}
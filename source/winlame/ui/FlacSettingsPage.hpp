@@ -0,0 +1,111 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2016-2018 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ui\FlacSettingsPage.hpp
+/// \brief FLAC encoder settings page
+//
+#pragma once
+
+#include "WizardPage.hpp"
+#include "resource.h"
+
+struct UISettings;
+
+namespace UI
+{
+   /// \brief FLAC settings page
+   class FlacSettingsPage :
+      public WizardPage,
+      public CWinDataExchange<FlacSettingsPage>,
+      public CDialogResize<FlacSettingsPage>
+   {
+   public:
+      /// ctor
+      explicit FlacSettingsPage(WizardPageHost& pageHost)
+         :WizardPage(pageHost, IDD_PAGE_FLAC_SETTINGS, WizardPage::typeCancelBackNext),
+         m_uiSettings(IoCContainer::Current().Resolve<UISettings>())
+      {
+      }
+      /// dtor
+      ~FlacSettingsPage()
+      {
+      }
+
+   private:
+      friend CDialogResize<FlacSettingsPage>;
+
+      BEGIN_DDX_MAP(FlacSettingsPage)
+         DDX_CONTROL_HANDLE(IDC_FLAC_SLIDER_COMPRESSION, m_sliderCompressionLevel)
+      END_DDX_MAP()
+
+      BEGIN_DLGRESIZE_MAP(FlacSettingsPage)
+      END_DLGRESIZE_MAP()
+
+      BEGIN_MSG_MAP(FlacSettingsPage)
+         MESSAGE_HANDLER(WM_INITDIALOG, OnInitDialog)
+         COMMAND_HANDLER(IDOK, BN_CLICKED, OnButtonOK)
+         COMMAND_HANDLER(IDCANCEL, BN_CLICKED, OnButtonCancel)
+         COMMAND_HANDLER(ID_WIZBACK, BN_CLICKED, OnButtonBack)
+         MESSAGE_HANDLER(WM_HSCROLL, OnHScroll)
+         CHAIN_MSG_MAP(CDialogResize<FlacSettingsPage>)
+         REFLECT_NOTIFICATIONS()
+      END_MSG_MAP()
+
+      /// inits the page
+      LRESULT OnInitDialog(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL& bHandled);
+
+      /// called when page is left with Next button
+      LRESULT OnButtonOK(WORD wNotifyCode, WORD wID, HWND hWndCtl, BOOL& bHandled);
+
+      /// called when page is left with Cancel button
+      LRESULT OnButtonCancel(WORD wNotifyCode, WORD wID, HWND hWndCtl, BOOL& bHandled);
+
+      /// called when page is left with Back button
+      LRESULT OnButtonBack(WORD wNotifyCode, WORD wID, HWND hWndCtl, BOOL& bHandled);
+
+      /// called when slider is moved
+      LRESULT OnHScroll(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL& bHandled)
+      {
+         // check if the compression level slider was moved
+         if ((HWND)lParam == GetDlgItem(IDC_FLAC_SLIDER_COMPRESSION))
+            UpdateCompressionLevel();
+         return 0;
+      }
+
+      /// updates compression level value
+      void UpdateCompressionLevel();
+
+      /// loads settings data into controls
+      void LoadData();
+
+      /// saves settings data from controls
+      void SaveData();
+
+   private:
+      // controls
+
+      /// compression level slider
+      CTrackBarCtrl m_sliderCompressionLevel;
+
+      // model
+
+      /// settings
+      UISettings& m_uiSettings;
+   };
+
+} // namespace UI
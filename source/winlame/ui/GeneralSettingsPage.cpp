@@ -23,6 +23,7 @@
 #include "GeneralSettingsPage.hpp"
 #include "LanguageResourceManager.hpp"
 #include "LangCountryMapper.hpp"
+#include "TaskManager.hpp"
 #include <thread>
 
 using UI::GeneralSettingsPage;
@@ -78,8 +79,6 @@ LRESULT GeneralSettingsPage::OnInitDialog(UINT /*uMsg*/, WPARAM /*wParam*/, LPAR
       m_spinCpuCores.SetBuddy(m_editCpuCores);
       m_spinCpuCores.SetFixedValues(CpuCores, sizeof(CpuCores) / sizeof(CpuCores[0]));
 
-      m_staticNoteCpuCores.ShowWindow(SW_HIDE);
-
       CString checkBoxText;
       m_checkBoxAutoTasks.GetWindowText(checkBoxText);
 
@@ -115,6 +114,10 @@ LRESULT GeneralSettingsPage::OnButtonOK(WORD /*wNotifyCode*/, WORD /*wID*/, HWND
       m_settings.m_taskManagerConfig.m_uiUseNumTasks = 64;
    }
 
+   // the number of tasks is changed without restarting
+   TaskManager& taskManager = IoCContainer::Current().Resolve<TaskManager>();
+   taskManager.UpdateConfig(m_settings.m_taskManagerConfig);
+
    int selectedLangIndex = m_comboLanguages.GetCurSel();
    if (selectedLangIndex != -1)
    {
@@ -136,15 +139,5 @@ LRESULT GeneralSettingsPage::OnCheckAutoTasks(WORD /*wNotifyCode*/, WORD /*wID*/
    m_spinCpuCores.EnableWindow(!isChecked);
    m_editCpuCores.EnableWindow(!isChecked);
 
-   m_staticNoteCpuCores.ShowWindow(SW_SHOW);
-
-   return 0;
-}
-
-LRESULT GeneralSettingsPage::OnChangeEditCpuCores(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hWndCtl*/, BOOL& /*bHandled*/)
-{
-   if (m_staticNoteCpuCores.IsWindow())
-      m_staticNoteCpuCores.ShowWindow(SW_SHOW);
-
    return 0;
 }
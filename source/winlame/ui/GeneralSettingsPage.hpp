@@ -60,21 +60,21 @@ namespace UI
          DDX_INT(IDC_SETTINGS_EDIT_CPU_CORES, m_settings.m_taskManagerConfig.m_uiUseNumTasks)
          DDX_CONTROL_HANDLE(IDC_SETTINGS_EDIT_CPU_CORES, m_editCpuCores)
          DDX_CONTROL(IDC_SETTINGS_SPIN_CPU_CORES, m_spinCpuCores)
-         DDX_CONTROL_HANDLE(IDC_SETTINGS_STATIC_NOTE_CPU_CORES, m_staticNoteCpuCores)
          DDX_CHECK(IDC_SETTINGS_CHECK_AUTO_TASKS, m_settings.m_taskManagerConfig.m_bAutoTasksPerCpu)
          DDX_CONTROL_HANDLE(IDC_SETTINGS_CHECK_AUTO_TASKS, m_checkBoxAutoTasks)
+         DDX_CHECK(IDC_SETTINGS_CHECK_ALLOW_PASS_THROUGH, m_settings.allow_pass_through)
       END_DDX_MAP()
 
       BEGIN_DLGRESIZE_MAP(GeneralSettingsPage)
          DLGRESIZE_CONTROL(IDC_SETTINGS_COMBO_LANGUAGE, DLSZ_SIZE_X)
          DLGRESIZE_CONTROL(IDC_SETTINGS_CHECK_AUTO_TASKS, DLSZ_SIZE_X)
+         DLGRESIZE_CONTROL(IDC_SETTINGS_CHECK_ALLOW_PASS_THROUGH, DLSZ_SIZE_X)
       END_DLGRESIZE_MAP()
 
       BEGIN_MSG_MAP(GeneralSettingsPage)
          MESSAGE_HANDLER(WM_INITDIALOG, OnInitDialog)
          COMMAND_HANDLER(IDOK, BN_CLICKED, OnButtonOK)
          COMMAND_HANDLER(IDC_SETTINGS_CHECK_AUTO_TASKS, BN_CLICKED, OnCheckAutoTasks)
-         COMMAND_HANDLER(IDC_SETTINGS_EDIT_CPU_CORES, EN_CHANGE, OnChangeEditCpuCores)
          CHAIN_MSG_MAP(CDialogResize<GeneralSettingsPage>)
          REFLECT_NOTIFICATIONS()
       END_MSG_MAP()
@@ -88,9 +88,6 @@ namespace UI
       /// called when the "auto tasks" check changes
       LRESULT OnCheckAutoTasks(WORD wNotifyCode, WORD wID, HWND hWndCtl, BOOL& bHandled);
 
-      /// called when the CPU cores edit field changes
-      LRESULT OnChangeEditCpuCores(WORD wNotifyCode, WORD wID, HWND hWndCtl, BOOL& bHandled);
-
    private:
       /// settings
       UISettings& m_settings;
@@ -112,9 +109,6 @@ namespace UI
       /// CPU cores spin button control
       FixedValueSpinButtonCtrl m_spinCpuCores;
 
-      /// static control with a note about the changed CPU cores setting
-      CStatic m_staticNoteCpuCores;
-
       /// checkbox for automatic choosing of number of tasks
       CButton m_checkBoxAutoTasks;
    };
@@ -84,11 +84,33 @@ LRESULT InputFilesPage::OnButtonOK(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hW
       return 1; // prevent leaving dialog
    }
 
-   // add encoder job for every file in list
+   // add encoder job for every file in list; disc images referenced by cue
+   // sheets are split into one job per track. The file lengths determined
+   // while adding the files are passed on, so that the encoder tasks don't
+   // have to read the files again to estimate their run time.
    for (int i = 0; i < max; i++)
    {
       CString filename = m_listViewInputFiles.GetFileName(i);
-      m_uiSettings.encoderjoblist.push_back(Encoder::EncoderJob(filename));
+      int lengthInSeconds = std::max(0, m_listViewInputFiles.GetFileLength(i));
+
+      CString key = filename;
+      key.MakeLower();
+
+      auto iter = m_uiSettings.cuesheet_track_jobs.find(key);
+      if (iter != m_uiSettings.cuesheet_track_jobs.end())
+      {
+         for (Encoder::EncoderJob job : iter->second)
+         {
+            job.InputLengthInSeconds(static_cast<unsigned int>(lengthInSeconds));
+            m_uiSettings.encoderjoblist.push_back(job);
+         }
+      }
+      else
+      {
+         Encoder::EncoderJob job(filename);
+         job.InputLengthInSeconds(static_cast<unsigned int>(lengthInSeconds));
+         m_uiSettings.encoderjoblist.push_back(job);
+      }
    }
 
    m_uiSettings.m_bFromInputFilesPage = true;
@@ -287,6 +309,9 @@ void InputFilesPage::AddFiles(const std::vector<CString>& inputFilesList)
 
    InsertFilenames(parser.FileList());
 
+   for (const auto& trackJobs : parser.CueSheetTrackJobs())
+      m_uiSettings.cuesheet_track_jobs[trackJobs.first] = trackJobs.second;
+
    if (!parser.PlaylistName().IsEmpty())
    {
       CString name = Path::FilenameOnly(parser.PlaylistName());
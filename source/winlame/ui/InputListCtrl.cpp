@@ -128,6 +128,14 @@ CString InputListCtrl::GetFileName(int index)
    return entry == nullptr ? CString() : entry->filename;
 }
 
+int InputListCtrl::GetFileLength(int index)
+{
+   AudioFileEntry* entry =
+      reinterpret_cast<AudioFileEntry*>(GetItemData(index));
+
+   return entry == nullptr ? -1 : entry->length;
+}
+
 unsigned int InputListCtrl::GetTotalLength()
 {
    unsigned int nLength = 0;
@@ -60,6 +60,9 @@ namespace UI
       /// returns file name
       CString GetFileName(int index);
 
+      /// returns length of file, in seconds; -1 when not known yet
+      int GetFileLength(int index);
+
       /// returns total length of files in list
       unsigned int GetTotalLength();
 
@@ -34,6 +34,7 @@
 #include "InputCDPage.hpp"
 #include "ResourceInstanceSwitcher.hpp"
 #include "DropFilesManager.hpp"
+#include "BatchJournal.hpp"
 #include <ulib/CommandLineParser.hpp>
 
 using namespace UI;
@@ -280,6 +281,15 @@ LRESULT MainFrame::OnCheckCommandLine(UINT /*uMsg*/, WPARAM /*wParam*/, LPARAM /
       app.SetAlreadyReadCommandLine();
    }
 
+   // offer to encode the remaining files of an interrupted batch
+   std::vector<CString> filenames;
+   if (app.AskResumeInterruptedJobs(m_hWnd, filenames))
+   {
+      WizardPageHost host;
+      host.SetWizardPage(std::make_shared<InputFilesPage>(host, filenames));
+      host.Run(m_hWnd);
+   }
+
    return 0;
 }
 
@@ -319,6 +329,9 @@ LRESULT MainFrame::OnTasksStopAll(WORD /*wNotifyCode*/, WORD /*wID*/, HWND /*hWn
 {
    m_taskManager.StopAll();
 
+   // the stopped jobs aren't resumed on the next start
+   IoCContainer::Current().Resolve<Encoder::BatchJournal>().FinishBatch();
+
    return 0;
 }
 
@@ -33,6 +33,7 @@
 #include "AACSettingsPage.hpp"
 #include "WMASettingsPage.hpp"
 #include "OpusSettingsPage.hpp"
+#include "FlacSettingsPage.hpp"
 #include "ModuleInterface.hpp"
 #include "BrowseForFolder.hpp"
 
@@ -91,7 +92,9 @@ LRESULT OutputSettingsPage::OnButtonBack(WORD /*wNotifyCode*/, WORD /*wID*/, HWN
 
       std::for_each(m_uiSettings.encoderjoblist.begin(), m_uiSettings.encoderjoblist.end(), [&](const Encoder::EncoderJob& job)
       {
-         inputFilesList.push_back(job.InputFilename());
+         // cue sheet tracks of the same disc image are only added once
+         if (inputFilesList.empty() || inputFilesList.back() != job.InputFilename())
+            inputFilesList.push_back(job.InputFilename());
       });
 
       m_uiSettings.encoderjoblist.clear();
@@ -261,6 +264,10 @@ void OutputSettingsPage::SetWizardPageByOutputModule(WizardPageHost& pageHost, i
       pageHost.SetWizardPage(std::shared_ptr<WizardPage>(new OpusSettingsPage(pageHost)));
       break;
 
+   case ID_OM_FLAC:
+      pageHost.SetWizardPage(std::shared_ptr<WizardPage>(new FlacSettingsPage(pageHost)));
+      break;
+
    default:
       ATLASSERT(false);
       break;
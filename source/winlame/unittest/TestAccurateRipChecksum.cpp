@@ -0,0 +1,140 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestAccurateRipChecksum.cpp
+/// \brief Tests for the AccurateRipChecksum class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "AccurateRipChecksum.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for AccurateRipChecksum class
+   TEST_CLASS(TestAccurateRipChecksum)
+   {
+   public:
+      /// tests checksums of a track in the middle, the first and the last
+      /// track of a disc; the expected values were calculated with an
+      /// independent reference implementation
+      TEST_METHOD(TestKnownChecksums)
+      {
+         std::vector<int16_t> samples = CreateTrackSamples();
+
+         CheckChecksums(samples, false, false, 0xd4fc46ed, 0xd9ed004b);
+         CheckChecksums(samples, false, true, 0xeb43ba0a, 0xe4c0ec8d);
+         CheckChecksums(samples, true, false, 0x464c121a, 0x4b1b70a1);
+         CheckChecksums(samples, true, true, 0x5c938537, 0x55ef5ce3);
+      }
+
+      /// tests that adding samples in blocks of any size results in the same checksums
+      TEST_METHOD(TestAddInBlocks)
+      {
+         std::vector<int16_t> samples = CreateTrackSamples();
+         uint32_t numSamples = static_cast<uint32_t>(samples.size() / 2);
+
+         Encoder::AccurateRipChecksum checksum(true, true, numSamples);
+         checksum.Add(samples.data(), numSamples);
+
+         // use block sizes that split the skipped ranges and the SSE2 lanes
+         const size_t blockSizes[] = { 1, 2, 3, 5, 1000, 2939, 7 };
+
+         Encoder::AccurateRipChecksum blockChecksum(true, true, numSamples);
+
+         size_t pos = 0;
+         for (size_t blockIndex = 0; pos < numSamples; blockIndex++)
+         {
+            size_t blockSize = std::min<size_t>(blockSizes[blockIndex % _countof(blockSizes)], numSamples - pos);
+            blockChecksum.Add(samples.data() + pos * 2, blockSize);
+            pos += blockSize;
+         }
+
+         Assert::AreEqual(checksum.GetNumSamples(), blockChecksum.GetNumSamples(), _T("number of samples must be equal"));
+         Assert::AreEqual(checksum.GetChecksumV1(), blockChecksum.GetChecksumV1(), _T("v1 checksums must be equal"));
+         Assert::AreEqual(checksum.GetChecksumV2(), blockChecksum.GetChecksumV2(), _T("v2 checksums must be equal"));
+         Assert::AreEqual(checksum.GetCrc32(), blockChecksum.GetCrc32(), _T("CRC32 values must be equal"));
+      }
+
+      /// tests that the first samples of the first track don't change the checksums
+      TEST_METHOD(TestSkippedSamples)
+      {
+         std::vector<int16_t> samples = CreateTrackSamples();
+         uint32_t numSamples = static_cast<uint32_t>(samples.size() / 2);
+
+         Encoder::AccurateRipChecksum checksum(true, false, numSamples);
+         checksum.Add(samples.data(), numSamples);
+
+         // the first 2939 stereo samples are left out
+         const size_t numSkippedSamples = 5 * Encoder::AccurateRipChecksum::c_samplesPerFrame - 1;
+         std::fill(samples.begin(), samples.begin() + numSkippedSamples * 2, int16_t(0));
+
+         Encoder::AccurateRipChecksum changedChecksum(true, false, numSamples);
+         changedChecksum.Add(samples.data(), numSamples);
+
+         Assert::AreEqual(checksum.GetChecksumV1(), changedChecksum.GetChecksumV1(), _T("v1 checksums must be equal"));
+         Assert::AreEqual(checksum.GetChecksumV2(), changedChecksum.GetChecksumV2(), _T("v2 checksums must be equal"));
+         Assert::AreNotEqual(checksum.GetCrc32(), changedChecksum.GetCrc32(), _T("CRC32 must include all samples"));
+      }
+
+      /// tests the CRC32 of a single silent sample
+      TEST_METHOD(TestCrc32Silence)
+      {
+         int16_t samples[2] = { 0, 0 };
+
+         Encoder::AccurateRipChecksum checksum(false, false, 1);
+         checksum.Add(samples, 1);
+
+         Assert::AreEqual(0x2144df1cU, checksum.GetCrc32(), _T("CRC32 must be correct"));
+         Assert::AreEqual(0U, checksum.GetChecksumV1(), _T("v1 checksum of silence must be 0"));
+      }
+
+   private:
+      /// creates samples of a track with a length of 3 seconds and 17 samples,
+      /// using a linear congruential generator
+      static std::vector<int16_t> CreateTrackSamples()
+      {
+         std::vector<int16_t> samples((44100 * 3 + 17) * 2);
+
+         uint32_t value = 12345;
+         for (int16_t& sample : samples)
+         {
+            value = value * 1103515245U + 12345U;
+            sample = static_cast<int16_t>(value >> 16);
+         }
+
+         return samples;
+      }
+
+      /// calculates checksums of given samples and checks them
+      static void CheckChecksums(const std::vector<int16_t>& samples, bool isFirstTrack, bool isLastTrack,
+         uint32_t expectedChecksumV1, uint32_t expectedChecksumV2)
+      {
+         uint32_t numSamples = static_cast<uint32_t>(samples.size() / 2);
+
+         Encoder::AccurateRipChecksum checksum(isFirstTrack, isLastTrack, numSamples);
+         checksum.Add(samples.data(), numSamples);
+
+         Assert::AreEqual(numSamples, checksum.GetNumSamples(), _T("number of samples must be correct"));
+         Assert::AreEqual(expectedChecksumV1, checksum.GetChecksumV1(), _T("v1 checksum must be correct"));
+         Assert::AreEqual(expectedChecksumV2, checksum.GetChecksumV2(), _T("v2 checksum must be correct"));
+         Assert::AreEqual(0xb68ed2d4U, checksum.GetCrc32(), _T("CRC32 must be correct"));
+      }
+   };
+}
@@ -0,0 +1,235 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestBatchJournal.cpp
+/// \brief Tests for the BatchJournal class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "BatchJournal.hpp"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for BatchJournal class
+   TEST_CLASS(TestBatchJournal)
+   {
+   public:
+      /// tests that a disabled journal doesn't record jobs
+      TEST_METHOD(TestDisabledJournal)
+      {
+         Encoder::BatchJournal journal((CString()));
+         Assert::IsFalse(journal.IsEnabled(), _T("journal must be disabled"));
+
+         Assert::AreEqual(0U, journal.AddJob(_T("input.wav"), false), _T("job must not be recorded"));
+      }
+
+      /// tests that the journal file is deleted when all jobs are finished
+      TEST_METHOD(TestFinishedBatchDeletesJournal)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString journalFolder = Path::Combine(folder.FolderName(), _T("journal"));
+         CString inputFilename = CreateTestFile(folder.FolderName(), _T("input.wav"));
+
+         {
+            Encoder::BatchJournal journal(journalFolder);
+
+            unsigned int jobId1 = journal.AddJob(inputFilename, false);
+            unsigned int jobId2 = journal.AddJob(inputFilename, false);
+            Assert::AreNotEqual(0U, jobId1, _T("job must be recorded"));
+            Assert::AreNotEqual(jobId1, jobId2, _T("job IDs must be different"));
+
+            Assert::AreEqual<size_t>(1, CountJournalFiles(journalFolder), _T("journal file must exist"));
+
+            journal.StartJob(jobId1);
+            journal.FinishJob(jobId1);
+            journal.StartJob(jobId2);
+            journal.FinishJob(jobId2);
+
+            Assert::AreEqual<size_t>(0, CountJournalFiles(journalFolder), _T("journal file must be deleted"));
+         }
+
+         Assert::IsTrue(Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder).empty(),
+            _T("there must be no jobs to resume"));
+      }
+
+      /// tests recovering the jobs of an interrupted batch
+      TEST_METHOD(TestRecoverInterruptedJobs)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString journalFolder = Path::Combine(folder.FolderName(), _T("journal"));
+
+         CString inputUnfinished = CreateTestFile(folder.FolderName(), _T("unfinished.wav"));
+         CString inputFinished = CreateTestFile(folder.FolderName(), _T("finished.wav"));
+         CString inputDeletedOutput = CreateTestFile(folder.FolderName(), _T("deleted-output.wav"));
+         CString inputRange = CreateTestFile(folder.FolderName(), _T("range.wav"));
+         CString inputNotStarted = CreateTestFile(folder.FolderName(), _T("not-started.wav"));
+
+         CString tempFilename = CreateTestFile(folder.FolderName(), _T("unfinished.mp3.temp"));
+         CString outputFinished = CreateTestFile(folder.FolderName(), _T("finished.mp3"));
+         CString outputDeleted = Path::Combine(folder.FolderName(), _T("deleted-output.mp3"));
+
+         {
+            Encoder::BatchJournal journal(journalFolder);
+
+            unsigned int jobUnfinished = journal.AddJob(inputUnfinished, false);
+            unsigned int jobFinished = journal.AddJob(inputFinished, false);
+            unsigned int jobDeletedOutput = journal.AddJob(inputDeletedOutput, false);
+            unsigned int jobRange = journal.AddJob(inputRange, true);
+            journal.AddJob(inputNotStarted, false);
+
+            journal.StartJob(jobUnfinished);
+            journal.AddTempFile(jobUnfinished, tempFilename);
+
+            journal.StartJob(jobFinished);
+            journal.AddTempFile(jobFinished, outputFinished + _T(".temp"));
+            journal.AddOutputFile(jobFinished, outputFinished);
+            journal.FinishJob(jobFinished);
+
+            journal.StartJob(jobDeletedOutput);
+            journal.AddOutputFile(jobDeletedOutput, outputDeleted);
+            journal.FinishJob(jobDeletedOutput);
+
+            journal.StartJob(jobRange);
+
+            // journal of a running batch must not be recovered
+            Assert::IsTrue(Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder).empty(),
+               _T("journal in use must not be recovered"));
+         }
+
+         Assert::AreEqual<size_t>(1, CountJournalFiles(journalFolder), _T("journal file must be kept"));
+
+         std::vector<CString> filenames = Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder);
+
+         Assert::AreEqual<size_t>(3, filenames.size(), _T("three jobs must be resumed"));
+         Assert::AreEqual(inputUnfinished.GetString(), filenames[0].GetString(), _T("unfinished job must be resumed"));
+         Assert::AreEqual(inputDeletedOutput.GetString(), filenames[1].GetString(), _T("job with deleted output must be resumed"));
+         Assert::AreEqual(inputNotStarted.GetString(), filenames[2].GetString(), _T("job that wasn't started must be resumed"));
+
+         Assert::IsFalse(Path::FileExists(tempFilename), _T("temp file must be deleted"));
+         Assert::IsTrue(Path::FileExists(outputFinished), _T("output file must be kept"));
+         Assert::AreEqual<size_t>(0, CountJournalFiles(journalFolder), _T("journal file must be deleted"));
+
+         Assert::IsTrue(Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder).empty(),
+            _T("jobs must only be recovered once"));
+      }
+
+      /// tests that a finished job is resumed when its output file was changed
+      TEST_METHOD(TestRecoverChangedOutput)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString journalFolder = Path::Combine(folder.FolderName(), _T("journal"));
+
+         CString inputFilename = CreateTestFile(folder.FolderName(), _T("input.wav"));
+         CString inputUnfinished = CreateTestFile(folder.FolderName(), _T("unfinished.wav"));
+         CString outputFilename = CreateTestFile(folder.FolderName(), _T("output.mp3"));
+
+         {
+            Encoder::BatchJournal journal(journalFolder);
+
+            unsigned int jobId = journal.AddJob(inputFilename, false);
+            journal.AddJob(inputUnfinished, false);
+
+            journal.StartJob(jobId);
+            journal.AddOutputFile(jobId, outputFilename);
+            journal.FinishJob(jobId);
+         }
+
+         // truncate output file
+         std::ofstream outputFile(outputFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+         outputFile.close();
+
+         std::vector<CString> filenames = Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder);
+
+         Assert::AreEqual<size_t>(2, filenames.size(), _T("two jobs must be resumed"));
+         Assert::AreEqual(inputFilename.GetString(), filenames[0].GetString(), _T("job with changed output must be resumed"));
+         Assert::AreEqual(inputUnfinished.GetString(), filenames[1].GetString(), _T("unfinished job must be resumed"));
+      }
+
+      /// tests that finishing a batch closes out stopped and not started jobs
+      TEST_METHOD(TestFinishBatch)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString journalFolder = Path::Combine(folder.FolderName(), _T("journal"));
+
+         CString inputStopped = CreateTestFile(folder.FolderName(), _T("stopped.wav"));
+         CString inputNotStarted = CreateTestFile(folder.FolderName(), _T("not-started.wav"));
+         CString inputNextBatch = CreateTestFile(folder.FolderName(), _T("next-batch.wav"));
+
+         {
+            Encoder::BatchJournal journal(journalFolder);
+
+            unsigned int jobStopped = journal.AddJob(inputStopped, false);
+            journal.AddJob(inputNotStarted, false);
+
+            journal.StartJob(jobStopped);
+            journal.FinishBatch();
+
+            Assert::AreEqual<size_t>(0, CountJournalFiles(journalFolder), _T("journal file must be deleted"));
+
+            // a job of the finished batch must not finish the next batch
+            unsigned int jobNextBatch = journal.AddJob(inputNextBatch, false);
+            journal.StartJob(jobNextBatch);
+            journal.FinishJob(jobStopped);
+
+            Assert::AreEqual<size_t>(1, CountJournalFiles(journalFolder), _T("journal file of the next batch must be kept"));
+         }
+
+         std::vector<CString> filenames = Encoder::BatchJournal::RecoverInterruptedJobs(journalFolder);
+
+         Assert::AreEqual<size_t>(1, filenames.size(), _T("only the job of the next batch must be resumed"));
+         Assert::AreEqual(inputNextBatch.GetString(), filenames[0].GetString(), _T("job of the next batch must be resumed"));
+      }
+
+   private:
+      /// creates small test file
+      static CString CreateTestFile(const CString& folderName, LPCTSTR filename)
+      {
+         CString pathname = Path::Combine(folderName, filename);
+
+         std::ofstream outputFile(pathname, std::ios::out | std::ios::binary);
+         outputFile.write("test", 4);
+
+         return pathname;
+      }
+
+      /// returns number of journal files in the folder
+      static size_t CountJournalFiles(const CString& journalFolder)
+      {
+         size_t count = 0;
+
+         WIN32_FIND_DATA findData = {};
+         HANDLE find = FindFirstFile(Path::Combine(journalFolder, _T("*.journal")), &findData);
+         if (find == INVALID_HANDLE_VALUE)
+            return 0;
+
+         do
+         {
+            count++;
+         } while (FindNextFile(find, &findData));
+
+         FindClose(find);
+
+         return count;
+      }
+   };
+}
@@ -0,0 +1,153 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestBufferedInputFile.cpp
+/// \brief Tests for the BufferedInputFile class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "BufferedInputFile.hpp"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for BufferedInputFile class
+   TEST_CLASS(TestBufferedInputFile)
+   {
+   public:
+      /// tests reading and seeking in a memory mapped file
+      TEST_METHOD(TestReadMemoryMapped)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = CreateTestFile(folder.FolderName());
+
+         Encoder::BufferedInputFile inputFile;
+         Assert::IsTrue(inputFile.Open(filename), _T("opening file must succeed"));
+         Assert::IsTrue(inputFile.IsMemoryMapped(), _T("local file must be memory mapped"));
+
+         CheckReadAndSeek(inputFile);
+      }
+
+      /// tests reading and seeking using the read-ahead thread
+      TEST_METHOD(TestReadAhead)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = CreateTestFile(folder.FolderName());
+
+         // use small blocks, so that many blocks are read by the I/O thread
+         Encoder::InputFileOptions options;
+         options.m_blockSize = 4096;
+         options.m_numReadAheadBlocks = 2;
+         options.m_allowMemoryMapping = false;
+
+         Encoder::BufferedInputFile inputFile;
+         Assert::IsTrue(inputFile.Open(filename, options), _T("opening file must succeed"));
+         Assert::IsFalse(inputFile.IsMemoryMapped(), _T("file must not be memory mapped"));
+
+         CheckReadAndSeek(inputFile);
+
+         Assert::IsTrue(inputFile.NumReadCalls() < c_numValues / 10, _T("small reads must have been combined"));
+      }
+
+      /// tests reading an empty file
+      TEST_METHOD(TestReadEmptyFile)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = Path::Combine(folder.FolderName(), _T("empty.bin"));
+
+         {
+            std::ofstream outputFile(filename, std::ios::out | std::ios::binary);
+         }
+
+         Encoder::BufferedInputFile inputFile;
+         Assert::IsTrue(inputFile.Open(filename), _T("opening file must succeed"));
+         Assert::AreEqual<ULONGLONG>(0, inputFile.Length(), _T("file must be empty"));
+         Assert::IsTrue(inputFile.IsEndOfFile(), _T("file must be at its end"));
+
+         unsigned int value = 0;
+         Assert::AreEqual<size_t>(0, inputFile.Read(&value, sizeof(value)), _T("reading must return no data"));
+      }
+
+      /// tests that opening a non-existent file fails
+      TEST_METHOD(TestOpenMissingFile)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = Path::Combine(folder.FolderName(), _T("missing.bin"));
+
+         Encoder::BufferedInputFile inputFile;
+         Assert::IsFalse(inputFile.Open(filename), _T("opening file must fail"));
+         Assert::IsFalse(inputFile.IsOpen(), _T("file must not be open"));
+         Assert::IsFalse(inputFile.GetLastErrorText().IsEmpty(), _T("error text must be set"));
+      }
+
+   private:
+      /// number of values in the test file
+      static const unsigned int c_numValues = 10000;
+
+      /// creates test file, containing consecutive values
+      static CString CreateTestFile(const CString& folderName)
+      {
+         CString filename = Path::Combine(folderName, _T("input.bin"));
+
+         std::ofstream outputFile(filename, std::ios::out | std::ios::binary);
+         for (unsigned int valueIndex = 0; valueIndex < c_numValues; valueIndex++)
+            outputFile.write(reinterpret_cast<const char*>(&valueIndex), sizeof(valueIndex));
+
+         return filename;
+      }
+
+      /// checks reading the whole test file, then seeking and reading again
+      static void CheckReadAndSeek(Encoder::BufferedInputFile& inputFile)
+      {
+         Assert::AreEqual<ULONGLONG>(c_numValues * sizeof(unsigned int), inputFile.Length(), _T("file length must be correct"));
+
+         unsigned int value = 0;
+         for (unsigned int valueIndex = 0; valueIndex < c_numValues; valueIndex++)
+         {
+            Assert::AreEqual(sizeof(value), inputFile.Read(&value, sizeof(value)), _T("reading must succeed"));
+            Assert::AreEqual(valueIndex, value, _T("value must have been read"));
+         }
+
+         Assert::IsTrue(inputFile.IsEndOfFile(), _T("file must be at its end"));
+         Assert::AreEqual<size_t>(0, inputFile.Read(&value, sizeof(value)), _T("reading at end must return no data"));
+
+         // seek relative to the end, e.g. for reading an ID3v1 tag
+         Assert::IsTrue(inputFile.Seek(-4 * LONGLONG(sizeof(value)), SEEK_END), _T("seeking must succeed"));
+
+         unsigned int lastValues[4] = {};
+         Assert::AreEqual(sizeof(lastValues), inputFile.Read(lastValues, sizeof(lastValues)), _T("reading must succeed"));
+         Assert::AreEqual(c_numValues - 1, lastValues[3], _T("last value must have been read"));
+
+         // seek back to the start, and a little bit back inside the current block
+         Assert::IsTrue(inputFile.Seek(0, SEEK_SET), _T("seeking must succeed"));
+         Assert::AreEqual(sizeof(value), inputFile.Read(&value, sizeof(value)), _T("reading must succeed"));
+         Assert::AreEqual(0U, value, _T("first value must have been read"));
+
+         Assert::IsTrue(inputFile.Seek(5000 * sizeof(value), SEEK_SET), _T("seeking must succeed"));
+         Assert::IsTrue(inputFile.Seek(-LONGLONG(sizeof(value)), SEEK_CUR), _T("seeking must succeed"));
+         Assert::AreEqual(sizeof(value), inputFile.Read(&value, sizeof(value)), _T("reading must succeed"));
+         Assert::AreEqual(4999U, value, _T("value must have been read"));
+
+         Assert::IsFalse(inputFile.Seek(-1, SEEK_SET), _T("seeking before start must fail"));
+      }
+   };
+}
@@ -0,0 +1,106 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestBufferedOutputFile.cpp
+/// \brief Tests for the BufferedOutputFile class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "BufferedOutputFile.hpp"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for BufferedOutputFile class
+   TEST_CLASS(TestBufferedOutputFile)
+   {
+   public:
+      /// tests writing many small blocks, seeking back and fixing up a header
+      TEST_METHOD(TestWriteSeekAndFixup)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = Path::Combine(folder.FolderName(), _T("output.bin"));
+
+         // use small buffers, so that many buffers are written by the I/O thread
+         Encoder::OutputFileOptions options;
+         options.m_bufferSize = 4096;
+         options.m_numBuffers = 2;
+         options.m_preallocateSize = 1024 * 1024;
+
+         const unsigned int numBlocks = 10000;
+         const unsigned int headerValue = 0x12345678;
+
+         {
+            Encoder::BufferedOutputFile outputFile;
+            Assert::IsTrue(outputFile.Open(filename, options), _T("opening file must succeed"));
+
+            unsigned int header = 0;
+            Assert::IsTrue(outputFile.Write(&header, sizeof(header)), _T("writing header must succeed"));
+
+            for (unsigned int blockIndex = 0; blockIndex < numBlocks; blockIndex++)
+               Assert::IsTrue(outputFile.Write(&blockIndex, sizeof(blockIndex)), _T("writing block must succeed"));
+
+            Assert::AreEqual<ULONGLONG>((numBlocks + 1) * sizeof(unsigned int), outputFile.Tell(), _T("position must be at end"));
+
+            // fix up header, then read it back
+            Assert::IsTrue(outputFile.Seek(0), _T("seeking must succeed"));
+            Assert::IsTrue(outputFile.Write(&headerValue, sizeof(headerValue)), _T("writing header must succeed"));
+
+            unsigned int firstBlock = 0xffffffff;
+            Assert::AreEqual(sizeof(firstBlock), outputFile.Read(&firstBlock, sizeof(firstBlock)), _T("reading must succeed"));
+            Assert::AreEqual(0U, firstBlock, _T("first block must have been read back"));
+
+            Assert::IsTrue(outputFile.Close(), _T("closing file must succeed"));
+            Assert::IsTrue(outputFile.NumWriteCalls() < numBlocks / 10, _T("small writes must have been combined"));
+         }
+
+         // check file contents
+         std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+         Assert::IsTrue(inputFile.is_open(), _T("output file must exist"));
+
+         unsigned int value = 0;
+         inputFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+         Assert::AreEqual(headerValue, value, _T("header must have been fixed up"));
+
+         for (unsigned int blockIndex = 0; blockIndex < numBlocks; blockIndex++)
+         {
+            inputFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+            Assert::AreEqual(blockIndex, value, _T("block must contain the written value"));
+         }
+
+         inputFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+         Assert::IsTrue(inputFile.eof(), _T("file must not contain more data"));
+      }
+
+      /// tests that opening a file in a non-existent folder fails
+      TEST_METHOD(TestOpenInvalidPath)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString filename = Path::Combine(folder.FolderName(), _T("missing\\output.bin"));
+
+         Encoder::BufferedOutputFile outputFile;
+         Assert::IsFalse(outputFile.Open(filename), _T("opening file must fail"));
+         Assert::IsFalse(outputFile.IsOpen(), _T("file must not be open"));
+         Assert::IsFalse(outputFile.GetLastErrorText().IsEmpty(), _T("error text must be set"));
+      }
+   };
+}
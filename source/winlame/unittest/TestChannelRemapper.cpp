@@ -0,0 +1,207 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestChannelRemapper.cpp
+/// \brief Tests for the ChannelRemapper class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "ChannelRemapper.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using Encoder::ChannelRemapper;
+using Encoder::T_enChannelMapType;
+
+namespace unittest
+{
+   /// tests for ChannelRemapper class
+   TEST_CLASS(TestChannelRemapper)
+   {
+   public:
+      /// golden channel maps for 1 to 6 channels, as used before 7.1 support
+      static const int c_goldenChannelMap[4][6][6];
+
+      /// tests that the channel maps for up to 6 channels didn't change
+      TEST_METHOD(TestGoldenChannelMaps)
+      {
+         for (int channelMapType = 0; channelMapType < 4; channelMapType++)
+            for (size_t numChannels = 1; numChannels <= 6; numChannels++)
+               for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+               {
+                  Assert::AreEqual<size_t>(
+                     c_goldenChannelMap[channelMapType][numChannels - 1][channelIndex],
+                     ChannelRemapper::GetMappedChannel(
+                        static_cast<T_enChannelMapType>(channelMapType), numChannels, channelIndex),
+                     _T("mapped channel must match golden channel map"));
+               }
+      }
+
+      /// tests remapping 7.1 channels, and that Vorbis input and output maps are inverse
+      TEST_METHOD(TestRemap71Channels)
+      {
+         // Vorbis order is l, c, r, sl, sr, bl, br, lfe
+         std::vector<short> vorbisSamples = { 1, 3, 2, 7, 8, 5, 6, 4 };
+         std::vector<short> waveSamples(8);
+
+         ChannelRemapper::RemapInterleaved(T_enChannelMapType::oggVorbisInputChannelMap,
+            vorbisSamples.data(), 1, 8, waveSamples.data());
+
+         std::vector<short> expectedWaveSamples = { 1, 2, 3, 4, 5, 6, 7, 8 };
+         Assert::IsTrue(expectedWaveSamples == waveSamples, _T("wave order must be l, r, c, lfe, bl, br, sl, sr"));
+
+         for (size_t numChannels = 3; numChannels <= 8; numChannels++)
+         {
+            if (numChannels == 4)
+               continue; // quadro isn't remapped
+
+            for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+            {
+               size_t outputChannel = ChannelRemapper::GetMappedChannel(
+                  T_enChannelMapType::oggVorbisOutputChannelMap, numChannels, channelIndex);
+
+               Assert::AreEqual(channelIndex,
+                  ChannelRemapper::GetMappedChannel(T_enChannelMapType::oggVorbisInputChannelMap, numChannels, outputChannel),
+                  _T("Vorbis input map must be inverse of output map"));
+            }
+         }
+      }
+
+      /// tests that more than 8 channels, e.g. Ambisonics, are passed through unchanged
+      TEST_METHOD(TestPassThroughMoreThan8Channels)
+      {
+         const size_t numChannels = 9;
+         const size_t numSamples = 3;
+
+         std::vector<short> samples(numChannels * numSamples);
+         for (size_t index = 0; index < samples.size(); index++)
+            samples[index] = static_cast<short>(index);
+
+         std::vector<short> output(samples.size());
+
+         ChannelRemapper::RemapInterleaved(T_enChannelMapType::aacInputChannelMap,
+            samples.data(), numSamples, numChannels, output.data());
+
+         Assert::IsTrue(samples == output, _T("samples must be passed through"));
+         Assert::AreEqual<size_t>(8, ChannelRemapper::GetMappedChannel(T_enChannelMapType::aacOutputChannelMap, numChannels, 8),
+            _T("channel must be passed through"));
+      }
+
+      /// tests fused remapping and converting against the scalar results
+      TEST_METHOD(TestRemapArrayToFloat)
+      {
+         // an odd number of samples also tests the remaining samples after the SSE2 loop
+         const size_t numSamples = 37;
+         const size_t numChannels = 6;
+
+         std::vector<std::vector<short>> samples(numChannels, std::vector<short>(numSamples));
+         std::vector<std::vector<float>> output(numChannels, std::vector<float>(numSamples));
+
+         std::vector<short*> sampleBuffer;
+         std::vector<float*> outputBuffer;
+
+         std::mt19937 generator(42);
+         std::uniform_int_distribution<int> distribution(-32768, 32767);
+
+         for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+         {
+            for (short& sample : samples[channelIndex])
+               sample = static_cast<short>(distribution(generator));
+
+            sampleBuffer.push_back(samples[channelIndex].data());
+            outputBuffer.push_back(output[channelIndex].data());
+         }
+
+         samples[0][0] = -32768;
+         samples[1][numSamples - 1] = 32767;
+
+         ChannelRemapper::RemapArrayToFloat(T_enChannelMapType::oggVorbisOutputChannelMap,
+            sampleBuffer.data(), numSamples, numChannels, outputBuffer.data());
+
+         const int* channelMap = c_goldenChannelMap[T_enChannelMapType::oggVorbisOutputChannelMap][numChannels - 1];
+
+         for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+            for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+            {
+               Assert::AreEqual(float(samples[channelMap[channelIndex]][sampleIndex]) / 32768.f,
+                  output[channelIndex][sampleIndex],
+                  _T("remapped sample must match scalar conversion exactly"));
+            }
+      }
+
+      /// tests downmix matrix and fused converting and downmixing against the scalar results
+      TEST_METHOD(TestDownmix)
+      {
+         std::vector<float> downmixMatrix;
+         Assert::IsFalse(ChannelRemapper::GetDownmixMatrix(9, 2, downmixMatrix), _T("9 channels can't be downmixed to stereo"));
+         Assert::IsFalse(ChannelRemapper::GetDownmixMatrix(2, 2, downmixMatrix), _T("stereo can't be downmixed to stereo"));
+
+         Assert::IsTrue(ChannelRemapper::GetDownmixMatrix(6, 2, downmixMatrix), _T("5.1 must be downmixed to stereo"));
+         Assert::AreEqual<size_t>(12, downmixMatrix.size(), _T("matrix must have 6 factors per output channel"));
+
+         // 2 / sum of all factors of the 6 channel row of the opus-tools matrix
+         float factor = 2.0f / (1.0f + 2 * 0.7071f + 1.0f + 2 * (0.866f + 0.5f) + 2 * 0.7071f);
+         Assert::AreEqual(factor, downmixMatrix[0], 1e-6f, _T("left channel factor must match"));
+         Assert::AreEqual(0.0f, downmixMatrix[2], _T("right channel must not be mixed into left channel"));
+
+         const size_t numSamples = 963;
+         const size_t numChannels = 6;
+
+         std::mt19937 generator(42);
+         std::uniform_int_distribution<int> distribution(-32768, 32767);
+
+         std::vector<short> samples(numSamples * numChannels);
+         for (short& sample : samples)
+            sample = static_cast<short>(distribution(generator));
+
+         std::vector<float> output(numSamples * 2);
+
+         ChannelRemapper::DownmixInterleavedToFloat(samples.data(), numSamples, numChannels,
+            downmixMatrix, 2, 1.0f / 32767, output.data());
+
+         for (size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+            for (size_t outputChannelIndex = 0; outputChannelIndex < 2; outputChannelIndex++)
+            {
+               float expected = 0.0f;
+               for (size_t channelIndex = 0; channelIndex < numChannels; channelIndex++)
+               {
+                  expected += float(samples[sampleIndex * numChannels + channelIndex]) / 32767 *
+                     downmixMatrix[outputChannelIndex * numChannels + channelIndex];
+               }
+
+               Assert::AreEqual(expected, output[sampleIndex * 2 + outputChannelIndex], 1e-6f,
+                  _T("downmixed sample must match scalar downmix"));
+            }
+      }
+   };
+
+   const int TestChannelRemapper::c_goldenChannelMap[4][6][6] =
+   {
+      // aacInputChannelMap
+      { { 0, }, { 0, 1, }, { 1, 2, 0, }, { 1, 2, 0, 3, }, { 1, 2, 0, 3, 4, }, { 1, 2, 0, 5, 3, 4 } },
+      // aacOutputChannelMap
+      { { 0, }, { 0, 1, }, { 2, 0, 1, }, { 2, 0, 1, 3, }, { 2, 0, 1, 3, 4, }, { 2, 0, 1, 4, 5, 3 } },
+      // oggVorbisInputChannelMap
+      { { 0, }, { 0, 1, }, { 0, 2, 1, }, { 0, 1, 2, 3, }, { 0, 2, 1, 3, 4, }, { 0, 2, 1, 5, 3, 4 } },
+      // oggVorbisOutputChannelMap
+      { { 0, }, { 0, 1, }, { 0, 2, 1, }, { 0, 1, 2, 3, }, { 0, 2, 1, 3, 4, }, { 0, 2, 1, 4, 5, 3 } },
+   };
+}
@@ -0,0 +1,281 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestCueSheet.cpp
+/// \brief Tests for the CueSheet class and splitting disc images by tracks
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "CueSheet.hpp"
+#include "TrackInfo.hpp"
+#include "EncoderImpl.hpp"
+#include <sndfile.h>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// cue sheet with pregap, metadata and a data track
+   static LPCTSTR c_cueSheetText =
+      _T("REM GENRE Rock\r\n")
+      _T("REM DATE 1999\r\n")
+      _T("PERFORMER \"The Band\"\r\n")
+      _T("TITLE \"The Album\"\r\n")
+      _T("FILE \"image.wav\" WAVE\r\n")
+      _T("  TRACK 01 AUDIO\r\n")
+      _T("    TITLE \"First Song\"\r\n")
+      _T("    INDEX 01 00:00:00\r\n")
+      _T("  TRACK 02 AUDIO\r\n")
+      _T("    TITLE \"Second Song\"\r\n")
+      _T("    PERFORMER \"Guest Singer\"\r\n")
+      _T("    PREGAP 00:02:00\r\n")
+      _T("    INDEX 00 03:10:20\r\n")
+      _T("    INDEX 01 03:12:20\r\n")
+      _T("  TRACK 03 AUDIO\r\n")
+      _T("    TITLE \"Third Song\"\r\n")
+      _T("    INDEX 01 07:45:74\r\n")
+      _T("FILE \"data.bin\" BINARY\r\n")
+      _T("  TRACK 04 MODE1/2352\r\n")
+      _T("    INDEX 01 00:00:00\r\n");
+
+   /// tests for CueSheet class
+   TEST_CLASS(TestCueSheet), public EncoderTestFixture
+   {
+   public:
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// tests parsing tracks, indices and metadata
+      TEST_METHOD(TestParse)
+      {
+         Encoder::CueSheet cueSheet;
+         cueSheet.Parse(c_cueSheetText, _T("C:\\Music"));
+
+         const std::vector<Encoder::CueSheetTrack>& tracks = cueSheet.Tracks();
+         Assert::AreEqual<size_t>(3, tracks.size(), _T("data track must be skipped"));
+
+         Assert::AreEqual(_T("C:\\Music\\image.wav"), tracks[0].m_filename.GetString(), _T("relative filename must be resolved"));
+         Assert::AreEqual(2U, tracks[1].m_trackNumber, _T("track number must be correct"));
+         Assert::AreEqual((3U * 60 + 10) * 75 + 20, tracks[1].m_pregapStartFrame, _T("INDEX 00 must be parsed"));
+         Assert::AreEqual((3U * 60 + 12) * 75 + 20, tracks[1].m_startFrame, _T("INDEX 01 must be parsed"));
+
+         Assert::AreEqual<size_t>(1, cueSheet.GetFilenames().size(), _T("there must be one audio file"));
+
+         Encoder::TrackInfo trackInfo;
+         cueSheet.SetTrackInfo(1, trackInfo);
+
+         bool isAvail = false;
+         Assert::AreEqual(_T("Second Song"), trackInfo.GetTextInfo(Encoder::TrackInfoTitle, isAvail).GetString(), _T("title must be set"));
+         Assert::AreEqual(_T("Guest Singer"), trackInfo.GetTextInfo(Encoder::TrackInfoArtist, isAvail).GetString(), _T("track performer must be used"));
+         Assert::AreEqual(_T("The Band"), trackInfo.GetTextInfo(Encoder::TrackInfoDiscArtist, isAvail).GetString(), _T("disc performer must be set"));
+         Assert::AreEqual(_T("The Album"), trackInfo.GetTextInfo(Encoder::TrackInfoAlbum, isAvail).GetString(), _T("album must be set"));
+         Assert::AreEqual(_T("Rock"), trackInfo.GetTextInfo(Encoder::TrackInfoGenre, isAvail).GetString(), _T("genre must be set"));
+         Assert::AreEqual(1999, trackInfo.GetNumberInfo(Encoder::TrackInfoYear, isAvail), _T("year must be set"));
+         Assert::AreEqual(2, trackInfo.GetNumberInfo(Encoder::TrackInfoTrack, isAvail), _T("track number must be set"));
+
+         cueSheet.SetTrackInfo(0, trackInfo);
+         Assert::AreEqual(_T("The Band"), trackInfo.GetTextInfo(Encoder::TrackInfoArtist, isAvail).GetString(), _T("disc performer must be used as artist"));
+      }
+
+      /// tests track ranges; pregaps belong to the previous track
+      TEST_METHOD(TestTrackFrameRanges)
+      {
+         Encoder::CueSheet cueSheet;
+         cueSheet.Parse(c_cueSheetText, _T("C:\\Music"));
+
+         unsigned int startFrame = 0, endFrame = 0;
+         cueSheet.GetTrackFrameRange(0, startFrame, endFrame);
+         Assert::AreEqual(0U, startFrame, _T("first track must start at the beginning"));
+         Assert::AreEqual((3U * 60 + 12) * 75 + 20, endFrame, _T("first track must include the pregap of the second track"));
+
+         cueSheet.GetTrackFrameRange(1, startFrame, endFrame);
+         Assert::AreEqual((3U * 60 + 12) * 75 + 20, startFrame, _T("second track must start at INDEX 01"));
+         Assert::AreEqual((7U * 60 + 45) * 75 + 74, endFrame, _T("second track must end at the third track"));
+
+         cueSheet.GetTrackFrameRange(2, startFrame, endFrame);
+         Assert::AreEqual((7U * 60 + 45) * 75 + 74, startFrame, _T("third track must start at INDEX 01"));
+         Assert::AreEqual(0U, endFrame, _T("last track must end at the end of the file"));
+      }
+
+      /// tests that the sample counts of all tracks sum up exactly to the image length
+      TEST_METHOD(TestTrackSampleCountsSumToImageLength)
+      {
+         Encoder::CueSheet cueSheet;
+         cueSheet.Parse(c_cueSheetText, _T("C:\\Music"));
+
+         for (unsigned int samplerateInHz : { 8000U, 22050U, 44100U, 48000U, 96000U })
+         {
+            // image length isn't a multiple of a CD frame
+            __int64 numImageSamples = __int64(10) * 60 * samplerateInHz + 37;
+
+            __int64 numTotalSamples = 0;
+            __int64 lastEndSample = 0;
+
+            for (size_t trackIndex = 0; trackIndex < cueSheet.Tracks().size(); trackIndex++)
+            {
+               unsigned int startFrame = 0, endFrame = 0;
+               cueSheet.GetTrackFrameRange(trackIndex, startFrame, endFrame);
+
+               __int64 startSample = Encoder::CueSheet::SampleFromFrame(startFrame, samplerateInHz);
+               __int64 endSample = endFrame == 0 ? numImageSamples : Encoder::CueSheet::SampleFromFrame(endFrame, samplerateInHz);
+
+               Assert::AreEqual(lastEndSample, startSample, _T("tracks must not overlap or have gaps"));
+               Assert::IsTrue(endSample > startSample, _T("tracks must not be empty"));
+
+               numTotalSamples += endSample - startSample;
+               lastEndSample = endSample;
+            }
+
+            Assert::AreEqual(numImageSamples, numTotalSamples, _T("track sample counts must sum up to the image length"));
+         }
+      }
+
+      /// tests loading a UTF-8 cue sheet and a track whose pregap is in the previous file
+      TEST_METHOD(TestLoadUTF8MultipleFiles)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString cueSheetFilename = Path::Combine(folder.FolderName(), _T("album.cue"));
+         {
+            std::ofstream cueSheetFile(cueSheetFilename, std::ios::out | std::ios::binary);
+            cueSheetFile <<
+               "\xef\xbb\xbf"
+               "TITLE \"Caf\xc3\xa9\"\r\n"
+               "FILE \"track1.wav\" WAVE\r\n"
+               "  TRACK 01 AUDIO\r\n"
+               "    INDEX 01 00:00:00\r\n"
+               "  TRACK 02 AUDIO\r\n"
+               "    INDEX 00 04:00:00\r\n"
+               "FILE \"track2.wav\" WAVE\r\n"
+               "    INDEX 01 00:00:00\r\n";
+         }
+
+         Encoder::CueSheet cueSheet;
+         Assert::IsTrue(cueSheet.Load(cueSheetFilename), _T("cue sheet must be loaded"));
+
+         Assert::AreEqual<size_t>(2, cueSheet.Tracks().size(), _T("there must be two tracks"));
+         Assert::AreEqual<size_t>(2, cueSheet.GetFilenames().size(), _T("there must be two audio files"));
+         Assert::AreEqual(Path::Combine(folder.FolderName(), _T("track2.wav")).GetString(),
+            cueSheet.Tracks()[1].m_filename.GetString(), _T("second track must be in the second file"));
+
+         unsigned int startFrame = 0, endFrame = 0;
+         cueSheet.GetTrackFrameRange(0, startFrame, endFrame);
+         Assert::AreEqual(0U, endFrame, _T("first track must contain the whole first file"));
+
+         cueSheet.GetTrackFrameRange(1, startFrame, endFrame);
+         Assert::AreEqual(0U, startFrame, _T("second track must start at the beginning of the second file"));
+
+         Encoder::TrackInfo trackInfo;
+         cueSheet.SetTrackInfo(0, trackInfo);
+
+         bool isAvail = false;
+         Assert::AreEqual(_T("Caf\u00e9"), trackInfo.GetTextInfo(Encoder::TrackInfoAlbum, isAvail).GetString(), _T("UTF-8 title must be decoded"));
+      }
+
+      /// tests splitting a wave file into two tracks; the samples of both
+      /// tracks must be the same as the samples of the whole file
+      TEST_METHOD(TestEncodeTrackRanges)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, originalFilename);
+
+         std::vector<short> originalSamples = ReadAudioSamples(originalFilename);
+
+         SF_INFO info = {};
+         SNDFILE* sndfile = sf_open(CStringA(Encoder::GetAnsiCompatFilename(originalFilename)), SFM_READ, &info);
+         Assert::IsNotNull(sndfile, _T("sound file must be opened"));
+         sf_close(sndfile);
+
+         unsigned int numFrames = static_cast<unsigned int>(info.frames * Encoder::CueSheet::c_framesPerSecond / info.samplerate);
+         unsigned int splitFrame = numFrames / 2;
+         Assert::IsTrue(splitFrame > 0, _T("sample file must be long enough"));
+
+         CString track1Filename = Path::Combine(folder.FolderName(), _T("track1.wav"));
+         CString track2Filename = Path::Combine(folder.FolderName(), _T("track2.wav"));
+
+         EncodeRange(originalFilename, track1Filename, 0, splitFrame);
+         EncodeRange(originalFilename, track2Filename, splitFrame, 0);
+
+         std::vector<short> track1Samples = ReadAudioSamples(track1Filename);
+         std::vector<short> track2Samples = ReadAudioSamples(track2Filename);
+
+         Assert::AreEqual<size_t>(
+            static_cast<size_t>(Encoder::CueSheet::SampleFromFrame(splitFrame, info.samplerate) * info.channels),
+            track1Samples.size(),
+            _T("first track must end exactly at the split position"));
+
+         std::vector<short> joinedSamples = track1Samples;
+         joinedSamples.insert(joinedSamples.end(), track2Samples.begin(), track2Samples.end());
+
+         Assert::AreEqual(originalSamples.size(), joinedSamples.size(), _T("track sample counts must sum up to the file length"));
+         Assert::IsTrue(originalSamples == joinedSamples, _T("track samples must match the original samples"));
+      }
+
+   private:
+      /// encodes range of input file to 16-bit wave file
+      void EncodeRange(const CString& inputFilename, const CString& outputFilename,
+         unsigned int startFrame, unsigned int endFrame)
+      {
+         Encoder::EncoderImpl encoder;
+
+         Encoder::EncoderSettings encoderSettings;
+         encoderSettings.m_inputFilename = inputFilename;
+         encoderSettings.m_outputFilename = outputFilename;
+         encoderSettings.m_outputModuleID = ID_OM_WAVE;
+         encoderSettings.m_rangeStartFrame = startFrame;
+         encoderSettings.m_rangeEndFrame = endFrame;
+
+         encoder.SetEncoderSettings(encoderSettings);
+
+         SettingsManager settingsManager;
+         settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+         settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_16);
+         encoder.SetSettingsManager(&settingsManager);
+
+         StartEncodeAndWaitForFinish(encoder);
+
+         Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+         Assert::IsTrue(Path::FileExists(outputFilename), _T("output file must exist"));
+      }
+
+      /// reads all audio samples of given sound file
+      static std::vector<short> ReadAudioSamples(const CString& filename)
+      {
+         SF_INFO info = {};
+         SNDFILE* sndfile = sf_open(CStringA(Encoder::GetAnsiCompatFilename(filename)), SFM_READ, &info);
+         Assert::IsNotNull(sndfile, _T("sound file must be opened"));
+
+         std::vector<short> samples(static_cast<size_t>(info.frames * info.channels));
+         sf_count_t numRead = sf_read_short(sndfile, samples.data(), samples.size());
+         sf_close(sndfile);
+
+         samples.resize(static_cast<size_t>(numRead));
+         return samples;
+      }
+   };
+}
@@ -29,6 +29,7 @@
 #include "ModuleManager.hpp"
 #include "ModuleManagerImpl.hpp"
 #include <sndfile.h>
+#include <fstream>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -106,5 +107,215 @@ namespace unittest
 
          // file contents of originalFilename and decodedFilename must match
       }
+
+      /// tests encoding wave to FLAC using the FLAC output module, and decoding back to wave
+      TEST_METHOD(TestEncodeDecodeFlacOutputModule)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, originalFilename);
+
+         // encode file
+         CString encodedFilename = Path::Combine(folder.FolderName(), _T("encoded.flac"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = originalFilename;
+            encoderSettings.m_outputFilename = encodedFilename;
+            encoderSettings.m_outputModuleID = ID_OM_FLAC;
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            SettingsManager settingsManager;
+            settingsManager.setValue(FlacCompressionLevel, 8);
+            settingsManager.setValue(FlacMultithreaded, 1);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+            Assert::IsTrue(Path::FileExists(encodedFilename), _T("output file must exist"));
+         }
+
+         // decode back to wave
+         CString decodedFilename = Path::Combine(folder.FolderName(), _T("decoded.wav"));
+         {
+            Encoder::EncoderImpl decoder;
+
+            Encoder::EncoderSettings decoderSettings;
+            decoderSettings.m_inputFilename = encodedFilename;
+            decoderSettings.m_outputFilename = decodedFilename;
+            decoderSettings.m_outputModuleID = ID_OM_WAVE;
+
+            decoder.SetEncoderSettings(decoderSettings);
+
+            SettingsManager settingsManagerDecoder;
+            settingsManagerDecoder.setValue(SndFileFormat, SF_FORMAT_WAV);
+            settingsManagerDecoder.setValue(SndFileSubType, SF_FORMAT_PCM_16);
+            decoder.SetSettingsManager(&settingsManagerDecoder);
+
+            StartEncodeAndWaitForFinish(decoder);
+
+            Assert::IsTrue(Path::FileExists(decodedFilename), _T("decoded file must exist"));
+         }
+
+         // the FLAC stream is lossless, so the audio data must be the same
+         Assert::IsTrue(ReadAudioSamples(originalFilename) == ReadAudioSamples(decodedFilename),
+            _T("decoded samples must match the original samples"));
+      }
+
+      /// tests decoding once and encoding to FLAC and wave at the same time
+      TEST_METHOD(TestEncodeMultipleOutputs)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, originalFilename);
+
+         CString flacFilename = Path::Combine(folder.FolderName(), _T("encoded.flac"));
+         CString waveFilename = Path::Combine(folder.FolderName(), _T("encoded.wav"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = originalFilename;
+            encoderSettings.m_outputFilename = flacFilename;
+            encoderSettings.m_outputModuleID = ID_OM_FLAC;
+
+            // output filename is generated from the main output filename
+            encoderSettings.m_additionalOutputs.push_back(Encoder::EncoderOutputSettings(ID_OM_WAVE));
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            // use a different sample format than the input file, so that the
+            // wave output is encoded and not just copied
+            SettingsManager settingsManager;
+            settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+            settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_24);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+            Assert::IsTrue(Path::FileExists(flacFilename), _T("FLAC output file must exist"));
+            Assert::IsTrue(Path::FileExists(waveFilename), _T("wave output file must exist"));
+         }
+
+         // both outputs are lossless, so the audio data must be the same
+         std::vector<short> originalSamples = ReadAudioSamples(originalFilename);
+
+         Assert::IsTrue(originalSamples == ReadAudioSamples(flacFilename),
+            _T("FLAC samples must match the original samples"));
+         Assert::IsTrue(originalSamples == ReadAudioSamples(waveFilename),
+            _T("wave samples must match the original samples"));
+      }
+
+      /// tests verifying the FLAC and wave output files after encoding
+      TEST_METHOD(TestVerifyOutputs)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, originalFilename);
+
+         CString flacFilename = Path::Combine(folder.FolderName(), _T("encoded.flac"));
+         CString waveFilename = Path::Combine(folder.FolderName(), _T("encoded.wav"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = originalFilename;
+            encoderSettings.m_outputFilename = flacFilename;
+            encoderSettings.m_outputModuleID = ID_OM_FLAC;
+            encoderSettings.m_additionalOutputs.push_back(Encoder::EncoderOutputSettings(ID_OM_WAVE));
+            encoderSettings.m_verifyOutput = true;
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            SettingsManager settingsManager;
+            settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+            settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_24);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("verifying must not have failed"));
+            Assert::IsTrue(encoder.GetAllErrorInfos().empty(), _T("there must be no errors"));
+            Assert::IsTrue(Path::FileExists(flacFilename), _T("FLAC output file must exist"));
+            Assert::IsTrue(Path::FileExists(waveFilename), _T("wave output file must exist"));
+         }
+      }
+
+      /// tests that re-encoding FLAC to FLAC copies the audio frames unchanged
+      TEST_METHOD(TestPassThroughFlacToFlac)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.flac"));
+         ExtractFromResource(IDR_SAMPLE_FLAC, originalFilename);
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("output.flac"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = originalFilename;
+            encoderSettings.m_outputFilename = outputFilename;
+            encoderSettings.m_outputModuleID = ID_OM_FLAC;
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            // a different compression level doesn't change the decoded samples
+            SettingsManager settingsManager;
+            settingsManager.setValue(FlacCompressionLevel, 0);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+            Assert::IsTrue(Path::FileExists(outputFilename), _T("output file must exist"));
+         }
+
+         // only the metadata blocks at the start of the file may be rewritten;
+         // the audio frames at the end must be the same
+         std::vector<char> originalContent = ReadFileContent(originalFilename);
+         std::vector<char> outputContent = ReadFileContent(outputFilename);
+
+         const size_t compareLength = 4096;
+         Assert::IsTrue(originalContent.size() > compareLength && outputContent.size() > compareLength,
+            _T("files must be large enough"));
+
+         Assert::IsTrue(std::equal(originalContent.end() - compareLength, originalContent.end(),
+            outputContent.end() - compareLength),
+            _T("audio frames must have been copied unchanged"));
+
+         Assert::IsTrue(ReadAudioSamples(originalFilename) == ReadAudioSamples(outputFilename),
+            _T("output samples must match the original samples"));
+      }
+
+   private:
+      /// reads whole file
+      static std::vector<char> ReadFileContent(const CString& filename)
+      {
+         std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+         return std::vector<char>(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+      }
+
+      /// reads all audio samples of given sound file
+      static std::vector<short> ReadAudioSamples(const CString& filename)
+      {
+         SF_INFO info = {};
+         SNDFILE* sndfile = sf_open(CStringA(Encoder::GetAnsiCompatFilename(filename)), SFM_READ, &info);
+         Assert::IsNotNull(sndfile, _T("sound file must be opened"));
+
+         std::vector<short> samples(static_cast<size_t>(info.frames * info.channels));
+         sf_count_t numRead = sf_read_short(sndfile, samples.data(), samples.size());
+         sf_close(sndfile);
+
+         samples.resize(static_cast<size_t>(numRead));
+         return samples;
+      }
    };
 }
@@ -0,0 +1,304 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestEncoderConcurrency.cpp
+/// \brief Stress test encoding all input and output module pairs at the same time
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/IoCContainer.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "EncoderImpl.hpp"
+#include "ModuleManager.hpp"
+#include "ModuleManagerImpl.hpp"
+#include "OutputModule.hpp"
+#include <sndfile.h>
+#include <atomic>
+#include <random>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// stress tests encoding with all modules on many threads
+   TEST_CLASS(TestEncoderConcurrency), public EncoderTestFixture
+   {
+   public:
+      /// number of threads encoding at the same time
+      static const unsigned int c_numThreads = 32;
+
+      /// number of times each input and output module pair is encoded
+      static const unsigned int c_numRunsPerPair = 3;
+
+      /// maximum delay before stopping or pausing an encoder, in milliseconds
+      static const unsigned int c_maxDelayInMilliseconds = 200;
+
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// \brief encodes all pairs of input and output modules on many threads
+      /// \details Each pair is encoded alone first. Then all pairs are encoded
+      /// several times on many threads at once, and some encoders are stopped
+      /// or paused at random. Encoders that weren't stopped must succeed the
+      /// same way as when encoding alone, and no temp files may be left.
+      TEST_METHOD(TestAllModulePairsConcurrently)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         std::vector<CString> inputFilenames = ExtractSampleFiles(folder.FolderName());
+         std::vector<int> outputModuleIds = GetOutputModuleIds();
+
+         // reference pass; encode each pair alone
+         std::vector<Job> jobList;
+         for (const CString& inputFilename : inputFilenames)
+         {
+            for (int outputModuleId : outputModuleIds)
+            {
+               Job job;
+               job.m_inputFilename = inputFilename;
+               job.m_outputModuleId = outputModuleId;
+               job.m_outputFilename = GetOutputFilename(folder.FolderName(), jobList.size(), outputModuleId);
+
+               job.m_referenceResult = RunJob(job);
+               jobList.push_back(job);
+            }
+         }
+
+         // set up concurrent jobs; the random actions are chosen up front, so
+         // that the threads don't share the random number generator
+         std::mt19937 randomGenerator(42);
+         std::uniform_int_distribution<int> actionDistribution(actionRun, actionPause);
+         std::uniform_int_distribution<unsigned int> delayDistribution(0, c_maxDelayInMilliseconds);
+
+         std::vector<Job> concurrentJobList;
+         for (unsigned int runIndex = 0; runIndex < c_numRunsPerPair; runIndex++)
+         {
+            for (const Job& referenceJob : jobList)
+            {
+               Job job = referenceJob;
+               job.m_outputFilename = GetOutputFilename(
+                  folder.FolderName(), jobList.size() + concurrentJobList.size(), job.m_outputModuleId);
+               job.m_action = static_cast<Action>(actionDistribution(randomGenerator));
+               job.m_delayInMilliseconds = delayDistribution(randomGenerator);
+
+               concurrentJobList.push_back(job);
+            }
+         }
+
+         // concurrent pass; the threads only store results, since asserts
+         // must happen on the test thread
+         std::atomic<size_t> nextJobIndex{ 0 };
+
+         std::vector<std::thread> threadList;
+         for (unsigned int threadIndex = 0; threadIndex < c_numThreads; threadIndex++)
+         {
+            threadList.emplace_back([&]()
+            {
+               size_t jobIndex;
+               while ((jobIndex = nextJobIndex++) < concurrentJobList.size())
+               {
+                  Job& job = concurrentJobList[jobIndex];
+                  job.m_result = RunJob(job);
+               }
+            });
+         }
+
+         for (std::thread& thread : threadList)
+            thread.join();
+
+         // check results
+         for (const Job& job : concurrentJobList)
+         {
+            if (job.m_action == actionStop)
+               continue;
+
+            CString message;
+            message.Format(_T("encoding %s to module %i must have the same result as when encoding alone"),
+               Path::FilenameAndExt(job.m_inputFilename).GetString(),
+               job.m_outputModuleId);
+
+            Assert::AreEqual(job.m_referenceResult, job.m_result, message);
+         }
+
+         Assert::AreEqual(0U, CountTempFiles(folder.FolderName()), _T("no temp files must be left"));
+      }
+
+   private:
+      /// action done while encoding a job
+      enum Action
+      {
+         actionRun = 0,    ///< runs the encoder to completion
+         actionStop = 1,   ///< stops the encoder after a delay
+         actionPause = 2,  ///< pauses and resumes the encoder after a delay
+      };
+
+      /// single encoding job
+      struct Job
+      {
+         /// input filename
+         CString m_inputFilename;
+
+         /// output module ID
+         int m_outputModuleId = 0;
+
+         /// output filename
+         CString m_outputFilename;
+
+         /// action done while encoding
+         Action m_action = actionRun;
+
+         /// delay before the action, in milliseconds
+         unsigned int m_delayInMilliseconds = 0;
+
+         /// result when the pair was encoded alone
+         bool m_referenceResult = false;
+
+         /// result when encoded concurrently
+         bool m_result = false;
+      };
+
+      /// extracts all sample files to given folder and returns their filenames
+      static std::vector<CString> ExtractSampleFiles(const CString& folderName)
+      {
+         static const struct { UINT m_resourceId; LPCTSTR m_filename; } c_sampleFiles[] =
+         {
+            { IDR_SAMPLE_MP3, _T("sample.mp3") },
+            { IDR_SAMPLE_WAV, _T("sample.wav") },
+            { IDR_SAMPLE_OPUS, _T("sample.opus") },
+            { IDR_SAMPLE_OGGV, _T("sample.ogg") },
+            { IDR_SAMPLE_AAC, _T("sample.aac") },
+            { IDR_SAMPLE_WMA, _T("sample.wma") },
+            { IDR_SAMPLE_FLAC, _T("sample.flac") },
+            { IDR_SAMPLE_AIFF, _T("sample.aiff") },
+            { IDR_SAMPLE_SPEEX, _T("sample.spx") },
+            { IDR_SAMPLE_MONKEYS_AUDIO, _T("sample.ape") },
+         };
+
+         std::vector<CString> filenameList;
+         for (const auto& sampleFile : c_sampleFiles)
+         {
+            CString filename = Path::Combine(folderName, sampleFile.m_filename);
+            ExtractFromResource(sampleFile.m_resourceId, filename);
+
+            filenameList.push_back(filename);
+         }
+
+         return filenameList;
+      }
+
+      /// returns the IDs of all available output modules
+      static std::vector<int> GetOutputModuleIds()
+      {
+         Encoder::ModuleManager& moduleManager = IoCContainer::Current().Resolve<Encoder::ModuleManager>();
+
+         std::vector<int> moduleIdList;
+         for (size_t index = 0, maxIndex = moduleManager.GetOutputModuleCount(); index < maxIndex; index++)
+            moduleIdList.push_back(moduleManager.GetOutputModuleID(index));
+
+         return moduleIdList;
+      }
+
+      /// returns a unique output filename for given job index and output module
+      static CString GetOutputFilename(const CString& folderName, size_t jobIndex, int outputModuleId)
+      {
+         Encoder::ModuleManagerImpl moduleManager;
+
+         std::unique_ptr<Encoder::OutputModule> outputModule(moduleManager.GetOutputModule(outputModuleId));
+
+         CString filename;
+         filename.Format(_T("output-%zu.%s"),
+            jobIndex,
+            outputModule != nullptr ? outputModule->GetOutputExtension().GetString() : _T("out"));
+
+         return Path::Combine(folderName, filename);
+      }
+
+      /// encodes a single job; returns if encoding succeeded and the output
+      /// file exists
+      static bool RunJob(const Job& job)
+      {
+         Encoder::EncoderImpl encoder;
+
+         Encoder::EncoderSettings encoderSettings;
+         encoderSettings.m_inputFilename = job.m_inputFilename;
+         encoderSettings.m_outputFilename = job.m_outputFilename;
+         encoderSettings.m_outputModuleID = job.m_outputModuleId;
+         encoderSettings.m_overwriteExisting = true;
+
+         encoder.SetEncoderSettings(encoderSettings);
+
+         SettingsManager settingsManager;
+         settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+         settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_16);
+
+         encoder.SetSettingsManager(&settingsManager);
+
+         encoder.StartEncode();
+
+         switch (job.m_action)
+         {
+         case actionStop:
+            Sleep(job.m_delayInMilliseconds);
+            encoder.StopEncode();
+            break;
+
+         case actionPause:
+            Sleep(job.m_delayInMilliseconds);
+            encoder.PauseEncoding();
+            Sleep(job.m_delayInMilliseconds);
+            encoder.PauseEncoding();
+            break;
+
+         default:
+            break;
+         }
+
+         encoder.WaitEncodeFinished();
+         encoder.StopEncode();
+
+         return encoder.GetEncoderState().m_errorCode == 0 &&
+            Path::FileExists(job.m_outputFilename);
+      }
+
+      /// returns number of temp files in given folder
+      static unsigned int CountTempFiles(const CString& folderName)
+      {
+         WIN32_FIND_DATA findData = {};
+         HANDLE findHandle = FindFirstFile(Path::Combine(folderName, _T("*.temp")), &findData);
+         if (findHandle == INVALID_HANDLE_VALUE)
+            return 0;
+
+         unsigned int count = 0;
+         do
+         {
+            count++;
+         } while (FindNextFile(findHandle, &findData));
+
+         FindClose(findHandle);
+
+         return count;
+      }
+   };
+}
@@ -0,0 +1,145 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestFileSystemCache.cpp
+/// \brief Tests for the FileSystemCache class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "FileSystemCache.hpp"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for FileSystemCache class
+   TEST_CLASS(TestFileSystemCache)
+   {
+   public:
+      /// number of output files checked in the benchmark
+      static const unsigned int c_numBenchmarkFiles = 200;
+
+      /// tests that existing files are found, and that the folder is only listed once
+      TEST_METHOD(TestFileExists)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString filename = CreateTestFile(folder.FolderName(), _T("Output.mp3"));
+
+         Encoder::FileSystemCache cache;
+
+         Assert::IsTrue(cache.FileExists(filename), _T("file must exist"));
+
+         unsigned int numCalls = cache.GetNumFileSystemCalls();
+
+         Assert::IsTrue(cache.FileExists(Path::Combine(folder.FolderName(), _T("output.MP3"))),
+            _T("file must be found regardless of case"));
+         Assert::IsFalse(cache.FileExists(Path::Combine(folder.FolderName(), _T("other.mp3"))),
+            _T("other file must not exist"));
+         Assert::IsTrue(cache.FolderExists(folder.FolderName()), _T("folder must exist"));
+
+         Assert::AreEqual(numCalls, cache.GetNumFileSystemCalls(), _T("folder must only be listed once"));
+      }
+
+      /// tests that files added and removed by encoder tasks are cached
+      TEST_METHOD(TestAddRemoveFile)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString filename = Path::Combine(folder.FolderName(), _T("output.mp3"));
+
+         Encoder::FileSystemCache cache;
+
+         Assert::IsFalse(cache.FileExists(filename), _T("file must not exist yet"));
+
+         cache.AddFile(filename);
+         Assert::IsTrue(cache.FileExists(filename), _T("added file must exist"));
+
+         cache.RemoveFile(filename);
+         Assert::IsFalse(cache.FileExists(filename), _T("removed file must not exist"));
+
+         CreateTestFile(folder.FolderName(), _T("output.mp3"));
+         Assert::IsFalse(cache.FileExists(filename), _T("file created by others must not be seen"));
+
+         cache.InvalidateFolder(folder.FolderName());
+         Assert::IsTrue(cache.FileExists(filename), _T("file must be seen after invalidating the folder"));
+      }
+
+      /// tests creating folders
+      TEST_METHOD(TestCreateFolder)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString folderName = Path::Combine(folder.FolderName(), _T("artist\\album"));
+
+         Encoder::FileSystemCache cache;
+
+         Assert::IsFalse(cache.FolderExists(folderName), _T("folder must not exist yet"));
+
+         cache.CreateFolder(folderName);
+
+         Assert::IsTrue(Path::FolderExists(folderName), _T("folder must have been created"));
+         Assert::IsTrue(cache.FolderExists(folderName), _T("created folder must exist in cache"));
+      }
+
+      /// \brief counts file system calls per output file, as a benchmark
+      /// \details does the same checks as the encoder does for each output
+      /// file of a batch that is written into the same folder
+      TEST_METHOD(TestFileSystemCallsPerFile)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         Encoder::FileSystemCache cache;
+
+         for (unsigned int fileIndex = 0; fileIndex < c_numBenchmarkFiles; fileIndex++)
+         {
+            CString filename;
+            filename.Format(_T("track%03u.mp3"), fileIndex);
+            filename = Path::Combine(folder.FolderName(), filename);
+
+            Assert::IsFalse(cache.FileExists(filename), _T("output file must not exist yet"));
+
+            cache.CreateFolder(folder.FolderName());
+            cache.AddFile(filename);
+         }
+
+         unsigned int numCalls = cache.GetNumFileSystemCalls();
+
+         CString message;
+         message.Format(_T("%u file system calls for %u files\n"), numCalls, c_numBenchmarkFiles);
+         Logger::WriteMessage(message);
+
+         Assert::IsTrue(numCalls < c_numBenchmarkFiles, _T("there must be less than one file system call per file"));
+      }
+
+   private:
+      /// creates a test file in given folder and returns its pathname
+      static CString CreateTestFile(const CString& folderName, LPCTSTR filename)
+      {
+         CString pathname = Path::Combine(folderName, filename);
+
+         std::ofstream outputFile(pathname, std::ios::out | std::ios::binary);
+         outputFile.write("test", 4);
+
+         return pathname;
+      }
+   };
+}
@@ -0,0 +1,187 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestInputModuleSeek.cpp
+/// \brief Tests seeking in input modules
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "ModuleManagerImpl.hpp"
+#include "SettingsManager.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for seeking in input modules; the samples decoded after seeking
+   /// are compared with the samples of a linear decode
+   TEST_CLASS(TestInputModuleSeek), public EncoderTestFixture
+   {
+   public:
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// tests seeking in wave file
+      TEST_METHOD(TestSeekWave)
+      {
+         CheckSeek(IDR_SAMPLE_WAV, _T("sample.wav"), 0);
+      }
+
+      /// tests seeking in AIFF file
+      TEST_METHOD(TestSeekAiff)
+      {
+         CheckSeek(IDR_SAMPLE_AIFF, _T("sample.aiff"), 0);
+      }
+
+      /// tests seeking in FLAC file
+      TEST_METHOD(TestSeekFlac)
+      {
+         CheckSeek(IDR_SAMPLE_FLAC, _T("sample.flac"), 0);
+      }
+
+      /// tests seeking in Monkey's Audio file
+      TEST_METHOD(TestSeekMonkeysAudio)
+      {
+         CheckSeek(IDR_SAMPLE_MONKEYS_AUDIO, _T("sample.ape"), 0);
+      }
+
+      /// tests seeking in Ogg Vorbis file
+      TEST_METHOD(TestSeekOggVorbis)
+      {
+         CheckSeek(IDR_SAMPLE_OGGV, _T("sample.ogg"), 0);
+      }
+
+      /// tests seeking in Opus file; the decoder state after seeking
+      /// converges during the pre-roll, so small differences are allowed
+      TEST_METHOD(TestSeekOpus)
+      {
+         CheckSeek(IDR_SAMPLE_OPUS, _T("sample.opus"), 64);
+      }
+
+      /// tests seeking in MP3 file; the bit reservoir is restored from
+      /// previous frames, so small differences are allowed
+      TEST_METHOD(TestSeekMp3)
+      {
+         CheckSeek(IDR_SAMPLE_MP3, _T("sample.mp3"), 64);
+      }
+
+   private:
+      /// decoded samples, 16-bit interleaved
+      struct DecodedSamples
+      {
+         std::vector<short> m_samples;    ///< samples
+         int m_numChannels = 0;           ///< number of channels
+      };
+
+      /// extracts sample file and checks seeking to multiple positions;
+      /// the decoded samples may differ by the given tolerance
+      void CheckSeek(UINT resourceId, LPCTSTR filename, int tolerance)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), filename);
+         ExtractFromResource(resourceId, inputFilename);
+
+         DecodedSamples linearSamples = Decode(inputFilename, -1);
+
+         __int64 numTotalSamples = static_cast<__int64>(linearSamples.m_samples.size() / linearSamples.m_numChannels);
+         Assert::IsTrue(numTotalSamples > 1000, _T("sample file must contain samples"));
+
+         // seek to unaligned positions at the start, the middle and near the end
+         const __int64 positionList[] = { 0, 1, 1153, numTotalSamples / 3 + 7, numTotalSamples / 2, numTotalSamples - 100 };
+
+         for (__int64 samplePosition : positionList)
+         {
+            DecodedSamples seekedSamples = Decode(inputFilename, samplePosition);
+
+            size_t offset = static_cast<size_t>(samplePosition * linearSamples.m_numChannels);
+            Assert::AreEqual(linearSamples.m_samples.size() - offset, seekedSamples.m_samples.size(),
+               _T("number of samples after seeking must match"));
+
+            for (size_t index = 0; index < seekedSamples.m_samples.size(); index++)
+            {
+               int difference = abs(linearSamples.m_samples[offset + index] - seekedSamples.m_samples[index]);
+               if (difference > tolerance)
+               {
+                  CString message;
+                  message.Format(_T("sample %zu after seeking to %I64d differs by %i"), index, samplePosition, difference);
+                  Assert::Fail(message);
+               }
+            }
+         }
+      }
+
+      /// decodes input file, starting at given sample position; a position
+      /// of -1 decodes without seeking, and checks the total number of samples
+      static DecodedSamples Decode(const CString& inputFilename, __int64 samplePosition)
+      {
+         Encoder::ModuleManagerImpl moduleManager;
+
+         std::unique_ptr<Encoder::InputModule> inputModule(moduleManager.ChooseInputModule(inputFilename));
+         Assert::IsNotNull(inputModule.get(), _T("input module must be found"));
+
+         Encoder::TrackInfo trackInfo;
+         Encoder::SampleContainer sampleContainer;
+         SettingsManager settingsManager;
+
+         int ret = inputModule->InitInput(inputFilename, settingsManager, trackInfo, sampleContainer);
+         Assert::IsTrue(ret >= 0, _T("input module must be initialized"));
+
+         Assert::IsTrue(inputModule->CanSeek(), _T("input module must be able to seek"));
+
+         sampleContainer.SetOutputModuleTraits(16, Encoder::SamplesInterleaved);
+
+         __int64 numTotalSamples = inputModule->GetTotalSamples();
+
+         if (samplePosition >= 0)
+            Assert::AreEqual(0, inputModule->SeekToSample(samplePosition), _T("seeking must succeed"));
+
+         DecodedSamples decodedSamples;
+         decodedSamples.m_numChannels = sampleContainer.GetInputModuleChannels();
+
+         while ((ret = inputModule->DecodeSamples(sampleContainer)) > 0)
+         {
+            int numSamples = 0;
+            const short* samples = static_cast<const short*>(sampleContainer.GetSamplesInterleaved(numSamples));
+
+            decodedSamples.m_samples.insert(decodedSamples.m_samples.end(),
+               samples, samples + numSamples * decodedSamples.m_numChannels);
+         }
+
+         Assert::AreEqual(0, ret, _T("decoding must not fail"));
+
+         inputModule->DoneInput();
+
+         if (samplePosition < 0)
+         {
+            Assert::AreEqual(numTotalSamples,
+               static_cast<__int64>(decodedSamples.m_samples.size() / decodedSamples.m_numChannels),
+               _T("total number of samples must match the decoded samples"));
+         }
+
+         return decodedSamples;
+      }
+   };
+}
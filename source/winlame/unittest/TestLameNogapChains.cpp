@@ -0,0 +1,357 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestLameNogapChains.cpp
+/// \brief Tests encoding multiple LAME nogap chains at the same time
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/IoCContainer.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "CueSheet.hpp"
+#include "EncoderImpl.hpp"
+#include "LameNogapInstanceManager.hpp"
+#include <sndfile.h>
+#include <fstream>
+#include <set>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for nogap encoding with the LAME mp3 encoder
+   TEST_CLASS(TestLameNogapChains), public EncoderTestFixture
+   {
+   public:
+      /// number of tracks the sample file is split into
+      static const unsigned int c_numTracks = 4;
+
+      /// number of nogap chains encoded at the same time
+      static const unsigned int c_numChains = 8;
+
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// tests that nogap instance IDs are unique when requested by many threads
+      TEST_METHOD(TestConcurrentInstanceIds)
+      {
+         Encoder::LameNogapInstanceManager nogapInstanceManager;
+
+         const unsigned int numThreads = 8;
+         const unsigned int numIdsPerThread = 1000;
+
+         std::vector<std::vector<int>> allIds(numThreads);
+         std::vector<std::thread> threads;
+
+         for (unsigned int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+         {
+            threads.emplace_back([&nogapInstanceManager, &allIds, threadIndex]()
+            {
+               for (unsigned int index = 0; index < numIdsPerThread; index++)
+                  allIds[threadIndex].push_back(nogapInstanceManager.NextNogapInstanceId());
+            });
+         }
+
+         for (std::thread& thread : threads)
+            thread.join();
+
+         std::set<int> uniqueIds;
+         for (const std::vector<int>& ids : allIds)
+            uniqueIds.insert(ids.begin(), ids.end());
+
+         Assert::AreEqual<size_t>(numThreads * numIdsPerThread, uniqueIds.size(), _T("all IDs must be unique"));
+      }
+
+      /// tests that two albums in the same folder are encoded as two chains
+      TEST_METHOD(TestChainKeysOfAlbumsInOneFolder)
+      {
+         // cue sheet tracks, with the disc images in the same folder
+         Encoder::EncoderJob cueJob1(_T("C:\\Music\\Album1.wav"));
+         cueJob1.CueSheetFilename(_T("C:\\Music\\Album1.cue"));
+         cueJob1.Range(0, 1000);
+
+         Encoder::EncoderJob cueJob2(cueJob1);
+         cueJob2.Range(1000, 0);
+
+         Encoder::EncoderJob cueJob3(_T("C:\\Music\\Album2.wav"));
+         cueJob3.CueSheetFilename(_T("C:\\Music\\Album2.cue"));
+
+         Assert::AreEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(cueJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(cueJob2).GetString(),
+            _T("tracks of one cue sheet must use the same chain"));
+         Assert::AreNotEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(cueJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(cueJob3).GetString(),
+            _T("tracks of two cue sheets must use different chains"));
+
+         // tracks with album track info
+         Encoder::EncoderJob albumJob1 = CreateAlbumJob(_T("C:\\Music\\01.wav"), _T("Album 1"));
+         Encoder::EncoderJob albumJob2 = CreateAlbumJob(_T("C:\\Music\\02.wav"), _T("Album 1"));
+         Encoder::EncoderJob albumJob3 = CreateAlbumJob(_T("C:\\Music\\03.wav"), _T("Album 2"));
+
+         Assert::AreEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(albumJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(albumJob2).GetString(),
+            _T("tracks of one album must use the same chain"));
+         Assert::AreNotEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(albumJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(albumJob3).GetString(),
+            _T("tracks of two albums must use different chains"));
+
+         // tracks without album use the folder
+         Encoder::EncoderJob folderJob1(_T("C:\\Music\\04.wav"));
+         Encoder::EncoderJob folderJob2(_T("C:\\MUSIC\\05.wav"));
+         Encoder::EncoderJob folderJob3(_T("C:\\Other\\06.wav"));
+
+         Assert::AreEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(folderJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(folderJob2).GetString(),
+            _T("tracks in one folder must use the same chain"));
+         Assert::AreNotEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(folderJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(folderJob3).GetString(),
+            _T("tracks in two folders must use different chains"));
+         Assert::AreNotEqual(
+            Encoder::LameNogapInstanceManager::GetChainKey(folderJob1).GetString(),
+            Encoder::LameNogapInstanceManager::GetChainKey(albumJob1).GetString(),
+            _T("tracks without album must not use an album chain"));
+      }
+
+      /// \brief tests encoding many nogap chains at the same time
+      /// \details the sample file is split into tracks, and each chain encodes
+      /// all tracks, one after another. The output files of all chains must be
+      /// the same as the output files of a chain that was encoded alone, and
+      /// the decoded tracks must join up to the length of the sample file.
+      TEST_METHOD(TestConcurrentChains)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString originalFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, originalFilename);
+
+         std::vector<unsigned int> splitFrames = GetSplitFrames(originalFilename);
+
+         // encode reference chain alone
+         CString referenceFolder = Path::Combine(folder.FolderName(), _T("reference"));
+         CreateDirectory(referenceFolder, nullptr);
+
+         bool referenceResult = EncodeChain(originalFilename, splitFrames, referenceFolder);
+         Assert::IsTrue(referenceResult, _T("encoding reference chain must succeed"));
+
+         // encode all chains at the same time; asserts must not be called in
+         // the threads, so only results are stored
+         std::vector<CString> chainFolders;
+         for (unsigned int chainIndex = 0; chainIndex < c_numChains; chainIndex++)
+         {
+            CString chainFolder;
+            chainFolder.Format(_T("chain%u"), chainIndex);
+            chainFolders.push_back(Path::Combine(folder.FolderName(), chainFolder));
+            CreateDirectory(chainFolders.back(), nullptr);
+         }
+
+         std::vector<char> chainResults(c_numChains, false);
+         std::vector<std::thread> threads;
+
+         for (unsigned int chainIndex = 0; chainIndex < c_numChains; chainIndex++)
+         {
+            threads.emplace_back([&, chainIndex]()
+            {
+               chainResults[chainIndex] = EncodeChain(originalFilename, splitFrames, chainFolders[chainIndex]);
+            });
+         }
+
+         for (std::thread& thread : threads)
+            thread.join();
+
+         for (unsigned int chainIndex = 0; chainIndex < c_numChains; chainIndex++)
+         {
+            Assert::IsTrue(chainResults[chainIndex] != 0, _T("encoding chain must succeed"));
+
+            for (unsigned int trackIndex = 0; trackIndex < c_numTracks; trackIndex++)
+            {
+               Assert::IsTrue(
+                  ReadFileContent(GetTrackFilename(referenceFolder, trackIndex)) ==
+                  ReadFileContent(GetTrackFilename(chainFolders[chainIndex], trackIndex)),
+                  _T("track of a chain must be the same as the track of the reference chain"));
+            }
+         }
+
+         // decoded tracks must join without gaps
+         size_t numOriginalSamples = ReadAudioSamples(originalFilename).size();
+
+         size_t numJoinedSamples = 0;
+         for (unsigned int trackIndex = 0; trackIndex < c_numTracks; trackIndex++)
+         {
+            CString decodedFilename = Path::Combine(referenceFolder, _T("decoded.wav"));
+            Decode(GetTrackFilename(referenceFolder, trackIndex), decodedFilename);
+
+            numJoinedSamples += ReadAudioSamples(decodedFilename).size();
+            DeleteFile(decodedFilename);
+         }
+
+         // allow one mp3 frame of stereo samples, since the end of the last
+         // track is padded to a whole frame
+         const size_t maxDifference = 1152 * 2;
+         Assert::IsTrue(numJoinedSamples + maxDifference >= numOriginalSamples &&
+            numJoinedSamples <= numOriginalSamples + maxDifference,
+            _T("decoded tracks must join up to the length of the sample file"));
+      }
+
+   private:
+      /// creates encoder job with given album in the track info
+      static Encoder::EncoderJob CreateAlbumJob(const CString& inputFilename, const CString& album)
+      {
+         Encoder::EncoderJob job(inputFilename);
+         job.GetTrackInfo().SetTextInfo(Encoder::TrackInfoAlbum, album);
+         job.UseTrackInfo(true);
+
+         return job;
+      }
+
+      /// returns CD frames at which the sample file is split into tracks;
+      /// contains the start frame of each track and the end frame of the
+      /// last track
+      static std::vector<unsigned int> GetSplitFrames(const CString& filename)
+      {
+         SF_INFO info = {};
+         SNDFILE* sndfile = sf_open(CStringA(Encoder::GetAnsiCompatFilename(filename)), SFM_READ, &info);
+         Assert::IsNotNull(sndfile, _T("sound file must be opened"));
+         sf_close(sndfile);
+
+         unsigned int numFrames = static_cast<unsigned int>(info.frames * Encoder::CueSheet::c_framesPerSecond / info.samplerate);
+         Assert::IsTrue(numFrames >= c_numTracks, _T("sample file must be long enough"));
+
+         std::vector<unsigned int> splitFrames;
+         for (unsigned int trackIndex = 0; trackIndex < c_numTracks; trackIndex++)
+            splitFrames.push_back(numFrames * trackIndex / c_numTracks);
+
+         // the last track ends at the end of the file
+         splitFrames.push_back(0);
+
+         return splitFrames;
+      }
+
+      /// returns filename of an encoded track
+      static CString GetTrackFilename(const CString& folderName, unsigned int trackIndex)
+      {
+         CString filename;
+         filename.Format(_T("track%u.mp3"), trackIndex + 1);
+
+         return Path::Combine(folderName, filename);
+      }
+
+      /// \brief encodes all tracks of the sample file as one nogap chain
+      /// \details may be called from multiple threads; returns false when
+      /// encoding a track failed
+      static bool EncodeChain(const CString& inputFilename,
+         const std::vector<unsigned int>& splitFrames, const CString& outputFolder)
+      {
+         Encoder::LameNogapInstanceManager& nogapInstanceManager =
+            IoCContainer::Current().Resolve<Encoder::LameNogapInstanceManager>();
+
+         int nogapInstanceId = nogapInstanceManager.NextNogapInstanceId();
+
+         for (unsigned int trackIndex = 0; trackIndex < c_numTracks; trackIndex++)
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = inputFilename;
+            encoderSettings.m_outputFilename = GetTrackFilename(outputFolder, trackIndex);
+            encoderSettings.m_outputModuleID = ID_OM_LAME;
+            encoderSettings.m_rangeStartFrame = splitFrames[trackIndex];
+            encoderSettings.m_rangeEndFrame = splitFrames[trackIndex + 1];
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            SettingsManager settingsManager;
+            settingsManager.setValue(LameSimpleQualityOrBitrate, 0);
+            settingsManager.setValue(LameSimpleEncodeQuality, 1);
+            settingsManager.setValue(LameSimpleQuality, 4);
+            settingsManager.setValue(LameOptNoGap, 1);
+            settingsManager.setValue(LameNoGapInstanceId, nogapInstanceId);
+
+            if (trackIndex == c_numTracks - 1)
+               settingsManager.setValue(GeneralIsLastFile, 1);
+
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            if (encoder.GetEncoderState().m_errorCode != 0 ||
+               !Path::FileExists(encoderSettings.m_outputFilename))
+               return false;
+         }
+
+         // the last track of the chain must have removed the instance
+         return !nogapInstanceManager.IsRegistered(nogapInstanceId);
+      }
+
+      /// decodes mp3 file to 16-bit wave file
+      static void Decode(const CString& inputFilename, const CString& outputFilename)
+      {
+         Encoder::EncoderImpl encoder;
+
+         Encoder::EncoderSettings encoderSettings;
+         encoderSettings.m_inputFilename = inputFilename;
+         encoderSettings.m_outputFilename = outputFilename;
+         encoderSettings.m_outputModuleID = ID_OM_WAVE;
+
+         encoder.SetEncoderSettings(encoderSettings);
+
+         SettingsManager settingsManager;
+         settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+         settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_16);
+         encoder.SetSettingsManager(&settingsManager);
+
+         StartEncodeAndWaitForFinish(encoder);
+
+         Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("decoding must not have failed"));
+      }
+
+      /// reads whole file
+      static std::vector<char> ReadFileContent(const CString& filename)
+      {
+         std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+         return std::vector<char>(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+      }
+
+      /// reads all audio samples of given sound file
+      static std::vector<short> ReadAudioSamples(const CString& filename)
+      {
+         SF_INFO info = {};
+         SNDFILE* sndfile = sf_open(CStringA(Encoder::GetAnsiCompatFilename(filename)), SFM_READ, &info);
+         Assert::IsNotNull(sndfile, _T("sound file must be opened"));
+
+         std::vector<short> samples(static_cast<size_t>(info.frames * info.channels));
+         sf_count_t numRead = sf_read_short(sndfile, samples.data(), samples.size());
+         sf_close(sndfile);
+
+         samples.resize(static_cast<size_t>(numRead));
+         return samples;
+      }
+   };
+}
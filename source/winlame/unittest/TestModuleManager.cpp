@@ -157,6 +157,29 @@ namespace unittest
          }
       }
 
+      /// tests choosing input modules by file extension, and getting output
+      /// modules by ID, with newly created module managers
+      TEST_METHOD(TestLookupModules)
+      {
+         for (int index = 0; index < 2; index++)
+         {
+            Encoder::ModuleManagerImpl moduleManager;
+
+            std::unique_ptr<Encoder::InputModule> inputModule(moduleManager.ChooseInputModule(_T("C:\\Music\\Track.MP3")));
+            Assert::IsNotNull(inputModule.get(), _T("input module for mp3 files must be found"));
+            Assert::AreEqual(ID_IM_LIBMPG123, inputModule->GetModuleID(), _T("input module must be libmpg123"));
+
+            Assert::IsNull(moduleManager.ChooseInputModule(_T("C:\\Music\\Track")),
+               _T("input module must not be found for files without extension"));
+
+            std::unique_ptr<Encoder::OutputModule> outputModule(moduleManager.GetOutputModule(ID_OM_WAVE));
+            Assert::IsNotNull(outputModule.get(), _T("wave output module must be found"));
+            Assert::AreEqual(ID_OM_WAVE, outputModule->GetModuleID(), _T("output module ID must match"));
+
+            Assert::IsNull(moduleManager.GetOutputModule(-1), _T("unknown output module must not be found"));
+         }
+      }
+
       /// Tests getting combined filter string
       TEST_METHOD(TestGetFilterString)
       {
@@ -0,0 +1,385 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestMp3FrameCopier.cpp
+/// \brief Tests for the Mp3FrameCopier class and MP3 pass-through encoding
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "Mp3FrameCopier.hpp"
+#include "EncoderImpl.hpp"
+#include "ModuleManagerImpl.hpp"
+#include "SettingsManager.hpp"
+#include <fstream>
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for Mp3FrameCopier class
+   TEST_CLASS(TestMp3FrameCopier), public EncoderTestFixture
+   {
+   public:
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// tests that the copied frames decode to exactly the same samples
+      TEST_METHOD(TestCopySampleAccurate)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("copy.mp3"));
+
+         Encoder::Mp3FrameCopier frameCopier;
+         Assert::IsTrue(frameCopier.Copy(inputFilename, outputFilename), _T("copying must succeed"));
+
+         const Encoder::Mp3StreamInfo& streamInfo = frameCopier.StreamInfo();
+         Assert::IsTrue(streamInfo.m_numFrames > 0, _T("frames must have been copied"));
+
+         std::vector<short> inputSamples = Decode(inputFilename);
+         std::vector<short> outputSamples = Decode(outputFilename);
+
+         Assert::IsTrue(inputSamples == outputSamples, _T("decoded samples must be the same"));
+
+         if (streamInfo.m_hasLameTag)
+         {
+            Assert::AreEqual<__int64>(streamInfo.GetNumSamples() * streamInfo.m_numChannels,
+               static_cast<__int64>(outputSamples.size()),
+               _T("encoder delay and padding must be trimmed"));
+         }
+      }
+
+      /// tests that tags and junk data are left out
+      TEST_METHOD(TestCopySkipsTagsAndJunk)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         CString cleanFilename = Path::Combine(folder.FolderName(), _T("clean.mp3"));
+
+         Encoder::Mp3FrameCopier frameCopier;
+         Assert::IsTrue(frameCopier.Copy(inputFilename, cleanFilename), _T("copying must succeed"));
+
+         unsigned int numFrames = frameCopier.StreamInfo().m_numFrames;
+
+         // add ID3v2 tag, junk data with a false sync word, and an ID3v1 tag
+         std::vector<char> content = ReadFileContent(cleanFilename);
+
+         std::vector<char> taggedContent = { 'I', 'D', '3', 4, 0, 0, 0, 0, 0, 20 };
+         taggedContent.insert(taggedContent.end(), 20, 0);
+         taggedContent.insert(taggedContent.end(), { 0, char(0xff), char(0xfb), 0x12, 0 });
+         taggedContent.insert(taggedContent.end(), content.begin(), content.end());
+
+         std::vector<char> id3v1Tag(128, 0);
+         id3v1Tag[0] = 'T'; id3v1Tag[1] = 'A'; id3v1Tag[2] = 'G';
+         id3v1Tag[3] = char(0xff); id3v1Tag[4] = char(0xfb);
+         taggedContent.insert(taggedContent.end(), id3v1Tag.begin(), id3v1Tag.end());
+
+         CString taggedFilename = Path::Combine(folder.FolderName(), _T("tagged.mp3"));
+         WriteFileContent(taggedFilename, taggedContent);
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("copy.mp3"));
+         Assert::IsTrue(frameCopier.Copy(taggedFilename, outputFilename), _T("copying must succeed"));
+
+         Assert::AreEqual(numFrames, frameCopier.StreamInfo().m_numFrames, _T("number of frames must be the same"));
+         Assert::IsTrue(frameCopier.StreamInfo().m_numSkippedBytes > 0, _T("junk data must have been skipped"));
+         Assert::IsTrue(content == ReadFileContent(outputFilename), _T("copied frames must be the same"));
+      }
+
+      /// tests that the Info frame is updated when frames of the input file
+      /// weren't copied
+      TEST_METHOD(TestCopyUpdatesInfoFrame)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         CString cleanFilename = Path::Combine(folder.FolderName(), _T("clean.mp3"));
+
+         Encoder::Mp3FrameCopier frameCopier;
+         Assert::IsTrue(frameCopier.Copy(inputFilename, cleanFilename), _T("copying must succeed"));
+         Assert::IsTrue(frameCopier.StreamInfo().m_hasLameTag, _T("sample file must have a LAME tag"));
+
+         unsigned int numFrames = frameCopier.StreamInfo().m_numFrames;
+
+         // cut off the last frames, in the middle of a frame; the Info frame
+         // still contains the frame count of the whole file
+         std::vector<char> content = ReadFileContent(cleanFilename);
+         content.resize(content.size() * 3 / 4);
+
+         CString truncatedFilename = Path::Combine(folder.FolderName(), _T("truncated.mp3"));
+         WriteFileContent(truncatedFilename, content);
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("copy.mp3"));
+         Assert::IsTrue(frameCopier.Copy(truncatedFilename, outputFilename), _T("copying must succeed"));
+
+         const Encoder::Mp3StreamInfo& streamInfo = frameCopier.StreamInfo();
+         Assert::IsTrue(streamInfo.m_numFrames < numFrames, _T("truncated frames must not have been copied"));
+
+         std::vector<char> output = ReadFileContent(outputFilename);
+
+         auto infoHeader = std::search(output.begin(), output.begin() + 64, "Info", "Info" + 4);
+         Assert::IsTrue(infoHeader != output.begin() + 64, _T("Info frame must have been copied"));
+
+         const BYTE* frameCount = reinterpret_cast<const BYTE*>(&*infoHeader) + 8;
+         const BYTE* byteCount = frameCount + 4;
+
+         Assert::AreEqual(streamInfo.m_numFrames,
+            (unsigned int(frameCount[0]) << 24) | (unsigned int(frameCount[1]) << 16) | (unsigned int(frameCount[2]) << 8) | frameCount[3],
+            _T("frame count must have been updated"));
+         Assert::AreEqual(static_cast<unsigned int>(output.size()),
+            (unsigned int(byteCount[0]) << 24) | (unsigned int(byteCount[1]) << 16) | (unsigned int(byteCount[2]) << 8) | byteCount[3],
+            _T("byte count must have been updated"));
+
+         // the decoder uses the frame count to remove the encoder padding
+         Assert::AreEqual<__int64>(streamInfo.GetNumSamples() * streamInfo.m_numChannels,
+            static_cast<__int64>(Decode(outputFilename).size()),
+            _T("encoder delay and padding must be trimmed"));
+      }
+
+      /// tests that non-MP3 files are rejected
+      TEST_METHOD(TestCopyRejectsOtherFiles)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.wav"));
+         ExtractFromResource(IDR_SAMPLE_WAV, inputFilename);
+
+         Encoder::Mp3FrameCopier frameCopier;
+         Assert::IsFalse(frameCopier.Copy(inputFilename, Path::Combine(folder.FolderName(), _T("copy.mp3"))),
+            _T("copying a wave file must fail"));
+      }
+
+      /// tests that encoding MP3 to MP3 without differing settings copies the frames
+      TEST_METHOD(TestEncodePassThrough)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("output.mp3"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = inputFilename;
+            encoderSettings.m_outputFilename = outputFilename;
+            encoderSettings.m_outputModuleID = ID_OM_LAME;
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            // the 128 kbps input is below the typical bitrate of quality 4,
+            // so re-encoding isn't needed
+            SettingsManager settingsManager;
+            settingsManager.setValue(LameSimpleQualityOrBitrate, 1);
+            settingsManager.setValue(LameSimpleQuality, 4);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+            Assert::IsTrue(Path::FileExists(outputFilename), _T("output file must exist"));
+         }
+
+         Assert::IsTrue(Decode(inputFilename) == Decode(outputFilename),
+            _T("decoded samples must be the same"));
+      }
+
+      /// tests that encoding MP3 to MP3 with a lower quality or mono re-encodes the file
+      TEST_METHOD(TestEncodeLowerQualityReencodes)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         for (int mono = 0; mono <= 1; mono++)
+         {
+            CString outputFilename = Path::Combine(folder.FolderName(),
+               mono == 0 ? _T("output-v7.mp3") : _T("output-mono.mp3"));
+            {
+               Encoder::EncoderImpl encoder;
+
+               Encoder::EncoderSettings encoderSettings;
+               encoderSettings.m_inputFilename = inputFilename;
+               encoderSettings.m_outputFilename = outputFilename;
+               encoderSettings.m_outputModuleID = ID_OM_LAME;
+
+               encoder.SetEncoderSettings(encoderSettings);
+
+               // quality 7 is below the 128 kbps input; mono output has
+               // fewer channels than the input
+               SettingsManager settingsManager;
+               settingsManager.setValue(LameSimpleQualityOrBitrate, 1);
+               settingsManager.setValue(LameSimpleQuality, mono == 0 ? 7 : 4);
+               settingsManager.setValue(LameSimpleMono, mono);
+               encoder.SetSettingsManager(&settingsManager);
+
+               StartEncodeAndWaitForFinish(encoder);
+
+               Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+               Assert::IsTrue(Path::FileExists(outputFilename), _T("output file must exist"));
+            }
+
+            Assert::IsFalse(Decode(inputFilename) == Decode(outputFilename),
+               _T("file must have been re-encoded"));
+         }
+      }
+
+      /// tests that a VBR file is re-encoded when its average bitrate is above
+      /// the target bitrate, even though the first frame's bitrate is below
+      TEST_METHOD(TestEncodeVbrLowFirstFrameReencodes)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString inputFilename = Path::Combine(folder.FolderName(), _T("sample.mp3"));
+         ExtractFromResource(IDR_SAMPLE_MP3, inputFilename);
+
+         CString cleanFilename = Path::Combine(folder.FolderName(), _T("clean.mp3"));
+
+         Encoder::Mp3FrameCopier frameCopier;
+         Assert::IsTrue(frameCopier.Copy(inputFilename, cleanFilename), _T("copying must succeed"));
+
+         // replace the Info frame with a silent 32 kbps frame, followed by
+         // the 128 kbps frames of the sample file
+         std::vector<char> content = ReadFileContent(cleanFilename);
+
+         size_t infoFrameLength = frameCopier.StreamInfo().m_hasInfoFrame ? GetFrameLength(content.data()) : 0;
+
+         std::vector<char> silentFrame(content.begin(), content.begin() + 4);
+         silentFrame[2] = char((1 << 4) | (silentFrame[2] & 0x0c));
+         silentFrame.resize(GetFrameLength(silentFrame.data()), 0);
+
+         std::vector<char> vbrContent = silentFrame;
+         vbrContent.insert(vbrContent.end(), content.begin() + infoFrameLength, content.end());
+
+         CString vbrFilename = Path::Combine(folder.FolderName(), _T("vbr.mp3"));
+         WriteFileContent(vbrFilename, vbrContent);
+
+         Assert::IsTrue(frameCopier.Scan(vbrFilename), _T("scanning must succeed"));
+         Assert::IsTrue(frameCopier.StreamInfo().GetAverageBitrate() > 120000, _T("average bitrate must be near 128 kbps"));
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("output.mp3"));
+         {
+            Encoder::EncoderImpl encoder;
+
+            Encoder::EncoderSettings encoderSettings;
+            encoderSettings.m_inputFilename = vbrFilename;
+            encoderSettings.m_outputFilename = outputFilename;
+            encoderSettings.m_outputModuleID = ID_OM_LAME;
+
+            encoder.SetEncoderSettings(encoderSettings);
+
+            // the first frame is below 64 kbps, the average is above
+            SettingsManager settingsManager;
+            settingsManager.setValue(LameSimpleQualityOrBitrate, 0);
+            settingsManager.setValue(LameSimpleBitrate, 64);
+            encoder.SetSettingsManager(&settingsManager);
+
+            StartEncodeAndWaitForFinish(encoder);
+
+            Assert::AreEqual(0, static_cast<int>(encoder.GetEncoderState().m_errorCode), _T("encoding must not have failed"));
+            Assert::IsTrue(Path::FileExists(outputFilename), _T("output file must exist"));
+         }
+
+         Assert::IsFalse(Decode(vbrFilename) == Decode(outputFilename),
+            _T("file must have been re-encoded"));
+      }
+
+   private:
+      /// returns length of the MPEG 1 layer III frame starting with the given header
+      static size_t GetFrameLength(const char* header)
+      {
+         static const unsigned int c_bitratesInKbps[16] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+         static const unsigned int c_sampleratesInHz[4] = { 44100, 48000, 32000, 0 };
+
+         unsigned int bitrateInKbps = c_bitratesInKbps[(BYTE(header[2]) >> 4) & 15];
+         unsigned int samplerateInHz = c_sampleratesInHz[(BYTE(header[2]) >> 2) & 3];
+         unsigned int padding = (BYTE(header[2]) >> 1) & 1;
+
+         Assert::IsTrue((BYTE(header[1]) & 0x1e) == 0x1a, _T("frame must be a MPEG 1 layer III frame"));
+
+         return 144 * bitrateInKbps * 1000 / samplerateInHz + padding;
+      }
+
+      /// decodes file using the input module, to 16-bit interleaved samples
+      static std::vector<short> Decode(const CString& inputFilename)
+      {
+         Encoder::ModuleManagerImpl moduleManager;
+
+         std::unique_ptr<Encoder::InputModule> inputModule(moduleManager.ChooseInputModule(inputFilename));
+         Assert::IsNotNull(inputModule.get(), _T("input module must be found"));
+         Assert::AreEqual(ID_IM_LIBMPG123, inputModule->GetModuleID(), _T("input module must be libmpg123"));
+
+         Encoder::TrackInfo trackInfo;
+         Encoder::SampleContainer sampleContainer;
+         SettingsManager settingsManager;
+
+         int ret = inputModule->InitInput(inputFilename, settingsManager, trackInfo, sampleContainer);
+         Assert::IsTrue(ret >= 0, _T("input module must be initialized"));
+
+         sampleContainer.SetOutputModuleTraits(16, Encoder::SamplesInterleaved);
+
+         int numChannels = sampleContainer.GetInputModuleChannels();
+
+         std::vector<short> decodedSamples;
+         while ((ret = inputModule->DecodeSamples(sampleContainer)) > 0)
+         {
+            int numSamples = 0;
+            const short* samples = static_cast<const short*>(sampleContainer.GetSamplesInterleaved(numSamples));
+
+            decodedSamples.insert(decodedSamples.end(), samples, samples + numSamples * numChannels);
+         }
+
+         Assert::AreEqual(0, ret, _T("decoding must not fail"));
+
+         inputModule->DoneInput();
+
+         return decodedSamples;
+      }
+
+      /// reads whole file
+      static std::vector<char> ReadFileContent(const CString& filename)
+      {
+         std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+         return std::vector<char>(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+      }
+
+      /// writes whole file
+      static void WriteFileContent(const CString& filename, const std::vector<char>& content)
+      {
+         std::ofstream outputFile(filename, std::ios::out | std::ios::binary);
+         outputFile.write(content.data(), content.size());
+      }
+   };
+}
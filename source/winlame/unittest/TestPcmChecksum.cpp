@@ -0,0 +1,131 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestPcmChecksum.cpp
+/// \brief Tests for the PcmChecksum class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "PcmChecksum.hpp"
+#include "SampleContainer.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for PcmChecksum class
+   TEST_CLASS(TestPcmChecksum)
+   {
+   public:
+      /// tests that samples with different bits per sample have the same checksum
+      TEST_METHOD(TestDifferentBitsPerSample)
+      {
+         std::vector<short> samples16 = { 0, 1, -1, 32767, -32768, 1234 };
+
+         std::vector<int> samples32;
+         for (short sample : samples16)
+            samples32.push_back(int(sample) << 16);
+
+         Encoder::PcmChecksum checksum16;
+         checksum16.AddInterleaved(samples16.data(), 3, 2, 16);
+
+         Encoder::PcmChecksum checksum32;
+         checksum32.AddInterleaved(samples32.data(), 3, 2, 32);
+
+         Assert::AreEqual<__int64>(3, checksum16.GetNumSamples(), _T("number of samples must be counted per channel"));
+         Assert::AreEqual(checksum16.GetNumSamples(), checksum32.GetNumSamples(), _T("number of samples must be equal"));
+         Assert::IsTrue(checksum16.GetHash() == checksum32.GetHash(), _T("hashes must be equal"));
+
+         Assert::AreEqual(16, checksum16.GetPrecision(), _T("16 bit samples must have a precision of 16 bit"));
+         Assert::AreEqual(16, checksum32.GetPrecision(), _T("shifted samples must have a precision of 16 bit"));
+      }
+
+      /// tests that changed samples change the checksum
+      TEST_METHOD(TestChangedSamples)
+      {
+         std::vector<short> samples = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+         Encoder::PcmChecksum checksum;
+         checksum.AddInterleaved(samples.data(), 4, 2, 16);
+
+         samples[5] = -5;
+
+         Encoder::PcmChecksum changedChecksum;
+         changedChecksum.AddInterleaved(samples.data(), 4, 2, 16);
+
+         Assert::IsTrue(checksum.GetHash() != changedChecksum.GetHash(), _T("hashes must differ"));
+
+         // swapping samples must change the checksum, too
+         std::swap(samples[0], samples[1]);
+
+         Encoder::PcmChecksum swappedChecksum;
+         swappedChecksum.AddInterleaved(samples.data(), 4, 2, 16);
+
+         Assert::IsTrue(changedChecksum.GetHash() != swappedChecksum.GetHash(), _T("hashes must differ"));
+      }
+
+      /// tests that adding samples in blocks results in the same checksum
+      TEST_METHOD(TestAddInBlocks)
+      {
+         std::vector<short> samples = { 10, -20, 30, -40, 50, -60, 70, -80 };
+
+         Encoder::PcmChecksum checksum;
+         checksum.AddInterleaved(samples.data(), 4, 2, 16);
+
+         Encoder::PcmChecksum blockChecksum;
+         blockChecksum.AddInterleaved(samples.data(), 1, 2, 16);
+         blockChecksum.AddInterleaved(samples.data() + 2, 3, 2, 16);
+
+         Assert::AreEqual(checksum.GetNumSamples(), blockChecksum.GetNumSamples(), _T("number of samples must be equal"));
+         Assert::IsTrue(checksum.GetHash() == blockChecksum.GetHash(), _T("hashes must be equal"));
+      }
+
+      /// tests adding samples from a sample container
+      TEST_METHOD(TestAddFromSampleContainer)
+      {
+         std::vector<short> samples = { 100, -100, 200, -200, 300, -300 };
+
+         Encoder::SampleContainer sampleContainer;
+         sampleContainer.SetInputModuleTraits(16, Encoder::SamplesInterleaved, 44100, 2);
+         sampleContainer.SetOutputModuleTraits(32, Encoder::SamplesInterleaved);
+         sampleContainer.PutSamplesInterleaved(samples.data(), 3);
+
+         Encoder::PcmChecksum containerChecksum;
+         containerChecksum.Add(sampleContainer);
+
+         Encoder::PcmChecksum checksum;
+         checksum.AddInterleaved(samples.data(), 3, 2, 16);
+
+         Assert::IsTrue(containerChecksum.IsHashed(), _T("interleaved samples must be hashed"));
+         Assert::AreEqual(checksum.GetNumSamples(), containerChecksum.GetNumSamples(), _T("number of samples must be equal"));
+         Assert::IsTrue(checksum.GetHash() == containerChecksum.GetHash(), _T("hashes must be equal"));
+
+         // samples in channel array format are only counted
+         Encoder::SampleContainer arrayContainer;
+         arrayContainer.SetInputModuleTraits(16, Encoder::SamplesInterleaved, 44100, 2);
+         arrayContainer.SetOutputModuleTraits(16, Encoder::SamplesChannelArray);
+         arrayContainer.PutSamplesInterleaved(samples.data(), 3);
+
+         Encoder::PcmChecksum arrayChecksum;
+         arrayChecksum.Add(arrayContainer);
+
+         Assert::IsFalse(arrayChecksum.IsHashed(), _T("channel array samples must not be hashed"));
+         Assert::AreEqual<__int64>(3, arrayChecksum.GetNumSamples(), _T("channel array samples must be counted"));
+      }
+   };
+}
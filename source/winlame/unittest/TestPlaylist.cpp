@@ -0,0 +1,117 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestPlaylist.cpp
+/// \brief Tests for the Playlist class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "Playlist.hpp"
+#include <fstream>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for Playlist class
+   TEST_CLASS(TestPlaylist)
+   {
+   public:
+      /// tests that entries are written in job order, even when encoded out of order
+      TEST_METHOD(TestEntriesInJobOrder)
+      {
+         Encoder::Playlist playlist;
+
+         playlist.AddEntry(_T("C:\\Music\\Track1.mp3"), _T("Track 1"), 10.0);
+         playlist.AddEntry(_T("C:\\Music\\Track2.mp3"), _T("Track 2"), 20.0);
+         playlist.AddEntry(_T("C:\\Music\\Track3.mp3"), _T("Track 3"), 30.0);
+
+         playlist.SetEncodedEntry(2, _T("C:\\Music\\Track3.mp3"), 30.0);
+         playlist.SetEncodedEntry(0, _T("C:\\Music\\Track1.mp3"), 10.0);
+         playlist.SetEncodedEntry(1, _T("C:\\Music\\Track2.mp3"), 20.0);
+
+         Assert::AreEqual<size_t>(3, playlist.GetNumEntries(), _T("playlist must contain 3 entries"));
+
+         CString text = playlist.Format(_T("C:\\Music\\"));
+
+         Assert::AreEqual(0, text.Find(_T("#EXTM3U")), _T("playlist must start with header"));
+
+         int pos1 = text.Find(_T("#EXTINF:10,Track 1"));
+         int pos2 = text.Find(_T("#EXTINF:20,Track 2"));
+         int pos3 = text.Find(_T("#EXTINF:30,Track 3"));
+
+         Assert::IsTrue(pos1 > 0 && pos2 > pos1 && pos3 > pos2, _T("entries must be in job order"));
+      }
+
+      /// tests that entries encoded before they were added keep the actual values
+      TEST_METHOD(TestEntryEncodedBeforeAdded)
+      {
+         Encoder::Playlist playlist;
+
+         playlist.SetEncodedEntry(0, _T("C:\\Music\\Track1 (2).mp3"), 12.6);
+         playlist.AddEntry(_T("C:\\Music\\Track1.mp3"), _T("Track 1"), 12.0);
+
+         CString text = playlist.Format(_T("C:\\Music\\"));
+
+         Assert::IsTrue(text.Find(_T("#EXTINF:13,Track 1")) > 0, _T("exact length must be used, rounded"));
+         Assert::IsTrue(text.Find(_T("Track1 (2).mp3")) > 0, _T("actual output filename must be used"));
+      }
+
+      /// tests that failed entries are left out and unknown lengths are written as -1
+      TEST_METHOD(TestFailedAndUnknownLengthEntries)
+      {
+         Encoder::Playlist playlist;
+
+         playlist.AddEntry(_T("C:\\Music\\Track1.mp3"), _T("Track 1"), 0.0);
+         playlist.AddEntry(_T("C:\\Music\\Track2.mp3"), _T("Track 2"), 20.0);
+
+         playlist.SetFailedEntry(1);
+
+         CString text = playlist.Format(_T("C:\\Music\\"));
+
+         Assert::IsTrue(text.Find(_T("#EXTINF:-1,Track 1")) > 0, _T("unknown length must be written as -1"));
+         Assert::AreEqual(-1, text.Find(_T("Track 2")), _T("failed entry must not be written"));
+         Assert::AreEqual(-1, text.Find(_T("Track2.mp3")), _T("failed entry filename must not be written"));
+      }
+
+      /// tests writing the playlist file
+      TEST_METHOD(TestWrite)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString playlistFilename = Path::Combine(folder.FolderName(), _T("playlist.m3u"));
+
+         Encoder::Playlist playlist;
+         playlist.AddEntry(Path::Combine(folder.FolderName(), _T("Track1.mp3")), _T("Track 1"), 10.0);
+         playlist.SetEncodedEntry(0, Path::Combine(folder.FolderName(), _T("Track1.mp3")), 9.8);
+
+         Assert::IsTrue(playlist.Write(playlistFilename), _T("writing playlist must succeed"));
+         Assert::IsTrue(Path::FileExists(playlistFilename), _T("playlist file must exist"));
+         Assert::IsFalse(Path::FileExists(playlistFilename + _T(".temp")), _T("temp file must be removed"));
+
+         std::ifstream file(playlistFilename);
+         std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+         Assert::IsTrue(content.find("#EXTINF:10,Track 1\nTrack1.mp3\n") != std::string::npos,
+            _T("playlist must contain entry with relative filename"));
+      }
+   };
+}
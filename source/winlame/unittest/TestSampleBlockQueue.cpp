@@ -0,0 +1,109 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestSampleBlockQueue.cpp
+/// \brief Tests for the SampleBlockQueue class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "SampleBlockQueue.hpp"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for SampleBlockQueue class
+   TEST_CLASS(TestSampleBlockQueue)
+   {
+   public:
+      /// tests that blocks are removed in the order they were added
+      TEST_METHOD(TestPushPop)
+      {
+         Encoder::SampleBlockQueue queue(4);
+
+         for (short value = 0; value < 4; value++)
+            Assert::IsTrue(queue.Push(CreateBlock(value)), _T("block must be added"));
+
+         queue.Close();
+
+         for (short value = 0; value < 4; value++)
+         {
+            auto block = queue.Pop();
+            Assert::IsNotNull(block.get(), _T("block must be removed"));
+            Assert::AreEqual(value, *reinterpret_cast<const short*>(block->m_data.data()), _T("blocks must keep their order"));
+         }
+
+         Assert::IsNull(queue.Pop().get(), _T("closed and empty queue must return no block"));
+         Assert::IsFalse(queue.Push(CreateBlock(0)), _T("closed queue must not accept blocks"));
+      }
+
+      /// tests passing blocks from a producer to a slower consumer
+      TEST_METHOD(TestProducerConsumer)
+      {
+         Encoder::SampleBlockQueue queue(2);
+
+         int sum = 0;
+         std::thread consumer([&]()
+         {
+            std::shared_ptr<const Encoder::SampleBlock> block;
+            while ((block = queue.Pop()) != nullptr)
+            {
+               sum += *reinterpret_cast<const short*>(block->m_data.data());
+               std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+         });
+
+         for (short value = 1; value <= 100; value++)
+            queue.Push(CreateBlock(value));
+
+         queue.Close();
+         consumer.join();
+
+         Assert::AreEqual(5050, sum, _T("all blocks must have been received"));
+      }
+
+      /// tests that aborting wakes up a waiting producer
+      TEST_METHOD(TestAbortWhileFull)
+      {
+         Encoder::SampleBlockQueue queue(1);
+         queue.Push(CreateBlock(1));
+
+         std::atomic<bool> pushResult = true;
+         std::thread producer([&]()
+         {
+            pushResult = queue.Push(CreateBlock(2));
+         });
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+         queue.Abort();
+         producer.join();
+
+         Assert::IsFalse(pushResult, _T("aborted queue must not accept blocks"));
+         Assert::IsNull(queue.Pop().get(), _T("aborted queue must return no block"));
+      }
+
+   private:
+      /// creates block with a single mono 16-bit sample
+      static std::shared_ptr<const Encoder::SampleBlock> CreateBlock(short value)
+      {
+         return std::make_shared<const Encoder::SampleBlock>(&value, 1, sizeof(value));
+      }
+   };
+}
@@ -0,0 +1,229 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestSteadyStateAllocations.cpp
+/// \brief Tests that decoding and encoding doesn't allocate memory after warm-up
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EncoderTestFixture.hpp"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "resource_unittest.h"
+#include "ModuleManager.hpp"
+#include "ModuleManagerImpl.hpp"
+#include "OutputModule.hpp"
+#include "SampleContainer.hpp"
+#include <sndfile.h>
+#include <crtdbg.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// \brief counts heap allocations of the calling thread, while an instance exists
+   /// \details Uses the allocation hook of the debug CRT, so only allocations
+   /// by code using the shared debug CRT are counted.
+   class AllocationCounter
+   {
+   public:
+      /// ctor; starts counting
+      AllocationCounter()
+      {
+         s_numAllocations = 0;
+         s_threadId = GetCurrentThreadId();
+         m_previousHook = _CrtSetAllocHook(AllocHook);
+      }
+
+      /// dtor; stops counting
+      ~AllocationCounter()
+      {
+         _CrtSetAllocHook(m_previousHook);
+      }
+
+      /// returns the number of allocations counted so far
+      unsigned int NumAllocations() const { return s_numAllocations; }
+
+   private:
+      /// allocation hook; counts allocations and reallocations
+      static int __cdecl AllocHook(int allocType, void* /*userData*/, size_t /*size*/,
+         int blockType, long /*requestNumber*/, const unsigned char* /*filename*/, int /*lineNumber*/)
+      {
+         if ((allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) &&
+            blockType != _CRT_BLOCK &&
+            GetCurrentThreadId() == s_threadId)
+            s_numAllocations++;
+
+         return TRUE;
+      }
+
+      /// previously set allocation hook
+      _CRT_ALLOC_HOOK m_previousHook;
+
+      /// number of allocations counted
+      static unsigned int s_numAllocations;
+
+      /// ID of thread whose allocations are counted
+      static DWORD s_threadId;
+   };
+
+   unsigned int AllocationCounter::s_numAllocations = 0;
+   DWORD AllocationCounter::s_threadId = 0;
+
+   /// tests for allocation-free decoding and encoding
+   TEST_CLASS(TestSteadyStateAllocations), public EncoderTestFixture
+   {
+   public:
+      /// number of blocks decoded and encoded before counting allocations
+      static const unsigned int c_numWarmUpBlocks = 16;
+
+      /// number of blocks decoded and encoded while counting allocations
+      static const unsigned int c_numCountedBlocks = 64;
+
+      /// sets up test; called before each test
+      TEST_CLASS_INITIALIZE(SetUp)
+      {
+         EncoderTestFixture::SetUp();
+      }
+
+      /// tests that growing a sample container keeps its memory for smaller blocks
+      TEST_METHOD(TestSampleContainerReserve)
+      {
+         Encoder::SampleContainer samples;
+         samples.SetInputModuleTraits(16, Encoder::SamplesInterleaved, 44100, 2);
+         samples.ReserveSamples(4096);
+         samples.SetOutputModuleTraits(16, Encoder::SamplesInterleaved);
+
+         Assert::AreEqual(4096, samples.GetReservedNumSamples(), _T("reserved number of samples must be stored"));
+
+         std::vector<short> block(2 * 4096);
+
+         int numSamples = 0;
+         void* buffer = nullptr;
+         for (int blockSize : { 4096, 1000, 4096, 512 })
+         {
+            samples.PutSamplesInterleaved(block.data(), blockSize);
+
+            void* currentBuffer = samples.GetSamplesInterleaved(numSamples);
+            Assert::AreEqual(blockSize, numSamples, _T("all samples must be stored"));
+
+            if (buffer != nullptr)
+               Assert::IsTrue(buffer == currentBuffer, _T("buffer must not be reallocated"));
+
+            buffer = currentBuffer;
+         }
+      }
+
+      /// tests that all input and output module pairs don't allocate memory
+      /// per block, after some blocks were decoded and encoded
+      TEST_METHOD(TestAllModulePairs)
+      {
+#ifdef _DEBUG
+         UnitTest::AutoCleanupFolder folder;
+
+         static const struct { UINT m_resourceId; LPCTSTR m_filename; } c_sampleFiles[] =
+         {
+            { IDR_SAMPLE_MP3, _T("sample.mp3") },
+            { IDR_SAMPLE_WAV, _T("sample.wav") },
+            { IDR_SAMPLE_OPUS, _T("sample.opus") },
+            { IDR_SAMPLE_OGGV, _T("sample.ogg") },
+            { IDR_SAMPLE_AAC, _T("sample.aac") },
+            { IDR_SAMPLE_WMA, _T("sample.wma") },
+            { IDR_SAMPLE_FLAC, _T("sample.flac") },
+            { IDR_SAMPLE_AIFF, _T("sample.aiff") },
+            { IDR_SAMPLE_SPEEX, _T("sample.spx") },
+            { IDR_SAMPLE_MONKEYS_AUDIO, _T("sample.ape") },
+         };
+
+         Encoder::ModuleManagerImpl moduleManager;
+
+         for (const auto& sampleFile : c_sampleFiles)
+         {
+            CString inputFilename = Path::Combine(folder.FolderName(), sampleFile.m_filename);
+            ExtractFromResource(sampleFile.m_resourceId, inputFilename);
+
+            for (size_t index = 0, maxIndex = moduleManager.GetOutputModuleCount(); index < maxIndex; index++)
+            {
+               int outputModuleId = moduleManager.GetOutputModuleID(index);
+
+               CString outputFilename;
+               outputFilename.Format(_T("output-%zu"), index);
+               outputFilename = Path::Combine(folder.FolderName(), outputFilename);
+
+               unsigned int numAllocations = CountAllocationsPerPair(moduleManager, inputFilename, outputModuleId, outputFilename);
+
+               CString message;
+               message.Format(_T("decoding %s and encoding with module %i must not allocate memory"),
+                  sampleFile.m_filename,
+                  outputModuleId);
+
+               Assert::AreEqual(0U, numAllocations, message);
+            }
+         }
+#else
+         Logger::WriteMessage(_T("allocations are only counted in debug builds"));
+#endif
+      }
+
+   private:
+      /// decodes and encodes given input file with given output module, and
+      /// returns the number of allocations after warm-up
+      static unsigned int CountAllocationsPerPair(Encoder::ModuleManagerImpl& moduleManager,
+         const CString& inputFilename, int outputModuleId, const CString& outputFilename)
+      {
+         std::unique_ptr<Encoder::InputModule> inputModule(moduleManager.ChooseInputModule(inputFilename));
+         std::unique_ptr<Encoder::OutputModule> outputModule(moduleManager.GetOutputModule(outputModuleId));
+         if (inputModule == nullptr || outputModule == nullptr)
+            return 0; // module not available
+
+         SettingsManager settingsManager;
+         settingsManager.setValue(SndFileFormat, SF_FORMAT_WAV);
+         settingsManager.setValue(SndFileSubType, SF_FORMAT_PCM_16);
+
+         Encoder::TrackInfo trackInfo;
+         Encoder::SampleContainer samples;
+
+         Assert::IsTrue(inputModule->InitInput(inputFilename, settingsManager, trackInfo, samples) >= 0,
+            _T("input module must be initialized"));
+
+         outputModule->PrepareOutput(settingsManager);
+
+         Assert::IsTrue(outputModule->InitOutput(outputFilename, settingsManager, trackInfo, samples) >= 0,
+            _T("output module must be initialized"));
+
+         unsigned int numAllocations = 0;
+         for (unsigned int blockIndex = 0; blockIndex < c_numWarmUpBlocks + c_numCountedBlocks; blockIndex++)
+         {
+            AllocationCounter counter;
+
+            if (inputModule->DecodeSamples(samples) <= 0)
+               break; // end of the input file, or error
+
+            outputModule->EncodeSamples(samples);
+
+            if (blockIndex >= c_numWarmUpBlocks)
+               numAllocations += counter.NumAllocations();
+         }
+
+         outputModule->DoneOutput();
+         inputModule->DoneInput();
+
+         return numAllocations;
+      }
+   };
+}
@@ -0,0 +1,185 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestTaskControl.cpp
+/// \brief Tests for the TaskControl class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "TaskControl.hpp"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for TaskControl class
+   TEST_CLASS(TestTaskControl)
+   {
+   public:
+      /// tests that check points pass when the task isn't paused or stopped
+      TEST_METHOD(TestCheckPointRunning)
+      {
+         Encoder::TaskControl taskControl;
+
+         Assert::IsTrue(taskControl.CheckPoint(), _T("check point must pass"));
+         Assert::IsFalse(taskControl.IsPaused(), _T("task must not be paused"));
+         Assert::IsFalse(taskControl.IsStopped(), _T("task must not be stopped"));
+      }
+
+      /// tests that a paused worker waits until resumed
+      TEST_METHOD(TestPauseResume)
+      {
+         Encoder::TaskControl taskControl;
+         taskControl.Pause();
+
+         std::atomic<bool> passedCheckPoint = false;
+         std::atomic<bool> checkPointResult = false;
+
+         std::thread worker([&]()
+         {
+            checkPointResult = taskControl.CheckPoint();
+            passedCheckPoint = true;
+         });
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+         Assert::IsFalse(passedCheckPoint, _T("paused worker must wait at check point"));
+
+         taskControl.Resume();
+         worker.join();
+
+         Assert::IsTrue(passedCheckPoint, _T("resumed worker must pass check point"));
+         Assert::IsTrue(checkPointResult, _T("resumed worker must continue"));
+      }
+
+      /// tests that the paused time is counted once, even when multiple
+      /// workers wait at their check points
+      TEST_METHOD(TestPausedTime)
+      {
+         Encoder::TaskControl taskControl;
+
+         Assert::IsTrue(taskControl.PausedTime() == std::chrono::steady_clock::duration::zero(),
+            _T("task that wasn't paused must have no paused time"));
+
+         taskControl.Pause();
+
+         std::thread worker1([&]() { taskControl.CheckPoint(); });
+         std::thread worker2([&]() { taskControl.CheckPoint(); });
+
+         auto pauseTime = std::chrono::milliseconds(200);
+         std::this_thread::sleep_for(pauseTime);
+
+         taskControl.Resume();
+         worker1.join();
+         worker2.join();
+
+         auto pausedTime = taskControl.PausedTime();
+         Assert::IsTrue(pausedTime >= pauseTime, _T("paused time must contain the pause"));
+         Assert::IsTrue(pausedTime < 2 * pauseTime, _T("paused time must be counted once"));
+
+         taskControl.Reset();
+
+         Assert::IsTrue(taskControl.PausedTime() == std::chrono::steady_clock::duration::zero(),
+            _T("reset must clear paused time"));
+      }
+
+      /// tests that stopping wakes up a paused worker
+      TEST_METHOD(TestStopWhilePaused)
+      {
+         Encoder::TaskControl taskControl;
+         taskControl.Pause();
+
+         std::atomic<bool> checkPointResult = true;
+
+         std::thread worker([&]()
+         {
+            checkPointResult = taskControl.CheckPoint();
+         });
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+         taskControl.Stop();
+         worker.join();
+
+         Assert::IsFalse(checkPointResult, _T("stopped worker must exit"));
+         Assert::IsTrue(taskControl.IsStopped(), _T("task must be stopped"));
+      }
+
+      /// tests that waiting returns early when stopped
+      TEST_METHOD(TestWaitForStop)
+      {
+         Encoder::TaskControl taskControl;
+
+         Assert::IsTrue(taskControl.WaitFor(std::chrono::milliseconds(1)), _T("waiting must time out"));
+
+         std::thread worker([&]()
+         {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            taskControl.Stop();
+         });
+
+         auto start = std::chrono::steady_clock::now();
+         bool result = taskControl.WaitFor(std::chrono::seconds(60));
+         auto waitTime = std::chrono::steady_clock::now() - start;
+
+         worker.join();
+
+         Assert::IsFalse(result, _T("waiting must return false when stopped"));
+         Assert::IsTrue(waitTime < std::chrono::seconds(10), _T("waiting must end when stopped"));
+      }
+
+      /// tests that resetting clears pause and stop state
+      TEST_METHOD(TestReset)
+      {
+         Encoder::TaskControl taskControl;
+         taskControl.Pause();
+         taskControl.Stop();
+
+         Assert::IsFalse(taskControl.CheckPoint(), _T("stopped task must not continue"));
+
+         taskControl.Reset();
+
+         Assert::IsFalse(taskControl.IsPaused(), _T("task must not be paused"));
+         Assert::IsTrue(taskControl.CheckPoint(), _T("check point must pass after reset"));
+      }
+
+      /// tests that a changed priority is applied to the worker thread
+      TEST_METHOD(TestPriority)
+      {
+         Encoder::TaskControl taskControl;
+         taskControl.SetPriority(Encoder::TaskControl::priorityLow);
+
+         int threadPriority = THREAD_PRIORITY_NORMAL;
+         int restoredThreadPriority = THREAD_PRIORITY_BELOW_NORMAL;
+
+         std::thread worker([&]()
+         {
+            taskControl.CheckPoint();
+            threadPriority = GetThreadPriority(GetCurrentThread());
+
+            taskControl.LeaveWorkerThread();
+            restoredThreadPriority = GetThreadPriority(GetCurrentThread());
+         });
+
+         worker.join();
+
+         Assert::AreEqual(THREAD_PRIORITY_BELOW_NORMAL, threadPriority, _T("priority must have been applied"));
+         Assert::AreEqual(THREAD_PRIORITY_NORMAL, restoredThreadPriority, _T("priority must have been restored"));
+      }
+   };
+}
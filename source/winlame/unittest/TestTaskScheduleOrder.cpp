@@ -0,0 +1,328 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestTaskScheduleOrder.cpp
+/// \brief Tests for the TaskScheduleOrder class, using simulated batches
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "TaskScheduleOrder.hpp"
+#include <cmath>
+#include <set>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// \brief simulated batch of encoder tasks
+   /// \details the lengths of the tasks follow the distribution of music
+   /// tracks, a log-normal distribution with a median of about 4 minutes;
+   /// the estimated costs differ from the real run times by a random error,
+   /// as the learned cost factors are only an average.
+   class SimulatedBatch
+   {
+   public:
+      /// ctor
+      explicit SimulatedBatch(double estimationError)
+         :m_estimationError(estimationError),
+         m_randomState(12345)
+      {
+      }
+
+      /// adds task with given run time, depending on the given tasks
+      void AddTask(double runTimeInSeconds, std::vector<unsigned int> dependentTaskIds = {})
+      {
+         TaskScheduleEntry entry;
+         entry.m_id = static_cast<unsigned int>(m_entries.size()) + 1;
+         entry.m_dependentTaskIds = dependentTaskIds;
+         entry.m_estimatedCost = runTimeInSeconds * (1.0 + m_estimationError * (2.0 * Random() - 1.0));
+
+         m_entries.push_back(entry);
+         m_runTimes.push_back(runTimeInSeconds);
+      }
+
+      /// adds given number of tasks with the run time of music tracks
+      void AddMusicTracks(unsigned int numTracks, double costFactor)
+      {
+         for (unsigned int trackIndex = 0; trackIndex < numTracks; trackIndex++)
+         {
+            double lengthInSeconds = 240.0 * std::exp(0.35 * RandomNormal());
+            AddTask(lengthInSeconds * costFactor);
+         }
+      }
+
+      /// adds a chain of tasks that depend on each other, e.g. for nogap encoding
+      void AddChain(unsigned int numTasks, double runTimeInSeconds)
+      {
+         unsigned int dependentTaskId = 0;
+         for (unsigned int taskIndex = 0; taskIndex < numTasks; taskIndex++)
+         {
+            if (dependentTaskId != 0)
+               AddTask(runTimeInSeconds, { dependentTaskId });
+            else
+               AddTask(runTimeInSeconds);
+
+            dependentTaskId = m_entries.back().m_id;
+         }
+      }
+
+      /// returns the time needed to run all tasks on the given number of
+      /// workers, in seconds; when longestFirst is false, the tasks are run in
+      /// insertion order
+      double Makespan(unsigned int numWorkers, bool longestFirst) const
+      {
+         std::vector<bool> isStarted(m_entries.size(), false);
+         std::set<unsigned int> finishedTaskIds;
+
+         // end time and index of running tasks
+         std::multiset<std::pair<double, size_t>> runningTasks;
+
+         double currentTime = 0.0;
+         size_t numFinished = 0;
+
+         while (numFinished < m_entries.size())
+         {
+            std::vector<TaskScheduleEntry> entries = m_entries;
+            for (size_t index = 0; index < entries.size(); index++)
+            {
+               if (isStarted[index] || !longestFirst)
+                  entries[index].m_estimatedCost = 0.0;
+            }
+
+            for (size_t index : TaskScheduleOrder::Calculate(entries))
+            {
+               if (runningTasks.size() >= numWorkers)
+                  break;
+
+               if (isStarted[index] ||
+                  !std::all_of(m_entries[index].m_dependentTaskIds.begin(), m_entries[index].m_dependentTaskIds.end(),
+                     [&finishedTaskIds](unsigned int dependentTaskId) { return finishedTaskIds.count(dependentTaskId) != 0; }))
+                  continue;
+
+               isStarted[index] = true;
+               runningTasks.insert(std::make_pair(currentTime + m_runTimes[index], index));
+            }
+
+            Assert::IsFalse(runningTasks.empty(), _T("a task must be runnable"));
+
+            // finish next task
+            auto iter = runningTasks.begin();
+            currentTime = iter->first;
+            finishedTaskIds.insert(m_entries[iter->second].m_id);
+            runningTasks.erase(iter);
+            numFinished++;
+         }
+
+         return currentTime;
+      }
+
+      /// returns the lower bound of the makespan with given number of workers
+      double MinMakespan(unsigned int numWorkers) const
+      {
+         double sum = 0.0;
+         double longestChain = 0.0;
+         std::vector<double> chainEnd(m_entries.size(), 0.0);
+
+         for (size_t index = 0; index < m_entries.size(); index++)
+         {
+            sum += m_runTimes[index];
+
+            double start = 0.0;
+            for (unsigned int dependentTaskId : m_entries[index].m_dependentTaskIds)
+               start = std::max(start, chainEnd[dependentTaskId - 1]);
+
+            chainEnd[index] = start + m_runTimes[index];
+            longestChain = std::max(longestChain, chainEnd[index]);
+         }
+
+         return std::max(longestChain, sum / numWorkers);
+      }
+
+   private:
+      /// returns deterministic pseudo random number in the range [0; 1)
+      double Random()
+      {
+         m_randomState = (m_randomState * 1103515245 + 12345) % 0x80000000;
+         return m_randomState / double(0x80000000);
+      }
+
+      /// returns normal distributed pseudo random number
+      double RandomNormal()
+      {
+         // Box-Muller transform
+         double u1 = std::max(Random(), 1e-9);
+         double u2 = Random();
+         return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * 3.14159265358979 * u2);
+      }
+
+   private:
+      /// relative error of the estimated costs
+      double m_estimationError;
+
+      /// state of the pseudo random number generator
+      unsigned long long m_randomState;
+
+      /// all task entries, in insertion order
+      std::vector<TaskScheduleEntry> m_entries;
+
+      /// real run time of all tasks
+      std::vector<double> m_runTimes;
+   };
+
+   /// tests for TaskScheduleOrder class
+   TEST_CLASS(TestTaskScheduleOrder)
+   {
+   public:
+      /// tests that tasks without estimated costs keep the queue order
+      TEST_METHOD(TestQueueOrderWithoutCosts)
+      {
+         std::vector<TaskScheduleEntry> entries(4);
+         for (size_t index = 0; index < entries.size(); index++)
+            entries[index].m_id = static_cast<unsigned int>(index) + 1;
+
+         std::vector<size_t> order = TaskScheduleOrder::Calculate(entries);
+
+         Assert::IsTrue(std::vector<size_t>{ 0, 1, 2, 3 } == order, _T("queue order must be kept"));
+      }
+
+      /// tests that the longest tasks are started first
+      TEST_METHOD(TestLongestFirst)
+      {
+         std::vector<TaskScheduleEntry> entries(4);
+         const double costs[] = { 10.0, 50.0, 30.0, 50.0 };
+         for (size_t index = 0; index < entries.size(); index++)
+         {
+            entries[index].m_id = static_cast<unsigned int>(index) + 1;
+            entries[index].m_estimatedCost = costs[index];
+         }
+
+         std::vector<size_t> order = TaskScheduleOrder::Calculate(entries);
+
+         Assert::IsTrue(std::vector<size_t>{ 1, 3, 2, 0 } == order,
+            _T("longest tasks must be first, tasks with equal cost in queue order"));
+      }
+
+      /// tests that a task is rated by the cost of the chain of tasks depending on it
+      TEST_METHOD(TestChainCost)
+      {
+         // task 1 is a short CD extract task, task 2 a long encoder task that
+         // depends on it; task 3 is a medium encoder task
+         std::vector<TaskScheduleEntry> entries(3);
+         entries[0].m_id = 1;
+         entries[0].m_estimatedCost = 1.0;
+         entries[1].m_id = 2;
+         entries[1].m_dependentTaskIds = { 1 };
+         entries[1].m_estimatedCost = 100.0;
+         entries[2].m_id = 3;
+         entries[2].m_estimatedCost = 50.0;
+
+         std::vector<double> chainCosts = TaskScheduleOrder::CalculateChainCosts(entries);
+
+         Assert::AreEqual(101.0, chainCosts[0], 1e-9, _T("chain cost must contain dependent task"));
+         Assert::AreEqual(100.0, chainCosts[1], 1e-9, _T("chain cost must be own cost"));
+
+         std::vector<size_t> order = TaskScheduleOrder::Calculate(entries);
+
+         Assert::AreEqual<size_t>(0, order[0], _T("task starting the long chain must be first"));
+      }
+
+      /// tests that a task depending on multiple tasks adds its cost to the
+      /// chain cost of all of them
+      TEST_METHOD(TestChainCostMultipleDependencies)
+      {
+         // tasks 1 and 2 are encoder tasks, task 3 is a playlist task that
+         // depends on both of them; task 5 is a nogap encoder task that
+         // depends on task 1 and on CD extract task 4
+         std::vector<TaskScheduleEntry> entries(5);
+         entries[0].m_id = 1;
+         entries[0].m_estimatedCost = 10.0;
+         entries[1].m_id = 2;
+         entries[1].m_estimatedCost = 20.0;
+         entries[2].m_id = 3;
+         entries[2].m_dependentTaskIds = { 1, 2 };
+         entries[2].m_estimatedCost = 1.0;
+         entries[3].m_id = 4;
+         entries[3].m_estimatedCost = 2.0;
+         entries[4].m_id = 5;
+         entries[4].m_dependentTaskIds = { 1, 4 };
+         entries[4].m_estimatedCost = 30.0;
+
+         std::vector<double> chainCosts = TaskScheduleOrder::CalculateChainCosts(entries);
+
+         Assert::AreEqual(40.0, chainCosts[0], 1e-9, _T("chain cost must contain longest dependent chain"));
+         Assert::AreEqual(21.0, chainCosts[1], 1e-9, _T("chain cost must contain playlist task"));
+         Assert::AreEqual(32.0, chainCosts[3], 1e-9, _T("chain cost must contain nogap encoder task"));
+      }
+
+      /// tests that an album with a few long tracks at the end of the queue
+      /// is finished earlier when starting the longest tasks first
+      TEST_METHOD(TestMakespanAlbumWithLongTracks)
+      {
+         SimulatedBatch batch(0.2);
+         batch.AddMusicTracks(40, 0.05);
+         batch.AddTask(3600.0 * 0.05);
+         batch.AddTask(2700.0 * 0.05);
+
+         const unsigned int numWorkers = 4;
+         double insertionOrderMakespan = batch.Makespan(numWorkers, false);
+         double longestFirstMakespan = batch.Makespan(numWorkers, true);
+
+         Assert::IsTrue(longestFirstMakespan < 0.8 * insertionOrderMakespan,
+            _T("starting longest tasks first must finish the batch earlier"));
+         Assert::IsTrue(longestFirstMakespan <= 1.1 * batch.MinMakespan(numWorkers),
+            _T("batch must finish near the lower bound"));
+      }
+
+      /// tests that a batch of music tracks is never finished later when
+      /// starting the longest tasks first
+      TEST_METHOD(TestMakespanMusicTracks)
+      {
+         for (unsigned int numWorkers = 2; numWorkers <= 16; numWorkers *= 2)
+         {
+            SimulatedBatch batch(0.2);
+            batch.AddMusicTracks(100, 0.05);
+
+            double insertionOrderMakespan = batch.Makespan(numWorkers, false);
+            double longestFirstMakespan = batch.Makespan(numWorkers, true);
+
+            Assert::IsTrue(longestFirstMakespan <= 1.01 * insertionOrderMakespan,
+               _T("starting longest tasks first must not finish the batch later"));
+            Assert::IsTrue(longestFirstMakespan <= 4.0 / 3.0 * batch.MinMakespan(numWorkers),
+               _T("batch must finish within the bound of longest job first scheduling"));
+         }
+      }
+
+      /// tests that a nogap chain queued after independent tasks is started
+      /// early, since it can't be run in parallel
+      TEST_METHOD(TestMakespanNogapChain)
+      {
+         SimulatedBatch batch(0.0);
+         batch.AddMusicTracks(20, 0.05);
+         batch.AddChain(12, 240.0 * 0.05);
+
+         const unsigned int numWorkers = 4;
+         double insertionOrderMakespan = batch.Makespan(numWorkers, false);
+         double longestFirstMakespan = batch.Makespan(numWorkers, true);
+
+         Assert::IsTrue(longestFirstMakespan < insertionOrderMakespan,
+            _T("starting the chain first must finish the batch earlier"));
+         Assert::AreEqual(batch.MinMakespan(numWorkers), longestFirstMakespan, 1e-6,
+            _T("batch must finish when the chain is finished"));
+      }
+   };
+}
@@ -0,0 +1,133 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestTempOutputFilename.cpp
+/// \brief Tests generating temporary output filenames
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "EncoderImpl.hpp"
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for EncoderImpl::GenerateTempOutFilename()
+   TEST_CLASS(TestTempOutputFilename)
+   {
+   public:
+      /// number of threads generating temp filenames at the same time
+      static const unsigned int c_numThreads = 64;
+
+      /// number of temp filenames generated per thread
+      static const unsigned int c_numFilesPerThread = 16;
+
+      /// tests that a temp file is created next to the output file
+      TEST_METHOD(TestCreatesTempFile)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("output.mp3"));
+
+         CString tempFilename;
+         Assert::IsTrue(Encoder::EncoderImpl::GenerateTempOutFilename(outputFilename, tempFilename),
+            _T("generating temp filename must succeed"));
+
+         Assert::IsTrue(Path::FileExists(tempFilename), _T("temp file must have been created"));
+         Assert::IsFalse(Path::FileExists(outputFilename), _T("output file must not have been created"));
+
+         Assert::IsTrue(tempFilename.Find(_T("output.mp3.")) != -1, _T("temp filename must contain output filename"));
+         Assert::IsTrue(tempFilename.Right(5) == _T(".temp"), _T("temp filename must end with .temp"));
+      }
+
+      /// tests that no filename is returned when the temp file can't be created
+      TEST_METHOD(TestFailsWhenFolderIsMissing)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("missing\\output.mp3"));
+
+         CString tempFilename;
+         Assert::IsFalse(Encoder::EncoderImpl::GenerateTempOutFilename(outputFilename, tempFilename),
+            _T("generating temp filename must fail"));
+
+         Assert::AreEqual(DWORD(ERROR_PATH_NOT_FOUND), ::GetLastError(), _T("error code must be set"));
+         Assert::IsTrue(tempFilename.IsEmpty(), _T("temp filename must be empty"));
+      }
+
+      /// tests that many threads writing into the same folder get unique temp
+      /// filenames; also logs the time needed, as a benchmark of task startup
+      TEST_METHOD(TestUniqueFromManyThreads)
+      {
+         UnitTest::AutoCleanupFolder folder;
+
+         CString outputFilename = Path::Combine(folder.FolderName(), _T("output.mp3"));
+
+         std::vector<std::vector<CString>> tempFilenameLists(c_numThreads);
+
+         auto start = std::chrono::steady_clock::now();
+
+         std::vector<std::thread> threadList;
+         for (unsigned int threadIndex = 0; threadIndex < c_numThreads; threadIndex++)
+         {
+            threadList.emplace_back([&, threadIndex]()
+            {
+               for (unsigned int fileIndex = 0; fileIndex < c_numFilesPerThread; fileIndex++)
+               {
+                  CString tempFilename;
+                  if (!Encoder::EncoderImpl::GenerateTempOutFilename(outputFilename, tempFilename))
+                     continue;
+
+                  tempFilenameLists[threadIndex].push_back(tempFilename);
+               }
+            });
+         }
+
+         for (std::thread& thread : threadList)
+            thread.join();
+
+         auto duration = std::chrono::steady_clock::now() - start;
+
+         CString message;
+         message.Format(_T("generated %u temp filenames on %u threads in %lld ms\n"),
+            c_numThreads * c_numFilesPerThread,
+            c_numThreads,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()));
+         Logger::WriteMessage(message);
+
+         std::set<CString> allTempFilenames;
+         for (const auto& tempFilenameList : tempFilenameLists)
+         {
+            for (const CString& tempFilename : tempFilenameList)
+            {
+               Assert::IsTrue(Path::FileExists(tempFilename), _T("temp file must have been created"));
+               allTempFilenames.insert(tempFilename);
+            }
+         }
+
+         Assert::AreEqual(size_t(c_numThreads * c_numFilesPerThread), allTempFilenames.size(),
+            _T("all temp filenames must be unique"));
+      }
+   };
+}
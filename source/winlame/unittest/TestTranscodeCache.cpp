@@ -0,0 +1,222 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestTranscodeCache.cpp
+/// \brief Tests for the TranscodeCache class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "TranscodeCache.hpp"
+#include "SettingsManager.hpp"
+#include "ModuleInterface.hpp"
+#include <fstream>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for TranscodeCache class
+   TEST_CLASS(TestTranscodeCache)
+   {
+   public:
+      /// tests that a disabled cache never finds anything
+      TEST_METHOD(TestDisabledCache)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString outputFilename = CreateTestFile(folder.FolderName(), _T("output.bin"), 100, 1);
+
+         Encoder::TranscodeCache cache(CString(), 1024);
+         Assert::IsFalse(cache.IsEnabled(), _T("cache must be disabled"));
+
+         cache.Store(_T("key"), outputFilename);
+         Assert::IsFalse(cache.Lookup(_T("key"), outputFilename + _T(".copy")), _T("lookup must fail"));
+      }
+
+      /// tests storing and looking up an output file
+      TEST_METHOD(TestStoreAndLookup)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString outputFilename = CreateTestFile(folder.FolderName(), _T("output.bin"), 100, 1);
+
+         Encoder::TranscodeCache cache(Path::Combine(folder.FolderName(), _T("cache")), 1024);
+
+         CString copyFilename = Path::Combine(folder.FolderName(), _T("copy.bin"));
+         Assert::IsFalse(cache.Lookup(_T("key1"), copyFilename), _T("lookup must fail before storing"));
+
+         cache.Store(_T("key1"), outputFilename);
+
+         Assert::IsTrue(cache.Lookup(_T("key1"), copyFilename), _T("lookup must succeed"));
+         Assert::IsTrue(ReadFileContent(outputFilename) == ReadFileContent(copyFilename), _T("copied file must be identical"));
+
+         Encoder::TranscodeCacheStatistics statistics = cache.GetStatistics();
+         Assert::AreEqual(1U, statistics.m_numHits, _T("there must be one hit"));
+         Assert::AreEqual(1U, statistics.m_numMisses, _T("there must be one miss"));
+         Assert::AreEqual(1U, statistics.m_numStored, _T("one file must have been stored"));
+         Assert::AreEqual<size_t>(1, statistics.m_numEntries, _T("cache must contain one entry"));
+         Assert::AreEqual<ULONGLONG>(100, statistics.m_currentSize, _T("cache size must be correct"));
+      }
+
+      /// tests that the least recently used entries are removed first
+      TEST_METHOD(TestEvictLeastRecentlyUsed)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString outputFilename1 = CreateTestFile(folder.FolderName(), _T("output1.bin"), 100, 1);
+         CString outputFilename2 = CreateTestFile(folder.FolderName(), _T("output2.bin"), 100, 2);
+         CString outputFilename3 = CreateTestFile(folder.FolderName(), _T("output3.bin"), 100, 3);
+
+         Encoder::TranscodeCache cache(Path::Combine(folder.FolderName(), _T("cache")), 250);
+
+         cache.Store(_T("key1"), outputFilename1);
+         cache.Store(_T("key2"), outputFilename2);
+
+         // use the first entry, so that the second one is the least recently used
+         CString copyFilename = Path::Combine(folder.FolderName(), _T("copy.bin"));
+         Assert::IsTrue(cache.Lookup(_T("key1"), copyFilename), _T("lookup must succeed"));
+
+         cache.Store(_T("key3"), outputFilename3);
+
+         Assert::IsTrue(cache.Lookup(_T("key1"), copyFilename), _T("recently used entry must be kept"));
+         Assert::IsFalse(cache.Lookup(_T("key2"), copyFilename), _T("least recently used entry must be removed"));
+         Assert::IsTrue(cache.Lookup(_T("key3"), copyFilename), _T("new entry must be kept"));
+
+         Encoder::TranscodeCacheStatistics statistics = cache.GetStatistics();
+         Assert::AreEqual(1U, statistics.m_numEvicted, _T("one entry must have been evicted"));
+         Assert::AreEqual<ULONGLONG>(200, statistics.m_currentSize, _T("cache size must be below the limit"));
+      }
+
+      /// tests that a new cache instance finds the entries of a previous one
+      TEST_METHOD(TestPersistentEntries)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString outputFilename = CreateTestFile(folder.FolderName(), _T("output.bin"), 100, 1);
+         CString cacheFolder = Path::Combine(folder.FolderName(), _T("cache"));
+
+         {
+            Encoder::TranscodeCache cache(cacheFolder, 1024);
+            cache.Store(_T("key1"), outputFilename);
+         }
+
+         Encoder::TranscodeCache cache(cacheFolder, 1024);
+         Assert::AreEqual<size_t>(1, cache.GetStatistics().m_numEntries, _T("cache must contain the previous entry"));
+
+         CString copyFilename = Path::Combine(folder.FolderName(), _T("copy.bin"));
+         Assert::IsTrue(cache.Lookup(_T("key1"), copyFilename), _T("lookup must succeed"));
+      }
+
+      /// tests calculating cache keys
+      TEST_METHOD(TestCalculateKey)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString inputFilename1 = CreateTestFile(folder.FolderName(), _T("input1.bin"), 1000, 1);
+         CString inputFilename2 = CreateTestFile(folder.FolderName(), _T("input2.bin"), 1000, 2);
+         CString inputFilename3 = CreateTestFile(folder.FolderName(), _T("input3.bin"), 1000, 1);
+
+         SettingsManager settingsManager;
+         CString key = Encoder::TranscodeCache::CalculateKey(inputFilename1, ID_OM_LAME, settingsManager);
+
+         Assert::IsFalse(key.IsEmpty(), _T("key must be calculated"));
+
+         CString otherKey = Encoder::TranscodeCache::CalculateKey(inputFilename3, ID_OM_LAME, settingsManager);
+         Assert::AreEqual(key.GetString(), otherKey.GetString(), _T("identical input files must have the same key"));
+
+         otherKey = Encoder::TranscodeCache::CalculateKey(inputFilename2, ID_OM_LAME, settingsManager);
+         Assert::AreNotEqual(key.GetString(), otherKey.GetString(), _T("different input files must have different keys"));
+
+         otherKey = Encoder::TranscodeCache::CalculateKey(inputFilename1, ID_OM_OGGV, settingsManager);
+         Assert::AreNotEqual(key.GetString(), otherKey.GetString(), _T("different output modules must have different keys"));
+
+         // settings that don't affect the audio don't change the key
+         SettingsManager otherSettingsManager;
+         otherSettingsManager.setValue(GeneralInputLengthInSeconds, 42);
+
+         otherKey = Encoder::TranscodeCache::CalculateKey(inputFilename1, ID_OM_LAME, otherSettingsManager);
+         Assert::AreEqual(key.GetString(), otherKey.GetString(), _T("input length must not change the key"));
+
+         otherSettingsManager.setValue(LameSimpleBitrate, 32);
+
+         otherKey = Encoder::TranscodeCache::CalculateKey(inputFilename1, ID_OM_LAME, otherSettingsManager);
+         Assert::AreNotEqual(key.GetString(), otherKey.GetString(), _T("encoder settings must change the key"));
+
+         Assert::IsTrue(Encoder::TranscodeCache::CalculateKey(
+            Path::Combine(folder.FolderName(), _T("missing.bin")), ID_OM_LAME, settingsManager).IsEmpty(),
+            _T("missing input file must return an empty key"));
+      }
+
+      /// tests storing and looking up from multiple threads at the same time
+      TEST_METHOD(TestConcurrentAccess)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString outputFilename = CreateTestFile(folder.FolderName(), _T("output.bin"), 10000, 1);
+
+         Encoder::TranscodeCache cache(Path::Combine(folder.FolderName(), _T("cache")), 25000);
+
+         const unsigned int numThreads = 8;
+         std::vector<std::thread> threads;
+
+         for (unsigned int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+         {
+            threads.emplace_back([&, threadIndex]()
+            {
+               for (unsigned int keyIndex = 0; keyIndex < 10; keyIndex++)
+               {
+                  CString key;
+                  key.Format(_T("key%u"), keyIndex);
+
+                  CString copyFilename;
+                  copyFilename.Format(_T("copy%u.bin"), threadIndex);
+                  copyFilename = Path::Combine(folder.FolderName(), copyFilename);
+
+                  if (!cache.Lookup(key, copyFilename))
+                     cache.Store(key, outputFilename);
+               }
+            });
+         }
+
+         for (std::thread& thread : threads)
+            thread.join();
+
+         Encoder::TranscodeCacheStatistics statistics = cache.GetStatistics();
+         Assert::AreEqual(numThreads * 10, statistics.m_numHits + statistics.m_numMisses, _T("all lookups must be counted"));
+         Assert::IsTrue(statistics.m_currentSize <= statistics.m_maxSize, _T("cache size must be below the limit"));
+         Assert::AreEqual<ULONGLONG>(statistics.m_numEntries * 10000, statistics.m_currentSize, _T("cache size must match the entries"));
+      }
+
+   private:
+      /// creates test file with given size, filled with given value
+      static CString CreateTestFile(const CString& folderName, LPCTSTR filename, size_t size, char value)
+      {
+         CString pathname = Path::Combine(folderName, filename);
+
+         std::ofstream outputFile(pathname, std::ios::out | std::ios::binary);
+         std::vector<char> data(size, value);
+         outputFile.write(data.data(), data.size());
+
+         return pathname;
+      }
+
+      /// reads whole file
+      static std::vector<char> ReadFileContent(const CString& filename)
+      {
+         std::ifstream inputFile(filename, std::ios::in | std::ios::binary);
+         return std::vector<char>(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+      }
+   };
+}
@@ -58,6 +58,7 @@ namespace unittest
          //std::make_tuple(ID_OM_AAC, _T("output.aac")), // not supported writing tags to .aac
          std::make_tuple(ID_OM_BASSWMA, _T("output.wma")),
          std::make_tuple(ID_OM_OPUS, _T("output.opus")),
+         std::make_tuple(ID_OM_FLAC, _T("output.flac")),
       };
 
    public:
@@ -0,0 +1,309 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestWorkerCountController.cpp
+/// \brief Tests for the WorkerCountController class, using simulated workloads
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "WorkerCountController.hpp"
+#include <map>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// \brief simulated workload of tasks
+   /// \details each task needs a fixed amount of CPU time and I/O wait time;
+   /// the throughput is limited by the number of workers, the CPU capacity
+   /// (where SMT siblings only add a fraction of a physical core) and the
+   /// bandwidth of the I/O subsystem.
+   class SimulatedWorkload
+   {
+   public:
+      /// ctor
+      SimulatedWorkload(unsigned int numPhysicalCores, unsigned int numLogicalCpus,
+         double cpuSecondsPerTask, double ioWaitSecondsPerTask)
+         :m_numPhysicalCores(numPhysicalCores),
+         m_numLogicalCpus(numLogicalCpus),
+         m_cpuSecondsPerTask(cpuSecondsPerTask),
+         m_ioWaitSecondsPerTask(ioWaitSecondsPerTask),
+         m_smtGain(0.0),
+         m_maxIoTasksPerSecond(0.0),
+         m_randomState(12345)
+      {
+      }
+
+      /// sets throughput of an SMT sibling, relative to a physical core
+      void SetSmtGain(double smtGain) { m_smtGain = smtGain; }
+
+      /// sets maximum number of tasks per second the I/O subsystem can serve
+      void SetMaxIoTasksPerSecond(double maxIoTasksPerSecond) { m_maxIoTasksPerSecond = maxIoTasksPerSecond; }
+
+      /// returns throughput with given number of workers, in tasks per second
+      double Throughput(unsigned int numWorkers) const
+      {
+         bool isIoLimited = false;
+         return Throughput(numWorkers, isIoLimited);
+      }
+
+      /// returns a sample, measured with given number of workers
+      WorkerPoolSample Sample(unsigned int numWorkers)
+      {
+         const double intervalInSeconds = 2.0;
+
+         bool isIoLimited = false;
+         double throughput = Throughput(numWorkers, isIoLimited);
+
+         // when waiting for I/O, the workers only use CPU time for the tasks
+         // they complete; otherwise they compute all the time
+         double cpuLoad = isIoLimited
+            ? throughput * m_cpuSecondsPerTask
+            : std::min<double>(m_numLogicalCpus,
+               numWorkers * m_cpuSecondsPerTask / (m_cpuSecondsPerTask + m_ioWaitSecondsPerTask));
+
+         WorkerPoolSample sample;
+         sample.m_intervalInSeconds = intervalInSeconds;
+         sample.m_numWaitingTasks = 5;
+         sample.m_busyWorkerSeconds = numWorkers * intervalInSeconds;
+         sample.m_cpuSeconds = cpuLoad * intervalInSeconds;
+         sample.m_completedWork = throughput * intervalInSeconds * (1.0 + c_noise * (2.0 * Random() - 1.0));
+
+         return sample;
+      }
+
+   private:
+      /// returns throughput with given number of workers, and if it's limited by I/O
+      double Throughput(unsigned int numWorkers, bool& isIoLimited) const
+      {
+         double unlimited = numWorkers / (m_cpuSecondsPerTask + m_ioWaitSecondsPerTask);
+
+         double cpuCapacity = std::min(numWorkers, m_numPhysicalCores) +
+            m_smtGain * (std::min(numWorkers, m_numLogicalCpus) - std::min(numWorkers, m_numPhysicalCores));
+
+         // more workers than CPUs only add context switches
+         if (numWorkers > m_numLogicalCpus)
+            cpuCapacity *= 1.0 - 0.02 * (numWorkers - m_numLogicalCpus);
+
+         double cpuLimited = cpuCapacity / m_cpuSecondsPerTask;
+
+         double throughput = std::min(unlimited, cpuLimited);
+
+         isIoLimited = m_maxIoTasksPerSecond > 0.0 && m_maxIoTasksPerSecond < throughput;
+
+         return isIoLimited ? m_maxIoTasksPerSecond : throughput;
+      }
+
+      /// returns deterministic pseudo random number in the range [0; 1)
+      double Random()
+      {
+         m_randomState = (m_randomState * 1103515245 + 12345) % 0x80000000;
+         return m_randomState / double(0x80000000);
+      }
+
+   private:
+      /// noise of measured throughput
+      static constexpr double c_noise = 0.03;
+
+      /// number of physical cores
+      unsigned int m_numPhysicalCores;
+
+      /// number of logical CPUs
+      unsigned int m_numLogicalCpus;
+
+      /// CPU time needed per task
+      double m_cpuSecondsPerTask;
+
+      /// I/O wait time per task
+      double m_ioWaitSecondsPerTask;
+
+      /// throughput of an SMT sibling, relative to a physical core
+      double m_smtGain;
+
+      /// maximum number of tasks per second the I/O subsystem can serve, or 0 for unlimited
+      double m_maxIoTasksPerSecond;
+
+      /// state of the pseudo random number generator
+      unsigned long long m_randomState;
+   };
+
+   /// tests for WorkerCountController class
+   TEST_CLASS(TestWorkerCountController)
+   {
+   public:
+      /// tests that CPU bound tasks use all cores, without SMT
+      TEST_METHOD(TestCpuBound)
+      {
+         SimulatedWorkload workload(8, 8, 1.0, 0.0);
+         WorkerCountController controller(1, 16, 8, 8);
+
+         SimulationResult result = RunSimulation(workload, controller);
+
+         Assert::AreEqual(8U, result.m_mostUsedNumWorkers, _T("controller must use all cores"));
+         Assert::IsTrue(result.m_averageThroughput >= 0.95 * result.m_bestThroughput,
+            _T("probing must not cost much throughput"));
+      }
+
+      /// tests that CPU bound tasks on an SMT machine with little SMT gain
+      /// use the physical cores only
+      TEST_METHOD(TestCpuBoundSmt)
+      {
+         SimulatedWorkload workload(4, 8, 1.0, 0.0);
+         workload.SetSmtGain(0.1);
+
+         WorkerCountController controller(1, 16, 8, 8);
+
+         SimulationResult result = RunSimulation(workload, controller);
+
+         Assert::AreEqual(4U, result.m_mostUsedNumWorkers, _T("controller must use the physical cores"));
+         Assert::IsTrue(result.m_maxNumWorkers <= 8, _T("controller must not oversubscribe the CPUs"));
+      }
+
+      /// tests that I/O bound tasks use more workers than CPUs
+      TEST_METHOD(TestIoBound)
+      {
+         SimulatedWorkload workload(4, 4, 0.1, 0.9);
+         workload.SetMaxIoTasksPerSecond(12.0);
+
+         WorkerCountController controller(1, 8, 4, 4);
+
+         SimulationResult result = RunSimulation(workload, controller);
+
+         Assert::AreEqual(8U, result.m_mostUsedNumWorkers, _T("controller must use the maximum number of workers"));
+         Assert::AreEqual(8U, result.m_maxNumWorkers, _T("controller must not exceed the maximum number of workers"));
+      }
+
+      /// tests that I/O bound tasks stop growing when the I/O bandwidth is saturated
+      TEST_METHOD(TestIoBandwidthSaturated)
+      {
+         SimulatedWorkload workload(8, 8, 0.2, 0.8);
+         workload.SetMaxIoTasksPerSecond(6.0);
+
+         WorkerCountController controller(1, 16, 8, 8);
+
+         SimulationResult result = RunSimulation(workload, controller);
+
+         Assert::AreEqual(6U, result.m_mostUsedNumWorkers, _T("controller must use as many workers as the I/O can serve"));
+         Assert::IsTrue(result.m_averageThroughput >= 0.95 * result.m_bestThroughput,
+            _T("probing must not cost much throughput"));
+      }
+
+      /// tests that a change only happens after several samples agree
+      TEST_METHOD(TestHysteresis)
+      {
+         WorkerCountController controller(1, 8, 2, 4);
+
+         // low CPU load and waiting tasks propose more workers
+         WorkerPoolSample sample;
+         sample.m_intervalInSeconds = 2.0;
+         sample.m_numWaitingTasks = 1;
+         sample.m_busyWorkerSeconds = 4.0;
+         sample.m_cpuSeconds = 1.0;
+         sample.m_completedWork = 1.0;
+
+         // the first sample is ignored, since it contains the startup
+         Assert::AreEqual(2U, controller.Update(sample), _T("first sample must be ignored"));
+
+         for (unsigned int sampleIndex = 1; sampleIndex < WorkerCountController::c_numStableSamples; sampleIndex++)
+            Assert::AreEqual(2U, controller.Update(sample), _T("number of workers must not change yet"));
+
+         Assert::AreEqual(3U, controller.Update(sample), _T("number of workers must have changed"));
+      }
+
+      /// tests that a pool that isn't fully used doesn't change the number of workers
+      TEST_METHOD(TestIdlePool)
+      {
+         WorkerCountController controller(1, 8, 4, 4);
+
+         WorkerPoolSample sample;
+         sample.m_intervalInSeconds = 2.0;
+         sample.m_numWaitingTasks = 0;
+         sample.m_busyWorkerSeconds = 2.0;
+         sample.m_cpuSeconds = 0.1;
+         sample.m_completedWork = 0.1;
+
+         for (unsigned int sampleIndex = 0; sampleIndex < 100; sampleIndex++)
+            Assert::AreEqual(4U, controller.Update(sample), _T("number of workers must not change"));
+      }
+
+   private:
+      /// result of a simulation
+      struct SimulationResult
+      {
+         /// number of workers used in most samples of the second half
+         unsigned int m_mostUsedNumWorkers = 0;
+
+         /// maximum number of workers used
+         unsigned int m_maxNumWorkers = 0;
+
+         /// average throughput
+         double m_averageThroughput = 0.0;
+
+         /// best possible throughput with any allowed number of workers
+         double m_bestThroughput = 0.0;
+      };
+
+      /// runs simulation of the controller with given workload
+      static SimulationResult RunSimulation(SimulatedWorkload& workload, WorkerCountController& controller)
+      {
+         const unsigned int numSamples = 300;
+
+         SimulationResult result;
+
+         std::map<unsigned int, unsigned int> numWorkersHistogram;
+         double throughputSum = 0.0;
+
+         for (unsigned int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++)
+         {
+            unsigned int numWorkers = controller.NumWorkers();
+
+            throughputSum += workload.Throughput(numWorkers);
+
+            unsigned int newNumWorkers = controller.Update(workload.Sample(numWorkers));
+
+            Assert::IsTrue(newNumWorkers >= controller.MinWorkers() && newNumWorkers <= controller.MaxWorkers(),
+               _T("number of workers must stay in bounds"));
+
+            Assert::IsTrue(newNumWorkers + 1 >= numWorkers && newNumWorkers <= numWorkers + 1,
+               _T("number of workers must change by one at most"));
+
+            result.m_maxNumWorkers = std::max(result.m_maxNumWorkers, newNumWorkers);
+
+            if (sampleIndex >= numSamples / 2)
+               numWorkersHistogram[newNumWorkers]++;
+         }
+
+         unsigned int maxCount = 0;
+         for (auto iter : numWorkersHistogram)
+         {
+            if (iter.second > maxCount)
+            {
+               maxCount = iter.second;
+               result.m_mostUsedNumWorkers = iter.first;
+            }
+         }
+
+         result.m_averageThroughput = throughputSum / numSamples;
+
+         for (unsigned int numWorkers = controller.MinWorkers(); numWorkers <= controller.MaxWorkers(); numWorkers++)
+            result.m_bestThroughput = std::max(result.m_bestThroughput, workload.Throughput(numWorkers));
+
+         return result;
+      }
+   };
+}
@@ -0,0 +1,162 @@
+//
+// winLAME - a frontend for the LAME encoding engine
+// Copyright (c) 2000-2026 Michael Fink
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestWorkerProcess.cpp
+/// \brief Tests for the WorkerProcess class
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <ulib/Path.hpp>
+#include <ulib/unittest/AutoCleanupFolder.hpp>
+#include "WorkerProcess.hpp"
+#include "SettingsManager.hpp"
+#include "ModuleInterface.hpp"
+#include "TranscodeCache.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unittest
+{
+   /// tests for WorkerProcess class
+   TEST_CLASS(TestWorkerProcess)
+   {
+   public:
+      /// tests that a job message contains all encoder settings
+      TEST_METHOD(TestJobMessageRoundTrip)
+      {
+         Encoder::EncoderSettings encoderSettings;
+         encoderSettings.m_inputFilename = _T("C:\\Music\\Input\tFile \x00e4\x00f6\x00fc.wav");
+         encoderSettings.m_outputFolder = _T("C:\\Music\\Output\\");
+         encoderSettings.m_outputFilename = _T("C:\\Music\\Output\\Input.mp3");
+         encoderSettings.m_outputModuleID = ID_OM_LAME;
+         encoderSettings.m_overwriteExisting = true;
+         encoderSettings.m_verifyOutput = true;
+         encoderSettings.m_useTrackInfo = true;
+         encoderSettings.m_allowPassThrough = false;
+         encoderSettings.m_rangeStartFrame = 75;
+         encoderSettings.m_rangeEndFrame = 7500;
+
+         Encoder::EncoderOutputSettings additionalOutput(ID_OM_OGGV);
+         additionalOutput.m_outputFilename = _T("C:\\Music\\Output\\Input.ogg");
+         encoderSettings.m_additionalOutputs.push_back(additionalOutput);
+
+         encoderSettings.m_trackInfo.SetTextInfo(Encoder::TrackInfoTitle, _T("Title"));
+         encoderSettings.m_trackInfo.SetTextInfo(Encoder::TrackInfoComment, _T("Line 1\r\nLine 2\\"));
+         encoderSettings.m_trackInfo.SetNumberInfo(Encoder::TrackInfoYear, 1999);
+         encoderSettings.m_trackInfo.SetBinaryInfo(Encoder::TrackInfoFrontCover, { 0x00, 0xff, 0x10, 0xd8 });
+
+         SettingsManager settingsManager;
+         settingsManager.setValue(LameSimpleQuality, 3);
+         settingsManager.setValue(GeneralIsLastFile, 1);
+
+         CStringA message = Encoder::WorkerProcess::FormatJobMessage(encoderSettings, settingsManager);
+
+         Encoder::EncoderSettings parsedSettings;
+         SettingsManager parsedSettingsManager;
+         CString transcodeCacheFolder;
+         ULONGLONG transcodeCacheMaxSize = 0;
+         Assert::IsTrue(Encoder::WorkerProcess::ParseJobMessage(message, parsedSettings, parsedSettingsManager,
+            transcodeCacheFolder, transcodeCacheMaxSize),
+            _T("message must be parsed"));
+         Assert::IsTrue(transcodeCacheFolder.IsEmpty(), _T("no transcode cache must be used"));
+
+         Assert::AreEqual(encoderSettings.m_inputFilename.GetString(), parsedSettings.m_inputFilename.GetString(), _T("input filename must match"));
+         Assert::AreEqual(encoderSettings.m_outputFolder.GetString(), parsedSettings.m_outputFolder.GetString(), _T("output folder must match"));
+         Assert::AreEqual(encoderSettings.m_outputFilename.GetString(), parsedSettings.m_outputFilename.GetString(), _T("output filename must match"));
+         Assert::AreEqual(encoderSettings.m_outputModuleID, parsedSettings.m_outputModuleID, _T("output module ID must match"));
+         Assert::IsTrue(parsedSettings.m_overwriteExisting, _T("overwrite flag must match"));
+         Assert::IsFalse(parsedSettings.m_deleteInputAfterEncode, _T("delete flag must match"));
+         Assert::IsTrue(parsedSettings.m_verifyOutput, _T("verify flag must match"));
+         Assert::IsTrue(parsedSettings.m_useTrackInfo, _T("track info flag must match"));
+         Assert::IsFalse(parsedSettings.m_allowPassThrough, _T("pass through flag must match"));
+         Assert::AreEqual(75U, parsedSettings.m_rangeStartFrame, _T("range start must match"));
+         Assert::AreEqual(7500U, parsedSettings.m_rangeEndFrame, _T("range end must match"));
+
+         Assert::AreEqual<size_t>(1, parsedSettings.m_additionalOutputs.size(), _T("there must be one additional output"));
+         Assert::AreEqual(ID_OM_OGGV, parsedSettings.m_additionalOutputs[0].m_outputModuleID, _T("additional output module must match"));
+         Assert::AreEqual(additionalOutput.m_outputFilename.GetString(), parsedSettings.m_additionalOutputs[0].m_outputFilename.GetString(),
+            _T("additional output filename must match"));
+
+         bool avail = false;
+         Assert::AreEqual(_T("Title"), parsedSettings.m_trackInfo.GetTextInfo(Encoder::TrackInfoTitle, avail).GetString(), _T("title must match"));
+         Assert::AreEqual(_T("Line 1\r\nLine 2\\"), parsedSettings.m_trackInfo.GetTextInfo(Encoder::TrackInfoComment, avail).GetString(), _T("comment must match"));
+         Assert::AreEqual(1999, parsedSettings.m_trackInfo.GetNumberInfo(Encoder::TrackInfoYear, avail), _T("year must match"));
+
+         parsedSettings.m_trackInfo.GetTextInfo(Encoder::TrackInfoArtist, avail);
+         Assert::IsFalse(avail, _T("artist must not be set"));
+
+         std::vector<unsigned char> frontCover;
+         Assert::IsTrue(parsedSettings.m_trackInfo.GetBinaryInfo(Encoder::TrackInfoFrontCover, frontCover), _T("front cover must be set"));
+         Assert::IsTrue(std::vector<unsigned char>{ 0x00, 0xff, 0x10, 0xd8 } == frontCover, _T("front cover must match"));
+
+         Assert::AreEqual(3, parsedSettingsManager.QueryValueInt(LameSimpleQuality), _T("setting must match"));
+         Assert::AreEqual(1, parsedSettingsManager.QueryValueInt(GeneralIsLastFile), _T("setting must match"));
+      }
+
+      /// tests that a job message contains the transcode cache folder and size
+      TEST_METHOD(TestJobMessageTranscodeCache)
+      {
+         UnitTest::AutoCleanupFolder folder;
+         CString cacheFolder = Path::Combine(folder.FolderName(), _T("cache folder"));
+         Encoder::TranscodeCache transcodeCache(cacheFolder, 3ULL * 1024 * 1024 * 1024);
+
+         Encoder::EncoderSettings encoderSettings;
+         encoderSettings.m_inputFilename = _T("C:\\Music\\Input.wav");
+         encoderSettings.m_transcodeCache = &transcodeCache;
+
+         SettingsManager settingsManager;
+         CStringA message = Encoder::WorkerProcess::FormatJobMessage(encoderSettings, settingsManager);
+
+         Encoder::EncoderSettings parsedSettings;
+         SettingsManager parsedSettingsManager;
+         CString transcodeCacheFolder;
+         ULONGLONG transcodeCacheMaxSize = 0;
+         Assert::IsTrue(Encoder::WorkerProcess::ParseJobMessage(message, parsedSettings, parsedSettingsManager,
+            transcodeCacheFolder, transcodeCacheMaxSize),
+            _T("message must be parsed"));
+
+         Assert::AreEqual(cacheFolder.GetString(), transcodeCacheFolder.GetString(), _T("cache folder must match"));
+         Assert::IsTrue(3ULL * 1024 * 1024 * 1024 == transcodeCacheMaxSize, _T("cache size must match"));
+         Assert::IsNull(parsedSettings.m_transcodeCache, _T("cache object must not be set by parsing"));
+      }
+
+      /// tests that invalid job messages are rejected
+      TEST_METHOD(TestInvalidJobMessage)
+      {
+         Encoder::EncoderSettings encoderSettings;
+         SettingsManager settingsManager;
+         CString transcodeCacheFolder;
+         ULONGLONG transcodeCacheMaxSize = 0;
+
+         Assert::IsFalse(Encoder::WorkerProcess::ParseJobMessage("", encoderSettings, settingsManager,
+            transcodeCacheFolder, transcodeCacheMaxSize), _T("empty message must be rejected"));
+         Assert::IsFalse(Encoder::WorkerProcess::ParseJobMessage("state\t0\t", encoderSettings, settingsManager,
+            transcodeCacheFolder, transcodeCacheMaxSize), _T("other message must be rejected"));
+         Assert::IsFalse(Encoder::WorkerProcess::ParseJobMessage("job\nunknown\t1\t2\n", encoderSettings, settingsManager,
+            transcodeCacheFolder, transcodeCacheMaxSize), _T("unknown key must be rejected"));
+      }
+
+      /// tests detecting the worker process command line
+      TEST_METHOD(TestIsWorkerCommandLine)
+      {
+         Assert::IsTrue(Encoder::WorkerProcess::IsWorkerCommandLine(_T("--encoder-worker \\\\.\\pipe\\name Local\\event")), _T("worker command line must be detected"));
+         Assert::IsFalse(Encoder::WorkerProcess::IsWorkerCommandLine(_T("--input-cd")), _T("other option must not be detected"));
+         Assert::IsFalse(Encoder::WorkerProcess::IsWorkerCommandLine(_T("")), _T("empty command line must not be detected"));
+      }
+   };
+}
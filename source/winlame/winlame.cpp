@@ -22,6 +22,7 @@
 //
 #include "stdafx.h"
 #include "App.hpp"
+#include "encoder/WorkerProcess.hpp"
 
 /// win main function
 int APIENTRY _tWinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/,
@@ -29,6 +30,11 @@ int APIENTRY _tWinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/,
 {
    try
    {
+      // worker processes only encode files; a crash is reported to the
+      // winLAME process that started the worker process
+      if (Encoder::WorkerProcess::IsWorkerCommandLine(lpCmdLine))
+         return Encoder::WorkerProcess::RunWorker(lpCmdLine);
+
       App::InitCrashReporter();
 
       App app(hInstance);